@@ -61,7 +61,7 @@ class Machine: public xf::SingleLoopMachine
 	Models				_models;
 	Hardware			_hardware		{ loop(), logger() };
 	Computers			_computers;
-	Simulation			_simulation		{ *this, _models, logger().with_context ("simulation") };
+	Simulation			_simulation		{ *this, _models, _hardware.servo_controller, logger().with_context ("simulation") };
 };
 
 } // namespace sim1::aircraft
@@ -15,7 +15,9 @@
 #define XEFIS__MACHINES__SIM_1__AIRCRAFT__MODELS_H__INCLUDED
 
 // Xefis:
+#include <xefis/config/all.h>
 #include <xefis/support/earth/air/standard_atmosphere.h>
+#include <xefis/support/earth/air/turbulent_atmosphere.h>
 
 // Standard:
 #include <cstddef>
@@ -26,7 +28,16 @@ namespace sim1::aircraft {
 class Models
 {
   public:
-	xf::StandardAtmosphere standard_atmosphere;
+	xf::TabulatedStandardAtmosphere standard_atmosphere;
+	xf::TurbulentAtmosphere atmosphere {
+		standard_atmosphere,
+		{
+			.wind_speed = 5_mps,
+			.wind_direction = 270_deg,
+			.turbulence_intensity = 1_mps,
+			.seed = 1,
+		},
+	};
 };
 
 } // namespace sim1::aircraft
@@ -33,6 +33,7 @@
 #include <xefis/support/simulation/constraints/hinge_constraint.h>
 #include <xefis/support/simulation/devices/angular_servo.h>
 #include <xefis/support/simulation/devices/prandtl_tube.h>
+#include <xefis/support/simulation/devices/blade_element_wing.h>
 #include <xefis/support/simulation/devices/wing.h>
 #include <xefis/support/simulation/rigid_body/concepts.h>
 #include <xefis/support/simulation/rigid_body/group.h>
@@ -74,6 +75,9 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 	auto const kElevatorLength = 1_m;
 	auto const kRudderChord = 20_cm;
 	auto const kRudderLength = 50_cm;
+	// Spanwise strips of long wings, to account for roll damping and uneven air along the span:
+	auto const kWingStrips = 8u;
+	auto const kAileronStrips = 4u;
 
 	auto const main_wing_airfoil_spline = xf::AirfoilSpline (sim1::control_surface_airfoil::kSpline);
 	auto const main_wing_airfoil_characteristics =
@@ -112,7 +116,7 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 
 	// Wing L
 
-	auto& wing_l = aircraft_group.add<xf::sim::Wing> (main_wing_airfoil, kFoamDensity);
+	auto& wing_l = aircraft_group.add<xf::sim::BladeElementWing> (main_wing_airfoil, kWingStrips, kFoamDensity);
 	wing_l.set_label ("wing L");
 	wing_l.rotate_about_body_origin (wing_to_normal_rotation);
 	// Move to the left:
@@ -121,7 +125,7 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 
 	// Wing R
 
-	auto& wing_r = aircraft_group.add<xf::sim::Wing> (main_wing_airfoil, kFoamDensity);
+	auto& wing_r = aircraft_group.add<xf::sim::BladeElementWing> (main_wing_airfoil, kWingStrips, kFoamDensity);
 	wing_r.set_label ("wing R");
 	wing_r.rotate_about_body_origin (wing_to_normal_rotation);
 	// Move to the right:
@@ -150,7 +154,7 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 
 	// Aileron L
 
-	auto& aileron_l = aircraft_group.add<xf::sim::Wing> (aileron_airfoil, kFoamDensity);
+	auto& aileron_l = aircraft_group.add<xf::sim::BladeElementWing> (aileron_airfoil, kAileronStrips, kFoamDensity);
 	aileron_l.set_label ("wing L/aileron L");
 	aileron_l.rotate_about_body_origin (wing_to_normal_rotation);
 	aileron_l.move_origin_to (wing_l.origin<WorldSpace>() + xf::SpaceLength<WorldSpace> {
@@ -162,7 +166,7 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 
 	// Aileron R
 
-	auto& aileron_r = aircraft_group.add<xf::sim::Wing> (aileron_airfoil, kFoamDensity);
+	auto& aileron_r = aircraft_group.add<xf::sim::BladeElementWing> (aileron_airfoil, kAileronStrips, kFoamDensity);
 	aileron_r.set_label ("wing R/aileron R");
 	aileron_r.rotate_about_body_origin (wing_to_normal_rotation);
 	aileron_r.move_origin_to (wing_r.origin<WorldSpace>() + xf::SpaceLength<WorldSpace> {
@@ -210,7 +214,7 @@ make_aircraft (xf::rigid_body::System& rigid_body_system, Models& models)
 
 	// Prandtl tube
 
-	auto& prandtl_tube = aircraft_group.add<xf::sim::PrandtlTube> (models.standard_atmosphere, xf::sim::PrandtlTubeParameters { .mass = 0.1_kg, .length = 20_cm, .diameter = 1_cm }); // TODO mass = 25 g
+	auto& prandtl_tube = aircraft_group.add<xf::sim::PrandtlTube> (models.atmosphere, xf::sim::PrandtlTubeParameters { .mass = 0.1_kg, .length = 20_cm, .diameter = 1_cm }); // TODO mass = 25 g
 	prandtl_tube.set_label ("Prandtl tube");
 	prandtl_tube.move_origin_to (wing_l.origin<WorldSpace>() + xf::SpaceLength<WorldSpace> (0_m, -0.75 * main_wing_airfoil.wing_length(), 0_m));
 
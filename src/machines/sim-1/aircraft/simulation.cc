@@ -35,9 +35,10 @@
 
 namespace sim1::aircraft {
 
-Simulation::Simulation (Machine& machine, Models& models, neutrino::Logger const& logger):
+Simulation::Simulation (Machine& machine, Models& models, VirtualServoController& servo_controller, neutrino::Logger const& logger):
 	_logger (logger),
 	_models (models),
+	_servo_controller (servo_controller),
 	_aircraft (make_aircraft (_rigid_body_system, _models))
 {
 	auto const location = xf::LonLatRadius (0_deg, 45_deg, xf::kEarthMeanRadius + 0.5_km);
@@ -57,12 +58,20 @@ Simulation::Simulation (Machine& machine, Models& models, neutrino::Logger const
 	});
 
 	_simulator.emplace (_rigid_body_system, _rigid_body_solver, 1_ms, _logger.with_context ("Simulator"));
+	// Called on the simulator thread before each evolve(), so servos are never touched concurrently:
+	_simulator->set_frame_callback ([this] (si::Time const simulation_time) {
+		_servo_controller.apply_setpoints();
+		_models.atmosphere.set_time (simulation_time);
+	});
+	_simulator_thread.emplace (*_simulator, _logger);
 
 	_simulator_widget.emplace (*_simulator, nullptr);
+	_simulator_widget->set_simulator_thread (&*_simulator_thread);
 	_simulator_widget->set_machine (&machine);
 	_simulator_widget->set_followed_body (&_aircraft.primary_body);
 	_simulator_widget->set_planet (&earth);
 	_simulator_widget->show();
+	_simulator_thread->start();
 }
 
 } // namespace sim1::aircraft
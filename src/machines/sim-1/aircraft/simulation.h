@@ -20,12 +20,14 @@
 // Xefis:
 #include <xefis/config/all.h>
 #include <xefis/core/components/simulator/simulator_widget.h>
+#include <xefis/modules/simulation/virtual_servo_controller.h>
 #include <xefis/support/simulation/constraints/angular_servo_constraint.h>
+#include <xefis/support/simulation/electrical/direct_solver.h>
 #include <xefis/support/simulation/electrical/network.h>
-#include <xefis/support/simulation/electrical/node_voltage_solver.h>
 #include <xefis/support/simulation/rigid_body/impulse_solver.h>
 #include <xefis/support/simulation/rigid_body/system.h>
 #include <xefis/support/simulation/simulator.h>
+#include <xefis/support/simulation/simulator_thread.h>
 #include <xefis/support/ui/rigid_body_viewer.h>
 
 // Neutrino:
@@ -48,7 +50,7 @@ class Simulation: public neutrino::Noncopyable
   public:
 	// Ctor
 	explicit
-	Simulation (Machine&, Models&, neutrino::Logger const&);
+	Simulation (Machine&, Models&, VirtualServoController&, neutrino::Logger const&);
 
 	SimulatedAircraft&
 	aircraft() noexcept
@@ -61,12 +63,15 @@ class Simulation: public neutrino::Noncopyable
   private:
 	xf::Logger							_logger;
 	Models&								_models;
-	xf::rigid_body::System				_rigid_body_system			{ _models.standard_atmosphere };
+	VirtualServoController&				_servo_controller;
+	xf::rigid_body::System				_rigid_body_system			{ _models.atmosphere };
 	xf::rigid_body::ImpulseSolver		_rigid_body_solver			{ _rigid_body_system, 1 };
 	xf::electrical::Network				_electrical_network;
-	xf::electrical::NodeVoltageSolver	_electrical_network_solver	{ _electrical_network, 1e-3 };
+	xf::electrical::DirectSolver		_electrical_network_solver	{ _electrical_network, 1e-3 };
 	SimulatedAircraft					_aircraft					{ make_aircraft (_rigid_body_system, _models) };
 	std::optional<xf::Simulator>		_simulator;
+	// Must be destroyed after the widget (which holds a snapshot reader) and before the simulator:
+	std::optional<xf::SimulatorThread>	_simulator_thread;
 	std::optional<xf::SimulatorWidget>	_simulator_widget;
 };
 
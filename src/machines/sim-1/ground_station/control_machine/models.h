@@ -26,7 +26,7 @@ namespace sim1::ground_station::control_machine {
 class Models
 {
   public:
-	xf::StandardAtmosphere standard_atmosphere;
+	xf::TabulatedStandardAtmosphere standard_atmosphere;
 };
 
 } // namespace sim1::ground_station::control_machine
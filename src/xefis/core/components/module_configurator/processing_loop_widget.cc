@@ -30,6 +30,8 @@
 
 // Standard:
 #include <cstddef>
+#include <format>
+#include <optional>
 
 
 namespace xf::configurator {
@@ -109,6 +111,38 @@ ProcessingLoopWidget::refresh()
 			_processing_latency_stats->set_data (histogram);
 		}
 	}
+
+	refresh_current_values();
+}
+
+
+void
+ProcessingLoopWidget::refresh_current_values()
+{
+	std::optional<si::Frequency> actual_frequency;
+	std::optional<si::Time> latency;
+
+	// With the real-time thread the sockets are written concurrently, so use the published snapshot:
+	if (_processing_loop.uses_real_time_thread())
+	{
+		auto const& results = _processing_loop.results();
+		actual_frequency = results.get (_processing_loop.actual_frequency);
+		latency = results.get (_processing_loop.latency);
+	}
+	else
+	{
+		actual_frequency = _processing_loop.actual_frequency.get_optional();
+		latency = _processing_loop.latency.get_optional();
+	}
+
+	auto const frequency_str = actual_frequency
+		? QString::fromStdString (std::format ("{:.1f} Hz", actual_frequency->in<si::Hertz>()))
+		: QString ("–");
+	auto const latency_str = latency
+		? QString::fromStdString (std::format ("{:.3f} ms", latency->in<si::Millisecond>()))
+		: QString ("–");
+
+	_current_values_label->setText (QString ("Actual frequency: %1    Latency: %2").arg (frequency_str, latency_str));
 }
 
 
@@ -124,14 +158,17 @@ ProcessingLoopWidget::create_performance_tab()
 	std::tie (_processing_time_histogram, _processing_time_stats, processing_time_group) = create_performance_widget (widget, "Processing time");
 	std::tie (_processing_latency_histogram, _processing_latency_stats, processing_latency_group) = create_performance_widget (widget, "Processing latency");
 
+	_current_values_label = new QLabel (widget);
+
 	auto layout = new QGridLayout (widget);
 	layout->setMargin (0);
-	layout->addWidget (communication_time_group, 0, 0);
-	layout->addWidget (processing_time_group, 1, 0);
-	layout->addWidget (processing_latency_group, 2, 0);
+	layout->addWidget (_current_values_label, 0, 0);
+	layout->addWidget (communication_time_group, 1, 0);
+	layout->addWidget (processing_time_group, 2, 0);
+	layout->addWidget (processing_latency_group, 3, 0);
 
 	layout->addItem (new QSpacerItem (0, 0, QSizePolicy::Expanding, QSizePolicy::Fixed), 0, 1);
-	layout->addItem (new QSpacerItem (0, 0, QSizePolicy::Fixed, QSizePolicy::Expanding), 3, 0);
+	layout->addItem (new QSpacerItem (0, 0, QSizePolicy::Fixed, QSizePolicy::Expanding), 4, 0);
 
 	return widget;
 }
@@ -23,6 +23,7 @@
 #include <xefis/support/ui/widget.h>
 
 // Qt:
+#include <QLabel>
 #include <QTimer>
 #include <QWidget>
 
@@ -46,6 +47,9 @@ class ProcessingLoopWidget: public ConfigWidget
 	void
 	refresh();
 
+	void
+	refresh_current_values();
+
 	QWidget*
 	create_performance_tab();
 
@@ -57,6 +61,7 @@ class ProcessingLoopWidget: public ConfigWidget
 	xf::HistogramStatsWidget*	_processing_time_stats			{ nullptr };
 	xf::HistogramWidget*		_processing_latency_histogram	{ nullptr };
 	xf::HistogramStatsWidget*	_processing_latency_stats		{ nullptr };
+	QLabel*						_current_values_label			{ nullptr };
 	QTimer*						_refresh_timer;
 };
 
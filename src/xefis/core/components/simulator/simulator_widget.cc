@@ -33,6 +33,7 @@
 
 // Standard:
 #include <cstddef>
+#include <functional>
 
 
 namespace xf {
@@ -66,17 +67,7 @@ SimulatorWidget::make_viewer_widget()
 	_rigid_body_viewer.emplace (this, RigidBodyViewer::AutoFPS);
 	_rigid_body_viewer->setSizePolicy (QSizePolicy::Expanding, QSizePolicy::Expanding);
 	_rigid_body_viewer->set_rigid_body_system (&_simulator.rigid_body_system());
-	_rigid_body_viewer->set_redraw_callback ([this] (std::optional<si::Time> const simulation_time) {
-		if (simulation_time)
-			_simulator.evolve (*simulation_time);
-		else
-			_simulator.evolve (1);
-
-		update_simulation_time_label();
-		update_simulation_performance_label();
-		_body_editor->refresh();
-		_constraint_editor->refresh();
-	});
+	_rigid_body_viewer->set_redraw_callback (std::bind_front (&SimulatorWidget::evolve, this));
 
 	auto* viewer_frame = new QFrame (this);
 	viewer_frame->setFrameStyle (QFrame::StyledPanel | QFrame::Sunken);
@@ -139,11 +130,11 @@ SimulatorWidget::make_simulation_controls()
 
 	_simulation_time_label.emplace ("", this);
 	_simulation_time_label->setSizePolicy (QSizePolicy::Fixed, QSizePolicy::Fixed);
-	update_simulation_time_label();
+	update_simulation_time_label (_simulator.simulation_time());
 
 	_simulation_performance_label.emplace ("", this);
 	_simulation_performance_label->setSizePolicy (QSizePolicy::Fixed, QSizePolicy::Fixed);
-	update_simulation_performance_label();
+	update_simulation_performance_label (_simulator.performance());
 
 	auto* basis_colors_label = new QLabel ("<b><span style='color: red'>X (Null Island)</span> <span style='color: green'>Y</span> <span style='color: blue'>Z (North Pole)</span></b>", this);
 
@@ -236,22 +227,89 @@ SimulatorWidget::make_body_controls()
 
 
 void
-SimulatorWidget::update_simulation_time_label()
+SimulatorWidget::set_simulator_thread (SimulatorThread* const simulator_thread)
+{
+	_simulator_thread = simulator_thread;
+	_snapshot_reader.reset();
+	_rigid_body_viewer->set_snapshot (nullptr);
+
+	if (_simulator_thread)
+	{
+		_snapshot_reader.emplace (_simulator_thread->make_snapshot_reader());
+		_simulator_thread->set_paused (_rigid_body_viewer->playback() != RigidBodyViewer::Playback::Running);
+		_rigid_body_viewer->set_redraw_callback (std::bind_front (&SimulatorWidget::display_snapshot, this));
+		_rigid_body_viewer->set_playback_change_callback ([this] (RigidBodyViewer::Playback const playback) {
+			_simulator_thread->set_paused (playback != RigidBodyViewer::Playback::Running);
+
+			// Now the System is not being evolved and can be safely accessed:
+			if (_simulator_thread->paused())
+				refresh_editors();
+		});
+	}
+	else
+	{
+		_rigid_body_viewer->set_redraw_callback (std::bind_front (&SimulatorWidget::evolve, this));
+		_rigid_body_viewer->set_playback_change_callback();
+	}
+}
+
+
+void
+SimulatorWidget::evolve (std::optional<si::Time> const simulation_time)
 {
-	auto const text = std::format ("Simulation time: {:.6f} s", _simulator.simulation_time().in<si::Second>());
+	if (simulation_time)
+		_simulator.evolve (*simulation_time);
+	else
+		_simulator.evolve (1);
+
+	update_simulation_time_label (_simulator.simulation_time());
+	update_simulation_performance_label (_simulator.performance());
+	refresh_editors();
+}
+
+
+void
+SimulatorWidget::display_snapshot (std::optional<si::Time> const simulation_time)
+{
+	// Single step requested (the thread is paused in Stepping mode):
+	if (!simulation_time)
+		_simulator_thread->step();
+
+	auto const& snapshot = _snapshot_reader->read();
+	_rigid_body_viewer->set_snapshot (&snapshot);
+	update_simulation_time_label (snapshot.simulation_time);
+	update_simulation_performance_label (_simulator_thread->performance());
+
+	// Editors read the System directly, so refresh them only when it's not being evolved:
+	if (_simulator_thread->paused())
+		refresh_editors();
+}
+
+
+void
+SimulatorWidget::update_simulation_time_label (si::Time const simulation_time)
+{
+	auto const text = std::format ("Simulation time: {:.6f} s", simulation_time.in<si::Second>());
 	_simulation_time_label->setText (QString::fromStdString (text));
 }
 
 
 void
-SimulatorWidget::update_simulation_performance_label()
+SimulatorWidget::update_simulation_performance_label (float const perf)
 {
-	auto const perf = _simulator.performance();
 	auto const text = std::format ("Performance: {:.0f}%", 100.0f * perf);
 	auto const prefix = perf < 1.0 ? "<span style='color: red'>" : "";
 	auto const suffix = perf < 1.0 ? "</span>" : "";
 	_simulation_performance_label->setText (prefix + QString::fromStdString (text) + suffix);
 }
 
+
+void
+SimulatorWidget::refresh_editors()
+{
+	_body_editor->refresh();
+	_constraint_editor->refresh();
+}
+
 } // namespace xf
 
@@ -24,6 +24,7 @@
 #include <xefis/base/icons.h>
 #include <xefis/support/simulation/rigid_body/system.h>
 #include <xefis/support/simulation/simulator.h>
+#include <xefis/support/simulation/simulator_thread.h>
 #include <xefis/support/ui/rigid_body_viewer.h>
 
 // Qt:
@@ -60,6 +61,14 @@ class SimulatorWidget: public QWidget
 	void
 	set_machine (Machine* machine);
 
+	/**
+	 * Use SimulatorThread to evolve the simulation instead of evolving it on each UI frame.
+	 * The widget then only starts/pauses the thread and displays published snapshots.
+	 * Must be called before the thread is started. Pass nullptr to evolve in the UI thread again.
+	 */
+	void
+	set_simulator_thread (SimulatorThread*);
+
 	/**
 	 * Sets the followed body in the internal RigidBodyViewer.
 	 */
@@ -86,15 +95,33 @@ class SimulatorWidget: public QWidget
 	QWidget*
 	make_body_controls();
 
+	/**
+	 * Redraw callback used when evolving the simulation in the UI thread.
+	 */
+	void
+	evolve (std::optional<si::Time> simulation_time);
+
+	/**
+	 * Redraw callback used with SimulatorThread.
+	 */
+	void
+	display_snapshot (std::optional<si::Time> simulation_time);
+
+	void
+	update_simulation_time_label (si::Time simulation_time);
+
 	void
-	update_simulation_time_label();
+	update_simulation_performance_label (float performance);
 
 	void
-	update_simulation_performance_label();
+	refresh_editors();
 
   private:
 	Machine*						_machine				{ nullptr };
 	Simulator&						_simulator;
+	SimulatorThread*				_simulator_thread		{ nullptr };
+	std::optional<SimulatorThread::SnapshotReader>
+									_snapshot_reader;
 	std::optional<RigidBodyViewer>	_rigid_body_viewer;
 	// Warning: QStackedWidget deletes widgets added to it in its destructor:
 	std::optional<QStackedWidget>	_editors_stack;
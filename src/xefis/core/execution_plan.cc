@@ -0,0 +1,169 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "execution_plan.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/core/module.h>
+#include <xefis/core/sockets/module_socket.h>
+
+// Standard:
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <unordered_map>
+
+
+namespace xf {
+
+ExecutionPlan::ExecutionPlan (std::vector<Module*> const& modules):
+	_connections_serial (BasicSocket::connections_serial())
+{
+	std::unordered_map<Module const*, std::size_t> indices;
+
+	_nodes.reserve (modules.size());
+
+	for (auto* module: modules)
+	{
+		indices[module] = _nodes.size();
+		_nodes.push_back ({ .module = module });
+	}
+
+	for (std::size_t i = 0; i < _nodes.size(); ++i)
+	{
+		auto& node = _nodes[i];
+		std::set<Module const*> source_modules;
+		// Use std::set to count each dependency only once:
+		std::set<std::size_t> dependencies;
+
+		for (auto* socket: Module::ModuleSocketAPI (*node.module).input_sockets())
+			collect_source_modules (*socket, *node.module, source_modules);
+
+		for (auto const* source: source_modules)
+			if (auto found = indices.find (source); found != indices.end())
+				dependencies.insert (found->second);
+
+		for (auto const dependency: dependencies)
+			_nodes[dependency].dependents.push_back (i);
+
+		node.dependencies_count = dependencies.size();
+	}
+
+	compute_topological_order();
+	collect_sockets();
+}
+
+
+void
+ExecutionPlan::collect_source_modules (BasicSocket& socket, Module const& owner, std::set<Module const*>& result)
+{
+	auto worklist = socket.data_sources();
+	// Sources may be shared by several sockets, don't walk them twice:
+	std::set<BasicSocket const*> visited;
+
+	while (!worklist.empty())
+	{
+		auto* source = worklist.back();
+		worklist.pop_back();
+
+		if (!visited.insert (source).second)
+			continue;
+
+		if (auto* module_socket = dynamic_cast<BasicModuleSocket*> (source))
+		{
+			if (auto const* module = &module_socket->module(); module != &owner)
+				result.insert (module);
+		}
+		else
+			for (auto* upstream: source->data_sources())
+				worklist.push_back (upstream);
+	}
+}
+
+
+void
+ExecutionPlan::compute_topological_order()
+{
+	std::vector<std::size_t> remaining_dependencies (_nodes.size());
+
+	_topological_order.clear();
+	_topological_order.reserve (_nodes.size());
+
+	for (std::size_t i = 0; i < _nodes.size(); ++i)
+	{
+		remaining_dependencies[i] = _nodes[i].dependencies_count;
+
+		if (remaining_dependencies[i] == 0)
+			_topological_order.push_back (i);
+	}
+
+	// _topological_order is used as the queue of nodes ready to run:
+	for (std::size_t k = 0; k < _topological_order.size(); ++k)
+		for (auto const dependent: _nodes[_topological_order[k]].dependents)
+			if (--remaining_dependencies[dependent] == 0)
+				_topological_order.push_back (dependent);
+}
+
+
+void
+ExecutionPlan::collect_sockets()
+{
+	std::size_t inputs_count = 0;
+	std::size_t outputs_count = 0;
+
+	for (auto const& node: _nodes)
+	{
+		auto const module_api = Module::ModuleSocketAPI (*node.module);
+		auto const inputs = module_api.input_sockets();
+		auto const outputs = module_api.output_sockets();
+		inputs_count += neutrino::to_unsigned (std::distance (inputs.begin(), inputs.end()));
+		outputs_count += neutrino::to_unsigned (std::distance (outputs.begin(), outputs.end()));
+	}
+
+	// Reserve everything up front, spans in nodes must not get invalidated:
+	_inputs.reserve (inputs_count);
+	_outputs.reserve (outputs_count);
+
+	auto const add_node_sockets = [&] (Node& node) {
+		auto const module_api = Module::ModuleSocketAPI (*node.module);
+		auto const inputs_start = _inputs.size();
+		auto const outputs_start = _outputs.size();
+
+		for (auto* socket: module_api.input_sockets())
+			_inputs.push_back (socket);
+
+		for (auto* socket: module_api.output_sockets())
+			_outputs.push_back (socket);
+
+		node.inputs = std::span (_inputs.data() + inputs_start, _inputs.size() - inputs_start);
+		node.outputs = std::span (_outputs.data() + outputs_start, _outputs.size() - outputs_start);
+	};
+
+	std::vector<bool> added (_nodes.size(), false);
+
+	for (auto const index: _topological_order)
+	{
+		add_node_sockets (_nodes[index]);
+		added[index] = true;
+	}
+
+	// Nodes that are part of dependency loops:
+	for (std::size_t i = 0; i < _nodes.size(); ++i)
+		if (!added[i])
+			add_node_sockets (_nodes[i]);
+}
+
+} // namespace xf
+
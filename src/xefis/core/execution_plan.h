@@ -0,0 +1,146 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__CORE__EXECUTION_PLAN_H__INCLUDED
+#define XEFIS__CORE__EXECUTION_PLAN_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/core/sockets/basic_socket.h>
+
+// Standard:
+#include <cstddef>
+#include <set>
+#include <span>
+#include <vector>
+
+
+namespace xf {
+
+class BasicModuleIn;
+class BasicModuleOut;
+class Module;
+
+
+/**
+ * Dependency graph of modules in a ProcessingLoop, built from connections
+ * between ModuleIns and ModuleOuts.
+ *
+ * A module depends on another module if any of its input sockets reads
+ * (directly or through any number of intermediate sockets) from a socket owned
+ * by the other module.
+ *
+ * The plan also keeps input and output sockets of all modules in flat arrays,
+ * grouped per module and ordered topologically, so that a processing cycle can be
+ * executed as a single linear sweep.
+ *
+ * The plan becomes outdated when any connection between sockets changes;
+ * use outdated() to check for that.
+ */
+class ExecutionPlan
+{
+  public:
+	struct Node
+	{
+		Module*						module;
+		// Indices of nodes that have to wait for this node:
+		std::vector<std::size_t>	dependents;
+		// Number of nodes that this node waits for:
+		std::size_t					dependencies_count	{ 0 };
+		// Module's sockets, stored contiguously in the plan:
+		std::span<BasicModuleIn* const>
+									inputs;
+		std::span<BasicModuleOut* const>
+									outputs;
+	};
+
+  public:
+	// Ctor
+	explicit
+	ExecutionPlan (std::vector<Module*> const& modules);
+
+	// Nodes refer to the plan's socket arrays, so forbid copying:
+	ExecutionPlan (ExecutionPlan const&) = delete;
+
+	ExecutionPlan&
+	operator= (ExecutionPlan const&) = delete;
+
+	/**
+	 * Return true if connections between sockets changed since the plan was built.
+	 */
+	[[nodiscard]]
+	bool
+	outdated() const noexcept
+		{ return _connections_serial != BasicSocket::connections_serial(); }
+
+	/**
+	 * Graph nodes, in the same order as the modules passed to the constructor.
+	 */
+	[[nodiscard]]
+	std::vector<Node> const&
+	nodes() const noexcept
+		{ return _nodes; }
+
+	/**
+	 * Node indices sorted topologically: each node comes after all nodes it depends on.
+	 * Contains all nodes only if the graph is acyclic.
+	 */
+	[[nodiscard]]
+	std::vector<std::size_t> const&
+	topological_order() const noexcept
+		{ return _topological_order; }
+
+	/**
+	 * Return true if there are no dependency loops between modules.
+	 * Modules with loops can only be executed in the serial mode, where the loop
+	 * is broken by the module's cached-result flag.
+	 */
+	[[nodiscard]]
+	bool
+	acyclic() const noexcept
+		{ return _topological_order.size() == _nodes.size(); }
+
+  private:
+	/**
+	 * Walk all data sources upstream of given socket (see BasicSocket::data_sources())
+	 * and add to the result every module other than the owner that owns a socket there.
+	 * Walking stops at module sockets, since modules fetch their own inputs.
+	 */
+	static void
+	collect_source_modules (BasicSocket& socket, Module const& owner, std::set<Module const*>& result);
+
+	/**
+	 * Compute _topological_order with Kahn's algorithm.
+	 */
+	void
+	compute_topological_order();
+
+	/**
+	 * Copy socket lists of modules into flat arrays, in topological order,
+	 * and point nodes to their parts of the arrays.
+	 */
+	void
+	collect_sockets();
+
+  private:
+	BasicSocket::Serial				_connections_serial;
+	std::vector<Node>				_nodes;
+	std::vector<std::size_t>		_topological_order;
+	std::vector<BasicModuleIn*>		_inputs;
+	std::vector<BasicModuleOut*>	_outputs;
+};
+
+} // namespace xf
+
+#endif
+
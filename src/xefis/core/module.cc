@@ -87,6 +87,7 @@ void
 Module::ModuleSocketAPI::register_input_socket (BasicModuleIn& socket)
 {
 	_module._registered_input_sockets.push_back (&socket);
+	BasicSocket::connections_changed();
 }
 
 
@@ -95,6 +96,7 @@ Module::ModuleSocketAPI::unregister_input_socket (BasicModuleIn& socket)
 {
 	auto new_end = std::remove (_module._registered_input_sockets.begin(), _module._registered_input_sockets.end(), &socket);
 	_module._registered_input_sockets.resize (neutrino::to_unsigned (std::distance (_module._registered_input_sockets.begin(), new_end)));
+	BasicSocket::connections_changed();
 }
 
 
@@ -102,6 +104,7 @@ void
 Module::ModuleSocketAPI::register_output_socket (BasicModuleOut& socket)
 {
 	_module._registered_output_sockets.push_back (&socket);
+	BasicSocket::connections_changed();
 }
 
 
@@ -110,6 +113,7 @@ Module::ModuleSocketAPI::unregister_output_socket (BasicModuleOut& socket)
 {
 	auto new_end = std::remove (_module._registered_output_sockets.begin(), _module._registered_output_sockets.end(), &socket);
 	_module._registered_output_sockets.resize (neutrino::to_unsigned (std::distance (_module._registered_output_sockets.begin(), new_end)));
+	BasicSocket::connections_changed();
 }
 
 
@@ -153,14 +157,15 @@ Module::ProcessingLoopAPI::communicate (Cycle const& cycle)
 
 
 void
-Module::ProcessingLoopAPI::fetch_and_process (Cycle const& cycle)
+Module::ProcessingLoopAPI::fetch_and_process (Cycle const& cycle, std::span<BasicModuleIn* const> const inputs)
 {
 	try {
-		if (!_module._cached)
+		if (_module._processed_cycle_number < cycle.number())
 		{
-			_module._cached = true;
+			// Set it before fetching, to break dependency loops:
+			_module._processed_cycle_number = cycle.number();
 
-			for (auto* socket: _module._registered_input_sockets)
+			for (auto* socket: inputs)
 				socket->fetch (cycle);
 
 			auto processing_time = TimeHelper::measure ([&] {
@@ -178,6 +183,22 @@ Module::ProcessingLoopAPI::fetch_and_process (Cycle const& cycle)
 }
 
 
+void
+Module::ProcessingLoopAPI::fetch_and_process_if_changed (Cycle const& cycle, std::span<BasicModuleIn* const> const inputs)
+{
+	// Module must be processed at least once (and again after reset_cache()):
+	bool const never_processed = _module._processed_cycle_number == 0;
+
+	if (_module._pure && !never_processed &&
+		std::none_of (inputs.begin(), inputs.end(), [] (BasicModuleIn const* socket) { return socket->source_changed(); }))
+	{
+		_module._processed_cycle_number = cycle.number();
+	}
+	else
+		fetch_and_process (cycle, inputs);
+}
+
+
 void
 Module::ProcessingLoopAPI::handle_exception (Cycle const& cycle, std::string_view const& context_info)
 {
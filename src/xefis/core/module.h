@@ -32,6 +32,7 @@
 #include <exception>
 #include <optional>
 #include <memory>
+#include <span>
 #include <type_traits>
 
 
@@ -194,11 +195,30 @@ class Module:
 
 		/**
 		 * Request all connected input sockets to be computed, and then
-		 * call the process() method. It will compute results only once, until
-		 * reset_cache() is called.
+		 * call the process() method. It will compute results only once per cycle
+		 * (or until reset_cache() is called).
 		 */
 		void
-		fetch_and_process (Cycle const&);
+		fetch_and_process (Cycle const& cycle)
+			{ fetch_and_process (cycle, _module._registered_input_sockets); }
+
+		/**
+		 * Like fetch_and_process (Cycle const&), but fetch only given input sockets.
+		 * Used by ProcessingLoop when executing an ExecutionPlan, which keeps module's
+		 * input sockets in its own flat array.
+		 */
+		void
+		fetch_and_process (Cycle const&, std::span<BasicModuleIn* const> inputs);
+
+		/**
+		 * Like fetch_and_process (Cycle const&, std::span<BasicModuleIn* const>), but if the module
+		 * is pure (see Module::set_pure()) and none of given inputs has a changed source since the last
+		 * cycle, skip both fetching and processing.
+		 * Caller must ensure that all modules that the inputs depend on have already been
+		 * processed in this cycle, otherwise their changes would be missed.
+		 */
+		void
+		fetch_and_process_if_changed (Cycle const&, std::span<BasicModuleIn* const> inputs);
 
 		/**
 		 * Delete cached result of fetch_and_process().
@@ -324,6 +344,14 @@ class Module:
 	verify_settings()
 	{ }
 
+	/**
+	 * Return true if module declared that it's pure. See set_pure().
+	 */
+	[[nodiscard]]
+	bool
+	pure() const noexcept
+		{ return _pure; }
+
   protected:
 	/**
 	 * Communicate with sensors/actuators to send/receive processing data and results.
@@ -357,14 +385,28 @@ class Module:
 	void
 	set_nil_on_exception (bool enable) noexcept;
 
+	/**
+	 * Declare that the module is pure: results of process() depend only on values of its
+	 * input sockets (and settings), not on time, cycle number, communicate() or any other
+	 * external state. When executing cycles in topological order, ProcessingLoop skips fetching
+	 * inputs and calling process() on pure modules whose inputs didn't change since
+	 * the previous cycle. Output sockets then simply keep their values.
+	 *
+	 * By default it's disabled.
+	 */
+	void
+	set_pure (bool enable) noexcept
+		{ _pure = enable; }
+
   private:
 	std::vector<BasicSetting*>			_registered_settings;
 	std::vector<BasicModuleIn*>			_registered_input_sockets;
 	std::vector<BasicModuleOut*>		_registered_output_sockets;
 	bool								_did_not_communicate: 1		{ false };
 	bool								_did_not_process: 1			{ false };
-	bool								_cached: 1					{ false };
 	bool								_set_nil_on_exception: 1	{ true };
+	bool								_pure: 1					{ false };
+	Cycle::Number						_processed_cycle_number		{ 0 };
 	boost::circular_buffer<si::Time>	_communication_times		{ kMaxProcessingTimesBackLog };
 	boost::circular_buffer<si::Time>	_processing_times			{ kMaxProcessingTimesBackLog };
 	si::Time							_cycle_time					{ 0_s };
@@ -394,7 +436,7 @@ Module::ProcessingLoopAPI::implements_process_method() const noexcept
 inline void
 Module::ProcessingLoopAPI::reset_cache()
 {
-	_module._cached = false;
+	_module._processed_cycle_number = 0;
 }
 
 
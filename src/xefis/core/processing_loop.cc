@@ -17,18 +17,32 @@
 // Xefis:
 #include <xefis/app/xefis.h>
 #include <xefis/config/all.h>
+#include <xefis/core/instrument.h>
 #include <xefis/core/machine.h>
 #include <xefis/core/module.h>
+#include <xefis/core/sockets/module_socket.h>
 
 // Neutrino:
+#include <neutrino/exception.h>
 #include <neutrino/time_helper.h>
 
 // Lib:
 #include <boost/circular_buffer.hpp>
 
+// System:
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
 // Standard:
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <cstddef>
+#include <cstring>
+#include <exception>
 #include <functional>
+#include <latch>
 
 
 namespace xf {
@@ -46,6 +60,11 @@ ProcessingLoop::ProcessingLoop (std::string_view const& instance, si::Frequency
 		execute_cycle (TimeHelper::now());
 	});
 
+	_stats_timer = new QTimer (this);
+	_stats_timer->setSingleShot (false);
+	_stats_timer->setInterval (kStatsCollectionInterval.in<si::Millisecond>());
+	QObject::connect (_stats_timer, &QTimer::timeout, this, &ProcessingLoop::collect_cycle_stats);
+
 	_logger.set_logger_tag_provider (*this);
 
 	register_module (*this);
@@ -62,7 +81,26 @@ ProcessingLoop::start()
 		module->initialize();
 
 	_uninitialized_modules.clear();
-	_loop_timer->start();
+	_execution_plan.reset();
+	ensure_execution_plan();
+
+	if (_real_time_settings)
+	{
+		// Instruments read sockets on the Qt thread while painting, which would race with the real-time thread:
+		for (auto* module: _modules)
+			if (dynamic_cast<Instrument*> (module))
+				throw InvalidCall ("ProcessingLoop::start(): instrument " + identifier (*module) + " can't be used with the real-time thread");
+
+		if (!_real_time_thread.joinable())
+		{
+			_stats_timer->start();
+			_real_time_thread = std::jthread ([this] (std::stop_token stop_token) {
+				real_time_thread_loop (stop_token);
+			});
+		}
+	}
+	else
+		_loop_timer->start();
 }
 
 
@@ -70,6 +108,37 @@ void
 ProcessingLoop::stop()
 {
 	_loop_timer->stop();
+
+	if (_real_time_thread.joinable())
+	{
+		_real_time_thread.request_stop();
+		_real_time_thread.join();
+		_stats_timer->stop();
+		collect_cycle_stats();
+	}
+}
+
+
+ProcessingLoop::~ProcessingLoop()
+{
+	stop();
+}
+
+
+void
+ProcessingLoop::set_work_performer (WorkPerformer* work_performer)
+{
+	_work_performer = work_performer;
+}
+
+
+void
+ProcessingLoop::use_real_time_thread (RealTimeSettings const& settings)
+{
+	if (_real_time_thread.joinable() || _loop_timer->isActive())
+		throw InvalidCall ("ProcessingLoop::use_real_time_thread() called after start()");
+
+	_real_time_settings = settings;
 }
 
 
@@ -83,39 +152,315 @@ ProcessingLoop::execute_cycle (si::Time const now)
 	si::Time latency = dt - _loop_period;
 
 	_current_cycle = Cycle (_next_cycle_number++, now, dt, _loop_period, _logger);
-	_processing_latencies.push_back (latency);
+	_current_cycle_number.store (_current_cycle->number(), std::memory_order_relaxed);
+
+	std::optional<BasicSocket::CycleTimeScope> cycle_time_scope;
+
+	if (_cycle_time_for_sockets)
+		cycle_time_scope.emplace (now);
+
 	this->latency = latency;
 	this->actual_frequency = 1.0 / dt;
 
-	for (auto* module: _modules)
-		Module::ProcessingLoopAPI (*module).reset_cache();
+	ensure_execution_plan();
+	bool const use_plan = _execution_plan->acyclic();
+
+	CycleStats stats;
+	stats.latency = latency;
 
-	_communication_times.push_back (TimeHelper::measure ([this] {
+	stats.communication_time = TimeHelper::measure ([this] {
 		for (auto* module: _modules)
 			Module::ProcessingLoopAPI (*module).communicate (*_current_cycle);
-	}));
+	});
 
-	_processing_times.push_back (TimeHelper::measure ([this] {
-		for (auto* module: _modules)
-		{
-			Module::AccountingAPI (*module).set_cycle_time (period());
-			Module::ProcessingLoopAPI (*module).fetch_and_process (*_current_cycle);
-		}
-	}));
+	stats.processing_time = TimeHelper::measure ([&] {
+		if (!use_plan)
+			process_recursively (*_current_cycle);
+		else if (_work_performer)
+			process_in_parallel (*_current_cycle);
+		else
+			process_serially (*_current_cycle);
+	});
+
+	record_cycle_stats (stats);
+
+	if (_real_time_settings)
+		publish_results (*_current_cycle);
 
 	if (latency > kLatencyFactorLogThreshold * _loop_period)
 		_logger << std::format ("Latency! {:.0f}% delay.\n", latency / _loop_period * 100.0);
 
 	_previous_timestamp = now;
 	_current_cycle.reset();
+	_current_cycle_number.store (0, std::memory_order_relaxed);
+}
+
+
+void
+ProcessingLoop::process_recursively (Cycle const& cycle)
+{
+	for (auto* module: _modules)
+	{
+		Module::AccountingAPI (*module).set_cycle_time (period());
+		Module::ProcessingLoopAPI (*module).fetch_and_process (cycle);
+	}
+}
+
+
+void
+ProcessingLoop::process_serially (Cycle const& cycle)
+{
+	auto const& nodes = _execution_plan->nodes();
+
+	for (auto const index: _execution_plan->topological_order())
+		process_node (nodes[index], cycle);
+}
+
+
+void
+ProcessingLoop::process_in_parallel (Cycle const& cycle)
+{
+	auto const& nodes = _execution_plan->nodes();
+	ParallelRun run (nodes.size());
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+		_pending_dependencies[i].store (nodes[i].dependencies_count, std::memory_order_relaxed);
+
+	for (std::size_t i = 0; i < nodes.size(); ++i)
+		if (nodes[i].dependencies_count == 0)
+			submit_node (i, cycle, run);
+
+	run.all_done.wait();
+
+	if (run.exception)
+		std::rethrow_exception (run.exception);
+}
+
+
+void
+ProcessingLoop::process_node (ExecutionPlan::Node const& node, Cycle const& cycle)
+{
+	auto& module = *node.module;
+
+	Module::AccountingAPI (module).set_cycle_time (period());
+	// Nodes are executed in topological order, so all modules that this one depends on
+	// are already processed and changes on its inputs can be detected without fetching:
+	Module::ProcessingLoopAPI (module).fetch_and_process_if_changed (cycle, node.inputs);
+
+	// The module has been processed, so fetch() on its outputs would only call its no-op
+	// fetch_and_process(). Mark the outputs as fetched, so that dependent modules skip
+	// the virtual ModuleOut::do_fetch() call (and in parallel mode don't race on calling it):
+	for (auto* socket: node.outputs)
+		socket->mark_fetched (cycle);
+}
+
+
+void
+ProcessingLoop::process_node_in_parallel (std::size_t const node_index, Cycle const& cycle, ParallelRun& run)
+{
+	auto const& node = _execution_plan->nodes()[node_index];
+
+	if (!run.failed.load (std::memory_order_acquire))
+	{
+		try {
+			// Worker threads need their own scope:
+			std::optional<BasicSocket::CycleTimeScope> cycle_time_scope;
+
+			if (_cycle_time_for_sockets)
+				cycle_time_scope.emplace (cycle.update_time());
+
+			process_node (node, cycle);
+		}
+		catch (...)
+		{
+			run.fail (std::current_exception());
+		}
+	}
+
+	// Dependents must be released even after a failure, otherwise all_done would never be reached:
+	for (auto const dependent: node.dependents)
+		if (_pending_dependencies[dependent].fetch_sub (1, std::memory_order_acq_rel) == 1)
+			submit_node (dependent, cycle, run);
+
+	run.all_done.count_down();
+}
+
+
+void
+ProcessingLoop::submit_node (std::size_t const node_index, Cycle const& cycle, ParallelRun& run)
+{
+	try {
+		_work_performer->submit ([this, node_index, &cycle, &run] { process_node_in_parallel (node_index, cycle, run); });
+	}
+	catch (...)
+	{
+		run.fail (std::current_exception());
+		process_node_in_parallel (node_index, cycle, run);
+	}
+}
+
+
+void
+ProcessingLoop::ensure_execution_plan()
+{
+	if (!_execution_plan || _execution_plan->outdated())
+	{
+		_execution_plan.emplace (_modules);
+		_pending_dependencies = std::vector<std::atomic<std::size_t>> (_modules.size());
+
+		if (!_execution_plan->acyclic())
+			_logger << "Modules have dependency loops; falling back to recursive processing.\n";
+	}
+}
+
+
+void
+ProcessingLoop::record_cycle_stats (CycleStats const& stats)
+{
+	if (_real_time_settings)
+		_cycle_stats_queue.push (stats);
+	else
+	{
+		_communication_times.push_back (stats.communication_time);
+		_processing_times.push_back (stats.processing_time);
+		_processing_latencies.push_back (stats.latency);
+	}
+}
+
+
+void
+ProcessingLoop::publish_results (Cycle const& cycle)
+{
+	auto& results = _results.write_buffer();
+	results.cycle_number = cycle.number();
+	results.sockets.clear();
+
+	for (auto* module: _modules)
+		for (auto* socket: Module::ModuleSocketAPI (*module).output_sockets())
+			results.sockets.push_back (socket);
+
+	// Reuse Blobs from previous cycles, so that in steady state nothing gets allocated:
+	results.values.resize (results.sockets.size());
+
+	for (std::size_t i = 0; i < results.sockets.size(); ++i)
+	{
+		results.values[i].clear();
+		results.sockets[i]->append_to (results.values[i]);
+	}
+
+	_results.publish();
+}
+
+
+void
+ProcessingLoop::collect_cycle_stats()
+{
+	while (auto const stats = _cycle_stats_queue.pop())
+	{
+		_communication_times.push_back (stats->communication_time);
+		_processing_times.push_back (stats->processing_time);
+		_processing_latencies.push_back (stats->latency);
+	}
+}
+
+
+void
+ProcessingLoop::real_time_thread_loop (std::stop_token stop_token)
+{
+	configure_real_time_thread();
+
+	auto const period_ns = static_cast<int64_t> (_loop_period.in<si::Second>() * 1e9);
+	auto const to_ns = [](timespec const& ts) {
+		return static_cast<int64_t> (ts.tv_sec) * 1'000'000'000 + ts.tv_nsec;
+	};
+	auto const to_timespec = [](int64_t const ns) {
+		return timespec {
+			.tv_sec = static_cast<time_t> (ns / 1'000'000'000),
+			.tv_nsec = static_cast<long> (ns % 1'000'000'000),
+		};
+	};
+
+	timespec now_ts;
+	::clock_gettime (CLOCK_MONOTONIC, &now_ts);
+	int64_t deadline_ns = to_ns (now_ts);
+
+	while (!stop_token.stop_requested())
+	{
+		deadline_ns += period_ns;
+		auto const deadline = to_timespec (deadline_ns);
+
+		// Restart the sleep if interrupted by a signal; absolute deadline makes that safe:
+		while (::clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+			continue;
+
+		// Nothing up the stack of this thread would catch exceptions, so catch and log them here,
+		// like Xefis::notify() does for cycles executed on the Qt thread:
+		Exception::catch_and_log (_logger, [this] {
+			execute_cycle (TimeHelper::now());
+		});
+
+		// If we missed more than a whole period, don't try to catch up with a burst of cycles:
+		::clock_gettime (CLOCK_MONOTONIC, &now_ts);
+
+		if (auto const now_ns = to_ns (now_ts); now_ns - deadline_ns > period_ns)
+			deadline_ns = now_ns;
+	}
+}
+
+
+void
+ProcessingLoop::configure_real_time_thread()
+{
+	if (_real_time_settings->sched_fifo_priority)
+	{
+		sched_param param {};
+		param.sched_priority = *_real_time_settings->sched_fifo_priority;
+
+		if (auto const error = ::pthread_setschedparam (::pthread_self(), SCHED_FIFO, &param); error != 0)
+			_logger << std::format ("Could not set SCHED_FIFO priority {}: {}\n", param.sched_priority, std::strerror (error));
+	}
+
+	if (_real_time_settings->cpu_affinity)
+	{
+		cpu_set_t cpu_set;
+		CPU_ZERO (&cpu_set);
+		CPU_SET (*_real_time_settings->cpu_affinity, &cpu_set);
+
+		if (auto const error = ::pthread_setaffinity_np (::pthread_self(), sizeof (cpu_set), &cpu_set); error != 0)
+			_logger << std::format ("Could not set CPU affinity to CPU {}: {}\n", *_real_time_settings->cpu_affinity, std::strerror (error));
+	}
+}
+
+
+std::optional<BlobView>
+ProcessingLoop::Results::value_of (BasicModuleOut const& socket) const
+{
+	if (auto const found = std::find (sockets.begin(), sockets.end(), &socket); found != sockets.end())
+		return values[static_cast<std::size_t> (found - sockets.begin())];
+	else
+		return std::nullopt;
+}
+
+
+bool
+ProcessingLoop::Results::read_into (BasicModuleOut const& source, BasicAssignableSocket& target) const
+{
+	if (auto const value = value_of (source))
+	{
+		target.from_blob (*value);
+		return true;
+	}
+	else
+		return false;
 }
 
 
 std::optional<std::string>
 ProcessingLoop::logger_tag() const
 {
-	if (auto cycle = current_cycle())
-		return std::format ("cycle={:08d}", cycle->number());
+	// Logger can be used from any thread, so don't touch _current_cycle here:
+	if (auto const number = current_cycle_number())
+		return std::format ("cycle={:08d}", *number);
 	else
 		return "cycle=--------";
 }
@@ -16,19 +16,30 @@
 
 // Xefis:
 #include <xefis/config/all.h>
+#include <xefis/core/execution_plan.h>
 #include <xefis/core/sockets/module_out.h>
+#include <xefis/core/sockets/socket_traits.h>
+#include <xefis/utility/spsc_queue.h>
+#include <xefis/utility/triple_buffer.h>
 
 // Neutrino:
 #include <neutrino/logger.h>
 #include <neutrino/noncopyable.h>
 #include <neutrino/sequence.h>
 #include <neutrino/time.h>
+#include <neutrino/work_performer.h>
 
 // Qt:
 #include <QTimer>
 
 // Standard:
+#include <atomic>
 #include <cstddef>
+#include <exception>
+#include <latch>
+#include <optional>
+#include <stop_token>
+#include <thread>
 #include <vector>
 
 
@@ -40,6 +51,24 @@ class Xefis;
 
 /**
  * A loop that periodically goes through all modules and calls process() method.
+ *
+ * Modules are processed according to an ExecutionPlan compiled from connections between sockets: by default
+ * serially in topological order, on the thread that runs the loop. Optionally a WorkPerformer can be provided,
+ * in which case modules are processed in parallel: each module is started as soon as all modules it reads data
+ * from have been processed. If modules have dependency loops, they're processed in order of registration and
+ * dependencies are resolved recursively when fetching sockets. The communicate() method of modules
+ * is always called serially on the loop's thread, since it usually talks to hardware objects that are not
+ * thread-safe.
+ *
+ * When executing the plan, modules that declared themselves pure (see Module::set_pure()) are skipped
+ * if none of their inputs changed since the previous cycle. Sockets mark their direct targets when
+ * their value changes, so this check doesn't need to fetch anything.
+ *
+ * The loop is driven either by a QTimer on the Qt event loop (the default) or by a dedicated real-time thread
+ * (see use_real_time_thread()) that isn't affected by GUI jitter. In the latter case modules are processed
+ * on that thread, timing statistics are passed to the Qt thread through a lock-free queue and values of output
+ * sockets are published after each cycle through a triple buffer (see results()). Modules can't be registered
+ * while the real-time thread is running and Instruments, which read sockets when painting, can't be used with it.
  */
 class ProcessingLoop:
 	public QObject,
@@ -50,12 +79,98 @@ class ProcessingLoop:
 	ModuleOut<si::Frequency>	actual_frequency	{ this, "actual_frequency" };
 	ModuleOut<si::Time>			latency				{ this, "latency" };
 
+	/**
+	 * Settings for the real-time processing thread.
+	 */
+	struct RealTimeSettings
+	{
+		// If set, use SCHED_FIFO scheduling policy with given priority (1…99):
+		std::optional<int>			sched_fifo_priority;
+		// If set, pin the thread to given CPU:
+		std::optional<std::size_t>	cpu_affinity;
+	};
+
+	/**
+	 * Values of output sockets of all registered modules, taken at the end of a processing cycle.
+	 */
+	struct Results
+	{
+		// Number of the cycle that computed the values or 0 if nothing has been published yet:
+		Cycle::Number						cycle_number	{ 0 };
+		std::vector<BasicModuleOut const*>	sockets;
+		// Values of sockets, serialized with BasicSocket::append_to():
+		std::vector<Blob>					values;
+
+		/**
+		 * Return serialized value of given socket or std::nullopt if the socket is not in the snapshot.
+		 */
+		[[nodiscard]]
+		std::optional<BlobView>
+		value_of (BasicModuleOut const&) const;
+
+		/**
+		 * Unserialize value of the source socket into the target socket.
+		 * Return false if source socket is not in the snapshot.
+		 */
+		bool
+		read_into (BasicModuleOut const& source, BasicAssignableSocket& target) const;
+
+		/**
+		 * Return value of given socket of an arithmetic or SI type.
+		 * Return std::nullopt if socket is nil or is not in the snapshot.
+		 */
+		template<class Value>
+			[[nodiscard]]
+			std::optional<Value>
+			get (ModuleOut<Value> const&) const;
+	};
+
   private:
 	static constexpr std::size_t	kMaxProcessingTimesBackLog	= 1000;
 	static constexpr float			kLatencyFactorLogThreshold	= 2.0f;
+	static constexpr std::size_t	kCycleStatsQueueSize		= 1024;
+	static constexpr si::Time		kStatsCollectionInterval	= 100_ms;
 
     using Modules = std::vector<Module*>;
 
+	/**
+	 * Timing statistics of a single cycle.
+	 */
+	struct CycleStats
+	{
+		si::Time	communication_time	{ 0_s };
+		si::Time	processing_time		{ 0_s };
+		si::Time	latency				{ 0_s };
+	};
+
+	/**
+	 * State of a single cycle processed on the WorkPerformer.
+	 */
+	struct ParallelRun
+	{
+		// Counted down once for each node of the execution plan, even if processing failed:
+		std::latch			all_done;
+		std::atomic<bool>	failed		{ false };
+		// First exception thrown by any of the nodes, rethrown after all_done is reached:
+		std::exception_ptr	exception;
+
+		// Ctor
+		explicit
+		ParallelRun (std::size_t nodes):
+			all_done (static_cast<std::ptrdiff_t> (nodes))
+		{ }
+
+		/**
+		 * Record exception. Only the first one is kept.
+		 */
+		void
+		fail (std::exception_ptr const exception_ptr)
+		{
+			if (!failed.exchange (true, std::memory_order_acq_rel))
+				exception = exception_ptr;
+		}
+	};
+
   public:
 	// Ctor
 	explicit
@@ -73,9 +188,15 @@ class ProcessingLoop:
 	ProcessingLoop&
 	operator= (ProcessingLoop&&) = delete;
 
+	// Dtor
+	~ProcessingLoop();
+
 	/**
 	 * Register a module in the processing loop. The module must be destroyed
 	 * before loop is destroyed.
+	 *
+	 * \throws	InvalidCall
+	 *			If the loop is running on the real-time thread, which reads the list of modules without locking.
 	 */
     void
     register_module (Module&);
@@ -93,14 +214,76 @@ class ProcessingLoop:
 	void
 	stop();
 
+	/**
+	 * Use given WorkPerformer to process independent modules in parallel.
+	 * Pass nullptr to go back to the deterministic serial mode (the default).
+	 *
+	 * If modules have dependency loops, they will be processed recursively anyway.
+	 * In parallel mode all data dependencies between modules must be expressed by connections
+	 * to ModuleIns, since modules that read other sockets directly might race with their sources.
+	 * The WorkPerformer must outlive the processing loop or be reset before it's destroyed.
+	 */
+	void
+	set_work_performer (WorkPerformer*);
+
+	/**
+	 * Drive the loop from a dedicated thread instead of a QTimer. The thread sleeps until absolute
+	 * deadlines on CLOCK_MONOTONIC, so that the period doesn't drift. Must be called before start().
+	 *
+	 * Since modules will be processed outside of the Qt thread, other threads must not read
+	 * module sockets directly; they should use results() instead. Any other data shared with GUI
+	 * must be protected by the modules themselves. Because of that start() throws InvalidCall
+	 * if any of the registered modules is an Instrument.
+	 */
+	void
+	use_real_time_thread (RealTimeSettings const& = {});
+
+	/**
+	 * Return true if the loop is driven by the real-time thread.
+	 */
+	[[nodiscard]]
+	bool
+	uses_real_time_thread() const noexcept
+		{ return _real_time_settings.has_value(); }
+
+	/**
+	 * Return values of output sockets published at the end of the most recent cycle
+	 * executed on the real-time thread. Never blocks the real-time thread.
+	 * The reference stays valid until the next call. Call only from one thread, usually the Qt thread.
+	 * Nothing is published if the loop isn't driven by the real-time thread.
+	 */
+	[[nodiscard]]
+	Results const&
+	results() noexcept
+		{ return _results.read(); }
+
+	/**
+	 * If enabled, sockets written during a cycle get Cycle::update_time() as their modification
+	 * timestamp, instead of reading the clock on each write. Sockets with
+	 * BasicSocket::precise_timestamps() enabled still read the clock.
+	 * Disabled by default.
+	 */
+	void
+	use_cycle_time_for_sockets (bool enabled) noexcept
+		{ _cycle_time_for_sockets = enabled; }
+
 	/**
 	 * Return current processing cycle, if called during a processing cycle.
-	 * Otherwise return nullptr.
+	 * Otherwise return nullptr. Call only from the thread that executes cycles;
+	 * other threads can use current_cycle_number().
 	 */
 	[[nodiscard]]
 	Cycle const*
 	current_cycle() const;
 
+	/**
+	 * Return number of the cycle being executed or std::nullopt between cycles.
+	 * Safe to call from any thread.
+	 */
+	[[nodiscard]]
+	std::optional<Cycle::Number>
+	current_cycle_number() const noexcept;
+
 	/**
 	 * Processing cycle period.
 	 */
@@ -161,13 +344,105 @@ class ProcessingLoop:
 	std::optional<std::string>
 	logger_tag() const override;
 
+  private:
+	/**
+	 * Process modules in order of registration, resolving dependencies recursively
+	 * by fetching input sockets. Works even if modules have dependency loops.
+	 */
+	void
+	process_recursively (Cycle const&);
+
+	/**
+	 * Process modules one by one in the topological order of the execution plan.
+	 */
+	void
+	process_serially (Cycle const&);
+
+	/**
+	 * Process modules on the WorkPerformer, respecting dependencies from the execution plan.
+	 */
+	void
+	process_in_parallel (Cycle const&);
+
+	/**
+	 * Fetch inputs and process module of given execution plan node.
+	 */
+	void
+	process_node (ExecutionPlan::Node const&, Cycle const&);
+
+	/**
+	 * Process module at given node of the execution plan and schedule dependent nodes
+	 * that became ready. Once any node failed, remaining nodes are only counted down,
+	 * without processing.
+	 */
+	void
+	process_node_in_parallel (std::size_t node_index, Cycle const&, ParallelRun&);
+
+	/**
+	 * Submit processing of given node to the WorkPerformer. If that fails, count the node
+	 * and its dependents down on the calling thread, so that the cycle always completes.
+	 */
+	void
+	submit_node (std::size_t node_index, Cycle const&, ParallelRun&);
+
+	/**
+	 * Rebuild the execution plan if it doesn't exist or is outdated.
+	 */
+	void
+	ensure_execution_plan();
+
+	/**
+	 * Store cycle statistics in buffers. If called from the real-time thread,
+	 * statistics are queued and moved to the buffers later on the Qt thread.
+	 */
+	void
+	record_cycle_stats (CycleStats const&);
+
+	/**
+	 * Serialize values of all output sockets into the triple buffer and publish them.
+	 */
+	void
+	publish_results (Cycle const&);
+
+	/**
+	 * Move queued statistics from the real-time thread to the buffers.
+	 */
+	void
+	collect_cycle_stats();
+
+	/**
+	 * Body of the real-time thread.
+	 */
+	void
+	real_time_thread_loop (std::stop_token);
+
+	/**
+	 * Apply scheduling policy and CPU affinity to the calling thread.
+	 */
+	void
+	configure_real_time_thread();
+
   private:
 	QTimer*								_loop_timer;
+	QTimer*								_stats_timer;
+	std::optional<RealTimeSettings>		_real_time_settings;
+	std::jthread						_real_time_thread;
+	SPSCQueue<CycleStats, kCycleStatsQueueSize>
+										_cycle_stats_queue;
+	TripleBuffer<Results>				_results;
 	si::Time							_loop_period;
 	std::optional<Timestamp>			_previous_timestamp;
 	std::vector<Module*>				_uninitialized_modules;
 	std::optional<Cycle>				_current_cycle;
+	// Copy of the current cycle number for other threads, 0 between cycles:
+	std::atomic<Cycle::Number>			_current_cycle_number	{ 0 };
 	Modules                             _modules;
+	WorkPerformer*						_work_performer			{ nullptr };
+	bool								_cycle_time_for_sockets	{ false };
+	std::optional<ExecutionPlan>		_execution_plan;
+	// Per-node counters of dependencies not yet processed in the current cycle:
+	std::vector<std::atomic<std::size_t>>
+										_pending_dependencies;
 	boost::circular_buffer<si::Time>	_communication_times	{ kMaxProcessingTimesBackLog };
 	boost::circular_buffer<si::Time>	_processing_times		{ kMaxProcessingTimesBackLog };
 	boost::circular_buffer<si::Time>	_processing_latencies	{ kMaxProcessingTimesBackLog };
@@ -176,11 +451,33 @@ class ProcessingLoop:
 };
 
 
+template<class Value>
+	inline std::optional<Value>
+	ProcessingLoop::Results::get (ModuleOut<Value> const& socket) const
+	{
+		if (auto blob = value_of (socket); blob && !blob->empty() && (*blob)[0] == detail::not_nil)
+		{
+			using neutrino::parse;
+			using neutrino::si::parse;
+
+			blob->remove_prefix (1);
+			return parse<Value> (*blob);
+		}
+		else
+			return std::nullopt;
+	}
+
+
 inline void
 ProcessingLoop::register_module (Module& module)
 {
+	// Modules and the execution plan are read by the real-time thread without locking:
+	if (_real_time_thread.joinable())
+		throw InvalidCall ("ProcessingLoop::register_module() called while the real-time thread is running");
+
     _modules.push_back (&module);
     _uninitialized_modules.push_back (&module);
+	_execution_plan.reset();
 }
 
 
@@ -192,6 +489,16 @@ ProcessingLoop::current_cycle() const
 		: nullptr;
 }
 
+
+inline std::optional<Cycle::Number>
+ProcessingLoop::current_cycle_number() const noexcept
+{
+	if (auto const number = _current_cycle_number.load (std::memory_order_relaxed); number != 0)
+		return number;
+	else
+		return std::nullopt;
+}
+
 } // namespace xf
 
 #endif
@@ -27,7 +27,11 @@
 #include <neutrino/utility.h>
 
 // Standard:
+#include <atomic>
 #include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
 
 
 namespace xf {
@@ -35,6 +39,11 @@ namespace xf {
 /**
  * A value holder.
  *
+ * By default modification timestamps are taken from TimeHelper::now() on each write. Code that sets up
+ * a CycleTimeScope (ProcessingLoop does that if asked with use_cycle_time_for_sockets()) makes writes on
+ * the current thread use the cycle's update time instead, which avoids reading the clock on every write.
+ * Sockets that really need precise per-write timestamps can opt out with set_precise_timestamps().
+ *
  * TODO Note: perhaps the *_age() methods should not use the timestamp of the set() call, but some timestamp provided from
  * outside, eg. some souce data sampling timestamp. That would be more proper from digital signal processing
  * perspective, but I guess it's OK enough as it is now.
@@ -53,6 +62,30 @@ class BasicSocket:
 	// Used to tell if node value has changed:
 	typedef uint64_t Serial;
 
+	/**
+	 * While an object of this class exists, socket timestamps set on the current thread
+	 * are taken from the given time instead of the clock (except for sockets with
+	 * precise timestamps enabled). Scopes can be nested.
+	 */
+	class CycleTimeScope: private Noncopyable
+	{
+	  public:
+		// Ctor
+		explicit
+		CycleTimeScope (si::Time cycle_time) noexcept:
+			_previous_time (_cycle_time)
+		{
+			_cycle_time = cycle_time;
+		}
+
+		// Dtor
+		~CycleTimeScope()
+			{ _cycle_time = _previous_time; }
+
+	  private:
+		std::optional<si::Time>	_previous_time;
+	};
+
   public:
 	// Ctor
 	BasicSocket();
@@ -69,6 +102,15 @@ class BasicSocket:
 	void
 	fetch (Cycle const&);
 
+	/**
+	 * Mark the socket as already fetched in given cycle, so that subsequent calls to fetch()
+	 * in the same cycle are no-ops. Used by ProcessingLoop when it knows that the data source
+	 * has already been computed.
+	 */
+	void
+	mark_fetched (Cycle const& cycle) noexcept
+		{ _fetched_cycle_number = cycle.number(); }
+
 	/**
 	 * Set no data source for this socket.
 	 */
@@ -114,6 +156,19 @@ class BasicSocket:
 	serial() const noexcept
 		{ return _serial; }
 
+	/**
+	 * Return true if value of this socket may be out of date, that is if the data source
+	 * of this socket, or of any socket further up the chain of data sources, changed its
+	 * value or was reconnected since it was last fetched.
+	 * Meaningful only for sockets that get their values by fetching (like ModuleIns),
+	 * not for ModuleOuts.
+	 *
+	 * Sources mark their targets when their value changes, so this doesn't need to fetch anything.
+	 */
+	[[nodiscard]]
+	bool
+	source_changed() const noexcept;
+
 	/**
 	 * Return timestamp of the value (time when it was modified).
 	 */
@@ -128,7 +183,7 @@ class BasicSocket:
 	[[nodiscard]]
 	si::Time
 	modification_age() const noexcept
-		{ return TimeHelper::now() - modification_timestamp(); }
+		{ return current_time() - modification_timestamp(); }
 
 	/**
 	 * Return timestamp of the last non-nil value.
@@ -145,7 +200,23 @@ class BasicSocket:
 	[[nodiscard]]
 	si::Time
 	valid_age() const noexcept
-		{ return TimeHelper::now() - valid_timestamp(); }
+		{ return current_time() - valid_timestamp(); }
+
+	/**
+	 * Return true if the socket always reads the clock for its timestamps, even within a CycleTimeScope.
+	 */
+	[[nodiscard]]
+	bool
+	precise_timestamps() const noexcept
+		{ return _precise_timestamps; }
+
+	/**
+	 * Make the socket always read the clock for its timestamps, even within a CycleTimeScope.
+	 * Use for sockets that need exact time of the write, eg. sensor data used for differentiation.
+	 */
+	void
+	set_precise_timestamps (bool enabled) noexcept
+		{ _precise_timestamps = enabled; }
 
 	/**
 	 * Number of sockets reading value from this socket.
@@ -155,6 +226,47 @@ class BasicSocket:
 	readers_count() const noexcept
 		{ return _targets.size(); }
 
+	/**
+	 * Return socket that this socket reads its value from, or nullptr if there's none
+	 * (eg. constant value or no data source).
+	 */
+	[[nodiscard]]
+	virtual BasicSocket*
+	data_source() const noexcept
+		{ return nullptr; }
+
+	/**
+	 * Return all sockets that this socket reads its value from. By default it's just the data_source().
+	 * Sockets that combine values of several other sockets must override this, so that ExecutionPlan
+	 * knows about all modules they depend on.
+	 */
+	[[nodiscard]]
+	virtual std::vector<BasicSocket*>
+	data_sources() const
+	{
+		if (auto* source = data_source())
+			return { source };
+		else
+			return {};
+	}
+
+	/**
+	 * Global serial number that changes every time any connection between sockets changes
+	 * or a module socket is registered or unregistered. Lets ProcessingLoop know when to rebuild
+	 * its ExecutionPlan.
+	 */
+	[[nodiscard]]
+	static Serial
+	connections_serial() noexcept
+		{ return _connections_serial.load (std::memory_order_relaxed); }
+
+	/**
+	 * Change the connections_serial().
+	 */
+	static void
+	connections_changed() noexcept
+		{ _connections_serial.fetch_add (1, std::memory_order_relaxed); }
+
 	/**
 	 * Return true if Blob returned by to_blob() is constant size.
 	 */
@@ -192,6 +304,31 @@ class BasicSocket:
 	virtual Blob
 	to_blob() const = 0;
 
+	/**
+	 * Return size of the serialized value, that is size of the Blob that to_blob()
+	 * would return for the current value.
+	 */
+	[[nodiscard]]
+	virtual size_t
+	blob_size() const = 0;
+
+	/**
+	 * Serialize socket's value, including nil-flag, at the end of given Blob.
+	 * Doesn't allocate if the Blob already has enough capacity, so the same Blob
+	 * can be reused for every cycle.
+	 */
+	virtual void
+	append_to (Blob&) const = 0;
+
+	/**
+	 * Serialize socket's value, including nil-flag, into a caller-provided buffer.
+	 * Return number of bytes written, equal to blob_size().
+	 * \throw	InvalidBlobSize
+	 *			If buffer is smaller than blob_size().
+	 */
+	virtual size_t
+	write_to (std::span<Blob::value_type>) const = 0;
+
 	/**
 	 * True if currently held nil value was caused by exception
 	 * thrown by source socket when fetching data from it.
@@ -213,8 +350,7 @@ class BasicSocket:
 	 * Increase use-count of this socket (listener started listening to value of this socket).
 	 */
 	void
-	inc_readers_count (BasicSocket* listener)
-		{ _targets.push_back (listener); }
+	inc_readers_count (BasicSocket* listener);
 
 	/**
 	 * Decrease use-count of this socket (listener stopped listening to value of this socket).
@@ -228,6 +364,13 @@ class BasicSocket:
 	virtual void
 	protected_set_nil() = 0;
 
+	/**
+	 * Increase serial number and mark all targets as having a changed source.
+	 * Call whenever the value changes.
+	 */
+	void
+	value_changed() noexcept;
+
 	/**
 	 * Set the nil-by-fetch-exception flag.
 	 */
@@ -235,13 +378,34 @@ class BasicSocket:
 	set_nil_by_fetch_exception (bool value)
 		{ _nil_by_fetch_exception = value; }
 
+	/**
+	 * Return time to use for timestamps: time of the current CycleTimeScope, if there's one
+	 * and precise timestamps are not enabled, or the current time otherwise.
+	 */
+	[[nodiscard]]
+	si::Time
+	current_time() const noexcept
+	{
+		if (_cycle_time && !_precise_timestamps)
+			return *_cycle_time;
+		else
+			return TimeHelper::now();
+	}
+
   private:
+	static inline std::atomic<Serial>	_connections_serial		{ 0 };
+	static inline thread_local std::optional<si::Time>
+										_cycle_time;
+
 	si::Time					_modification_timestamp	= 0_s;
 	si::Time					_valid_timestamp		= 0_s;
 	Serial						_serial					= 0;
 	Cycle::Number				_fetched_cycle_number	= 0;
 	std::vector<BasicSocket*>	_targets;
 	bool						_nil_by_fetch_exception = false;
+	bool						_precise_timestamps		= false;
+	// Set by the data source when it changes, reset when fetched:
+	bool						_source_changed			= true;
 };
 
 
@@ -267,13 +431,51 @@ BasicSocket::fetch (Cycle const& cycle)
 	{
 		_fetched_cycle_number = cycle.number();
 		do_fetch (cycle);
+		// Changes made by sources while fetching are already reflected in the fetched value:
+		_source_changed = false;
 	}
 }
 
 
+inline bool
+BasicSocket::source_changed() const noexcept
+{
+	if (_source_changed)
+		return true;
+
+	// Sockets at the start of the chain are not fetched, so skip them:
+	for (auto const* socket = data_source(); socket && socket->data_source(); socket = socket->data_source())
+		if (socket->_source_changed)
+			return true;
+
+	return false;
+}
+
+
+inline void
+BasicSocket::value_changed() noexcept
+{
+	++_serial;
+
+	for (auto* target: _targets)
+		target->_source_changed = true;
+}
+
+
+inline void
+BasicSocket::inc_readers_count (BasicSocket* listener)
+{
+	_targets.push_back (listener);
+	listener->_source_changed = true;
+	connections_changed();
+}
+
+
 inline void
 BasicSocket::dec_readers_count (BasicSocket* listener)
 {
+	connections_changed();
+	listener->_source_changed = true;
 	auto new_end = std::remove (_targets.begin(), _targets.end(), listener);
 	_targets.resize (neutrino::to_unsigned (std::distance (_targets.begin(), new_end)));
 }
@@ -17,6 +17,7 @@
 // Xefis:
 #include <xefis/config/all.h>
 #include <xefis/core/sockets/constant_source.h>
+#include <xefis/core/sockets/inline_transformer.h>
 #include <xefis/core/sockets/socket.h>
 
 // Neutrino:
@@ -29,6 +30,10 @@
 
 namespace xf {
 
+template<class pObservedValue, class pAssignedValue, class pFunction>
+	class TransformingSocket;
+
+
 /**
  * A Socket that can use other sockets and constant values as data source.
  */
@@ -74,6 +79,11 @@ template<class pObservedValue, class pAssignedValue = pObservedValue>
 		void
 		operator<< (NoDataSource) override;
 
+		// BasicSocket API
+		[[nodiscard]]
+		BasicSocket*
+		data_source() const noexcept override;
+
 		/**
 		 * Set non-owned Socket as a data source for this socket.
 		 */
@@ -139,11 +149,31 @@ template<class pObservedValue, class pAssignedValue = pObservedValue>
 			ConnectableSocket<AssignedValue, FunctionArgument>&
 			operator<< (std::function<std::optional<AssignedValue> (std::optional<FunctionArgument>)> const&);
 
+		/**
+		 * Set a function to be data source for this socket.
+		 * Return a reference to a new Socket that wraps the provided function and can be further chained.
+		 * The function is not type-erased and can be inlined by the compiler; prefer this over std::function
+		 * for simple transformations like unit conversions or clamping.
+		 */
+		template<class Function>
+			requires (std::is_convertible_v<typename InlineTransformer<Function>::Result, std::optional<AssignedValue>>)
+			TransformingSocket<AssignedValue, typename InlineTransformer<Function>::Value, Function>&
+			operator<< (InlineTransformer<Function>);
+
 	  protected:
 		// BasicSocket API
 		void
 		do_fetch (Cycle const&) override;
 
+		/**
+		 * Fetch data from the source and pass it through given transform function,
+		 * which must be callable with std::optional<AssignedValue> const& and return std::optional<ObservedValue>.
+		 * Used by do_fetch() implementations.
+		 */
+		template<class TransformFunction>
+			void
+			fetch_and_transform (Cycle const&, TransformFunction&&);
+
 		/**
 		 * Transform argument with the internal transformer function.
 		 */
@@ -160,8 +190,9 @@ template<class pObservedValue, class pAssignedValue = pObservedValue>
 		/**
 		 * Fetch data from given socket.
 		 */
-		void
-		fetch_from_socket (Socket<AssignedValue>&, Cycle const&);
+		template<class TransformFunction>
+			void
+			fetch_from_socket (Socket<AssignedValue>&, Cycle const&, TransformFunction&);
 
 	  private:
 		SourceVariant				_source;
@@ -202,6 +233,27 @@ template<class OV, class AV>
 	}
 
 
+template<class OV, class AV>
+	inline BasicSocket*
+	ConnectableSocket<OV, AV>::data_source() const noexcept
+	{
+		return std::visit (overload {
+			[&] (std::monostate) noexcept -> BasicSocket* {
+				return nullptr;
+			},
+			[&] (ConstantSource<AssignedValue> const&) noexcept -> BasicSocket* {
+				return nullptr;
+			},
+			[&] (Socket<AssignedValue>* socket) noexcept -> BasicSocket* {
+				return socket;
+			},
+			[&] (std::unique_ptr<Socket<AssignedValue>> const& socket) noexcept -> BasicSocket* {
+				return socket.get();
+			}
+		}, _source);
+	}
+
+
 template<class OV, class AV>
 	template<template<class> class SocketType>
 		requires (std::is_base_of_v<Socket<AV>, SocketType<AV>>)
@@ -287,46 +339,71 @@ template<class OV, class AV>
 		}
 
 
+template<class OV, class AV>
+	template<class Function>
+		requires (std::is_convertible_v<typename InlineTransformer<Function>::Result, std::optional<AV>>)
+		inline TransformingSocket<AV, typename InlineTransformer<Function>::Value, Function>&
+		ConnectableSocket<OV, AV>::operator<< (InlineTransformer<Function> transformer)
+		{
+			using Transforming = TransformingSocket<AssignedValue, typename InlineTransformer<Function>::Value, Function>;
+
+			auto u = std::make_unique<Transforming> (std::move (transformer.function));
+			auto b = std::unique_ptr<Socket<AssignedValue>> (static_cast<Socket<AssignedValue>*> (u.release()));
+			return static_cast<Transforming&> (*this << std::move (b));
+		}
+
+
 template<class OV, class AV>
 	inline void
 	ConnectableSocket<OV, AV>::do_fetch (Cycle const& cycle)
 	{
-		bool thrown = false;
-		this->set_nil_by_fetch_exception (false);
+		fetch_and_transform (cycle, [this] (std::optional<AssignedValue> const& value) {
+			return transform (value);
+		});
+	}
 
-		auto const execute = [&] {
-			std::visit (overload {
-				[&] (std::monostate) {
-					this->protected_set_nil();
-				},
-				[&] (ConstantSource<AssignedValue>& constant_source) {
-					this->protected_set (transform (constant_source.value));
-				},
-				[&] (Socket<AssignedValue>* socket) {
-					fetch_from_socket (*socket, cycle);
-				},
-				[&] (std::unique_ptr<Socket<AssignedValue>>& socket) {
-					fetch_from_socket (*socket, cycle);
-				}
-			}, _source);
-		};
 
-		if (auto const* logger = connectable_socket_fetch_exception_logger())
-			thrown = Exception::catch_and_log (*logger, execute);
-		else
+template<class OV, class AV>
+	template<class TransformFunction>
+		inline void
+		ConnectableSocket<OV, AV>::fetch_and_transform (Cycle const& cycle, TransformFunction&& transform_function)
 		{
-			try {
-				execute();
-			}
-			catch (...)
+			bool thrown = false;
+			this->set_nil_by_fetch_exception (false);
+
+			auto const execute = [&] {
+				std::visit (overload {
+					[&] (std::monostate) {
+						this->protected_set_nil();
+					},
+					[&] (ConstantSource<AssignedValue>& constant_source) {
+						this->protected_set (transform_function (constant_source.value));
+					},
+					[&] (Socket<AssignedValue>* socket) {
+						fetch_from_socket (*socket, cycle, transform_function);
+					},
+					[&] (std::unique_ptr<Socket<AssignedValue>>& socket) {
+						fetch_from_socket (*socket, cycle, transform_function);
+					}
+				}, _source);
+			};
+
+			if (auto const* logger = connectable_socket_fetch_exception_logger())
+				thrown = Exception::catch_and_log (*logger, execute);
+			else
 			{
-				thrown = true;
+				try {
+					execute();
+				}
+				catch (...)
+				{
+					thrown = true;
+				}
 			}
-		}
 
-		if (thrown)
-			this->set_nil_by_fetch_exception (true);
-	}
+			if (thrown)
+				this->set_nil_by_fetch_exception (true);
+		}
 
 
 template<class OV, class AV>
@@ -406,23 +483,29 @@ template<class OV, class AV>
 
 
 template<class OV, class AV>
-	inline void
-	ConnectableSocket<OV, AV>::fetch_from_socket (Socket<AssignedValue>& socket, Cycle const& cycle)
-	{
-		socket.fetch (cycle);
+	template<class TransformFunction>
+		inline void
+		ConnectableSocket<OV, AV>::fetch_from_socket (Socket<AssignedValue>& socket, Cycle const& cycle, TransformFunction& transform_function)
+		{
+			socket.fetch (cycle);
 
-		auto const source_value = socket.get_optional();
-		auto const transformed_value = transform (source_value);
+			auto const source_value = socket.get_optional();
+			std::optional<ObservedValue> const transformed_value = transform_function (source_value);
 
-		this->protected_set (transformed_value);
+			this->protected_set (transformed_value);
 
-		// If both before and after transformation results are nil, then also
-		// propagate the nil-by-exception flag:
-		if (!source_value && !transformed_value)
-			this->set_nil_by_fetch_exception (socket.nil_by_fetch_exception());
-	}
+			// If both before and after transformation results are nil, then also
+			// propagate the nil-by-exception flag:
+			if (!source_value && !transformed_value)
+				this->set_nil_by_fetch_exception (socket.nil_by_fetch_exception());
+		}
 
 } // namespace xf
 
+
+// TransformingSocket derives from ConnectableSocket and must be complete where
+// operator<< (InlineTransformer) gets instantiated:
+#include <xefis/core/sockets/transforming_socket.h>
+
 #endif
 
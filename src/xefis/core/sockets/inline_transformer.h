@@ -0,0 +1,102 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__CORE__SOCKETS__INLINE_TRANSFORMER_H__INCLUDED
+#define XEFIS__CORE__SOCKETS__INLINE_TRANSFORMER_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/utility/is_optional.h>
+
+// Standard:
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+
+namespace xf::detail {
+
+template<class>
+	struct TransformerSignature;
+
+
+template<class pResult, class pArgument>
+	struct TransformerSignature<std::function<pResult (pArgument)>>
+	{
+		using Result = pResult;
+		using Argument = std::remove_cvref_t<pArgument>;
+	};
+
+
+template<class T>
+	struct RemoveOptional
+	{
+		using type = T;
+	};
+
+
+template<class T>
+	struct RemoveOptional<std::optional<T>>
+	{
+		using type = T;
+	};
+
+} // namespace xf::detail
+
+
+namespace xf {
+
+/**
+ * Wrapper for a function (usually a lambda) to be used as a transformer in
+ * a chain of sockets, eg.:
+ *
+ *   module.input << xf::InlineTransformer ([](si::Angle a) { return 2.0 * a; }) << other_module.output;
+ *
+ * Unlike with std::function transformers, the concrete type of the function is kept
+ * in the TransformingSocket created for it, so the call gets inlined into the socket's
+ * fetch code instead of going through a variant and a type-erased call.
+ *
+ * The function must take exactly one argument: either Value or std::optional<Value>.
+ * If it takes Value, nil values are not passed to it and result in nil.
+ * It must return either the target socket's value or an std::optional of it.
+ */
+template<class pFunction>
+	class InlineTransformer
+	{
+	  public:
+		using Function	= pFunction;
+		using Signature	= detail::TransformerSignature<decltype (std::function (std::declval<Function>()))>;
+		using Result	= typename Signature::Result;
+		using Argument	= typename Signature::Argument;
+		// Value type of the socket that provides data to the function:
+		using Value		= typename detail::RemoveOptional<Argument>::type;
+
+		// True if the function wants to see nil values:
+		static constexpr bool kTakesOptional = is_optional_v<Argument>;
+
+	  public:
+		// Ctor
+		explicit
+		InlineTransformer (Function function):
+			function (std::move (function))
+		{ }
+
+		Function function;
+	};
+
+} // namespace xf
+
+#endif
+
@@ -30,6 +30,7 @@
 
 // Standard:
 #include <cstddef>
+#include <span>
 
 
 namespace xf {
@@ -162,6 +163,19 @@ template<class pValue>
 		Blob
 		to_blob() const override;
 
+		// BasicSocket API
+		[[nodiscard]]
+		size_t
+		blob_size() const override;
+
+		// BasicSocket API
+		void
+		append_to (Blob&) const override;
+
+		// BasicSocket API
+		size_t
+		write_to (std::span<Blob::value_type>) const override;
+
 	  protected:
 		// BasicSocket API
 		void
@@ -258,10 +272,10 @@ template<class V>
 	{
 		if (_fallback_value != fallback_value)
 		{
-			_modification_timestamp = TimeHelper::now();
+			_modification_timestamp = this->current_time();
 			_valid_timestamp = _modification_timestamp;
 			_fallback_value = fallback_value;
-			++_serial;
+			this->value_changed();
 		}
 	}
 
@@ -306,15 +320,39 @@ template<class V>
 	}
 
 
+template<class V>
+	inline size_t
+	Socket<V>::blob_size() const
+	{
+		return SocketTraits<Value>::blob_size (*this);
+	}
+
+
+template<class V>
+	inline void
+	Socket<V>::append_to (Blob& blob) const
+	{
+		SocketTraits<Value>::append_to (*this, blob);
+	}
+
+
+template<class V>
+	inline size_t
+	Socket<V>::write_to (std::span<Blob::value_type> const output) const
+	{
+		return SocketTraits<Value>::write_to (*this, output);
+	}
+
+
 template<class V>
 	inline void
 	Socket<V>::protected_set_nil()
 	{
 		if (_value)
 		{
-			_modification_timestamp = TimeHelper::now();
+			_modification_timestamp = this->current_time();
 			_value.reset();
-			++_serial;
+			this->value_changed();
 		}
 	}
 
@@ -347,10 +385,10 @@ template<class V>
 	{
 		if (!_value || *_value != value)
 		{
-			_modification_timestamp = TimeHelper::now();
+			_modification_timestamp = this->current_time();
 			_valid_timestamp = _modification_timestamp;
 			_value = value;
-			++_serial;
+			this->value_changed();
 		}
 	}
 
@@ -24,10 +24,15 @@
 #include <neutrino/string.h>
 
 // Standard:
+#include <algorithm>
+#include <bit>
 #include <charconv>
 #include <cstddef>
+#include <cstring>
 #include <concepts>
 #include <format>
+#include <optional>
+#include <span>
 #include <string>
 #include <utility>
 
@@ -58,22 +63,83 @@ template<class AssignableSocketType, class Value>
 	assign (AssignableSocketType& socket, Value&& value);
 
 
+/**
+ * Throw InvalidBlobSize if output buffer is smaller than required.
+ */
+inline void
+verify_output_size (std::span<Blob::value_type> const output, size_t const required_size)
+{
+	if (output.size() < required_size)
+		throw InvalidBlobSize (output.size(), required_size);
+}
+
+
+/**
+ * Write bytes of an arithmetic value in little-endian order (same as neutrino::to_blob() does).
+ * Output must have at least sizeof (Value) bytes.
+ */
 template<class Value>
-	inline Blob
-	apply_generic_to_blob (Socket<Value> const& socket, size_t constant_blob_size)
+	inline void
+	write_little_endian (Value const value, Blob::value_type* const output) noexcept
 	{
-		Blob result (constant_blob_size, 0);
-		result[0] = socket ? not_nil : nil;
+		std::memcpy (output, &value, sizeof (value));
 
-		if (socket)
-		{
-			using neutrino::to_blob;
-			using neutrino::si::to_blob;
+		if constexpr (std::endian::native == std::endian::big)
+			std::reverse (output, output + sizeof (value));
+	}
+
+
+/**
+ * Write value prefixed with the nil-flag byte. If value is empty, the rest of the
+ * output is filled with zeros. BlobSize is known at compile time, so for arithmetic
+ * values this compiles down to a couple of stores.
+ */
+template<size_t BlobSize, class Value>
+	inline size_t
+	write_nil_prefixed (std::optional<Value> const& value, std::span<Blob::value_type> const output)
+	{
+		static_assert (BlobSize == 1 + sizeof (Value));
+
+		verify_output_size (output, BlobSize);
 
-			Blob converted = to_blob (*socket);
-			std::copy (converted.begin(), converted.end(), std::next (result.begin()));
+		if (value)
+		{
+			output[0] = not_nil;
+			write_little_endian (*value, output.data() + 1);
+		}
+		else
+		{
+			output[0] = nil;
+			std::fill_n (output.data() + 1, BlobSize - 1, Blob::value_type (0));
 		}
 
+		return BlobSize;
+	}
+
+
+/**
+ * Append blob_size() bytes to the blob and serialize socket there.
+ * Doesn't allocate if blob has enough capacity.
+ */
+template<class Traits, class Value>
+	inline void
+	apply_generic_append_to (Socket<Value> const& socket, Blob& blob)
+	{
+		auto const offset = blob.size();
+		blob.resize (offset + Traits::blob_size (socket));
+		Traits::write_to (socket, std::span (blob).subspan (offset));
+	}
+
+
+/**
+ * Serialize socket into a new Blob of exactly blob_size() bytes.
+ */
+template<class Traits, class Value>
+	inline Blob
+	apply_generic_to_blob (Socket<Value> const& socket)
+	{
+		Blob result (Traits::blob_size (socket));
+		Traits::write_to (socket, result);
 		return result;
 	}
 
@@ -215,33 +281,41 @@ template<class Enum>
 			return std::nullopt;
 		}
 
-		static inline Blob
-		to_blob (Socket<Enum> const& socket)
+		static constexpr size_t
+		blob_size (Socket<Enum> const&)
+		{
+			return constant_blob_size();
+		}
+
+		static inline size_t
+		write_to (Socket<Enum> const& socket, std::span<Blob::value_type> const output)
 		{
-			Blob result (constant_blob_size(), 0);
+			using Integer = std::underlying_type_t<Enum>;
 
 			if constexpr (EnumWithNilValue<Enum>)
 			{
-				if (socket)
-					result = to_blob (static_cast<std::underlying_type_t<Enum>> (*socket));
-				else
-					result = to_blob (static_cast<std::underlying_type_t<Enum>> (Enum::xf_nil_value));
+				detail::verify_output_size (output, constant_blob_size());
+				auto const value = socket ? *socket : Enum::xf_nil_value;
+				detail::write_little_endian (static_cast<Integer> (value), output.data());
+				return constant_blob_size();
 			}
 			else
 			{
-				result[0] = socket ? detail::not_nil : detail::nil;
-
-				if (socket)
-				{
-					using neutrino::to_blob;
-					using neutrino::si::to_blob;
-
-					Blob tmp = to_blob (static_cast<std::underlying_type_t<Enum>> (*socket));
-					std::copy (tmp.begin(), tmp.end(), std::next (result.begin()));
-				}
+				auto const value = socket ? std::optional<Integer> (static_cast<Integer> (*socket)) : std::nullopt;
+				return detail::write_nil_prefixed<constant_blob_size()> (value, output);
 			}
+		}
+
+		static inline void
+		append_to (Socket<Enum> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<EnumSocketTraits> (socket, blob);
+		}
 
-			return result;
+		static inline Blob
+		to_blob (Socket<Enum> const& socket)
+		{
+			return detail::apply_generic_to_blob<EnumSocketTraits> (socket);
 		}
 
 		static inline void
@@ -312,10 +386,28 @@ template<std::integral Integer>
 				return std::nullopt;
 		}
 
+		static constexpr size_t
+		blob_size (Socket<Integer> const&)
+		{
+			return constant_blob_size();
+		}
+
+		static inline size_t
+		write_to (Socket<Integer> const& socket, std::span<Blob::value_type> const output)
+		{
+			return detail::write_nil_prefixed<constant_blob_size()> (socket.get_optional(), output);
+		}
+
+		static inline void
+		append_to (Socket<Integer> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<IntegerSocketTraits> (socket, blob);
+		}
+
 		static inline Blob
 		to_blob (Socket<Integer> const& socket)
 		{
-			return detail::apply_generic_to_blob (socket, constant_blob_size());
+			return detail::apply_generic_to_blob<IntegerSocketTraits> (socket);
 		}
 
 		static inline void
@@ -371,16 +463,31 @@ template<std::floating_point FloatingPoint>
 				return std::nullopt;
 		}
 
+		static constexpr size_t
+		blob_size (Socket<FloatingPoint> const&)
+		{
+			return constant_blob_size();
+		}
+
+		static inline size_t
+		write_to (Socket<FloatingPoint> const& socket, std::span<Blob::value_type> const output)
+		{
+			detail::verify_output_size (output, constant_blob_size());
+			auto const value = socket ? *socket : std::numeric_limits<FloatingPoint>::quiet_NaN();
+			detail::write_little_endian (value, output.data());
+			return constant_blob_size();
+		}
+
+		static inline void
+		append_to (Socket<FloatingPoint> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<FloatingPointSocketTraits> (socket, blob);
+		}
+
 		static inline Blob
 		to_blob (Socket<FloatingPoint> const& socket)
 		{
-			using neutrino::to_blob;
-			using neutrino::si::to_blob;
-
-			if (socket)
-				return to_blob (*socket);
-			else
-				return to_blob (std::numeric_limits<FloatingPoint>::quiet_NaN());
+			return detail::apply_generic_to_blob<FloatingPointSocketTraits> (socket);
 		}
 
 		static inline void
@@ -420,6 +527,15 @@ template<class Value, class Enabled = void>
 		static inline std::optional<float128_t>
 		to_floating_point (Socket<Value> const&, SocketConversionSettings const&);
 
+		static inline size_t
+		blob_size (Socket<Value> const&);
+
+		static inline size_t
+		write_to (Socket<Value> const&, std::span<Blob::value_type>);
+
+		static inline void
+		append_to (Socket<Value> const&, Blob&);
+
 		static inline Blob
 		to_blob (Socket<Value> const&);
 
@@ -469,13 +585,35 @@ template<>
 			return std::nullopt;
 		}
 
-		static inline Blob
-		to_blob (Socket<bool> const& socket)
+		static constexpr size_t
+		blob_size (Socket<bool> const&)
+		{
+			return constant_blob_size();
+		}
+
+		static inline size_t
+		write_to (Socket<bool> const& socket, std::span<Blob::value_type> const output)
 		{
+			detail::verify_output_size (output, constant_blob_size());
+
 			if (socket)
-				return { *socket ? Blob::value_type (1) : Blob::value_type (0) };
+				output[0] = *socket ? Blob::value_type (1) : Blob::value_type (0);
 			else
-				return { 2 };
+				output[0] = 2;
+
+			return constant_blob_size();
+		}
+
+		static inline void
+		append_to (Socket<bool> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<SocketTraits<bool>> (socket, blob);
+		}
+
+		static inline Blob
+		to_blob (Socket<bool> const& socket)
+		{
+			return detail::apply_generic_to_blob<SocketTraits<bool>> (socket);
 		}
 
 		static inline void
@@ -593,18 +731,39 @@ template<>
 			return std::nullopt;
 		}
 
-		static inline Blob
-		to_blob (Socket<std::string> const& socket)
+		static inline size_t
+		blob_size (Socket<std::string> const& socket)
+		{
+			return socket ? 1 + socket->size() : 1;
+		}
+
+		static inline size_t
+		write_to (Socket<std::string> const& socket, std::span<Blob::value_type> const output)
 		{
+			auto const size = blob_size (socket);
+			detail::verify_output_size (output, size);
+
 			if (socket)
 			{
-				Blob result (1 + socket->size(), 0);
-				result[0] = detail::not_nil;
-				std::copy (socket->begin(), socket->end(), std::next (result.begin()));
-				return result;
+				output[0] = detail::not_nil;
+				std::copy (socket->begin(), socket->end(), std::next (output.begin()));
 			}
 			else
-				return { detail::nil };
+				output[0] = detail::nil;
+
+			return size;
+		}
+
+		static inline void
+		append_to (Socket<std::string> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<SocketTraits<std::string>> (socket, blob);
+		}
+
+		static inline Blob
+		to_blob (Socket<std::string> const& socket)
+		{
+			return detail::apply_generic_to_blob<SocketTraits<std::string>> (socket);
 		}
 
 		static inline void
@@ -676,10 +835,31 @@ template<class Unit>
 				return std::nullopt;
 		}
 
+		static constexpr size_t
+		blob_size (Socket<si::Quantity<Unit>> const&)
+		{
+			return constant_blob_size();
+		}
+
+		static inline size_t
+		write_to (Socket<si::Quantity<Unit>> const& socket, std::span<Blob::value_type> const output)
+		{
+			using Value = typename si::Quantity<Unit>::Value;
+
+			auto const value = socket ? std::optional<Value> (socket->value()) : std::nullopt;
+			return detail::write_nil_prefixed<constant_blob_size()> (value, output);
+		}
+
+		static inline void
+		append_to (Socket<si::Quantity<Unit>> const& socket, Blob& blob)
+		{
+			detail::apply_generic_append_to<SocketTraits> (socket, blob);
+		}
+
 		static inline Blob
 		to_blob (Socket<si::Quantity<Unit>> const& socket)
 		{
-			return detail::apply_generic_to_blob (socket, constant_blob_size());
+			return detail::apply_generic_to_blob<SocketTraits> (socket);
 		}
 
 		static inline void
@@ -20,10 +20,15 @@
 // Neutrino:
 #include <neutrino/demangle.h>
 #include <neutrino/test/auto_test.h>
+#include <neutrino/time_helper.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 #include <memory>
+#include <optional>
+#include <span>
 #include <sstream>
 #include <string>
 #include <type_traits>
@@ -207,6 +212,70 @@ template<class T, template<class> class AnySocket>
 	}
 
 
+template<class T, template<class> class AnySocket>
+	void
+	test_buffer_serialization (AnySocket<T> const& socket, Blob const& serialized)
+	{
+		test_asserts::verify (desc_type<T> ("blob_size() equals size of to_blob()"),
+							  socket.blob_size() == serialized.size());
+
+		Blob appended = { 0xff };
+		appended.reserve (1 + socket.blob_size());
+		auto const capacity = appended.capacity();
+		socket.append_to (appended);
+
+		test_asserts::verify (desc_type<T> ("append_to() appends the same bytes as to_blob()"),
+							  Blob (std::next (appended.begin()), appended.end()) == serialized && appended[0] == 0xff);
+
+		test_asserts::verify (desc_type<T> ("append_to() doesn't reallocate when capacity is enough"),
+							  appended.capacity() == capacity);
+
+		Blob written (socket.blob_size(), 0xaa);
+
+		test_asserts::verify (desc_type<T> ("write_to() returns number of written bytes"),
+							  socket.write_to (written) == serialized.size());
+
+		test_asserts::verify (desc_type<T> ("write_to() writes the same bytes as to_blob()"),
+							  written == serialized);
+
+		test_asserts::verify (desc_type<T> ("write_to() throws when buffer is too small"),
+							  Exception::catch_and_log (g_null_logger, [&]{ socket.write_to (std::span (written).first (written.size() - 1)); }));
+	}
+
+
+/**
+ * Check serialization of given value against bytes produced by the original to_blob() implementation,
+ * which was written before the buffer-based write_to() and append_to().
+ */
+template<class T>
+	void
+	test_golden_serialization (std::optional<T> const& value, Blob const& golden)
+	{
+		TestEnvironment<T> env;
+
+		if (value)
+			env.out = *value;
+		else
+			env.out = xf::nil;
+
+		test_asserts::verify (desc_type<T> ("to_blob() gives golden bytes"), env.out.to_blob() == golden);
+		test_asserts::verify (desc_type<T> ("blob_size() equals size of golden bytes"), env.out.blob_size() == golden.size());
+
+		Blob appended = { 0xff };
+		env.out.append_to (appended);
+		test_asserts::verify (desc_type<T> ("append_to() appends golden bytes"),
+							  Blob (std::next (appended.begin()), appended.end()) == golden && appended[0] == 0xff);
+
+		Blob written (golden.size(), 0xaa);
+		env.out.write_to (written);
+		test_asserts::verify (desc_type<T> ("write_to() writes golden bytes"), written == golden);
+
+		env.out = xf::nil;
+		env.out.from_blob (golden);
+		test_asserts::verify (desc_type<T> ("from_blob() reads golden bytes"), env.out.get_optional() == value);
+	}
+
+
 template<class T>
 	constexpr bool
 	should_test_string_serialization()
@@ -421,6 +490,7 @@ AutoTest t5 ("xf::Socket serialization", for_all_types ([](auto value1, auto val
 			env.in << value1;
 			env.in.fetch (env.cycle += 1_s);
 			auto serialized = env.in.to_blob();
+			test_buffer_serialization (env.in, serialized);
 			env.out = value2;
 			test_asserts::verify (desc_type<T> ("to_blob(): socket == value2"), *env.out == value2);
 			env.out.from_blob (serialized);
@@ -449,6 +519,7 @@ AutoTest t5 ("xf::Socket serialization", for_all_types ([](auto value1, auto val
 			env.in << xf::no_data_source;
 			env.in.fetch (env.cycle += 1_s);
 			auto serialized = env.in.to_blob();
+			test_buffer_serialization (env.in, serialized);
 			env.out = value1;
 			test_asserts::verify (desc_type<T> ("to_blob() on nil: socket == value1"), *env.out == value1);
 			env.out.from_blob (serialized);
@@ -600,6 +671,228 @@ AutoTest t12 ("xf::ConnectableSocket expression (reactions to nil)", []{
 	test_asserts::verify ("expression transforms data properly (in5)", in5.is_nil());
 });
 
+
+AutoTest t13 ("xf::ConnectableSocket expression with InlineTransformer", []{
+	TestProcessingLoop			loop	{ 0.1_s };
+	Module						module	{ loop };
+	ModuleOut<int>				out		{ &module, "out" };
+	ModuleIn<std::string>		in		{ &module, "in" };
+	ModuleIn<int>				in_nil	{ &module, "in_nil" };
+	ModuleIn<int>				in_opt	{ &module, "in_opt" };
+	TestCycle					cycle;
+
+	in
+		<< xf::InlineTransformer ([](int const value) { return std::to_string (value) + "abc"; })
+		<< xf::InlineTransformer ([](int const value) { return std::clamp (value, 0, 50); })
+		<< out;
+	in_nil << xf::InlineTransformer ([](int const value) { return value * 2; }) << out;
+	in_opt << xf::InlineTransformer ([](std::optional<int> const value) { return value.value_or (-1); }) << out;
+
+	out = 77;
+	cycle += 1_s;
+	in.fetch (cycle);
+	in_nil.fetch (cycle);
+	in_opt.fetch (cycle);
+	test_asserts::verify ("expression transforms data properly", *in == "50abc");
+	test_asserts::verify ("function taking Value gets called on non-nil", *in_nil == 154);
+	test_asserts::verify ("function taking std::optional gets called on non-nil", *in_opt == 77);
+
+	out = xf::nil;
+	cycle += 1_s;
+	in.fetch (cycle);
+	in_nil.fetch (cycle);
+	in_opt.fetch (cycle);
+	test_asserts::verify ("nil passes through functions taking Value", in.is_nil() && in_nil.is_nil());
+	test_asserts::verify ("function taking std::optional gets called on nil", *in_opt == -1);
+});
+
+
+AutoTest t14 ("xf::BasicSocket::source_changed()", []{
+	TestProcessingLoop			loop	{ 0.1_s };
+	Module						module	{ loop };
+	ModuleOut<int>				out		{ &module, "out" };
+	ModuleIn<int>				in		{ &module, "in" };
+	ModuleIn<int>				chained	{ &module, "chained" };
+	TestCycle					cycle;
+
+	in << out;
+	chained << xf::InlineTransformer ([](int const value) { return value + 1; }) << out;
+
+	test_asserts::verify ("source changed after connecting", in.source_changed() && chained.source_changed());
+
+	out = 1;
+	in.fetch (cycle += 1_s);
+	chained.fetch (cycle);
+	test_asserts::verify ("source not changed after fetching", !in.source_changed() && !chained.source_changed());
+
+	out = 1;
+	test_asserts::verify ("writing the same value doesn't mark targets", !in.source_changed() && !chained.source_changed());
+
+	out = 2;
+	test_asserts::verify ("writing new value marks targets (also through transforming sockets)", in.source_changed() && chained.source_changed());
+
+	in.fetch (cycle += 1_s);
+	chained.fetch (cycle);
+	test_asserts::verify ("fetched values are correct", *in == 2 && *chained == 3);
+	test_asserts::verify ("source not changed after fetching again", !in.source_changed() && !chained.source_changed());
+
+	in << xf::no_data_source;
+	test_asserts::verify ("disconnecting marks socket as changed", in.source_changed());
+});
+
+
+AutoTest t15 ("xf::BasicSocket timestamps from CycleTimeScope", []{
+	class Writer: public Module
+	{
+	  public:
+		ModuleOut<int>	out			{ this, "out" };
+		ModuleOut<int>	precise_out	{ this, "precise_out" };
+
+	  public:
+		using Module::Module;
+
+		void
+		process (Cycle const& cycle) override
+		{
+			// Value must change, otherwise timestamps are not updated:
+			out = static_cast<int> (cycle.number());
+			precise_out = static_cast<int> (cycle.number());
+		}
+	};
+
+	TestProcessingLoop loop (0.1_s);
+	Writer writer (loop);
+	writer.precise_out.set_precise_timestamps (true);
+
+	auto const clock_reading = [] (auto& socket) {
+		auto const before = TimeHelper::now();
+		socket = socket.value_or (0) + 1;
+		auto const after = TimeHelper::now();
+		return before <= socket.modification_timestamp() && socket.modification_timestamp() <= after;
+	};
+
+	test_asserts::verify ("without CycleTimeScope timestamps come from the clock", clock_reading (writer.out));
+
+	{
+		BasicSocket::CycleTimeScope const scope (1234_s);
+		writer.out = 1000;
+		test_asserts::verify ("within CycleTimeScope timestamp is the cycle time", writer.out.modification_timestamp() == 1234_s);
+		test_asserts::verify ("socket with precise timestamps reads the clock within CycleTimeScope", clock_reading (writer.precise_out));
+	}
+
+	test_asserts::verify ("clock is used again after CycleTimeScope ends", clock_reading (writer.out));
+
+	// TestProcessingLoop runs cycles at 0.1 s, 0.2 s, … which is far from the real clock:
+	loop.next_cycle();
+	test_asserts::verify ("ProcessingLoop doesn't use cycle time for sockets by default",
+						  writer.out.modification_timestamp() > 1_s);
+
+	loop.use_cycle_time_for_sockets (true);
+	loop.next_cycle();
+	test_asserts::verify ("ProcessingLoop uses cycle time for sockets when enabled",
+						  writer.out.modification_timestamp() == 0.2_s);
+	test_asserts::verify ("ProcessingLoop doesn't override precise timestamps",
+						  writer.precise_out.modification_timestamp() > 1_s);
+});
+
+
+AutoTest t16 ("xf::Socket serialization matches golden bytes", []{
+	// Integers are little-endian, prefixed with the nil-flag byte:
+	test_golden_serialization<bool> (true, { 0x01 });
+	test_golden_serialization<bool> (false, { 0x00 });
+	test_golden_serialization<bool> (std::nullopt, { 0x02 });
+	test_golden_serialization<int8_t> (120, { 0x01, 0x78 });
+	test_golden_serialization<int8_t> (-5, { 0x01, 0xfb });
+	test_golden_serialization<int8_t> (std::nullopt, { 0x00, 0x00 });
+	test_golden_serialization<int16_t> (1337, { 0x01, 0x39, 0x05 });
+	test_golden_serialization<int16_t> (-5, { 0x01, 0xfb, 0xff });
+	test_golden_serialization<int32_t> (1337, { 0x01, 0x39, 0x05, 0x00, 0x00 });
+	test_golden_serialization<int32_t> (std::nullopt, { 0x00, 0x00, 0x00, 0x00, 0x00 });
+	test_golden_serialization<int64_t> (-5, { 0x01, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff });
+	test_golden_serialization<uint8_t> (133, { 0x01, 0x85 });
+	test_golden_serialization<uint16_t> (1337, { 0x01, 0x39, 0x05 });
+	test_golden_serialization<uint32_t> (1337, { 0x01, 0x39, 0x05, 0x00, 0x00 });
+	test_golden_serialization<uint64_t> (1337, { 0x01, 0x39, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+	test_golden_serialization<uint64_t> (std::nullopt, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+	// Floating-point values are little-endian IEEE 754, with quiet NaN as nil:
+	test_golden_serialization<float16_t> (0.125f16, { 0x00, 0x30 });
+	test_golden_serialization<float32_t> (0.125f, { 0x00, 0x00, 0x00, 0x3e });
+	test_golden_serialization<float32_t> (std::nullopt, { 0x00, 0x00, 0xc0, 0x7f });
+	test_golden_serialization<float64_t> (0.125, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x3f });
+	test_golden_serialization<float64_t> (std::nullopt, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0x7f });
+	// Strings are prefixed with the nil-flag byte:
+	test_golden_serialization<std::string> ("abc", { 0x01, 'a', 'b', 'c' });
+	test_golden_serialization<std::string> ("", { 0x01 });
+	test_golden_serialization<std::string> (std::nullopt, { 0x00 });
+	// Quantities are serialized like their double values, prefixed with the nil-flag byte:
+	test_golden_serialization<si::Length> (1.15_m, { 0x01, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0xf2, 0x3f });
+	test_golden_serialization<si::Length> (-2.5_m, { 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0xc0 });
+	test_golden_serialization<si::Length> (std::nullopt, { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 });
+	// Enums without Nil value are serialized like their underlying integers:
+	test_golden_serialization<TestEnum> (TestEnum::Value2, { 0x01, 0x01, 0x00, 0x00, 0x00 });
+	test_golden_serialization<TestEnum> (std::nullopt, { 0x00, 0x00, 0x00, 0x00, 0x00 });
+});
+
+
+AutoTest t17 ("xf::Module: pure modules skip processing when inputs didn't change", []{
+	class PureModule: public Module
+	{
+	  public:
+		ModuleIn<int>		in1				{ this, "in1" };
+		ModuleIn<int>		in2				{ this, "in2" };
+		ModuleOut<double>	out				{ this, "out" };
+		std::size_t			process_count	{ 0 };
+
+	  public:
+		explicit
+		PureModule (ProcessingLoop& loop):
+			Module (loop)
+		{
+			set_pure (true);
+		}
+
+		void
+		process (Cycle const&) override
+		{
+			++process_count;
+			out = in1.value_or (0) / 3.0 + in2.value_or (0);
+		}
+	};
+
+	TestProcessingLoop loop (0.1_s);
+	Module source (loop);
+	ModuleOut<int> source1 (&source, "source1");
+	ModuleOut<int> source2 (&source, "source2");
+	PureModule pure (loop);
+
+	pure.in1 << source1;
+	pure.in2 << source2;
+	source1 = 1;
+	source2 = 2;
+
+	loop.next_cycle();
+	test_asserts::verify ("pure module is processed in the first cycle", pure.process_count == 1);
+	auto const out_blob = pure.out.to_blob();
+	auto const out_timestamp = pure.out.modification_timestamp();
+
+	loop.next_cycles (3);
+	test_asserts::verify ("pure module is not processed when inputs didn't change", pure.process_count == 1);
+	test_asserts::verify ("output is bit-identical", pure.out.to_blob() == out_blob);
+	test_asserts::verify ("output isn't rewritten", pure.out.modification_timestamp() == out_timestamp);
+
+	source1 = 1;
+	loop.next_cycle();
+	test_asserts::verify ("writing the same value doesn't cause processing", pure.process_count == 1);
+
+	source2 = 5;
+	loop.next_cycle();
+	test_asserts::verify ("pure module is processed when one input changed", pure.process_count == 2);
+	test_asserts::verify ("output is updated", *pure.out == 1 / 3.0 + 5);
+
+	loop.next_cycle();
+	test_asserts::verify ("pure module is skipped again afterwards", pure.process_count == 2);
+});
+
 } // namespace
 } // namespace xf::test
 
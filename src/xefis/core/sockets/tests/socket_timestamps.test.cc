@@ -0,0 +1,92 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/core/cycle.h>
+#include <xefis/core/sockets/module_socket.h>
+#include <xefis/core/sockets/tests/test_cycle.h>
+#include <xefis/test/test_processing_loop.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+constexpr std::size_t kSockets	= 500;
+constexpr std::size_t kCycles	= 2000;
+
+
+/**
+ * Write all sockets kCycles times and return average time per write.
+ */
+si::Time
+measure_writes (std::vector<std::unique_ptr<ModuleOut<double>>>& sockets, bool use_cycle_time)
+{
+	TestCycle cycle;
+
+	auto const total = TimeHelper::measure ([&] {
+		for (std::size_t c = 0; c < kCycles; ++c)
+		{
+			cycle += 1_ms;
+
+			std::optional<BasicSocket::CycleTimeScope> cycle_time_scope;
+
+			if (use_cycle_time)
+				cycle_time_scope.emplace (cycle.update_time());
+
+			// Value must change, otherwise timestamps are not updated:
+			for (auto& socket: sockets)
+				*socket = static_cast<double> (c);
+		}
+	});
+
+	return total / static_cast<double> (kSockets * kCycles);
+}
+
+
+ManualTest t_1 ("xf::Socket: cost of a write with clock and cycle-time timestamps", []{
+	TestProcessingLoop loop (1_ms);
+	Module module (loop);
+	std::vector<std::unique_ptr<ModuleOut<double>>> sockets;
+
+	for (std::size_t i = 0; i < kSockets; ++i)
+		sockets.push_back (std::make_unique<ModuleOut<double>> (&module, std::format ("out/{}", i)));
+
+	auto const with_clock = measure_writes (sockets, false);
+	auto const with_cycle_time = measure_writes (sockets, true);
+
+	for (auto& socket: sockets)
+		socket->set_precise_timestamps (true);
+
+	auto const with_precise_opt_in = measure_writes (sockets, true);
+
+	std::cout << std::format ("Socket writes ({} sockets × {} cycles):\n", kSockets, kCycles);
+	std::cout << std::format ("  TimeHelper::now() timestamps:          {:.2f} ns/write\n", with_clock.in<si::Second>() * 1e9);
+	std::cout << std::format ("  Cycle::update_time() timestamps:       {:.2f} ns/write\n", with_cycle_time.in<si::Second>() * 1e9);
+	std::cout << std::format ("  cycle time, but precise opt-in:        {:.2f} ns/write\n", with_precise_opt_in.in<si::Second>() * 1e9);
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -0,0 +1,107 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/core/cycle.h>
+#include <xefis/core/sockets/module_socket.h>
+#include <xefis/core/sockets/tests/test_cycle.h>
+#include <xefis/test/test_processing_loop.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+// 1000 chains × 10 transforming sockets = 10k chained sockets:
+constexpr std::size_t kChains		= 1000;
+constexpr std::size_t kChainLength	= 10;
+constexpr std::size_t kCycles		= 1000;
+
+
+double
+clamped_conversion (double const value)
+{
+	return std::clamp (value * 1.852, -1000.0, 1000.0);
+}
+
+
+/**
+ * Fetch all inputs kCycles times and return average time per fetch of a single transforming socket.
+ */
+si::Time
+measure_fetches (ModuleOut<double>& output, std::vector<std::unique_ptr<ModuleIn<double>>>& inputs)
+{
+	TestCycle cycle;
+
+	auto const total = TimeHelper::measure ([&] {
+		for (std::size_t c = 0; c < kCycles; ++c)
+		{
+			output = static_cast<double> (c);
+			cycle += 1_ms;
+
+			for (auto& input: inputs)
+				input->fetch (cycle);
+		}
+	});
+
+	return total / static_cast<double> (kChains * kChainLength * kCycles);
+}
+
+
+ManualTest t_1 ("xf::ConnectableSocket: fetch cost of std::function vs. InlineTransformer for 10k chained sockets", []{
+	TestProcessingLoop loop (1_ms);
+	Module module (loop);
+	ModuleOut<double> output (&module, "output");
+	std::vector<std::unique_ptr<ModuleIn<double>>> std_function_inputs;
+	std::vector<std::unique_ptr<ModuleIn<double>>> inline_inputs;
+
+	for (std::size_t i = 0; i < kChains; ++i)
+	{
+		auto& std_function_input = *std_function_inputs.emplace_back (std::make_unique<ModuleIn<double>> (&module, std::format ("std_function/{}", i)));
+		auto& inline_input = *inline_inputs.emplace_back (std::make_unique<ModuleIn<double>> (&module, std::format ("inline/{}", i)));
+		ConnectableSocket<double>* std_function_tail = &std_function_input;
+		ConnectableSocket<double>* inline_tail = &inline_input;
+
+		for (std::size_t k = 0; k < kChainLength; ++k)
+		{
+			std_function_tail = &(*std_function_tail << std::function<double (double)> (clamped_conversion));
+			inline_tail = &(*inline_tail << xf::InlineTransformer ([](double const value) { return clamped_conversion (value); }));
+		}
+
+		*std_function_tail << output;
+		*inline_tail << output;
+	}
+
+	auto const with_std_function = measure_fetches (output, std_function_inputs);
+	auto const with_inline_transformer = measure_fetches (output, inline_inputs);
+
+	std::cout << std::format ("Socket fetches ({} chains × {} transforming sockets × {} cycles):\n", kChains, kChainLength, kCycles);
+	std::cout << std::format ("  std::function transformers:   {:.2f} ns/socket\n", with_std_function.in<si::Second>() * 1e9);
+	std::cout << std::format ("  InlineTransformer:            {:.2f} ns/socket\n", with_inline_transformer.in<si::Second>() * 1e9);
+});
+
+} // namespace
+} // namespace xf::test
+
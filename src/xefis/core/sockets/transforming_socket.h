@@ -0,0 +1,84 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__CORE__SOCKETS__TRANSFORMING_SOCKET_H__INCLUDED
+#define XEFIS__CORE__SOCKETS__TRANSFORMING_SOCKET_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/core/sockets/connectable_socket.h>
+#include <xefis/core/sockets/inline_transformer.h>
+
+// Standard:
+#include <cstddef>
+#include <optional>
+#include <utility>
+
+
+namespace xf {
+
+/**
+ * A ConnectableSocket that transforms values fetched from its data source
+ * with a function of known type (see InlineTransformer).
+ * Created by ConnectableSocket::operator<< (InlineTransformer<Function>).
+ */
+template<class pObservedValue, class pAssignedValue, class pFunction>
+	class TransformingSocket final: public ConnectableSocket<pObservedValue, pAssignedValue>
+	{
+	  public:
+		using ObservedValue	= pObservedValue;
+		using AssignedValue	= pAssignedValue;
+		using Function		= pFunction;
+
+	  public:
+		// Ctor
+		explicit
+		TransformingSocket (Function function):
+			_function (std::move (function))
+		{ }
+
+	  protected:
+		// BasicSocket API
+		void
+		do_fetch (Cycle const& cycle) override
+		{
+			this->fetch_and_transform (cycle, [this] (std::optional<AssignedValue> const& value) {
+				return call_function (value);
+			});
+		}
+
+	  private:
+		std::optional<ObservedValue>
+		call_function (std::optional<AssignedValue> const&);
+
+	  private:
+		Function _function;
+	};
+
+
+template<class OV, class AV, class F>
+	inline std::optional<OV>
+	TransformingSocket<OV, AV, F>::call_function (std::optional<AssignedValue> const& value)
+	{
+		if constexpr (InlineTransformer<Function>::kTakesOptional)
+			return _function (value);
+		else if (value)
+			return _function (*value);
+		else
+			return std::nullopt;
+	}
+
+} // namespace xf
+
+#endif
+
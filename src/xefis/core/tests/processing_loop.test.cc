@@ -0,0 +1,317 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/core/execution_plan.h>
+#include <xefis/core/module.h>
+#include <xefis/core/sockets/connectable_socket.h>
+#include <xefis/core/sockets/module_socket.h>
+#include <xefis/test/test_processing_loop.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+#include <neutrino/work_performer.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+constexpr std::size_t	kNetworkSize	= 24;
+constexpr std::size_t	kCycles			= 10;
+
+
+/**
+ * Module that computes output from its inputs and cycle number, optionally
+ * logging order of processing.
+ */
+class TestModule: public Module
+{
+  public:
+	ModuleIn<int64_t>	input_a	{ this, "input_a" };
+	ModuleIn<int64_t>	input_b	{ this, "input_b" };
+	ModuleOut<int64_t>	output	{ this, "output" };
+
+  public:
+	explicit
+	TestModule (ProcessingLoop& loop, std::string_view const instance, int64_t const seed = 1, std::vector<std::string>* processing_log = nullptr):
+		Module (loop, instance),
+		_seed (seed),
+		_processing_log (processing_log)
+	{ }
+
+	void
+	process (Cycle const& cycle) override
+	{
+		if (_processing_log)
+			_processing_log->push_back (instance());
+
+		output = (input_a.value_or (0) * 3 + input_b.value_or (0) + _seed * static_cast<int64_t> (cycle.number())) % 1'000'003;
+	}
+
+  private:
+	int64_t						_seed;
+	std::vector<std::string>*	_processing_log;
+};
+
+
+/**
+ * Socket that forwards its data source and also depends on another socket,
+ * the way sockets combining values of several sockets do.
+ */
+template<class Value>
+	class CombiningSocket: public ConnectableSocket<Value>
+	{
+	  public:
+		explicit
+		CombiningSocket (BasicSocket& other_source):
+			_other_source (other_source)
+		{ }
+
+		// BasicSocket API
+		std::vector<BasicSocket*>
+		data_sources() const override
+		{
+			auto sources = ConnectableSocket<Value>::data_sources();
+			sources.push_back (&_other_source);
+			return sources;
+		}
+
+	  private:
+		BasicSocket& _other_source;
+	};
+
+
+/**
+ * Module that throws from process().
+ */
+class ThrowingModule: public Module
+{
+  public:
+	ModuleOut<int64_t>	output	{ this, "output" };
+
+  public:
+	using Module::Module;
+
+	void
+	process (Cycle const&) override
+	{
+		throw std::runtime_error ("test exception");
+	}
+};
+
+
+/**
+ * Modules connected into an acyclic graph where each module reads modules registered after it,
+ * so that order of registration is reverse to the order of dependencies.
+ */
+class TestNetwork
+{
+  public:
+	TestProcessingLoop							loop	{ 0.01_s };
+	std::vector<std::unique_ptr<TestModule>>	modules;
+
+  public:
+	explicit
+	TestNetwork()
+	{
+		for (std::size_t i = 0; i < kNetworkSize; ++i)
+			modules.push_back (std::make_unique<TestModule> (loop, "module " + std::to_string (i), static_cast<int64_t> (i + 1)));
+
+		for (std::size_t i = 0; i < kNetworkSize; ++i)
+		{
+			if (auto const a = i + 1 + i % 3; a < kNetworkSize)
+				modules[i]->input_a << modules[a]->output;
+
+			if (auto const b = i + 2 + i % 5; b < kNetworkSize)
+				modules[i]->input_b << modules[b]->output;
+		}
+	}
+
+	std::vector<std::optional<int64_t>>
+	outputs() const
+	{
+		std::vector<std::optional<int64_t>> result;
+
+		for (auto const& module: modules)
+			result.push_back (module->output.get_optional());
+
+		return result;
+	}
+};
+
+
+AutoTest t1 ("xf::ExecutionPlan topological order", []{
+	TestProcessingLoop loop (0.01_s);
+	std::vector<std::string> processing_log;
+	// Registered in reverse order of data flow:
+	TestModule c (loop, "c", 1, &processing_log);
+	TestModule b (loop, "b", 1, &processing_log);
+	TestModule a (loop, "a", 1, &processing_log);
+	// Not connected to anything:
+	TestModule d (loop, "d", 1, &processing_log);
+
+	c.input_a << b.output;
+	c.input_b << a.output;
+	b.input_a << a.output;
+
+	ExecutionPlan const plan ({ &c, &b, &a, &d });
+	auto const& nodes = plan.nodes();
+	auto const& order = plan.topological_order();
+
+	test_asserts::verify ("plan is acyclic", plan.acyclic());
+	test_asserts::verify ("all nodes are in topological order", order.size() == 4);
+	test_asserts::verify ("dependencies are counted", nodes[0].dependencies_count == 2 && nodes[1].dependencies_count == 1 &&
+													  nodes[2].dependencies_count == 0 && nodes[3].dependencies_count == 0);
+
+	auto const position = [&order] (std::size_t const node) {
+		return std::find (order.begin(), order.end(), node) - order.begin();
+	};
+
+	test_asserts::verify ("a comes before b", position (2) < position (1));
+	test_asserts::verify ("b comes before c", position (1) < position (0));
+
+	loop.next_cycle();
+	auto const processed = [&processing_log] (std::string const& instance) {
+		return std::find (processing_log.begin(), processing_log.end(), instance) - processing_log.begin();
+	};
+
+	test_asserts::verify ("each module is processed once", processing_log.size() == 4);
+	test_asserts::verify ("modules are processed in topological order", processed ("a") < processed ("b") && processed ("b") < processed ("c"));
+});
+
+
+AutoTest t2 ("xf::ProcessingLoop falls back to recursive processing on dependency loops", []{
+	TestProcessingLoop loop (0.01_s);
+	std::vector<std::string> processing_log;
+	TestModule a (loop, "a", 1, &processing_log);
+	TestModule b (loop, "b", 1, &processing_log);
+	TestModule c (loop, "c", 1, &processing_log);
+
+	a.input_a << b.output;
+	b.input_a << a.output;
+	c.input_a << b.output;
+
+	ExecutionPlan const plan ({ &a, &b, &c });
+	test_asserts::verify ("plan is not acyclic", !plan.acyclic());
+
+	for (std::size_t cycle = 1; cycle <= 3; ++cycle)
+	{
+		processing_log.clear();
+		loop.next_cycle();
+		test_asserts::verify ("each module is processed exactly once per cycle", processing_log.size() == 3);
+		test_asserts::verify ("outputs are computed", a.output && b.output && c.output);
+	}
+});
+
+
+AutoTest t3 ("xf::ProcessingLoop serial and parallel processing give the same results", []{
+	WorkPerformer work_performer (4, TestProcessingLoop::logger);
+	TestNetwork serial;
+	TestNetwork parallel;
+	parallel.loop.set_work_performer (&work_performer);
+
+	for (std::size_t cycle = 1; cycle <= kCycles; ++cycle)
+	{
+		serial.loop.next_cycle();
+		parallel.loop.next_cycle();
+		test_asserts::verify ("outputs are equal in cycle " + std::to_string (cycle), serial.outputs() == parallel.outputs());
+	}
+
+	test_asserts::verify ("outputs are computed", serial.modules.front()->output.valid());
+});
+
+
+AutoTest t4 ("xf::ProcessingLoop parallel cycle completes when a module throws", []{
+	WorkPerformer work_performer (2, TestProcessingLoop::logger);
+	TestProcessingLoop loop (0.01_s);
+	ThrowingModule thrower (loop, "thrower");
+	TestModule dependent (loop, "dependent");
+	TestModule independent (loop, "independent");
+
+	dependent.input_a << thrower.output;
+	loop.set_work_performer (&work_performer);
+
+	for (std::size_t cycle = 1; cycle <= 3; ++cycle)
+	{
+		loop.next_cycle();
+		test_asserts::verify ("output of the throwing module is nil", thrower.output.is_nil());
+		test_asserts::verify ("dependent module is processed with nil input", *dependent.output == static_cast<int64_t> (cycle));
+		test_asserts::verify ("independent module is processed", *independent.output == static_cast<int64_t> (cycle));
+	}
+});
+
+
+AutoTest t5 ("xf::ProcessingLoop rebuilds execution plan when connections change", []{
+	TestProcessingLoop loop (0.01_s);
+	std::vector<std::string> processing_log;
+	TestModule a (loop, "a", 1, &processing_log);
+	TestModule b (loop, "b", 1, &processing_log);
+
+	b.input_a << a.output;
+
+	ExecutionPlan const plan ({ &a, &b });
+	test_asserts::verify ("new plan is not outdated", !plan.outdated());
+
+	loop.next_cycle();
+	test_asserts::verify ("a is processed before b", processing_log == std::vector<std::string> { "a", "b" });
+	test_asserts::verify ("b reads a", *a.output == 1 && *b.output == 4);
+
+	// Reverse the dependency:
+	b.input_a << xf::no_data_source;
+	test_asserts::verify ("plan is outdated after disconnecting a socket", plan.outdated());
+	a.input_a << b.output;
+
+	processing_log.clear();
+	loop.next_cycle();
+	test_asserts::verify ("b is processed before a", processing_log == std::vector<std::string> { "b", "a" });
+	test_asserts::verify ("a reads b from the same cycle", *b.output == 2 && *a.output == 8);
+});
+
+
+AutoTest t6 ("xf::ExecutionPlan follows all data sources of a socket", []{
+	TestProcessingLoop loop (0.01_s);
+	TestModule c (loop, "c");
+	TestModule b (loop, "b");
+	TestModule a (loop, "a");
+	CombiningSocket<int64_t> combining (b.output);
+
+	combining << a.output;
+	c.input_a << combining;
+
+	ExecutionPlan const plan ({ &c, &b, &a });
+	auto const& nodes = plan.nodes();
+	auto const& order = plan.topological_order();
+
+	auto const position = [&order] (std::size_t const node) {
+		return std::find (order.begin(), order.end(), node) - order.begin();
+	};
+
+	test_asserts::verify ("c depends on both a and b", nodes[0].dependencies_count == 2);
+	test_asserts::verify ("a and b come before c", position (2) < position (0) && position (1) < position (0));
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -32,8 +32,12 @@
 #include <boost/endian/conversion.hpp>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
+#include <cstring>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <random>
 
 
@@ -386,7 +390,26 @@ LinkProtocol::LinkProtocol (EnvelopeList envelopes):
 			if (e->unique_prefix().size() != _unique_prefix_size)
 				throw InvalidMagicSize();
 
-			_envelope_unique_prefixes[e->unique_prefix()] = e;
+			// Envelope defined later replaces one with the same unique prefix:
+			auto const same_prefix = std::find_if (_envelope_unique_prefixes.begin(), _envelope_unique_prefixes.end(), [&e] (auto const* other) {
+				return other->unique_prefix() == e->unique_prefix();
+			});
+
+			if (same_prefix != _envelope_unique_prefixes.end())
+				*same_prefix = e.get();
+			else
+				_envelope_unique_prefixes.push_back (e.get());
+
+			if (_unique_prefix_size > 0)
+			{
+				auto const first_byte = e->unique_prefix()[0];
+
+				if (!_is_prefix_first_byte[first_byte])
+				{
+					_is_prefix_first_byte[first_byte] = true;
+					_prefix_first_bytes.push_back (first_byte);
+				}
+			}
 		}
 	}
 }
@@ -416,80 +439,67 @@ LinkProtocol::consume (Blob::const_iterator begin,
 	logger << "Recv: " << neutrino::to_hex_string (BlobView (begin, end), ":") << std::endl;
 #endif
 
-	_aux_unique_prefix_buffer.resize (_unique_prefix_size);
+	auto const min_remaining = static_cast<Blob::difference_type> (_unique_prefix_size + 1);
 
-	while (std::distance (begin, end) > static_cast<Blob::difference_type> (_unique_prefix_size + 1))
-	{
-		auto skip_byte_and_retry = [&]() {
-			// Skip one byte and try again:
-			if (std::distance (begin, end) >= 1)
-				++begin;
+	auto skip_bytes = [&] (Blob::const_iterator const new_begin) {
+		auto const skipped = std::distance (begin, new_begin);
+		begin = new_begin;
 
+		if (skipped > 0)
+		{
 			if (input_link)
-				input_link->link_error_bytes = input_link->link_error_bytes.value_or (0) + 1;
+				input_link->link_error_bytes = input_link->link_error_bytes.value_or (0) + skipped;
 
 			// Since there was an error, stop the reacquire timer:
 			if (reacquire_timer)
 				reacquire_timer->stop();
-		};
-
-		bool return_from_outer_function = false;
-		Blob::const_iterator outer_result = begin;
+		}
+	};
 
-		xf::Exception::catch_and_log (logger, [&] {
-			try {
-				// Find the right unique_prefix and envelope:
-				std::copy (begin, begin + neutrino::to_signed (_unique_prefix_size), _aux_unique_prefix_buffer.begin());
-				auto envelope_and_unique_prefix = _envelope_unique_prefixes.find (_aux_unique_prefix_buffer);
+	while (std::distance (begin, end) > min_remaining)
+	{
+		// Skip garbage up to the first byte that may start a unique prefix, but leave
+		// at least min_remaining bytes, just like skipping byte-by-byte would:
+		auto const scan_end = end - min_remaining;
+		auto const candidate = find_prefix_candidate (begin, scan_end);
+		skip_bytes (candidate);
 
-				// If not found, retry starting with next byte:
-				if (envelope_and_unique_prefix == _envelope_unique_prefixes.end())
-					throw LinkProtocol::ParseError();
+		if (candidate == scan_end)
+			break;
 
-				auto envelope = envelope_and_unique_prefix->second;
-				// Now see if we have enough data in input buffer for this envelope type.
-				// If not, return and retry when enough data is read.
-				if (neutrino::to_unsigned (std::distance (begin, end)) - _unique_prefix_size < envelope->size())
-				{
-					return_from_outer_function = true;
-					outer_result = begin;
-					return;
-				}
+		auto* envelope = find_envelope (begin);
 
-				auto e = envelope->consume (begin + neutrino::to_signed (_unique_prefix_size), end, logger);
+		// If not found, retry starting with next byte:
+		if (!envelope)
+		{
+			skip_bytes (std::next (begin));
+			continue;
+		}
 
-				if (e != begin)
-				{
-					envelope->apply();
-					begin = e;
-				}
+		// Now see if we have enough data in input buffer for this envelope type.
+		// If not, return and retry when enough data is read.
+		if (neutrino::to_unsigned (std::distance (begin, end)) - _unique_prefix_size < envelope->size())
+			return begin;
 
-				if (input_link)
-					input_link->link_valid_envelopes = input_link->link_valid_envelopes.value_or (0) + 1;
+		if (auto const envelope_end = consume_envelope (*envelope, begin + neutrino::to_signed (_unique_prefix_size), end, logger))
+		{
+			begin = *envelope_end;
 
-				// Restart failsafe timer:
-				if (failsafe_timer)
-					failsafe_timer->start();
+			if (input_link)
+				input_link->link_valid_envelopes = input_link->link_valid_envelopes.value_or (0) + 1;
 
-				// If input_link is not valid, and we got valid envelope,
-				// start reacquire timer:
-				if (reacquire_timer && input_link)
-					if (!input_link->link_valid.value_or (false) && !reacquire_timer->isActive())
-						reacquire_timer->start();
-			}
-			catch (LinkProtocol::ParseError&)
-			{
-				skip_byte_and_retry();
-			}
-			catch (...)
-			{
-				skip_byte_and_retry();
-				throw;
-			}
-		});
+			// Restart failsafe timer:
+			if (failsafe_timer)
+				failsafe_timer->start();
 
-		if (return_from_outer_function)
-			return outer_result;
+			// If input_link is not valid, and we got valid envelope,
+			// start reacquire timer:
+			if (reacquire_timer && input_link)
+				if (!input_link->link_valid.value_or (false) && !reacquire_timer->isActive())
+					reacquire_timer->start();
+		}
+		else
+			skip_bytes (std::next (begin));
 	}
 
 	return begin;
@@ -515,3 +525,70 @@ LinkProtocol::failsafe()
 		e->failsafe();
 }
 
+
+Blob::const_iterator
+LinkProtocol::find_prefix_candidate (Blob::const_iterator const begin, Blob::const_iterator const end) const
+{
+	if (begin == end || _envelope_unique_prefixes.empty())
+		return end;
+
+	// Empty prefix matches anything:
+	if (_unique_prefix_size == 0)
+		return begin;
+
+	auto const* const data = std::to_address (begin);
+	auto const length = neutrino::to_unsigned (std::distance (begin, end));
+
+	if (_prefix_first_bytes.size() <= kMaxMemchrFirstBytes)
+	{
+		// memchr() is vectorized by the C library. Each next search only needs
+		// to cover bytes before the best candidate found so far:
+		auto best_length = length;
+
+		for (auto const byte: _prefix_first_bytes)
+			if (auto const* found = static_cast<uint8_t const*> (std::memchr (data, byte, best_length)))
+				best_length = neutrino::to_unsigned (found - data);
+
+		return begin + neutrino::to_signed (best_length);
+	}
+	else
+		return std::find_if (begin, end, [this] (uint8_t const byte) { return _is_prefix_first_byte[byte]; });
+}
+
+
+LinkProtocol::Envelope*
+LinkProtocol::find_envelope (Blob::const_iterator const begin) const
+{
+	auto const* const data = std::to_address (begin);
+
+	for (auto* envelope: _envelope_unique_prefixes)
+		if (std::memcmp (data, envelope->unique_prefix().data(), _unique_prefix_size) == 0)
+			return envelope;
+
+	return nullptr;
+}
+
+
+std::optional<Blob::const_iterator>
+LinkProtocol::consume_envelope (Envelope& envelope, Blob::const_iterator const begin, Blob::const_iterator const end, xf::Logger const& logger)
+{
+	try {
+		auto const envelope_end = envelope.consume (begin, end, logger);
+		envelope.apply();
+		return envelope_end;
+	}
+	catch (ParseError&)
+	{
+		return std::nullopt;
+	}
+	catch (InsufficientDataError&)
+	{
+		return std::nullopt;
+	}
+	catch (...)
+	{
+		logger << "Could not consume envelope: " << neutrino::describe_exception (std::current_exception()) << "\n";
+		return std::nullopt;
+	}
+}
+
@@ -31,12 +31,17 @@
 
 // Standard:
 #include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
 #include <functional>
 #include <initializer_list>
 #include <limits>
 #include <optional>
 #include <random>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -54,8 +59,8 @@ class LinkProtocol
 {
   public:
 	/**
-	 * Thrown on known parse errors.
-	 * TODO use std::expect to be faster?
+	 * Thrown by sub-packets on known parse errors (eg. signature mismatch).
+	 * It never escapes consume_envelope(), so resynchronization on garbage doesn't throw.
 	 */
 	class ParseError
 	{ };
@@ -436,6 +441,240 @@ class LinkProtocol
 		Blob			_temp;
 	};
 
+	/**
+	 * Integer, floating-point or SI-value field of a Packed packet.
+	 * Encoded the same way as by Socket<Bytes, Value>.
+	 */
+	template<uint16_t pBytes, class pValue>
+		class PackedSocket
+		{
+		  public:
+			using Value		= pValue;
+			using Params	= std::conditional_t<std::integral<Value>,
+												 typename Socket<pBytes, Value>::IntegerParams,
+												 typename Socket<pBytes, Value>::FloatingPointParams>;
+
+			static constexpr std::size_t kSize { pBytes };
+
+			static_assert (std::integral<Value> || si::FloatingPointOrQuantity<Value>,
+						   "strings are only supported by LinkProtocol::Socket");
+
+		  public:
+			// Ctor
+			explicit
+			PackedSocket (xf::Socket<Value>& socket, xf::AssignableSocket<Value>* assignable_socket, Params&& params):
+				_socket (socket),
+				_assignable_socket (assignable_socket),
+				_params (std::move (params))
+			{ }
+
+			/**
+			 * Store the socket value at kSize bytes starting at data.
+			 */
+			void
+			encode (uint8_t* data) const;
+
+			/**
+			 * Load value from kSize bytes starting at data.
+			 * It will be output when apply() is called.
+			 */
+			void
+			decode (uint8_t const* data);
+
+			void
+			apply();
+
+			void
+			failsafe();
+
+		  private:
+			xf::Socket<Value>&				_socket;
+			xf::AssignableSocket<Value>*	_assignable_socket;
+			Params							_params;
+			std::optional<Value>			_value;
+		};
+
+	/**
+	 * Boolean or limited-width unsigned integer field of a PackedBitfield.
+	 * Width is known at compile time.
+	 */
+	template<uint8_t pBits, class pValue>
+		class PackedBits
+		{
+		  public:
+			using Value = pValue;
+
+			struct Params
+			{
+				bool	retained		{ false };
+				// Also used when the socket value doesn't fit in kBits:
+				Value	value_if_nil	{ };
+			};
+
+			static constexpr uint8_t kBits { pBits };
+
+			static_assert ((std::is_same_v<Value, bool> && kBits == 1) ||
+						   (std::unsigned_integral<Value> && !std::is_same_v<Value, bool> && kBits >= 1 && kBits <= std::numeric_limits<Value>::digits));
+
+		  public:
+			/**
+			 * Ctor
+			 *
+			 * \throws	xf::InvalidArgument
+			 *			If value_if_nil doesn't fit in kBits.
+			 */
+			explicit
+			PackedBits (xf::Socket<Value>& socket, xf::AssignableSocket<Value>* assignable_socket, Params&& params):
+				_socket (socket),
+				_assignable_socket (assignable_socket),
+				_params (std::move (params))
+			{
+				if (!fits_in_bits (_params.value_if_nil, kBits))
+					throw xf::InvalidArgument ("value_if_nil doesn't fit in given number of bits");
+			}
+
+			/**
+			 * Return kBits-wide value to transmit.
+			 */
+			[[nodiscard]]
+			uint_least64_t
+			encode() const
+			{
+				if (_socket && fits_in_bits (*_socket, kBits))
+					return *_socket;
+				else
+					return _params.value_if_nil;
+			}
+
+			/**
+			 * Take kBits-wide received value.
+			 * It will be output when apply() is called.
+			 */
+			void
+			decode (uint_least64_t value)
+				{ _value = static_cast<Value> (value); }
+
+			void
+			apply()
+			{
+				if (_assignable_socket)
+					*_assignable_socket = _value;
+			}
+
+			void
+			failsafe()
+			{
+				if (_assignable_socket && !_params.retained)
+					*_assignable_socket = xf::nil;
+			}
+
+		  private:
+			xf::Socket<Value>&				_socket;
+			xf::AssignableSocket<Value>*	_assignable_socket;
+			Params							_params;
+			Value							_value		{ };
+		};
+
+	/**
+	 * Field of a Packed packet made of PackedBits.
+	 * Bits are packed LSB-first and padded with zeroes to a whole byte, the same way as by Bitfield.
+	 */
+	template<class... Bits>
+		class PackedBitfield
+		{
+		  public:
+			static constexpr std::size_t kBits { (std::size_t (Bits::kBits) + ... + 0) };
+			static constexpr std::size_t kSize { (kBits + 7) / 8 };
+
+		  public:
+			// Ctor
+			explicit
+			PackedBitfield (Bits&&... bits):
+				_bits (std::move (bits)...)
+			{ }
+
+			/**
+			 * Store all bits at kSize bytes starting at data.
+			 */
+			void
+			encode (uint8_t* data) const;
+
+			/**
+			 * Load all bits from kSize bytes starting at data.
+			 * They will be output when apply() is called.
+			 */
+			void
+			decode (uint8_t const* data);
+
+			void
+			apply()
+				{ std::apply ([](auto&... bits) { (bits.apply(), ...); }, _bits); }
+
+			void
+			failsafe()
+				{ std::apply ([](auto&... bits) { (bits.failsafe(), ...); }, _bits); }
+
+		  private:
+			// Bit offsets of consecutive PackedBits:
+			static constexpr std::array<std::size_t, sizeof... (Bits)>
+			offsets()
+				{ return offsets_for (std::array<std::size_t, sizeof... (Bits)> { Bits::kBits... }); }
+
+		  private:
+
+			std::tuple<Bits...> _bits;
+		};
+
+	/**
+	 * A packet with layout known at compile time. An alternative to a Sequence of Socket and Bitfield packets:
+	 * fields are stored at constant offsets with a single resize of the output blob, with no virtual calls,
+	 * std::functions or temporary vectors per field. Produces exactly the same bytes as a Sequence of
+	 * corresponding Socket and Bitfield packets, so both sides of the link don't need to be upgraded at once.
+	 *
+	 * Fields are PackedSocket and PackedBitfield objects, see packed_socket(), packed_bitfield() and packed_bits().
+	 */
+	template<class... Fields>
+		class Packed: public Packet
+		{
+		  public:
+			static constexpr std::size_t kSize { (Fields::kSize + ... + 0) };
+
+		  public:
+			// Ctor
+			explicit
+			Packed (Fields&&... fields):
+				_fields (std::move (fields)...)
+			{ }
+
+			Blob::size_type
+			size() const override
+				{ return kSize; }
+
+			void
+			produce (Blob&, xf::Logger const&) override;
+
+			Blob::const_iterator
+			consume (Blob::const_iterator, Blob::const_iterator, xf::Logger const&) override;
+
+			void
+			apply() override
+				{ std::apply ([](auto&... fields) { (fields.apply(), ...); }, _fields); }
+
+			void
+			failsafe() override
+				{ std::apply ([](auto&... fields) { (fields.failsafe(), ...); }, _fields); }
+
+		  private:
+			// Byte offsets of consecutive fields:
+			static constexpr std::array<std::size_t, sizeof... (Fields)>
+			offsets()
+				{ return offsets_for (std::array<std::size_t, sizeof... (Fields)> { Fields::kSize... }); }
+
+		  private:
+
+			std::tuple<Fields...> _fields;
+		};
+
 	/**
 	 * A single packet containing a set of packets. Configurable how often should be sent,
 	 * also contains unique_prefix to be able to distinguish between different Envelopes
@@ -651,6 +890,51 @@ class LinkProtocol
 			};
 		}
 
+	/**
+	 * Make a packet with compile-time layout from PackedSocket and PackedBitfield fields.
+	 */
+	template<class... Fields>
+		static auto
+		packed (Fields&&... fields)
+		{
+			return std::make_shared<Packed<std::remove_cvref_t<Fields>...>> (std::forward<Fields> (fields)...);
+		}
+
+	template<uint16_t Bytes, class Value>
+		static auto
+		packed_socket (xf::Socket<Value>& socket, typename PackedSocket<Bytes, Value>::Params&& params = {})
+		{
+			return PackedSocket<Bytes, Value> (socket, nullptr, std::move (params));
+		}
+
+	template<uint16_t Bytes, class Value>
+		static auto
+		packed_socket (xf::AssignableSocket<Value>& assignable_socket, typename PackedSocket<Bytes, Value>::Params&& params = {})
+		{
+			return PackedSocket<Bytes, Value> (assignable_socket, &assignable_socket, std::move (params));
+		}
+
+	template<class... Bits>
+		static auto
+		packed_bitfield (Bits&&... bits)
+		{
+			return PackedBitfield<std::remove_cvref_t<Bits>...> (std::forward<Bits> (bits)...);
+		}
+
+	template<uint8_t Bits, class Value>
+		static auto
+		packed_bits (xf::Socket<Value>& socket, typename PackedBits<Bits, Value>::Params&& params = {})
+		{
+			return PackedBits<Bits, Value> (socket, nullptr, std::move (params));
+		}
+
+	template<uint8_t Bits, class Value>
+		static auto
+		packed_bits (xf::AssignableSocket<Value>& assignable_socket, typename PackedBits<Bits, Value>::Params&& params = {})
+		{
+			return PackedBits<Bits, Value> (assignable_socket, &assignable_socket, std::move (params));
+		}
+
 	static auto
 	signature (Signature::Params&& params)
 	{
@@ -663,16 +947,145 @@ class LinkProtocol
 		return std::make_shared<Envelope> (std::move (params));
 	}
 
+  private:
+	// Above this number of distinct first bytes of unique prefixes the input is scanned with a lookup table
+	// instead of one memchr() per byte:
+	static constexpr std::size_t kMaxMemchrFirstBytes = 4;
+
   private:
 	static constexpr bool
 	fits_in_bits (uint_least64_t value, uint8_t bits)
 		{ return value == 0 || value < xf::static_pow<uint_least64_t> (2U, bits); }
 
+	/**
+	 * Return offsets of consecutive fields of given sizes.
+	 */
+	template<std::size_t N>
+		static constexpr std::array<std::size_t, N>
+		offsets_for (std::array<std::size_t, N> const& sizes)
+		{
+			std::array<std::size_t, N> offsets {};
+			std::size_t offset = 0;
+
+			for (std::size_t i = 0; i < N; ++i)
+			{
+				offsets[i] = offset;
+				offset += sizes[i];
+			}
+
+			return offsets;
+		}
+
+	/**
+	 * Call function (element, offset) for each tuple element.
+	 */
+	template<class Tuple, std::size_t N, class Function>
+		static void
+		for_each_at_offset (Tuple& tuple, std::array<std::size_t, N> const& offsets, Function&& function)
+		{
+			[&]<std::size_t... I> (std::index_sequence<I...>) {
+				(function (std::get<I> (tuple), offsets[I]), ...);
+			} (std::make_index_sequence<N>());
+		}
+
+	/**
+	 * Store value in little-endian order.
+	 */
+	template<class Value>
+		static void
+		store_little (Value value, uint8_t* data)
+		{
+			neutrino::perhaps_native_to_little_inplace (value);
+			std::memcpy (data, &value, sizeof (value));
+		}
+
+	/**
+	 * Load value stored in little-endian order.
+	 */
+	template<class Value>
+		[[nodiscard]]
+		static Value
+		load_little (uint8_t const* data)
+		{
+			Value value;
+			std::memcpy (&value, data, sizeof (value));
+			neutrino::perhaps_little_to_native_inplace (value);
+			return value;
+		}
+
+	/**
+	 * Store bits-wide value at given bit offset. Bit n of the stream is bit n % 8 of byte n / 8.
+	 * Destination bits must be zeroed.
+	 */
+	static constexpr void
+	store_bits (uint8_t* data, std::size_t offset, std::size_t bits, uint_least64_t value)
+	{
+		for (std::size_t done = 0; done < bits; )
+		{
+			auto const shift = (offset + done) % 8;
+			auto const n = std::min<std::size_t> (8 - shift, bits - done);
+			auto const mask = static_cast<uint_least64_t> ((1u << n) - 1u);
+			data[(offset + done) / 8] |= static_cast<uint8_t> (((value >> done) & mask) << shift);
+			done += n;
+		}
+	}
+
+	/**
+	 * Load bits-wide value from given bit offset.
+	 */
+	[[nodiscard]]
+	static constexpr uint_least64_t
+	load_bits (uint8_t const* data, std::size_t offset, std::size_t bits)
+	{
+		uint_least64_t value = 0;
+
+		for (std::size_t done = 0; done < bits; )
+		{
+			auto const shift = (offset + done) % 8;
+			auto const n = std::min<std::size_t> (8 - shift, bits - done);
+			auto const mask = static_cast<uint_least64_t> ((1u << n) - 1u);
+			value |= ((data[(offset + done) / 8] >> shift) & mask) << done;
+			done += n;
+		}
+
+		return value;
+	}
+
+	/**
+	 * Return position of the first byte in [begin, end) that may start a unique prefix
+	 * (matches the first byte of any of the prefixes) or end if there's none.
+	 */
+	[[nodiscard]]
+	Blob::const_iterator
+	find_prefix_candidate (Blob::const_iterator begin, Blob::const_iterator end) const;
+
+	/**
+	 * Return envelope whose unique prefix starts at given position or nullptr.
+	 * There must be at least _unique_prefix_size bytes available.
+	 */
+	[[nodiscard]]
+	Envelope*
+	find_envelope (Blob::const_iterator begin) const;
+
+	/**
+	 * Consume and apply envelope data (without the unique prefix).
+	 * ParseError and InsufficientDataError thrown by sub-packets are swallowed here
+	 * and reported only as std::nullopt, so that the caller can resynchronize.
+	 *
+	 * \returns iterator past the envelope or std::nullopt on parse error.
+	 */
+	[[nodiscard]]
+	static std::optional<Blob::const_iterator>
+	consume_envelope (Envelope&, Blob::const_iterator begin, Blob::const_iterator end, xf::Logger const&);
+
   private:
 	std::vector<std::shared_ptr<Envelope>>		_envelopes;
-	std::map<Blob, std::shared_ptr<Envelope>>	_envelope_unique_prefixes;
+	// Envelopes with distinct unique prefixes, in order of lookup:
+	std::vector<Envelope*>						_envelope_unique_prefixes;
 	Blob::size_type								_unique_prefix_size { 0 };
-	Blob										_aux_unique_prefix_buffer;
+	// Distinct first bytes of unique prefixes and a lookup table for them:
+	std::vector<uint8_t>						_prefix_first_bytes;
+	std::array<bool, 256>						_is_prefix_first_byte {};
 };
 
 
@@ -1072,5 +1485,145 @@ template<uint16_t B, class V>
 			}
 		}
 
+
+template<uint16_t B, class V>
+	inline void
+	LinkProtocol::PackedSocket<B, V>::encode (uint8_t* const data) const
+	{
+		if constexpr (std::integral<Value>)
+		{
+			int64_t const int_value = _socket
+				? *_socket
+				: _params.value_if_nil;
+
+			store_little (static_cast<xf::int_for_width_t<kSize>> (int_value), data);
+		}
+		else if constexpr (si::is_quantity<Value>())
+		{
+			typename Value::Value const value = _socket
+				? _params.offset
+					? (*_socket - *_params.offset).base_value()
+					: (*_socket).base_value()
+				: std::numeric_limits<typename Value::Value>::quiet_NaN();
+
+			store_little (static_cast<neutrino::float_for_width_t<kSize>> (value), data);
+		}
+		else
+		{
+			Value const value = _socket
+				? _params.offset
+					? *_socket - *_params.offset
+					: *_socket
+				: std::numeric_limits<Value>::quiet_NaN();
+
+			store_little (static_cast<neutrino::float_for_width_t<kSize>> (value), data);
+		}
+	}
+
+
+template<uint16_t B, class V>
+	inline void
+	LinkProtocol::PackedSocket<B, V>::decode (uint8_t const* const data)
+	{
+		if constexpr (std::integral<Value>)
+			_value = load_little<xf::int_for_width_t<kSize>> (data);
+		else
+		{
+			auto const cast_value = load_little<neutrino::float_for_width_t<kSize>> (data);
+
+			if (std::isnan (cast_value))
+				_value.reset();
+			else if constexpr (si::is_quantity<Value>())
+				_value = Value { cast_value };
+			else
+				_value = cast_value;
+		}
+	}
+
+
+template<uint16_t B, class V>
+	inline void
+	LinkProtocol::PackedSocket<B, V>::apply()
+	{
+		if (_assignable_socket)
+		{
+			if (_value)
+			{
+				if constexpr (si::FloatingPointOrQuantity<Value>)
+				{
+					*_assignable_socket = _params.offset
+						? *_value + *_params.offset
+						: *_value;
+				}
+				else
+					*_assignable_socket = _value;
+			}
+			else if (!_params.retained)
+				*_assignable_socket = xf::nil;
+		}
+	}
+
+
+template<uint16_t B, class V>
+	inline void
+	LinkProtocol::PackedSocket<B, V>::failsafe()
+	{
+		if (_assignable_socket && !_params.retained)
+			*_assignable_socket = xf::nil;
+	}
+
+
+template<class... Bits>
+	inline void
+	LinkProtocol::PackedBitfield<Bits...>::encode (uint8_t* const data) const
+	{
+		std::fill (data, data + kSize, 0);
+
+		for_each_at_offset (_bits, offsets(), [data] (auto const& bits, std::size_t const offset) {
+			store_bits (data, offset, bits.kBits, bits.encode());
+		});
+	}
+
+
+template<class... Bits>
+	inline void
+	LinkProtocol::PackedBitfield<Bits...>::decode (uint8_t const* const data)
+	{
+		for_each_at_offset (_bits, offsets(), [data] (auto& bits, std::size_t const offset) {
+			bits.decode (load_bits (data, offset, bits.kBits));
+		});
+	}
+
+
+template<class... Fields>
+	inline void
+	LinkProtocol::Packed<Fields...>::produce (Blob& blob, xf::Logger const&)
+	{
+		auto const position = blob.size();
+		blob.resize (position + kSize);
+		auto* const data = blob.data() + position;
+
+		for_each_at_offset (_fields, offsets(), [data] (auto const& field, std::size_t const offset) {
+			field.encode (data + offset);
+		});
+	}
+
+
+template<class... Fields>
+	inline Blob::const_iterator
+	LinkProtocol::Packed<Fields...>::consume (Blob::const_iterator const begin, Blob::const_iterator const end, xf::Logger const&)
+	{
+		if (std::distance (begin, end) < static_cast<Blob::difference_type> (kSize))
+			throw InsufficientDataError();
+
+		auto const* const data = std::to_address (begin);
+
+		for_each_at_offset (_fields, offsets(), [data] (auto& field, std::size_t const offset) {
+			field.decode (data + offset);
+		});
+
+		return begin + neutrino::to_signed (kSize);
+	}
+
 #endif
 
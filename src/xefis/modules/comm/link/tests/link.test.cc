@@ -28,6 +28,8 @@
 
 // Standard:
 #include <cstddef>
+#include <format>
+#include <string_view>
 
 
 namespace xf::test {
@@ -259,6 +261,73 @@ class AirToGroundLinkProtocol: public LinkProtocol
 };
 
 
+/**
+ * Unsigned envelopes described with Socket and Bitfield packets…
+ */
+class SequenceLinkProtocol: public LinkProtocol
+{
+  public:
+	// Ctor
+	template<class IO>
+		explicit
+		SequenceLinkProtocol (IO& io):
+			LinkProtocol ({
+				envelope ({
+					.unique_prefix	= { 0x00, 0x05 },
+					.packets		= {
+						socket<8> (io.angle_prop),
+						socket<8> (io.angle_prop_r,				{ .retained = true }),
+						socket<2> (io.velocity_prop,			{ .retained = false }),
+						socket<2> (io.velocity_prop_offset,		{ .retained = false,	.offset = 1000_kph }),
+						bitfield ({
+							bitfield_socket (io.bool_prop,		{ .retained = false,	.value_if_nil = kFallbackBool }),
+							bitfield_socket (io.bool_prop_r,	{ .retained = true,		.value_if_nil = kFallbackBool }),
+							bitfield_socket (io.uint_prop,		{ .bits = 4,			.retained = false,	.value_if_nil = kFallbackInt }),
+							bitfield_socket (io.uint_prop_r,	{ .bits = 4,			.retained = true,	.value_if_nil = kFallbackInt }),
+						}),
+						socket<2> (io.int_prop,					{ .retained = false,	.value_if_nil = 0L }),
+						socket<4> (io.int_prop_r,				{ .retained = true,		.value_if_nil = 0L }),
+					},
+				}),
+			})
+		{ }
+};
+
+
+/**
+ * …and the same envelopes described with compile-time layout.
+ */
+class PackedLinkProtocol: public LinkProtocol
+{
+  public:
+	// Ctor
+	template<class IO>
+		explicit
+		PackedLinkProtocol (IO& io):
+			LinkProtocol ({
+				envelope ({
+					.unique_prefix	= { 0x00, 0x05 },
+					.packets		= {
+						packed (
+							packed_socket<8> (io.angle_prop),
+							packed_socket<8> (io.angle_prop_r,				{ .retained = true }),
+							packed_socket<2> (io.velocity_prop,				{ .retained = false }),
+							packed_socket<2> (io.velocity_prop_offset,		{ .retained = false,	.offset = 1000_kph }),
+							packed_bitfield (
+								packed_bits<1> (io.bool_prop,				{ .retained = false,	.value_if_nil = kFallbackBool }),
+								packed_bits<1> (io.bool_prop_r,				{ .retained = true,		.value_if_nil = kFallbackBool }),
+								packed_bits<4> (io.uint_prop,				{ .retained = false,	.value_if_nil = kFallbackInt }),
+								packed_bits<4> (io.uint_prop_r,				{ .retained = true,		.value_if_nil = kFallbackInt })
+							),
+							packed_socket<2> (io.int_prop,					{ .retained = false,	.value_if_nil = 0L }),
+							packed_socket<4> (io.int_prop_r,				{ .retained = true,		.value_if_nil = 0L })
+						),
+					},
+				}),
+			})
+		{ }
+};
+
 using Ground_Tx_Data = GroundToAirData<xf::ModuleIn>;
 using Ground_Rx_Data = AirToGroundData<xf::ModuleOut>;
 using Air_Tx_Data = AirToGroundData<xf::ModuleIn>;
@@ -653,6 +722,105 @@ AutoTest t6 ("modules/io/link: protocol: encrypted channel works", []{
 	test_asserts::verify ("data transmitted properly", ground_tx_data.string_prop == air_rx_data.string_prop);
 });
 
+
+AutoTest t7 ("modules/io/link: protocol: resynchronization on garbage between envelopes", []{
+	TestProcessingLoop loop (0.1_s);
+	Air_Tx_Data tx (loop);
+	Ground_Rx_Data rx (loop);
+	AirToGroundLinkProtocol tx_protocol (tx);
+	AirToGroundLinkProtocol rx_protocol (rx);
+	TestCycle cycle;
+	// Contains first bytes of unique prefixes, but no full prefix:
+	Blob const garbage = { 0xff, 0xff, 0x02, 0x13, 0xff, 0x37, 0x00, 0x01 };
+	Blob blob;
+
+	for (auto const i: { 1, 2, 3 })
+	{
+		tx.int_prop << i;
+		tx.fetch_all (cycle += 1_s);
+		blob += garbage;
+		tx_protocol.produce (blob, g_logger);
+		blob += garbage;
+	}
+
+	auto const end = rx_protocol.consume (blob.begin(), blob.end(), nullptr, nullptr, nullptr, g_logger);
+
+	test_asserts::verify ("int_prop transmitted properly", *rx.int_prop == 3);
+	// consume() needs more bytes than the unique prefix size to do anything:
+	test_asserts::verify ("garbage skipped up to the last 3 bytes", std::distance (end, blob.cend()) == 3);
+});
+
+AutoTest t8 ("modules/io/link: protocol: packed layout is compatible with sequence of packets", []{
+	TestProcessingLoop loop (0.1_s);
+	Ground_Tx_Data tx (loop);
+	Air_Rx_Data sequence_rx (loop);
+	Air_Rx_Data packed_rx (loop);
+	SequenceLinkProtocol sequence_tx_protocol (tx);
+	PackedLinkProtocol packed_tx_protocol (tx);
+	SequenceLinkProtocol sequence_rx_protocol (sequence_rx);
+	PackedLinkProtocol packed_rx_protocol (packed_rx);
+	TestCycle cycle;
+
+	test_asserts::verify ("sizes are equal", sequence_tx_protocol.size() == packed_tx_protocol.size());
+
+	auto test = [&] (std::string_view const what) {
+		tx.fetch_all (cycle += 1_s);
+
+		Blob sequence_blob;
+		Blob packed_blob;
+		sequence_tx_protocol.produce (sequence_blob, g_logger);
+		packed_tx_protocol.produce (packed_blob, g_logger);
+
+		test_asserts::verify (std::format ("produced bytes are identical ({})", what), sequence_blob == packed_blob);
+
+		// Decode each one's output with the other one:
+		sequence_rx_protocol.consume (packed_blob.begin(), packed_blob.end(), nullptr, nullptr, nullptr, g_logger);
+		packed_rx_protocol.consume (sequence_blob.begin(), sequence_blob.end(), nullptr, nullptr, nullptr, g_logger);
+
+		test_asserts::verify (std::format ("angle_prop decoded equally ({})", what), sequence_rx.angle_prop == packed_rx.angle_prop);
+		test_asserts::verify (std::format ("angle_prop_r decoded equally ({})", what), sequence_rx.angle_prop_r == packed_rx.angle_prop_r);
+		test_asserts::verify (std::format ("velocity_prop decoded equally ({})", what), sequence_rx.velocity_prop == packed_rx.velocity_prop);
+		test_asserts::verify (std::format ("velocity_prop_offset decoded equally ({})", what), sequence_rx.velocity_prop_offset == packed_rx.velocity_prop_offset);
+		test_asserts::verify (std::format ("bool_prop decoded equally ({})", what), sequence_rx.bool_prop == packed_rx.bool_prop);
+		test_asserts::verify (std::format ("bool_prop_r decoded equally ({})", what), sequence_rx.bool_prop_r == packed_rx.bool_prop_r);
+		test_asserts::verify (std::format ("uint_prop decoded equally ({})", what), sequence_rx.uint_prop == packed_rx.uint_prop);
+		test_asserts::verify (std::format ("uint_prop_r decoded equally ({})", what), sequence_rx.uint_prop_r == packed_rx.uint_prop_r);
+		test_asserts::verify (std::format ("int_prop decoded equally ({})", what), sequence_rx.int_prop == packed_rx.int_prop);
+		test_asserts::verify (std::format ("int_prop_r decoded equally ({})", what), sequence_rx.int_prop_r == packed_rx.int_prop_r);
+	};
+
+	test ("all nil");
+
+	tx.angle_prop << 1.99_rad;
+	tx.angle_prop_r << -0.5_rad;
+	tx.velocity_prop << 101_kph;
+	tx.velocity_prop_offset << 1001_kph;
+	tx.bool_prop << false;
+	tx.bool_prop_r << true;
+	tx.uint_prop << 9u;
+	tx.uint_prop_r << 3u;
+	tx.int_prop << -1234;
+	tx.int_prop_r << 123456;
+	test ("all set");
+
+	// Values that don't fit in 4 bits are sent as value_if_nil:
+	tx.uint_prop << 16u;
+	tx.int_prop << xf::no_data_source;
+	tx.angle_prop << xf::no_data_source;
+	test ("some nil");
+
+	test_asserts::verify ("packed uint_prop falls back to value_if_nil", *packed_rx.uint_prop == kFallbackInt);
+	test_asserts::verify ("packed angle_prop_r received", *packed_rx.angle_prop_r == -0.5_rad);
+	test_asserts::verify_equal_with_epsilon ("packed velocity_prop_offset received", *packed_rx.velocity_prop_offset, 1001_kph, 0.1_kph);
+
+	sequence_rx_protocol.failsafe();
+	packed_rx_protocol.failsafe();
+	test_asserts::verify ("failsafe: angle_prop is nil", !packed_rx.angle_prop);
+	test_asserts::verify ("failsafe: angle_prop_r is retained", sequence_rx.angle_prop_r == packed_rx.angle_prop_r && packed_rx.angle_prop_r);
+	test_asserts::verify ("failsafe: bool_prop is nil", !packed_rx.bool_prop);
+	test_asserts::verify ("failsafe: int_prop_r is retained", sequence_rx.int_prop_r == packed_rx.int_prop_r && packed_rx.int_prop_r);
+});
+
 } // namespace
 } // namespace xf::test
 
@@ -0,0 +1,188 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/core/sockets/tests/test_cycle.h>
+#include <xefis/core/sockets/module_in.h>
+#include <xefis/core/sockets/module_out.h>
+#include <xefis/core/module.h>
+#include <xefis/modules/comm/link/link_protocol.h>
+#include <xefis/test/test_processing_loop.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <initializer_list>
+#include <iostream>
+#include <random>
+#include <string_view>
+
+
+namespace xf::test {
+namespace {
+
+auto g_logger_output	= xf::LoggerOutput (std::clog);
+auto g_logger			= xf::Logger (g_logger_output);
+
+constexpr std::size_t	kStreamSize		= 1024 * 1024;
+// Bytes read from the radio at once:
+constexpr std::size_t	kChunkSize		= 4096;
+// Average number of garbage bytes between consecutive envelopes:
+constexpr std::size_t	kGarbageBytes	= 200;
+
+
+template<template<class> class SocketType>
+	class Data: public Module
+	{
+	  public:
+		SocketType<si::Angle>		angle		{ this, "angle" };
+		SocketType<si::Velocity>	velocity	{ this, "velocity" };
+		SocketType<int64_t>			counter		{ this, "counter" };
+		SocketType<bool>			flag		{ this, "flag" };
+
+	  public:
+		// Ctor
+		using Module::Module;
+
+		void
+		fetch_all (Cycle const& cycle)
+		{
+			std::initializer_list<BasicSocket*> const sockets = {
+				&angle,
+				&velocity,
+				&counter,
+				&flag,
+			};
+
+			for (auto* socket: sockets)
+				socket->fetch (cycle);
+		}
+	};
+
+
+class ResyncLinkProtocol: public LinkProtocol
+{
+  public:
+	// Ctor
+	template<class IO>
+		explicit
+		ResyncLinkProtocol (IO& io):
+			LinkProtocol ({
+				envelope ({
+					.unique_prefix	= { 0xaf, 0xfa },
+					.packets		= {
+						signature ({
+							.nonce_bytes		= 4,
+							.signature_bytes	= 8,
+							.key				= { 0x12, 0x34, 0x56, 0x78 },
+							.packets			= {
+								socket<8> (io.angle),
+								socket<2> (io.velocity),
+								socket<4> (io.counter),
+							},
+						}),
+					},
+				}),
+				envelope ({
+					.unique_prefix	= { 0xf6, 0x6f },
+					.packets		= {
+						socket<4> (io.counter),
+						bitfield ({
+							bitfield_socket (io.flag, { .retained = false, .value_if_nil = false }),
+						}),
+					},
+				}),
+			})
+		{ }
+};
+
+
+/**
+ * Feed the stream to the protocol in kChunkSize pieces, the way InputLink does,
+ * and print the time it took.
+ */
+void
+print_consume_stats (std::string_view const name, LinkProtocol& protocol, Blob const& stream)
+{
+	Blob input;
+	std::size_t leftover = 0;
+
+	si::Time const total = TimeHelper::measure ([&] {
+		for (std::size_t pos = 0; pos < stream.size(); pos += kChunkSize)
+		{
+			auto const chunk_end = std::min (pos + kChunkSize, stream.size());
+			input.insert (input.end(), stream.begin() + neutrino::to_signed (pos), stream.begin() + neutrino::to_signed (chunk_end));
+			auto const e = protocol.consume (input.begin(), input.end(), nullptr, nullptr, nullptr, g_logger);
+			input.erase (input.cbegin(), e);
+		}
+
+		leftover = input.size();
+	});
+
+	std::cout << std::format ("  {:40} {:9.3f} ms, {:8.1f} MB/s, {} bytes left\n",
+							  name,
+							  total.in<si::Millisecond>(),
+							  stream.size() / total.in<si::Second>() * 1e-6,
+							  leftover);
+}
+
+
+ManualTest t_1 ("modules/io/link: resynchronization on 1 MB of random bytes with interleaved envelopes", []{
+	TestProcessingLoop loop (0.1_s);
+	Data<ModuleIn> tx (loop);
+	Data<ModuleOut> rx (loop);
+	ResyncLinkProtocol tx_protocol (tx);
+	ResyncLinkProtocol rx_protocol (rx);
+	TestCycle cycle;
+	std::mt19937 rng (1);
+	std::uniform_int_distribution<uint16_t> random_byte (0, 255);
+	std::uniform_int_distribution<std::size_t> garbage_length (0, 2 * kGarbageBytes);
+
+	Blob valid_stream;
+	Blob noisy_stream;
+	std::size_t envelopes = 0;
+
+	while (noisy_stream.size() < kStreamSize)
+	{
+		for (auto n = garbage_length (rng); n > 0; --n)
+			noisy_stream.push_back (static_cast<uint8_t> (random_byte (rng)));
+
+		Blob packet;
+		cycle += 10_ms;
+		tx.angle << 1_deg * static_cast<double> (envelopes % 360);
+		tx.velocity << 1_kph * static_cast<double> (envelopes % 100);
+		tx.counter << static_cast<int64_t> (envelopes);
+		tx.flag << (envelopes % 2 == 0);
+		tx.fetch_all (cycle);
+		tx_protocol.produce (packet, g_logger);
+		valid_stream += packet;
+		noisy_stream += packet;
+		++envelopes;
+	}
+
+	noisy_stream.resize (kStreamSize);
+
+	std::cout << std::format ("{} bytes, {} envelope pairs, ~{} garbage bytes between them:\n", kStreamSize, envelopes, kGarbageBytes);
+	print_consume_stats ("valid envelopes only", rx_protocol, valid_stream);
+	print_consume_stats ("random bytes with envelopes", rx_protocol, noisy_stream);
+});
+
+} // namespace
+} // namespace xf::test
+
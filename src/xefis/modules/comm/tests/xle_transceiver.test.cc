@@ -21,13 +21,16 @@
 #include <neutrino/test/auto_test.h>
 #include <neutrino/exception_support.h>
 #include <neutrino/string.h>
+#include <neutrino/work_performer.h>
 
 // Boost:
 #include <boost/random.hpp>
 
 // Standard:
+#include <chrono>
 #include <cstddef>
 #include <format>
+#include <thread>
 
 
 namespace xf::xle_transceiver_test {
@@ -638,8 +641,56 @@ auto_test_t2()
 }
 
 
+void
+auto_test_t3()
+{
+	static auto const p1 = to_blob ("(master → slave) message");
+	static auto const p2 = to_blob ("(slave → master) message");
+
+	WorkPerformer work_performer (2, TestProcessingLoop::logger);
+	auto loop = TestProcessingLoop (0.01_s);
+	auto slave = xle::SlaveTransceiver (loop, crypto_params, [](xle::HandshakeID) { return false; }, TestProcessingLoop::logger);
+	auto master = xle::MasterTransceiver (loop, crypto_params, TestProcessingLoop::logger);
+
+	slave.handshake_request << master.handshake_request;
+	master.handshake_response << slave.handshake_response;
+	master.set_work_performer (&work_performer);
+	slave.set_work_performer (&work_performer);
+
+	// Handshake computations run in real time, so give them up to 10 s:
+	auto const cycle_until = [&] (auto const& condition) {
+		for (int i = 0; i < 1000 && !condition(); ++i)
+		{
+			loop.next_cycles (1);
+			std::this_thread::sleep_for (std::chrono::milliseconds (10));
+		}
+
+		return condition();
+	};
+
+	for (size_t session_number = 0; session_number < 3; ++session_number)
+	{
+		auto const p = std::format ("session {}: ", session_number);
+		auto const [session_prepared, session_activated] = master.start_handshake();
+
+		test_asserts::verify (p + "session gets prepared", cycle_until ([&] { return is_ready (session_prepared); }));
+		session_prepared.get();
+		test_asserts::verify (p + "master reports handshake latency", master.handshake_latency.valid());
+		test_asserts::verify (p + "slave reports handshake latency", slave.handshake_latency.valid());
+
+		auto const d1 = slave.decrypt_packet (master.encrypt_packet (p1));
+		auto const d2 = master.decrypt_packet (slave.encrypt_packet (p2));
+
+		test_asserts::verify (p + "encryption master → slave works correctly", p1 == d1);
+		test_asserts::verify (p + "encryption slave → master works correctly", p2 == d2);
+		test_asserts::verify (p + "session gets activated", is_ready (session_activated));
+	}
+}
+
+
 AutoTest t1 ("Xefis Lossy Encryption/Protocol: handshaking gives correct keys", AutoTestT1::auto_test_t1);
 AutoTest t2 ("Xefis Lossy Encryption/Protocol: handshaking eventually works even on lossy channel", auto_test_t2);
+AutoTest t3 ("Xefis Lossy Encryption/Protocol: handshakes computed on WorkPerformer", auto_test_t3);
 
 } // namespace xf::xle_transceiver_test
 
@@ -28,6 +28,8 @@
 // Standard:
 #include <cstddef>
 #include <future>
+#include <type_traits>
+#include <utility>
 
 
 namespace xf::crypto::xle {
@@ -38,6 +40,30 @@ static Blob const kSlaveToMaster { 0x02 };
 static thread_local boost::random::random_device transceiver_rnd;
 
 
+namespace {
+
+/**
+ * Run the function on the WorkPerformer or, if it's nullptr, right away on the calling thread.
+ * Either way the result or exception is returned through the future.
+ */
+template<class Function>
+	std::future<std::invoke_result_t<Function>>
+	run_on (WorkPerformer* work_performer, Function&& function)
+	{
+		if (work_performer)
+			return work_performer->submit (std::forward<Function> (function));
+		else
+		{
+			std::packaged_task<std::invoke_result_t<Function>()> task (std::forward<Function> (function));
+			auto future = task.get_future();
+			task();
+			return future;
+		}
+	}
+
+} // namespace
+
+
 Transceiver::Transceiver (Role const role, size_t ciphertext_expansion, xf::Logger const& logger):
 	_role (role),
 	_logger (logger),
@@ -172,14 +198,21 @@ Transceiver::role_name() const
 }
 
 
-MasterTransceiver::Session::HandshakeRequested::HandshakeRequested (CryptoParams const& params):
-	handshake_master (transceiver_rnd, {
+MasterTransceiver::Session::PreparedHandshake::PreparedHandshake (CryptoParams const& params):
+	handshake_master (random_device, {
 		.master_signature_key = params.master_signature_key,
 		.slave_signature_key = params.slave_signature_key,
 		.hmac_size = params.hmac_size,
 		.max_time_difference = params.max_time_difference,
-	}),
-	handshake_request (handshake_master.generate_handshake_blob (neutrino::TimeHelper::now()))
+	})
+{
+	handshake_master.prepare_exchange_blob();
+}
+
+
+MasterTransceiver::Session::HandshakeRequested::HandshakeRequested (std::shared_ptr<PreparedHandshake> prepared):
+	prepared_handshake (std::move (prepared)),
+	handshake_request (prepared_handshake->handshake_master.generate_handshake_blob (neutrino::TimeHelper::now()))
 { }
 
 
@@ -203,10 +236,11 @@ MasterTransceiver::Session::Connected::Connected (Secure<Blob> const& ephemeral_
 { }
 
 
-MasterTransceiver::Session::Session (CryptoParams const& params):
+MasterTransceiver::Session::Session (CryptoParams const& params, std::future<std::shared_ptr<PreparedHandshake>> prepared_handshake):
 	Transceiver::Session ("M", _id_generator),
 	_crypto_params (params),
-	_state (std::in_place_type_t<HandshakeRequested>(), params)
+	_state (std::in_place_type_t<PreparingHandshake>(), std::move (prepared_handshake)),
+	_created_at (neutrino::TimeHelper::now())
 {
 	_session_prepared_future = _session_prepared_promise.get_future();
 	_session_activated_future = _session_activated_promise.get_future();
@@ -229,14 +263,55 @@ MasterTransceiver::Session::handshake_request() const
 }
 
 
+bool
+MasterTransceiver::Session::update()
+{
+	if (auto* ph = std::get_if<PreparingHandshake> (&_state))
+	{
+		if (is_ready (ph->prepared_handshake))
+		{
+			auto prepared_handshake = ph->prepared_handshake.get();
+			_state.emplace<HandshakeRequested> (std::move (prepared_handshake));
+			return true;
+		}
+	}
+	else if (auto* ck = std::get_if<CalculatingKey> (&_state))
+	{
+		if (is_ready (ck->ephemeral_key))
+		{
+			Blob ephemeral_key;
+
+			try {
+				ephemeral_key = ck->ephemeral_key.get();
+			}
+			catch (...)
+			{
+				// Allow another handshake response to be tried:
+				auto handshake_requested = std::move (ck->handshake_requested);
+				_state = std::move (handshake_requested);
+				throw;
+			}
+
+			set_connected (ephemeral_key);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
 void
-MasterTransceiver::Session::set_handshake_response (Blob const& handshake_response)
+MasterTransceiver::Session::set_handshake_response (Blob const& handshake_response, WorkPerformer* work_performer)
 {
 	if (auto* hr = std::get_if<HandshakeRequested> (&_state))
 	{
-		auto const ephemeral_key = Secure (hr->handshake_master.calculate_key (handshake_response));
-		_state.emplace<Connected> (ephemeral_key, _crypto_params);
-		_session_prepared_promise.set_value();
+		// The task keeps the PreparedHandshake alive even if this session gets deleted in the meantime:
+		auto ephemeral_key = run_on (work_performer, [prepared_handshake = hr->prepared_handshake, handshake_response] {
+			return prepared_handshake->handshake_master.calculate_key (handshake_response);
+		});
+		auto calculating_key = CalculatingKey { std::move (*hr), std::move (ephemeral_key) };
+		_state = std::move (calculating_key);
 	}
 	else
 		throw Exception ("unexpected MasterTransceiver::Session::set_handshake_response() when not waiting for it", false);
@@ -254,6 +329,15 @@ MasterTransceiver::Session::abort (AbortReason const reason)
 }
 
 
+void
+MasterTransceiver::Session::set_connected (Blob const& ephemeral_key)
+{
+	_state.emplace<Connected> (Secure (ephemeral_key), _crypto_params);
+	_handshake_latency = neutrino::TimeHelper::now() - _created_at;
+	_session_prepared_promise.set_value();
+}
+
+
 std::optional<Blob>
 MasterTransceiver::Session::tx_key_hash() const
 {
@@ -301,16 +385,28 @@ MasterTransceiver::MasterTransceiver (xf::ProcessingLoop& loop, CryptoParams con
 { }
 
 
+void
+MasterTransceiver::set_work_performer (WorkPerformer* work_performer)
+{
+	_work_performer = work_performer;
+	_prepared_handshake = {};
+	prepare_next_handshake();
+}
+
+
 MasterTransceiver::StartHandshakeResult
 MasterTransceiver::start_handshake()
 {
-	_next_session_candidate = std::make_unique<Session> (_crypto_params);
-	this->handshake_request = to_string (_next_session_candidate->handshake_request());
+	_next_session_candidate = std::make_unique<Session> (_crypto_params, take_prepared_handshake());
+	prepare_next_handshake();
 
-	return {
+	auto result = StartHandshakeResult {
 		.session_prepared	= _next_session_candidate->session_prepared(),
 		.session_activated	= _next_session_candidate->session_activated(),
 	};
+
+	update_next_session_candidate();
+	return result;
 }
 
 
@@ -342,20 +438,28 @@ MasterTransceiver::process (Cycle const&)
 
 	try {
 		if (_handshake_response_changed.value_changed() && this->handshake_response.valid())
-			if (_next_session_candidate->waiting_for_handshake_response())
-				_next_session_candidate->set_handshake_response (to_blob (*this->handshake_response));
+			if (_next_session_candidate && _next_session_candidate->waiting_for_handshake_response())
+				_next_session_candidate->set_handshake_response (to_blob (*this->handshake_response), _work_performer);
+
+		// Without a WorkPerformer this finishes the handshake right away:
+		update_next_session_candidate();
 	}
 	catch (...)
 	{
 		logger() << std::format ("Exception when handling handshake response: {}\n", neutrino::describe_exception (std::current_exception()));
 	}
+
+	if (_next_session_candidate)
+		if (auto const latency = _next_session_candidate->handshake_latency())
+			this->handshake_latency = *latency;
 }
 
 
 void
 MasterTransceiver::shift_sessions()
 {
-	if (_next_session_candidate)
+	// Only a session with its keys calculated can become active:
+	if (_next_session_candidate && _next_session_candidate->connected())
 	{
 		_previous_session = std::move (_active_session);
 		_active_session = std::move (_next_session_candidate);
@@ -365,18 +469,78 @@ MasterTransceiver::shift_sessions()
 }
 
 
-SlaveTransceiver::Session::Session (Blob const& handshake_request,
-									CryptoParams const& params,
-									std::function<bool (HandshakeID)> handshake_id_reused_check):
-	Transceiver::Session ("S", _id_generator)
+std::future<std::shared_ptr<MasterTransceiver::Session::PreparedHandshake>>
+MasterTransceiver::take_prepared_handshake()
+{
+	if (_prepared_handshake.valid())
+		return std::move (_prepared_handshake);
+	else
+	{
+		return run_on (_work_performer, [params = _crypto_params] {
+			return std::make_shared<Session::PreparedHandshake> (params);
+		});
+	}
+}
+
+
+void
+MasterTransceiver::prepare_next_handshake()
 {
-	auto handshake_slave = HandshakeSlave (transceiver_rnd, {
+	if (_work_performer && !_prepared_handshake.valid())
+		_prepared_handshake = take_prepared_handshake();
+}
+
+
+void
+MasterTransceiver::update_next_session_candidate()
+{
+	if (!_next_session_candidate)
+		return;
+
+	// Once the future with the prepared handshake has thrown, it's invalid and the session can't leave PreparingHandshake:
+	auto const preparing_handshake = _next_session_candidate->preparing_handshake();
+
+	try {
+		if (_next_session_candidate->update())
+			publish_handshake_request();
+	}
+	catch (...)
+	{
+		if (preparing_handshake)
+		{
+			logger() << std::format ("Failed to prepare handshake, dropping the session: {}\n", neutrino::describe_exception (std::current_exception()));
+			_next_session_candidate.reset();
+		}
+		else
+			throw;
+	}
+}
+
+
+void
+MasterTransceiver::publish_handshake_request()
+{
+	if (_next_session_candidate && _next_session_candidate->waiting_for_handshake_response())
+		this->handshake_request = to_string (_next_session_candidate->handshake_request());
+}
+
+
+SlaveTransceiver::Session::PreparedHandshake::PreparedHandshake (CryptoParams const& params,
+																 std::function<bool (HandshakeID)> handshake_id_reuse_check):
+	handshake_slave (random_device, {
 		.master_signature_key = params.master_signature_key,
 		.slave_signature_key = params.slave_signature_key,
 		.hmac_size = params.hmac_size,
 		.max_time_difference = params.max_time_difference,
-	}, handshake_id_reused_check);
-	auto const response_and_key = handshake_slave.generate_handshake_blob_and_key (handshake_request, neutrino::TimeHelper::now());
+	}, handshake_id_reuse_check)
+{
+	handshake_slave.prepare_exchange_blob();
+}
+
+
+SlaveTransceiver::Session::Session (HandshakeSlave::HandshakeAndKey const& response_and_key, CryptoParams const& params):
+	Transceiver::Session ("S", _id_generator)
+{
 	_handshake_response = response_and_key.handshake_response;
 	_transmitter.emplace (transceiver_rnd, Transmitter::Params {
 		.ephemeral_session_key = *response_and_key.ephemeral_key,
@@ -409,6 +573,15 @@ SlaveTransceiver::SlaveTransceiver (xf::ProcessingLoop& loop,
 { }
 
 
+void
+SlaveTransceiver::set_work_performer (WorkPerformer* work_performer)
+{
+	_work_performer = work_performer;
+	_prepared_handshake = {};
+	prepare_next_handshake();
+}
+
+
 std::optional<Blob>
 SlaveTransceiver::tx_key_hash() const
 {
@@ -435,8 +608,20 @@ SlaveTransceiver::process (Cycle const&)
 	try {
 		if (_handshake_request_changed.value_changed() && this->handshake_request.valid())
 		{
-			_next_session_candidate = std::make_unique<Session> (to_blob (*this->handshake_request), _crypto_params, _handshake_id_reuse_check);
+			// A response to a previous request that's still being calculated is abandoned.
+			// The prepared handshake was submitted to the WorkPerformer earlier, so waiting for it in the task can't deadlock:
+			_handshake_requested_at = neutrino::TimeHelper::now();
+			_handshake_and_key = run_on (_work_performer, [prepared_handshake = take_prepared_handshake().share(), request = to_blob (*this->handshake_request)] {
+				return prepared_handshake.get()->handshake_slave.generate_handshake_blob_and_key (request, neutrino::TimeHelper::now());
+			});
+			prepare_next_handshake();
+		}
+
+		if (_handshake_and_key.valid() && is_ready (_handshake_and_key))
+		{
+			_next_session_candidate = std::make_unique<Session> (_handshake_and_key.get(), _crypto_params);
 			this->handshake_response = to_string (*_next_session_candidate->handshake_response());
+			this->handshake_latency = neutrino::TimeHelper::now() - _handshake_requested_at;
 		}
 	}
 	catch (...)
@@ -456,5 +641,27 @@ SlaveTransceiver::shift_sessions()
 	}
 }
 
+
+std::future<std::shared_ptr<SlaveTransceiver::Session::PreparedHandshake>>
+SlaveTransceiver::take_prepared_handshake()
+{
+	if (_prepared_handshake.valid())
+		return std::move (_prepared_handshake);
+	else
+	{
+		return run_on (_work_performer, [params = _crypto_params, handshake_id_reuse_check = _handshake_id_reuse_check] {
+			return std::make_shared<Session::PreparedHandshake> (params, handshake_id_reuse_check);
+		});
+	}
+}
+
+
+void
+SlaveTransceiver::prepare_next_handshake()
+{
+	if (_work_performer && !_prepared_handshake.valid())
+		_prepared_handshake = take_prepared_handshake();
+}
+
 } // namespace xf::crypto::xle
 
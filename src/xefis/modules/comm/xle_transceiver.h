@@ -25,6 +25,7 @@
 // Neutrino:
 #include <neutrino/crypto/secure.h>
 #include <neutrino/noncopyable.h>
+#include <neutrino/work_performer.h>
 
 // Qt:
 #include <QtCore/QTimer>
@@ -32,6 +33,8 @@
 // Standard:
 #include <cstddef>
 #include <functional>
+#include <future>
+#include <memory>
 
 
 namespace xf::xle_transceiver_test {
@@ -290,6 +293,8 @@ class MasterTransceiver:
 
 	// It's non-nil when offering a handshake, becomes nil after the handshake is complete.
 	xf::ModuleOut<std::string>	handshake_request		{ this, "handshake_request" };
+	// Time from start_handshake() to the new session being prepared (includes the round trip to the slave):
+	xf::ModuleOut<si::Time>		handshake_latency		{ this, "handshake_latency" };
 
   public:
 	enum AbortReason
@@ -334,6 +339,29 @@ class MasterTransceiver:
 		static inline size_t _id_generator = 0;
 
 	  public:
+		/**
+		 * HandshakeMaster with its own random device and DHE exchange blob already generated,
+		 * so that it can be prepared on a WorkPerformer thread and used on another.
+		 */
+		struct PreparedHandshake
+		{
+			boost::random::random_device	random_device;
+			HandshakeMaster					handshake_master;
+
+			// Ctor
+			explicit
+			PreparedHandshake (CryptoParams const&);
+		};
+
+		/**
+		 * PreparingHandshake state.
+		 * Waiting for the HandshakeMaster to be prepared.
+		 */
+		struct PreparingHandshake
+		{
+			std::future<std::shared_ptr<PreparedHandshake>>	prepared_handshake;
+		};
+
 		/**
 		 * HandshakeRequested state.
 		 * Handshake has been requested to be sent, and it will be requested periodically
@@ -342,12 +370,23 @@ class MasterTransceiver:
 		 */
 		struct HandshakeRequested
 		{
-			HandshakeMaster	handshake_master;
-			Blob			handshake_request;
+			std::shared_ptr<PreparedHandshake>	prepared_handshake;
+			Blob								handshake_request;
 
 			// Ctor
 			explicit
-			HandshakeRequested (CryptoParams const&);
+			HandshakeRequested (std::shared_ptr<PreparedHandshake>);
+		};
+
+		/**
+		 * CalculatingKey state.
+		 * Handshake response has been received and the ephemeral key is being calculated.
+		 * If calculation fails, session goes back to the HandshakeRequested state.
+		 */
+		struct CalculatingKey
+		{
+			HandshakeRequested	handshake_requested;
+			std::future<Blob>	ephemeral_key;
 		};
 
 		/**
@@ -366,11 +405,20 @@ class MasterTransceiver:
 
 		// Ctor
 		explicit
-		Session (CryptoParams const&);
+		Session (CryptoParams const&, std::future<std::shared_ptr<PreparedHandshake>>);
 
 		// Dtor
 		~Session();
 
+		/**
+		 * Move on to the next state if the handshake preparation or key calculation has finished.
+		 *
+		 * \returns	true if the state has changed.
+		 * \throws	exception thrown by the key calculation; session goes back to the HandshakeRequested state.
+		 */
+		bool
+		update();
+
 		/**
 		 * Return the handshake request blob to be sent to the SlaveTransceiver.
 		 */
@@ -378,6 +426,14 @@ class MasterTransceiver:
 		Blob const&
 		handshake_request() const;
 
+		/**
+		 * Return true if session is still waiting for its HandshakeMaster to be prepared.
+		 */
+		[[nodiscard]]
+		bool
+		preparing_handshake() const noexcept
+			{ return std::holds_alternative<PreparingHandshake> (_state); }
+
 		/**
 		 * Return true if session is awaiting for handshake response
 		 * to be set with set_handshake_response().
@@ -389,9 +445,20 @@ class MasterTransceiver:
 
 		/**
 		 * Use handshake response obtained from SlaveTransceiver.
+		 * The ephemeral key is calculated on the WorkPerformer, if one is given,
+		 * and the session becomes connected on a later update().
 		 */
 		void
-		set_handshake_response (Blob const&);
+		set_handshake_response (Blob const&, WorkPerformer*);
+
+		/**
+		 * Return time it took from creating the session to calculating the ephemeral key
+		 * or std::nullopt if the session is not yet connected.
+		 */
+		[[nodiscard]]
+		std::optional<si::Time>
+		handshake_latency() const noexcept
+			{ return _handshake_latency; }
 
 		/**
 		 * Called when this session becomes the main active session.
@@ -462,9 +529,19 @@ class MasterTransceiver:
 		decrypt_packet (BlobView const packet, std::optional<Transport::SequenceNumber> const maximum_allowed_sequence_number = std::nullopt)
 			{ return this->receiver().decrypt_packet (packet, maximum_allowed_sequence_number); }
 
+	  private:
+		/**
+		 * Switch to the Connected state.
+		 */
+		void
+		set_connected (Blob const& ephemeral_key);
+
 	  private:
 		CryptoParams								_crypto_params;
-		std::variant<HandshakeRequested, Connected>	_state;
+		std::variant<PreparingHandshake, HandshakeRequested, CalculatingKey, Connected>
+													_state;
+		si::Time									_created_at;
+		std::optional<si::Time>						_handshake_latency;
 		std::shared_future<void>					_session_prepared_future;
 		std::promise<void>							_session_prepared_promise;
 		std::shared_future<void>					_session_activated_future;
@@ -491,6 +568,15 @@ class MasterTransceiver:
 	disconnect() noexcept
 		{ _active_session.reset(); }
 
+	/**
+	 * Use given WorkPerformer to prepare DHE key pairs in advance and calculate ephemeral keys,
+	 * so that the processing loop isn't stalled by handshakes.
+	 * Pass nullptr to do everything on the processing loop thread (the default).
+	 * The WorkPerformer must outlive the transceiver.
+	 */
+	void
+	set_work_performer (WorkPerformer*);
+
 	[[nodiscard]]
 	std::optional<Blob>
 	tx_key_hash() const;
@@ -549,8 +635,39 @@ class MasterTransceiver:
 	get_rid_of_previous_session() override
 		{ _previous_session.reset(); }
 
+  private:
+	/**
+	 * Return the handshake prepared in advance or start preparing a new one.
+	 */
+	[[nodiscard]]
+	std::future<std::shared_ptr<Session::PreparedHandshake>>
+	take_prepared_handshake();
+
+	/**
+	 * Start preparing a handshake for the next request in advance, if there's a WorkPerformer.
+	 */
+	void
+	prepare_next_handshake();
+
+	/**
+	 * Call update() on the next session candidate, if there's one, and publish its handshake request
+	 * when it becomes ready. If the handshake couldn't be prepared, the candidate can't continue
+	 * anymore, so log the error and drop it, which also rejects its futures.
+	 */
+	void
+	update_next_session_candidate();
+
+	/**
+	 * Set the handshake_request socket if next session candidate has the request ready.
+	 */
+	void
+	publish_handshake_request();
+
   private:
 	CryptoParams						_crypto_params;
+	WorkPerformer*						_work_performer					{ nullptr };
+	std::future<std::shared_ptr<Session::PreparedHandshake>>
+										_prepared_handshake;
 	xf::SocketValueChanged<bool>		_start_handshake_button_changed { start_handshake_button };
 	xf::SocketValueChanged<std::string>	_handshake_response_changed     { handshake_response };
 	// Active session means connected and confirmed correct encryption+authentication:
@@ -576,6 +693,8 @@ class SlaveTransceiver:
 	xf::ModuleOut<uint64_t>		num_correct_handshakes	{ this, "num_correct_handshakes" };
 	// It's non-nil when responding to a handshake, becomes nil after the handshake is complete.
 	xf::ModuleOut<std::string>	handshake_response		{ this, "handshake_response" };
+	// Time from receiving a handshake request to having the response ready:
+	xf::ModuleOut<si::Time>		handshake_latency		{ this, "handshake_latency" };
 
   private:
 	static constexpr char kLoggerScope[] = "mod::SlaveTransceiver";
@@ -589,12 +708,25 @@ class SlaveTransceiver:
 	{
 		static inline size_t _id_generator = 0;
 
+	  public:
+		/**
+		 * HandshakeSlave with its own random device and DHE exchange blob already generated,
+		 * so that it can be prepared on a WorkPerformer thread and used on another.
+		 */
+		struct PreparedHandshake
+		{
+			boost::random::random_device	random_device;
+			HandshakeSlave					handshake_slave;
+
+			// Ctor
+			explicit
+			PreparedHandshake (CryptoParams const&, std::function<bool (HandshakeID)> handshake_id_reuse_check);
+		};
+
 	  public:
 		// Ctor
 		explicit
-		Session (Blob const& handshake_request,
-				 CryptoParams const&,
-				 std::function<bool (HandshakeID)> handshake_id_reuse_check);
+		Session (HandshakeSlave::HandshakeAndKey const&, CryptoParams const&);
 
 		[[nodiscard]]
 		Secure<Blob> const&
@@ -639,7 +771,6 @@ class SlaveTransceiver:
 		Secure<Blob>						_handshake_response;
 		std::optional<Transmitter>			_transmitter;
 		std::optional<Receiver>				_receiver;
-		std::function<bool (HandshakeID)>	_handshake_id_reuse_check;
 	};
 
   public:
@@ -658,6 +789,16 @@ class SlaveTransceiver:
 	disconnect() noexcept
 		{ _active_session.reset(); }
 
+	/**
+	 * Use given WorkPerformer to prepare DHE key pairs in advance and calculate handshake responses,
+	 * so that the processing loop isn't stalled by handshakes. The handshake_id_reuse_check callback
+	 * is then called on the WorkPerformer thread.
+	 * Pass nullptr to do everything on the processing loop thread (the default).
+	 * The WorkPerformer must outlive the transceiver.
+	 */
+	void
+	set_work_performer (WorkPerformer*);
+
 	[[nodiscard]]
 	std::optional<Blob>
 	tx_key_hash() const;
@@ -711,8 +852,29 @@ class SlaveTransceiver:
 	void
 	shift_sessions() override;
 
+  private:
+	/**
+	 * Return the handshake prepared in advance or start preparing a new one.
+	 */
+	[[nodiscard]]
+	std::future<std::shared_ptr<Session::PreparedHandshake>>
+	take_prepared_handshake();
+
+	/**
+	 * Start preparing a handshake for the next request in advance, if there's a WorkPerformer.
+	 */
+	void
+	prepare_next_handshake();
+
   private:
 	CryptoParams						_crypto_params;
+	WorkPerformer*						_work_performer				{ nullptr };
+	std::future<std::shared_ptr<Session::PreparedHandshake>>
+										_prepared_handshake;
+	// Response to the last handshake request being calculated:
+	std::future<HandshakeSlave::HandshakeAndKey>
+										_handshake_and_key;
+	si::Time							_handshake_requested_at;
 	xf::SocketValueChanged<std::string>	_handshake_request_changed { handshake_request };
 	std::function<bool (HandshakeID)>	_handshake_id_reuse_check;
 	// Active session means connected and confirmed correct encryption+authentication:
@@ -1678,24 +1678,24 @@ PaintingWork::paint_navaids()
 	};
 
 	if (_p.fix_visible)
-		for (auto const& navaid: _current_navaids.fix_navs)
-			paint_navaid (navaid);
+		for (auto const* navaid: _current_navaids.fix_navs)
+			paint_navaid (*navaid);
 
 	if (_p.ndb_visible)
-		for (auto const& navaid: _current_navaids.ndb_navs)
-			paint_navaid (navaid);
+		for (auto const* navaid: _current_navaids.ndb_navs)
+			paint_navaid (*navaid);
 
 	if (_p.dme_visible)
-		for (auto const& navaid: _current_navaids.dme_navs)
-			paint_navaid (navaid);
+		for (auto const* navaid: _current_navaids.dme_navs)
+			paint_navaid (*navaid);
 
 	if (_p.vor_visible)
-		for (auto const& navaid: _current_navaids.vor_navs)
-			paint_navaid (navaid);
+		for (auto const* navaid: _current_navaids.vor_navs)
+			paint_navaid (*navaid);
 
 	if (_p.arpt_visible)
-		for (auto const& navaid: _current_navaids.arpt_navs)
-			paint_navaid (navaid);
+		for (auto const* navaid: _current_navaids.arpt_navs)
+			paint_navaid (*navaid);
 
 	if (_p.home)
 	{
@@ -1862,13 +1862,13 @@ PaintingWork::paint_locs()
 	_painter.setPen (_c.lo_loc_pen);
 	xf::Navaid const* hi_loc = nullptr;
 
-	for (auto const& navaid: _current_navaids.loc_navs)
+	for (auto const* navaid: _current_navaids.loc_navs)
 	{
 		// Paint highlighted LOC at the end, so it's on top:
-		if (navaid.identifier() == _p.highlighted_loc)
-			hi_loc = &navaid;
+		if (navaid->identifier() == _p.highlighted_loc)
+			hi_loc = navaid;
 		else
-			paint_loc (navaid);
+			paint_loc (*navaid);
 	}
 
 	// Paint identifiers:
@@ -1992,9 +1992,11 @@ PaintingWork::retrieve_navaids()
 	_current_navaids.loc_navs.clear();
 	_current_navaids.arpt_navs.clear();
 
-	for (xf::Navaid const& navaid: _navaid_storage.get_navs (*_p.position, std::max (_p.range + 20_nmi, 2.f * _p.range)))
+	_navaid_storage.get_navs (*_p.position, std::max (_p.range + 20_nmi, 2.f * _p.range), _current_navaids.retrieved_navs);
+
+	for (auto const* navaid: _current_navaids.retrieved_navs)
 	{
-		switch (navaid.type())
+		switch (navaid->type())
 		{
 			case xf::Navaid::LOC:
 				_current_navaids.loc_navs.push_back (navaid);
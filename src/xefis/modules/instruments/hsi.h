@@ -305,16 +305,18 @@ struct ResizeCache
  */
 struct CurrentNavaids
 {
-	xf::NavaidStorage::Navaids	fix_navs;
-	xf::NavaidStorage::Navaids	vor_navs;
-	xf::NavaidStorage::Navaids	dme_navs;
-	xf::NavaidStorage::Navaids	ndb_navs;
-	xf::NavaidStorage::Navaids	loc_navs;
-	xf::NavaidStorage::Navaids	arpt_navs;
-
-	bool						retrieved			{ false };
-	si::LonLat					retrieve_position	{ 0_deg, 0_deg };
-	si::Length					retrieve_range		{ 0_nmi };
+	// Points to navaids owned by the NavaidStorage:
+	xf::NavaidStorage::NavaidPointers	retrieved_navs;
+	xf::NavaidStorage::NavaidPointers	fix_navs;
+	xf::NavaidStorage::NavaidPointers	vor_navs;
+	xf::NavaidStorage::NavaidPointers	dme_navs;
+	xf::NavaidStorage::NavaidPointers	ndb_navs;
+	xf::NavaidStorage::NavaidPointers	loc_navs;
+	xf::NavaidStorage::NavaidPointers	arpt_navs;
+
+	bool								retrieved			{ false };
+	si::LonLat							retrieve_position	{ 0_deg, 0_deg };
+	si::Length							retrieve_range		{ 0_nmi };
 };
 
 
@@ -49,11 +49,25 @@ VirtualServoController::socket_for (xf::sim::interfaces::AngularServo& servo, st
 }
 
 
+void
+VirtualServoController::apply_setpoints()
+{
+	if (_setpoints.has_fresh_value())
+		for (auto const& setpoint: _setpoints.read())
+			setpoint.servo->set_setpoint (setpoint.angle);
+}
+
+
 void
 VirtualServoController::process (xf::Cycle const&)
 {
+	auto& setpoints = _setpoints.write_buffer();
+	setpoints.clear();
+
 	for (auto& [servo, socket_ptr]: _angular_servo_sockets)
 		if (*socket_ptr)
-			servo->set_setpoint (**socket_ptr);
+			setpoints.push_back ({ .servo = servo, .angle = **socket_ptr });
+
+	_setpoints.publish();
 }
 
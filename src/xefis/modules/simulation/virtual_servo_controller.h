@@ -20,10 +20,12 @@
 #include <xefis/core/setting.h>
 #include <xefis/core/sockets/module_socket.h>
 #include <xefis/support/simulation/devices/interfaces/angular_servo.h>
+#include <xefis/utility/triple_buffer.h>
 
 // Standard:
 #include <cstddef>
 #include <string_view>
+#include <vector>
 
 
 namespace si = neutrino::si;
@@ -33,9 +35,19 @@ namespace si = neutrino::si;
  * Simulates servo PWM generator.
  * Can couple IO sockets with provided xf::sim::AngularServos to control
  * the simulated servos.
+ *
+ * Setpoints are not set on the servos directly, since the simulation usually runs on
+ * another thread. process() publishes them and the simulation thread applies them
+ * with apply_setpoints() before evolving the system.
  */
 class VirtualServoController: public xf::Module
 {
+	struct Setpoint
+	{
+		xf::sim::interfaces::AngularServo*	servo;
+		si::Angle							angle;
+	};
+
   public:
 	// Ctor
 	explicit
@@ -53,6 +65,13 @@ class VirtualServoController: public xf::Module
 	xf::ModuleIn<si::Angle>&
 	socket_for (xf::sim::interfaces::AngularServo&, std::string_view name);
 
+	/**
+	 * Set the setpoints published by the most recent process() on the servos.
+	 * Call only from the thread that evolves the simulation, eg. from Simulator's frame callback.
+	 */
+	void
+	apply_setpoints();
+
   protected:
 	// Module API
 	void
@@ -60,6 +79,7 @@ class VirtualServoController: public xf::Module
 
   private:
 	std::map<xf::sim::interfaces::AngularServo*, std::unique_ptr<xf::ModuleIn<si::Angle>>> _angular_servo_sockets;
+	xf::TripleBuffer<std::vector<Setpoint>>	_setpoints;
 };
 
 #endif
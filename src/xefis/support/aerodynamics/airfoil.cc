@@ -19,6 +19,8 @@
 #include <xefis/support/earth/air/air.h>
 
 // Standard:
+#include <algorithm>
+#include <array>
 #include <cstddef>
 
 
@@ -36,7 +38,7 @@ Airfoil::Airfoil (AirfoilCharacteristics const& airfoil_characteristics,
 si::Force
 Airfoil::lift_force (si::Angle alpha, si::Angle beta, ReynoldsNumber re, si::Pressure dynamic_pressure, std::optional<si::Area> lifting_area) const
 {
-	auto const cl = _airfoil_characteristics.lift_coefficient (*re, wrap_angle_for_field (alpha));
+	auto const cl = _airfoil_characteristics.coefficients (*re, wrap_angle_for_field (alpha)).lift;
 
 	if (!lifting_area)
 		lifting_area = lift_drag_areas (alpha, beta).first;
@@ -48,7 +50,7 @@ Airfoil::lift_force (si::Angle alpha, si::Angle beta, ReynoldsNumber re, si::Pre
 si::Force
 Airfoil::drag_force (si::Angle alpha, si::Angle beta, ReynoldsNumber re, si::Pressure dynamic_pressure, std::optional<si::Area> dragging_area) const
 {
-	auto const cd = _airfoil_characteristics.drag_coefficient (*re, wrap_angle_for_field (alpha));
+	auto const cd = _airfoil_characteristics.coefficients (*re, wrap_angle_for_field (alpha)).drag;
 
 	if (!dragging_area)
 		dragging_area = lift_drag_areas (alpha, beta).second;
@@ -60,7 +62,7 @@ Airfoil::drag_force (si::Angle alpha, si::Angle beta, ReynoldsNumber re, si::Pre
 si::Torque
 Airfoil::pitching_moment (si::Angle alpha, ReynoldsNumber re, si::Pressure dynamic_pressure) const
 {
-	auto const cm = _airfoil_characteristics.pitching_moment_coefficient (*re, wrap_angle_for_field (alpha));
+	auto const cm = _airfoil_characteristics.coefficients (*re, wrap_angle_for_field (alpha)).pitching_moment;
 	auto const wing_planform = _wing_length * _chord_length;
 	return cm * dynamic_pressure * wing_planform * _chord_length;
 }
@@ -69,58 +71,12 @@ Airfoil::pitching_moment (si::Angle alpha, ReynoldsNumber re, si::Pressure dynam
 AirfoilAerodynamicParameters<AirfoilSplineSpace>
 Airfoil::planar_aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air) const
 {
-	// Wind vector will be normalized, so make sure it's not near 0:
-	if (abs (relative_air.velocity) > 1e-6_mps)
-	{
-		auto const aoa = AngleOfAttack {
-			.alpha	= 1_rad * atan2 (relative_air.velocity[1], relative_air.velocity[0]),
-			.beta	= 1_rad * atan2 (relative_air.velocity[2], relative_air.velocity[0]),
-		};
-
-		SpaceVector<si::Velocity, AirfoilSplineSpace> const planar_wind { relative_air.velocity[0], relative_air.velocity[1], 0_mps };
-		si::Velocity const		planar_tas				= abs (planar_wind);
-		si::Pressure const		planar_dp				= dynamic_pressure (relative_air.density, planar_tas);
-		ReynoldsNumber const	re						= reynolds_number (relative_air.density, planar_tas, _chord_length, relative_air.dynamic_viscosity);
-		auto const				[lift_area, drag_area]	= lift_drag_areas (aoa.alpha, aoa.beta);
-		si::Force const			lift					= lift_force (aoa.alpha, aoa.beta, re, planar_dp, lift_area);
-		si::Force const			drag					= drag_force (aoa.alpha, aoa.beta, re, planar_dp, drag_area);
-		si::Torque const		torque					= pitching_moment (aoa.alpha, re, planar_dp);
-
-		// Lift force is always perpendicular to relative wind.
-		// Drag is always parallel to relative wind.
-		// Pitching moment is always perpendicular to lift and drag forces.
-
-		SpaceVector<si::Length, AirfoilSplineSpace> const	cp_position			{ _airfoil_characteristics.center_of_pressure_position (*re, wrap_angle_for_field (aoa.alpha)) * _chord_length, 0_m, 0_m };
-		// If air.velocity is 0, normalized will be nan³, but we're guarded by the if above.
-		SpaceVector<double, AirfoilSplineSpace> const		drag_direction		= relative_air.velocity.normalized() / 1_mps;
-		SpaceVector<double, AirfoilSplineSpace> const		lift_direction		= cross_product (SpaceVector<double, AirfoilSplineSpace> { 0.0, 0.0, +1.0 }, relative_air.velocity).normalized() / 1_mps;
-		SpaceVector<si::Torque, AirfoilSplineSpace> const	pitching_moment_vec	{ 0_Nm, 0_Nm, torque };
-
-		// TODO drag should be 3D, that is also in Z direction
-		// TODO maybe lift, too?
-		return {
-			.air = relative_air,
-			.reynolds_number = re,
-			.true_air_speed = planar_tas,
-			.angle_of_attack = aoa,
-			.forces = {
-				.lift = lift * lift_direction,
-				.drag = drag * drag_direction,
-				.pitching_moment = pitching_moment_vec,
-				.center_of_pressure = cp_position,
-			},
-		};
-	}
-	else
-	{
-		return {
-			.air = relative_air,
-			.reynolds_number = {},
-			.true_air_speed = 0_mps,
-			.angle_of_attack = { 0_deg, 0_deg },
-			.forces = {},
-		};
-	}
+	if (!has_wind (relative_air))
+		return no_wind_aerodynamic_forces (relative_air);
+
+	auto const air_data = planar_air_data (relative_air);
+	auto const coefficients = _airfoil_characteristics.coefficients (*air_data.reynolds_number, air_data.angle_of_attack.alpha);
+	return planar_aerodynamic_forces (relative_air, air_data, coefficients);
 }
 
 
@@ -133,12 +89,122 @@ Airfoil::aerodynamic_forces (Air<AirfoilSplineSpace> const& air) const
 }
 
 
+void
+Airfoil::aerodynamic_forces (std::span<Air<AirfoilSplineSpace> const> const relative_airs,
+							 std::span<AirfoilAerodynamicParameters<AirfoilSplineSpace>> const results) const
+{
+	if (results.size() != relative_airs.size())
+		throw InvalidArgument ("Airfoil::aerodynamic_forces(): results must have the same size as relative_airs");
+
+	auto const cp_correction = SpaceLength<AirfoilSplineSpace> { 0_m, 0_m, 0.5 * _wing_length };
+	std::array<PlanarAirData, kBatchSize> air_data;
+	std::array<AirfoilCharacteristics::Coefficients, kBatchSize> coefficients;
+
+	for (std::size_t batch_start = 0; batch_start < relative_airs.size(); batch_start += kBatchSize)
+	{
+		auto const n = std::min (kBatchSize, relative_airs.size() - batch_start);
+		auto const airs = relative_airs.subspan (batch_start, n);
+
+		for (std::size_t i = 0; i < n; ++i)
+			if (has_wind (airs[i]))
+				air_data[i] = planar_air_data (airs[i]);
+
+		for (std::size_t i = 0; i < n; ++i)
+			if (has_wind (airs[i]))
+				coefficients[i] = _airfoil_characteristics.coefficients (*air_data[i].reynolds_number, air_data[i].angle_of_attack.alpha);
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			auto& result = results[batch_start + i];
+
+			if (has_wind (airs[i]))
+			{
+				result = planar_aerodynamic_forces (airs[i], air_data[i], coefficients[i]);
+				result.forces.center_of_pressure += cp_correction;
+			}
+			else
+				result = no_wind_aerodynamic_forces (airs[i]);
+		}
+	}
+}
+
+
+Airfoil::PlanarAirData
+Airfoil::planar_air_data (Air<AirfoilSplineSpace> const& relative_air) const
+{
+	SpaceVector<si::Velocity, AirfoilSplineSpace> const planar_wind { relative_air.velocity[0], relative_air.velocity[1], 0_mps };
+	auto const planar_tas = abs (planar_wind);
+
+	return {
+		.angle_of_attack = {
+			.alpha	= 1_rad * atan2 (relative_air.velocity[1], relative_air.velocity[0]),
+			.beta	= 1_rad * atan2 (relative_air.velocity[2], relative_air.velocity[0]),
+		},
+		.true_air_speed = planar_tas,
+		.dynamic_pressure = dynamic_pressure (relative_air.density, planar_tas),
+		.reynolds_number = reynolds_number (relative_air.density, planar_tas, _chord_length, relative_air.dynamic_viscosity),
+	};
+}
+
+
+AirfoilAerodynamicParameters<AirfoilSplineSpace>
+Airfoil::planar_aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air,
+									PlanarAirData const& air_data,
+									AirfoilCharacteristics::Coefficients const& coefficients) const
+{
+	auto const& aoa = air_data.angle_of_attack;
+	auto const& planar_dp = air_data.dynamic_pressure;
+	auto const [lift_area, drag_area] = lift_drag_areas (aoa.alpha, aoa.beta);
+	si::Force const lift = coefficients.lift * planar_dp * lift_area;
+	si::Force const drag = coefficients.drag * planar_dp * drag_area;
+	si::Torque const torque = coefficients.pitching_moment * planar_dp * _wing_length * _chord_length * _chord_length;
+
+	// Lift force is always perpendicular to relative wind.
+	// Drag is always parallel to relative wind.
+	// Pitching moment is always perpendicular to lift and drag forces.
+
+	SpaceVector<si::Length, AirfoilSplineSpace> const	cp_position			{ coefficients.center_of_pressure_position * _chord_length, 0_m, 0_m };
+	// If air.velocity is 0, normalized will be nan³, but callers check has_wind() first.
+	SpaceVector<double, AirfoilSplineSpace> const		drag_direction		= relative_air.velocity.normalized() / 1_mps;
+	SpaceVector<double, AirfoilSplineSpace> const		lift_direction		= cross_product (SpaceVector<double, AirfoilSplineSpace> { 0.0, 0.0, +1.0 }, relative_air.velocity).normalized() / 1_mps;
+	SpaceVector<si::Torque, AirfoilSplineSpace> const	pitching_moment_vec	{ 0_Nm, 0_Nm, torque };
+
+	// TODO drag should be 3D, that is also in Z direction
+	// TODO maybe lift, too?
+	return {
+		.air = relative_air,
+		.reynolds_number = air_data.reynolds_number,
+		.true_air_speed = air_data.true_air_speed,
+		.angle_of_attack = aoa,
+		.forces = {
+			.lift = lift * lift_direction,
+			.drag = drag * drag_direction,
+			.pitching_moment = pitching_moment_vec,
+			.center_of_pressure = cp_position,
+		},
+	};
+}
+
+
+AirfoilAerodynamicParameters<AirfoilSplineSpace>
+Airfoil::no_wind_aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air)
+{
+	return {
+		.air = relative_air,
+		.reynolds_number = {},
+		.true_air_speed = 0_mps,
+		.angle_of_attack = { 0_deg, 0_deg },
+		.forces = {},
+	};
+}
+
+
 std::pair<si::Area, si::Area>
 Airfoil::lift_drag_areas (si::Angle alpha, si::Angle beta) const
 {
-	auto const [chord, thickness] = _airfoil_characteristics.spline().projected_chord_and_thickness (alpha, beta);
+	auto const projections = _airfoil_characteristics.projections (wrap_angle_for_field (alpha), beta);
 	auto const k = _chord_length * _wing_length;
-	return { k * chord, k * thickness };
+	return { k * projections.chord, k * projections.thickness };
 }
 
 
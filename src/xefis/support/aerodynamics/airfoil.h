@@ -25,6 +25,7 @@
 
 // Standard:
 #include <cstddef>
+#include <span>
 #include <utility>
 
 
@@ -39,6 +40,21 @@ namespace xf {
  */
 class Airfoil
 {
+	// Number of wing segments processed together in each phase of the batch aerodynamic_forces():
+	static constexpr std::size_t kBatchSize { 16 };
+
+	/**
+	 * Quantities derived from relative air needed to compute forces.
+	 */
+	class PlanarAirData
+	{
+	  public:
+		AngleOfAttack	angle_of_attack;
+		si::Velocity	true_air_speed;
+		si::Pressure	dynamic_pressure;
+		ReynoldsNumber	reynolds_number;
+	};
+
   public:
 	// Ctor
 	explicit
@@ -128,7 +144,50 @@ class Airfoil
 	AirfoilAerodynamicParameters<AirfoilSplineSpace>
 	aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air) const;
 
+	/**
+	 * Batch version of aerodynamic_forces() for many wing segments sharing this airfoil, eg. strips
+	 * of a blade-element wing model. Segments are processed in small groups, one phase at a time
+	 * (air data, coefficient lookups, forces), so that each phase runs as a tight loop.
+	 *
+	 * \param	relative_airs
+	 *			Relative air for each segment.
+	 * \param	results
+	 *			Output parameters, must have the same size as relative_airs.
+	 * \throws	InvalidArgument if sizes of relative_airs and results differ.
+	 */
+	void
+	aerodynamic_forces (std::span<Air<AirfoilSplineSpace> const> relative_airs,
+						std::span<AirfoilAerodynamicParameters<AirfoilSplineSpace>> results) const;
+
   private:
+	/**
+	 * Return true if air velocity is big enough to compute forces (wind vector will be normalized, so it must not be near 0).
+	 */
+	[[nodiscard]]
+	static bool
+	has_wind (Air<AirfoilSplineSpace> const& relative_air)
+		{ return abs (relative_air.velocity) > 1e-6_mps; }
+
+	[[nodiscard]]
+	PlanarAirData
+	planar_air_data (Air<AirfoilSplineSpace> const& relative_air) const;
+
+	/**
+	 * Compute forces from precomputed air data and coefficients.
+	 */
+	[[nodiscard]]
+	AirfoilAerodynamicParameters<AirfoilSplineSpace>
+	planar_aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air,
+							   PlanarAirData const&,
+							   AirfoilCharacteristics::Coefficients const&) const;
+
+	/**
+	 * Return result for no relative wind.
+	 */
+	[[nodiscard]]
+	static AirfoilAerodynamicParameters<AirfoilSplineSpace>
+	no_wind_aerodynamic_forces (Air<AirfoilSplineSpace> const& relative_air);
+
 	/**
 	 * Return area for calculation of the lift and drag forces (wing projected in the lift direction and wing projected in the drag direction).
 	 */
@@ -18,10 +18,88 @@
 #include <xefis/config/all.h>
 
 // Standard:
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <iterator>
+#include <limits>
 
 
 namespace xf {
+namespace {
+
+/**
+ * Return convex hull of the spline points (Andrew's monotone chain).
+ * Only hull points matter for the projections, and there are usually much fewer of them.
+ */
+[[nodiscard]]
+std::vector<AirfoilSpline::Point>
+convex_hull (std::vector<AirfoilSpline::Point> points)
+{
+	if (points.size() < 3)
+		return points;
+
+	std::ranges::sort (points, [] (auto const& a, auto const& b) {
+		return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+	});
+
+	auto const turn = [] (auto const& o, auto const& a, auto const& b) {
+		return (a[0] - o[0]) * (b[1] - o[1]) - (a[1] - o[1]) * (b[0] - o[0]);
+	};
+
+	std::vector<AirfoilSpline::Point> hull (2 * points.size());
+	std::size_t k = 0;
+
+	// Lower hull:
+	for (std::size_t i = 0; i < points.size(); ++i)
+	{
+		while (k >= 2 && turn (hull[k - 2], hull[k - 1], points[i]) <= 0.0)
+			--k;
+
+		hull[k++] = points[i];
+	}
+
+	// Upper hull:
+	for (std::size_t i = points.size() - 1, lower_size = k + 1; i > 0; --i)
+	{
+		while (k >= lower_size && turn (hull[k - 2], hull[k - 1], points[i - 1]) <= 0.0)
+			--k;
+
+		hull[k++] = points[i - 1];
+	}
+
+	// Last point is the same as the first one:
+	hull.resize (k - 1);
+	return hull;
+}
+
+
+/**
+ * Append Reynolds numbers for which the field has data.
+ */
+template<class Field>
+	void
+	append_reynolds_numbers (Field const& field, std::vector<double>& reynolds_numbers)
+	{
+		for (auto const& [reynolds_number, angle_field]: field.data_map())
+			reynolds_numbers.push_back (reynolds_number);
+	}
+
+
+/**
+ * Return field value with Reynolds number clamped to the field's domain.
+ */
+template<class Field>
+	[[nodiscard]]
+	double
+	clamped_value (Field const& field, double const reynolds_number, si::Angle const alpha)
+	{
+		auto const domain = field.domain();
+		return field (std::clamp (reynolds_number, domain.min(), domain.max()), alpha);
+	}
+
+} // namespace
+
 
 AirfoilCharacteristics::AirfoilCharacteristics (AirfoilSpline const& spline,
 												LiftField const& lift_field,
@@ -33,7 +111,179 @@ AirfoilCharacteristics::AirfoilCharacteristics (AirfoilSpline const& spline,
 	_drag_coefficient (drag_field),
 	_pitching_moment_coefficient (pitching_moment_field),
 	_center_of_pressure_position (center_of_pressure_offset_field)
-{ }
+{
+	compute_coefficients_table();
+	compute_projections_table();
+}
+
+
+void
+AirfoilCharacteristics::set_lift_coefficient_field (LiftField const& field)
+{
+	_lift_coefficient = field;
+	compute_coefficients_table();
+}
+
+
+void
+AirfoilCharacteristics::set_drag_coefficient_field (DragField const& field)
+{
+	_drag_coefficient = field;
+	compute_coefficients_table();
+}
+
+
+void
+AirfoilCharacteristics::set_pitching_moment_coefficient_field (PitchingMomentField const& field)
+{
+	_pitching_moment_coefficient = field;
+	compute_coefficients_table();
+}
+
+
+void
+AirfoilCharacteristics::set_center_of_pressure_position_field (CenterOfPressurePositionField const& field)
+{
+	_center_of_pressure_position = field;
+	compute_coefficients_table();
+}
+
+
+AirfoilCharacteristics::Coefficients
+AirfoilCharacteristics::coefficients (double const reynolds_number, si::Angle const alpha) const noexcept
+{
+	auto const& table = *_coefficients_table;
+	auto const [a, ta] = angle_bracket (alpha);
+
+	auto const& reynolds_numbers = table.reynolds_numbers;
+
+	// Reynolds number bracket. Rows are at the fields' own breakpoints, so interpolating between them
+	// gives the same result as the fields themselves:
+	std::size_t r = 0;
+	double tr = 0.0;
+
+	if (reynolds_numbers.size() > 1)
+	{
+		auto const re = std::clamp (reynolds_number, reynolds_numbers.front(), reynolds_numbers.back());
+		auto const upper = std::upper_bound (reynolds_numbers.begin() + 1, reynolds_numbers.end() - 1, re);
+		r = static_cast<std::size_t> (std::distance (reynolds_numbers.begin(), upper)) - 1;
+		tr = (re - reynolds_numbers[r]) / (reynolds_numbers[r + 1] - reynolds_numbers[r]);
+	}
+
+	auto const r_next = reynolds_numbers.size() > 1 ? r + 1 : r;
+	auto const& v00 = table.values[r * kTableAngleSamples + a];
+	auto const& v01 = table.values[r * kTableAngleSamples + a + 1];
+	auto const& v10 = table.values[r_next * kTableAngleSamples + a];
+	auto const& v11 = table.values[r_next * kTableAngleSamples + a + 1];
+
+	auto const interpolate = [&] (double Coefficients::* coefficient) {
+		auto const lower = v00.*coefficient + ta * (v01.*coefficient - v00.*coefficient);
+		auto const upper = v10.*coefficient + ta * (v11.*coefficient - v10.*coefficient);
+		return lower + tr * (upper - lower);
+	};
+
+	return {
+		.lift = interpolate (&Coefficients::lift),
+		.drag = interpolate (&Coefficients::drag),
+		.pitching_moment = interpolate (&Coefficients::pitching_moment),
+		.center_of_pressure_position = interpolate (&Coefficients::center_of_pressure_position),
+	};
+}
+
+
+AirfoilCharacteristics::Projections
+AirfoilCharacteristics::projections (si::Angle const alpha, si::Angle const beta) const noexcept
+{
+	auto const& table = *_projections_table;
+	auto const [a, ta] = angle_bracket (alpha);
+	auto const& p0 = table[a];
+	auto const& p1 = table[a + 1];
+	auto const cos_beta = std::abs (cos (beta));
+
+	return {
+		.chord = cos_beta * (p0.chord + ta * (p1.chord - p0.chord)),
+		.thickness = cos_beta * (p0.thickness + ta * (p1.thickness - p0.thickness)),
+	};
+}
+
+
+void
+AirfoilCharacteristics::compute_coefficients_table()
+{
+	auto table = std::make_shared<CoefficientsTable>();
+	auto& reynolds_numbers = table->reynolds_numbers;
+
+	// Fields are linear in Reynolds number between their breakpoints, so a row for each breakpoint of each field
+	// is enough. Fields may have different breakpoints and domains:
+	append_reynolds_numbers (_lift_coefficient, reynolds_numbers);
+	append_reynolds_numbers (_drag_coefficient, reynolds_numbers);
+	append_reynolds_numbers (_pitching_moment_coefficient, reynolds_numbers);
+	append_reynolds_numbers (_center_of_pressure_position, reynolds_numbers);
+	std::ranges::sort (reynolds_numbers);
+	reynolds_numbers.erase (std::unique (reynolds_numbers.begin(), reynolds_numbers.end()), reynolds_numbers.end());
+	table->values.resize (reynolds_numbers.size() * kTableAngleSamples);
+
+	for (std::size_t r = 0; r < reynolds_numbers.size(); ++r)
+	{
+		auto const re = reynolds_numbers[r];
+
+		for (std::size_t a = 0; a < kTableAngleSamples; ++a)
+		{
+			auto const alpha = -180_deg + static_cast<double> (a) * kTableAngleStep;
+
+			table->values[r * kTableAngleSamples + a] = {
+				.lift = clamped_value (_lift_coefficient, re, alpha),
+				.drag = clamped_value (_drag_coefficient, re, alpha),
+				.pitching_moment = clamped_value (_pitching_moment_coefficient, re, alpha),
+				.center_of_pressure_position = clamped_value (_center_of_pressure_position, re, alpha),
+			};
+		}
+	}
+
+	_coefficients_table = std::move (table);
+}
+
+
+void
+AirfoilCharacteristics::compute_projections_table()
+{
+	auto table = std::make_shared<ProjectionsTable> (kTableAngleSamples);
+	auto const hull = convex_hull (_spline.points());
+
+	for (std::size_t a = 0; a < kTableAngleSamples; ++a)
+	{
+		auto const rotation = z_rotation<AirfoilSplineSpace> (-180_deg + static_cast<double> (a) * kTableAngleStep);
+		double min_x = std::numeric_limits<double>::max();
+		double max_x = std::numeric_limits<double>::lowest();
+		double min_y = std::numeric_limits<double>::max();
+		double max_y = std::numeric_limits<double>::lowest();
+
+		for (auto const& point: hull)
+		{
+			auto const rotated = rotation * AirfoilSpline::Point::Resized<1, 3> { point[0], point[1], 0.0 };
+			min_x = std::min (min_x, rotated[0]);
+			max_x = std::max (max_x, rotated[0]);
+			min_y = std::min (min_y, rotated[1]);
+			max_y = std::max (max_y, rotated[1]);
+		}
+
+		(*table)[a] = {
+			.chord = hull.empty() ? 0.0 : max_x - min_x,
+			.thickness = hull.empty() ? 0.0 : max_y - min_y,
+		};
+	}
+
+	_projections_table = std::move (table);
+}
+
+
+std::pair<std::size_t, double>
+AirfoilCharacteristics::angle_bracket (si::Angle const alpha) noexcept
+{
+	auto const position = std::clamp ((alpha + 180_deg) / kTableAngleStep, 0.0, static_cast<double> (kTableAngleSamples - 1));
+	auto const index = std::min (static_cast<std::size_t> (position), kTableAngleSamples - 2);
+	return { index, position - static_cast<double> (index) };
+}
 
 } // namespace xf
 
@@ -24,6 +24,9 @@
 
 // Standard:
 #include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
 
 
 namespace xf {
@@ -36,6 +39,51 @@ namespace xf {
  */
 class AirfoilCharacteristics
 {
+	// Resolution of precomputed tables:
+	static constexpr si::Angle		kTableAngleStep			{ 0.25_deg };
+	static constexpr std::size_t	kTableAngleSamples		{ 1441 }; // [-180°…180°] in kTableAngleStep steps
+
+  public:
+	/**
+	 * All coefficients for given Reynolds number and angle of attack.
+	 */
+	class Coefficients
+	{
+	  public:
+		double	lift						{ 0.0 };
+		double	drag						{ 0.0 };
+		double	pitching_moment				{ 0.0 };
+		double	center_of_pressure_position	{ 0.0 };
+	};
+
+	/**
+	 * Airfoil chord length projected onto the plane perpendicular to the wind and airfoil thickness
+	 * projected onto the plane perpendicular to the lift vector, relative to the chord length.
+	 */
+	class Projections
+	{
+	  public:
+		double	chord		{ 0.0 };
+		double	thickness	{ 0.0 };
+	};
+
+  private:
+	/**
+	 * All coefficients sampled at Reynolds numbers for which any of the fields has data,
+	 * and on a regular angle of attack grid.
+	 */
+	class CoefficientsTable
+	{
+	  public:
+		// Sorted Reynolds numbers of the rows:
+		std::vector<double>			reynolds_numbers;
+		// Element [r * kTableAngleSamples + a] is for r-th Reynolds number and a-th angle:
+		std::vector<Coefficients>	values;
+	};
+
+	// Element [a] is for a-th angle on the same grid as in CoefficientsTable:
+	using ProjectionsTable = std::vector<Projections>;
+
   public:
 	// All fields must be defined for angle of attack range [-180°…180°].
 	// They map Reynolds number and angle of attack to a result coefficient:
@@ -76,8 +124,7 @@ class AirfoilCharacteristics
 	 * Set new lift coefficient field.
 	 */
 	void
-	set_lift_coefficient_field (LiftField const& field)
-		{ _lift_coefficient = field; }
+	set_lift_coefficient_field (LiftField const& field);
 
 	/**
 	 * Drag coefficient field.
@@ -92,8 +139,7 @@ class AirfoilCharacteristics
 	 * Set new drag coefficient field.
 	 */
 	void
-	set_drag_coefficient_field (DragField const& field)
-		{ _drag_coefficient = field; }
+	set_drag_coefficient_field (DragField const& field);
 
 	/**
 	 * Pitching moment coefficient field.
@@ -108,8 +154,7 @@ class AirfoilCharacteristics
 	 * Set new pitching moment coefficient field.
 	 */
 	void
-	set_pitching_moment_coefficient_field (PitchingMomentField const& field)
-		{ _pitching_moment_coefficient = field; }
+	set_pitching_moment_coefficient_field (PitchingMomentField const& field);
 
 	/**
 	 * Center of pressure position field (relative to origin).
@@ -125,8 +170,7 @@ class AirfoilCharacteristics
 	 * Set new center of pressure position field.
 	 */
 	void
-	set_center_of_pressure_position_field (CenterOfPressurePositionField const& field)
-		{ _center_of_pressure_position = field; }
+	set_center_of_pressure_position_field (CenterOfPressurePositionField const& field);
 
 	/**
 	 * Return value of lift coefficient field.
@@ -164,12 +208,54 @@ class AirfoilCharacteristics
 		center_of_pressure_position (Arg&& ...args) const
 			{ return _center_of_pressure_position (std::forward<Arg> (args)...); }
 
+	/**
+	 * Return all coefficients at once from the precomputed table.
+	 * Uses bilinear interpolation with a single bracket search for all coefficients.
+	 * Each coefficient is the same as from its field with Reynolds number clamped to that field's domain.
+	 *
+	 * \param	alpha
+	 *			Angle of attack in range [-180°…180°].
+	 */
+	[[nodiscard]]
+	Coefficients
+	coefficients (double reynolds_number, si::Angle alpha) const noexcept;
+
+	/**
+	 * Return chord and thickness projections of the spline from the precomputed table.
+	 * Equivalent to spline().projected_chord_and_thickness(), but doesn't need to rotate all spline points.
+	 *
+	 * \param	alpha
+	 *			Angle of attack in range [-180°…180°].
+	 */
+	[[nodiscard]]
+	Projections
+	projections (si::Angle alpha, si::Angle beta) const noexcept;
+
+  private:
+	void
+	compute_coefficients_table();
+
+	void
+	compute_projections_table();
+
+	/**
+	 * Return index of the lower sample for given alpha and a weight of the upper sample.
+	 */
+	[[nodiscard]]
+	static std::pair<std::size_t, double>
+	angle_bracket (si::Angle alpha) noexcept;
+
   private:
 	AirfoilSpline					_spline;
 	LiftField						_lift_coefficient;				// Cl
 	DragField						_drag_coefficient;				// Cd
 	PitchingMomentField				_pitching_moment_coefficient;	// Cm
 	CenterOfPressurePositionField	_center_of_pressure_position;	// XCp
+	// Tables are shared between copies, since Airfoils copy their AirfoilCharacteristics:
+	std::shared_ptr<CoefficientsTable const>
+									_coefficients_table;
+	std::shared_ptr<ProjectionsTable const>
+									_projections_table;
 };
 
 } // namespace xf
@@ -38,9 +38,9 @@ std::pair<double, double>
 AirfoilSpline::projected_chord_and_thickness (si::Angle const alpha, si::Angle const beta) const
 {
 	double min_x = std::numeric_limits<double>::max();
-	double max_x = std::numeric_limits<double>::min();
+	double max_x = std::numeric_limits<double>::lowest();
 	double min_y = std::numeric_limits<double>::max();
-	double max_y = std::numeric_limits<double>::min();
+	double max_y = std::numeric_limits<double>::lowest();
 
 	for (auto point: _points)
 	{
@@ -0,0 +1,231 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/aerodynamics/airfoil.h>
+#include <xefis/support/aerodynamics/airfoil_characteristics.h>
+#include <xefis/support/aerodynamics/airfoil_spline.h>
+#include <xefis/support/earth/air/standard_atmosphere.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+AirfoilSpline const kSpline {
+	{ 1.00,  0.00 },
+	{ 0.75,  0.04 },
+	{ 0.50,  0.08 },
+	{ 0.25,  0.10 },
+	{ 0.10,  0.08 },
+	{ 0.00,  0.00 },
+	{ 0.10, -0.04 },
+	{ 0.25, -0.05 },
+	{ 0.50, -0.04 },
+	{ 0.75, -0.02 },
+};
+
+
+/**
+ * Return a field with given Reynolds number breakpoints. Angle breakpoints are aligned with
+ * the AirfoilCharacteristics angle table, Reynolds numbers don't need to be.
+ */
+AirfoilCharacteristics::LiftField
+make_field (std::array<double, 3> const& reynolds_numbers, double const offset, double const scale)
+{
+	auto const s0 = scale;
+	auto const s1 = 1.3 * scale;
+	auto const s2 = 0.8 * scale;
+
+	return {
+		{
+			reynolds_numbers[0],
+			{
+				{ -180_deg, offset + s0 *  0.0 },
+				{ -135_deg, offset + s0 *  0.7 },
+				{  -90_deg, offset + s0 *  0.1 },
+				{  -45_deg, offset + s0 * -0.9 },
+				{    0_deg, offset + s0 *  0.2 },
+				{   45_deg, offset + s0 *  1.1 },
+				{   90_deg, offset + s0 *  0.1 },
+				{  135_deg, offset + s0 * -0.7 },
+				{  180_deg, offset + s0 *  0.0 },
+			},
+		},
+		{
+			reynolds_numbers[1],
+			{
+				{ -180_deg, offset + s1 *  0.0 },
+				{ -135_deg, offset + s1 *  0.8 },
+				{  -90_deg, offset + s1 *  0.2 },
+				{  -45_deg, offset + s1 * -1.0 },
+				{    0_deg, offset + s1 *  0.3 },
+				{   45_deg, offset + s1 *  1.3 },
+				{   90_deg, offset + s1 *  0.2 },
+				{  135_deg, offset + s1 * -0.8 },
+				{  180_deg, offset + s1 *  0.0 },
+			},
+		},
+		{
+			reynolds_numbers[2],
+			{
+				{ -180_deg, offset + s2 *  0.0 },
+				{ -135_deg, offset + s2 *  0.6 },
+				{  -90_deg, offset + s2 *  0.3 },
+				{  -45_deg, offset + s2 * -0.8 },
+				{    0_deg, offset + s2 *  0.1 },
+				{   45_deg, offset + s2 *  1.2 },
+				{   90_deg, offset + s2 *  0.3 },
+				{  135_deg, offset + s2 * -0.6 },
+				{  180_deg, offset + s2 *  0.0 },
+			},
+		},
+	};
+}
+
+
+/**
+ * Fields have different Reynolds number breakpoints and domains, like the ones generated
+ * for sim-1 airfoils (31000 + 20000·k):
+ */
+AirfoilCharacteristics
+make_airfoil_characteristics()
+{
+	return AirfoilCharacteristics (kSpline,
+								   make_field ({ 31'000, 51'000, 171'000 }, 0.0, 1.0),
+								   make_field ({ 20'000, 90'000, 250'000 }, 0.05, 0.5),
+								   make_field ({ 31'000, 111'000, 131'000 }, -0.1, 0.1),
+								   make_field ({ 71'000, 72'000, 300'000 }, 0.25, 0.05));
+}
+
+
+/**
+ * Return field value with Reynolds number clamped to the field's domain.
+ */
+double
+clamped_value (AirfoilCharacteristics::LiftField const& field, double const reynolds_number, si::Angle const alpha)
+{
+	auto const domain = field.domain();
+	return field (std::clamp (reynolds_number, domain.min(), domain.max()), alpha);
+}
+
+
+AutoTest t_1 ("AirfoilCharacteristics: precomputed coefficients match fields", []{
+	auto const characteristics = make_airfoil_characteristics();
+	std::mt19937 prng (1);
+	// Also outside of the domains of the fields:
+	std::uniform_real_distribution<double> reynolds_distribution (1e4, 3.5e5);
+	std::uniform_real_distribution<double> angle_distribution (-180.0, 180.0);
+	std::vector<double> reynolds_numbers = { 20'000, 31'000, 51'000, 71'000, 72'000, 90'000, 111'000, 131'000, 171'000, 250'000, 300'000 };
+
+	for (std::size_t i = 0; i < 1000; ++i)
+		reynolds_numbers.push_back (reynolds_distribution (prng));
+
+	for (auto const re: reynolds_numbers)
+	{
+		auto const alpha = 1_deg * angle_distribution (prng);
+		auto const coefficients = characteristics.coefficients (re, alpha);
+
+		test_asserts::verify_equal_with_epsilon ("lift coefficient", coefficients.lift,
+												 clamped_value (characteristics.lift_coefficient_field(), re, alpha), 1e-9);
+		test_asserts::verify_equal_with_epsilon ("drag coefficient", coefficients.drag,
+												 clamped_value (characteristics.drag_coefficient_field(), re, alpha), 1e-9);
+		test_asserts::verify_equal_with_epsilon ("pitching moment coefficient", coefficients.pitching_moment,
+												 clamped_value (characteristics.pitching_moment_coefficient_field(), re, alpha), 1e-9);
+		test_asserts::verify_equal_with_epsilon ("center of pressure position", coefficients.center_of_pressure_position,
+												 clamped_value (characteristics.center_of_pressure_position_field(), re, alpha), 1e-9);
+	}
+});
+
+
+AutoTest t_2 ("AirfoilCharacteristics: precomputed projections match spline", []{
+	auto const characteristics = make_airfoil_characteristics();
+
+	for (auto alpha = -180_deg; alpha <= 180_deg; alpha += 0.7_deg)
+	{
+		for (auto const beta: { 0_deg, 10_deg, -30_deg })
+		{
+			auto const [chord, thickness] = kSpline.projected_chord_and_thickness (alpha, beta);
+			auto const projections = characteristics.projections (alpha, beta);
+
+			test_asserts::verify_equal_with_epsilon ("projected chord", projections.chord, chord, 1e-4);
+			test_asserts::verify_equal_with_epsilon ("projected thickness", projections.thickness, thickness, 1e-4);
+		}
+	}
+});
+
+
+AutoTest t_3 ("Airfoil: batch aerodynamic_forces() gives the same results as single calls", []{
+	auto const airfoil = Airfoil (make_airfoil_characteristics(), 20_cm, 1_m);
+	auto const sea_level_air = Air<AirfoilSplineSpace> {
+		.density = standard_density (0_m),
+		.pressure = standard_pressure (0_m),
+		.temperature = standard_temperature (0_m),
+		.dynamic_viscosity = dynamic_air_viscosity (standard_temperature (0_m)),
+		.speed_of_sound = 340_mps,
+		.velocity = { 0_mps, 0_mps, 0_mps },
+	};
+	std::vector<Air<AirfoilSplineSpace>> airs;
+
+	// Include zero velocity, and more segments than a single batch:
+	for (std::size_t i = 0; i < 37; ++i)
+	{
+		auto const angle = 10_deg * static_cast<double> (i);
+		auto air = sea_level_air;
+		air.velocity = i == 0
+			? SpaceVector<si::Velocity, AirfoilSplineSpace> { 0_mps, 0_mps, 0_mps }
+			: SpaceVector<si::Velocity, AirfoilSplineSpace> { 15_mps * cos (angle), 15_mps * sin (angle), 1_mps * static_cast<double> (i % 3) };
+		airs.push_back (air);
+	}
+
+	std::vector<AirfoilAerodynamicParameters<AirfoilSplineSpace>> results (airs.size());
+	airfoil.aerodynamic_forces (airs, results);
+
+	for (std::size_t i = 0; i < airs.size(); ++i)
+	{
+		auto const single = airfoil.aerodynamic_forces (airs[i]);
+		auto const& batch = results[i];
+
+		test_asserts::verify_equal_with_epsilon ("lift", abs (batch.forces.lift), abs (single.forces.lift), 1e-9_N);
+		test_asserts::verify_equal_with_epsilon ("drag", abs (batch.forces.drag), abs (single.forces.drag), 1e-9_N);
+		test_asserts::verify_equal_with_epsilon ("pitching moment", abs (batch.forces.pitching_moment), abs (single.forces.pitching_moment), 1e-9_Nm);
+		test_asserts::verify_equal_with_epsilon ("center of pressure", abs (batch.forces.center_of_pressure - single.forces.center_of_pressure), 0_m, 1e-9_m);
+	}
+
+	bool rejected = false;
+
+	try {
+		std::vector<AirfoilAerodynamicParameters<AirfoilSplineSpace>> too_short_results (airs.size() - 1);
+		airfoil.aerodynamic_forces (airs, too_short_results);
+	}
+	catch (InvalidArgument const&)
+	{
+		rejected = true;
+	}
+
+	test_asserts::verify ("results of a different size than relative_airs are rejected", rejected);
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -29,6 +29,7 @@
 // Standard:
 #include <cstddef>
 #include <limits>
+#include <utility>
 
 
 namespace xf::crypto::xle {
@@ -43,6 +44,16 @@ Handshake::Handshake (boost::random::random_device& random_device, Params const&
 { }
 
 
+Blob
+Handshake::take_exchange_blob()
+{
+	if (_prepared_dhe_exchange_blob)
+		return *std::exchange (_prepared_dhe_exchange_blob, std::nullopt);
+	else
+		return _dhe_exchange.generate_exchange_blob();
+}
+
+
 Blob
 HandshakeMaster::generate_handshake_blob (si::Time const unix_timestamp)
 {
@@ -54,7 +65,7 @@ HandshakeMaster::generate_handshake_blob (si::Time const unix_timestamp)
 	return make_master_handshake_blob ({
 		.handshake_id = _handshake_id,
 		.unix_timestamp_ms = round_to<uint64_t> (unix_timestamp.in<si::Millisecond>()),
-		.dhe_exchange_blob = _dhe_exchange.generate_exchange_blob(),
+		.dhe_exchange_blob = take_exchange_blob(),
 	});
 }
 
@@ -134,7 +145,7 @@ HandshakeSlave::generate_handshake_blob_and_key (BlobView const master_handshake
 	if (abs (1_ms * master_handshake.unix_timestamp_ms - neutrino::TimeHelper::now()) > _max_time_difference)
 		throw Exception (ErrorCode::DeltaTimeTooHigh, "delta time too high");
 
-	Blob const dhe_exchange_blob = _dhe_exchange.generate_exchange_blob();
+	Blob const dhe_exchange_blob = take_exchange_blob();
 	Blob const ephemeral_key_with_weak_bits = _dhe_exchange.calculate_key_with_weak_bits (master_handshake.dhe_exchange_blob);
 	Blob const ephemeral_key = calculate_hash<kHashAlgorithm> (ephemeral_key_with_weak_bits);
 
@@ -29,6 +29,7 @@
 // Standard:
 #include <cstddef>
 #include <functional>
+#include <optional>
 #include <variant>
 
 
@@ -95,6 +96,23 @@ class Handshake
 	// Ctor
 	Handshake (boost::random::random_device&, Params const&);
 
+	/**
+	 * Generate own part of the DHE exchange in advance. It's the costly part of generating
+	 * the handshake blob, so it can be done on another thread before the handshake is needed.
+	 * The handshake object must not be used concurrently.
+	 */
+	void
+	prepare_exchange_blob()
+		{ _prepared_dhe_exchange_blob = _dhe_exchange.generate_exchange_blob(); }
+
+  protected:
+	/**
+	 * Return the exchange blob prepared with prepare_exchange_blob() or generate a new one.
+	 */
+	[[nodiscard]]
+	Blob
+	take_exchange_blob();
+
   protected:
 	static constexpr Hash::Algorithm const kHashAlgorithm = Hash::SHA3_256;
 
@@ -103,6 +121,7 @@ class Handshake
 	Secure<Blob> const				_master_signature_key;
 	Secure<Blob> const				_slave_signature_key;
 	DiffieHellmanExchange			_dhe_exchange;
+	std::optional<Blob>				_prepared_dhe_exchange_blob;
 	size_t const					_hmac_size;
 	si::Time const					_max_time_difference;
 };
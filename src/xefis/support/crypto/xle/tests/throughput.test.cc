@@ -0,0 +1,102 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/crypto/xle/transport.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Boost:
+#include <boost/random/random_device.hpp>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+using xf::crypto::xle::Receiver;
+using xf::crypto::xle::Transmitter;
+
+constexpr std::size_t	kPackets	= 100'000;
+
+
+void
+print_throughput (std::string_view const name, std::size_t const payload_size, si::Time const total)
+{
+	std::cout << std::format ("  {:4} B {:32} {:10.0f} packets/s, {:8.3f} µs/packet\n",
+							  payload_size,
+							  name,
+							  kPackets / total.in<si::Second>(),
+							  total.in<si::Second>() * 1e6 / kPackets);
+}
+
+
+ManualTest t_1 ("Xefis Lossy Encryption/Transport: packet throughput", []{
+	Blob const key = to_blob ("abcdefghijklmnop");
+	boost::random::random_device rnd;
+
+	std::cout << std::format ("{} packets per measurement:\n", kPackets);
+
+	for (std::size_t const payload_size: { 64u, 128u, 256u, 512u, 1024u })
+	{
+		Transmitter tx (rnd, { .ephemeral_session_key = key });
+		Receiver rx ({ .ephemeral_session_key = key });
+		Blob const plain_text (payload_size, 0x55);
+		std::vector<Blob> packets (kPackets);
+
+		si::Time const encryption = TimeHelper::measure ([&] {
+			for (auto& packet: packets)
+				packet = tx.encrypt_packet (plain_text);
+		});
+		print_throughput ("encrypt_packet() → Blob", payload_size, encryption);
+
+		si::Time const decryption = TimeHelper::measure ([&] {
+			for (auto const& packet: packets)
+				static_cast<void> (rx.decrypt_packet (packet));
+		});
+		print_throughput ("decrypt_packet() → Blob", payload_size, decryption);
+
+		// Buffers reused for all packets:
+		Blob buffer (payload_size + tx.ciphertext_expansion(), 0);
+		Blob output (payload_size, 0);
+
+		si::Time const encryption_into_buffer = TimeHelper::measure ([&] {
+			for (std::size_t i = 0; i < kPackets; ++i)
+				tx.encrypt_packet (plain_text, buffer);
+		});
+		print_throughput ("encrypt_packet() into buffer", payload_size, encryption_into_buffer);
+
+		// Can't decrypt the same packet twice, so encrypt into the buffer each time and subtract encryption time:
+		si::Time const round_trip_into_buffer = TimeHelper::measure ([&] {
+			for (std::size_t i = 0; i < kPackets; ++i)
+			{
+				tx.encrypt_packet (plain_text, buffer);
+				static_cast<void> (rx.decrypt_packet (buffer, output));
+			}
+		});
+		print_throughput ("decrypt_packet() into buffer", payload_size, round_trip_into_buffer - encryption_into_buffer);
+	}
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -15,18 +15,139 @@
 #include <xefis/support/crypto/xle/transport.h>
 
 // Neutrino:
+#include <neutrino/crypto/aes.h>
+#include <neutrino/crypto/hash.h>
+#include <neutrino/crypto/hkdf.h>
+#include <neutrino/crypto/hmac.h>
+#include <neutrino/crypto/utility.h>
 #include <neutrino/test/auto_test.h>
 
 // Boost:
 #include <boost/random/random_device.hpp>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
+#include <optional>
+#include <string_view>
 
 
 namespace xf::test {
 namespace {
 
+using xf::crypto::xle::Receiver;
+using xf::crypto::xle::Transmitter;
+using xf::crypto::xle::Transport;
+
+
+constexpr size_t kHMACSize = 12;
+
+
+/**
+ * Straightforward implementation of the XLE packet format using stateless Neutrino functions,
+ * to check that Transmitter and Receiver stay wire-compatible with it.
+ */
+class ReferenceTransport
+{
+  public:
+	explicit
+	ReferenceTransport (BlobView const key):
+		_hmac_key (derive_key (key, "hmac_key")),
+		_data_encryption_key (derive_key (key, "data_encryption_key")),
+		_seq_num_encryption_key (derive_key (key, "seq_num_encryption_key"))
+	{ }
+
+	Blob
+	encrypt_packet (BlobView const data, Transport::SequenceNumber const sequence_number, BlobView const salt) const
+	{
+		auto const binary_sequence_number = to_blob (sequence_number);
+		auto const hmac = calculate_hmac<Hash::SHA3_256> ({
+			.data = data + salt + binary_sequence_number,
+			.key = _hmac_key,
+		}).substr (0, kHMACSize);
+		auto const encrypted_data = aes_ctr_xor ({
+			.data = data + salt + hmac,
+			.key = _data_encryption_key,
+			.nonce = calculate_hash<Hash::SHA3_256> (binary_sequence_number).substr (0, 8),
+		});
+		auto const encrypted_sequence_number = aes_ctr_xor ({
+			.data = binary_sequence_number,
+			.key = _seq_num_encryption_key,
+			.nonce = calculate_hash<Hash::SHA3_256> (encrypted_data).substr (0, 8),
+		});
+
+		return encrypted_sequence_number + encrypted_data;
+	}
+
+	/**
+	 * Return decrypted data or std::nullopt if HMAC doesn't match.
+	 */
+	std::optional<Blob>
+	decrypt_packet (BlobView const encrypted_packet) const
+	{
+		auto const encrypted_data = encrypted_packet.substr (sizeof (Transport::SequenceNumber));
+		auto const binary_sequence_number = aes_ctr_xor ({
+			.data = encrypted_packet.substr (0, sizeof (Transport::SequenceNumber)),
+			.key = _seq_num_encryption_key,
+			.nonce = calculate_hash<Hash::SHA3_256> (encrypted_data).substr (0, 8),
+		});
+		auto const data_with_hmac = aes_ctr_xor ({
+			.data = encrypted_data,
+			.key = _data_encryption_key,
+			.nonce = calculate_hash<Hash::SHA3_256> (binary_sequence_number).substr (0, 8),
+		});
+		auto const data_size = data_with_hmac.size() - Transport::kDataSaltSize - kHMACSize;
+		auto const data = data_with_hmac.substr (0, data_size);
+		auto const salt = data_with_hmac.substr (data_size, Transport::kDataSaltSize);
+		auto const hmac = data_with_hmac.substr (data_size + Transport::kDataSaltSize);
+		auto const calculated_hmac = calculate_hmac<Hash::SHA3_256> ({
+			.data = data + salt + binary_sequence_number,
+			.key = _hmac_key,
+		}).substr (0, kHMACSize);
+
+		if (hmac == calculated_hmac)
+			return data;
+		else
+			return std::nullopt;
+	}
+
+  private:
+	static Blob
+	derive_key (BlobView const key, std::string_view const info)
+	{
+		return calculate_hkdf<Hash::SHA3_256> ({
+			.salt = {},
+			.key_material = key,
+			.info = to_blob (info),
+			.result_length = 32,
+		});
+	}
+
+  private:
+	Blob	_hmac_key;
+	Blob	_data_encryption_key;
+	Blob	_seq_num_encryption_key;
+};
+
+
+/**
+ * Return Transport::ErrorCode of the DecryptionFailure thrown by the function or std::nullopt.
+ */
+template<class Function>
+	std::optional<Transport::ErrorCode>
+	decryption_error (Function&& function)
+	{
+		try {
+			function();
+			return std::nullopt;
+		}
+		catch (Transport::DecryptionFailure const& failure)
+		{
+			return failure.error_code();
+		}
+	}
+
+
 AutoTest t1 ("Xefis Lossy Encryption/Transport: encryption and decryption", []{
 	Blob const key = to_blob ("abcdefghijklmnop");
 
@@ -49,6 +170,87 @@ AutoTest t1 ("Xefis Lossy Encryption/Transport: encryption and decryption", []{
 	test_asserts::verify ("encryption expansion is declared properly (2)", encrypted.size() - plain_text.size() == tx.ciphertext_expansion());
 });
 
+
+AutoTest t2 ("Xefis Lossy Encryption/Transport: encryption and decryption into buffers", []{
+	Blob const key = to_blob ("abcdefghijklmnop");
+	Blob const plain_text = to_blob ("some plain text that is encrypted in place");
+
+	boost::random::random_device rnd;
+	Transmitter tx (rnd, { .ephemeral_session_key = key, .hmac_size = kHMACSize });
+	Receiver rx ({ .ephemeral_session_key = key, .hmac_size = kHMACSize });
+
+	Blob buffer (plain_text.size() + tx.ciphertext_expansion(), 0);
+	Blob output (plain_text.size(), 0);
+
+	for (int i = 0; i < 3; ++i)
+	{
+		// Put the data in place first:
+		std::copy (plain_text.begin(), plain_text.end(), buffer.begin() + sizeof (Transport::SequenceNumber));
+		auto const data = BlobView (buffer).substr (sizeof (Transport::SequenceNumber), plain_text.size());
+		tx.encrypt_packet (data, buffer);
+		auto const size = rx.decrypt_packet (buffer, output);
+
+		test_asserts::verify ("decrypted size is correct", size == plain_text.size());
+		test_asserts::verify ("decryption works", output == plain_text);
+	}
+});
+
+
+AutoTest t3 ("Xefis Lossy Encryption/Transport: compatibility with reference implementation", []{
+	Blob const key = to_blob ("abcdefghijklmnop");
+	Blob const salt = to_blob ("saltsalt");
+
+	boost::random::random_device rnd;
+	ReferenceTransport reference (key);
+	Transmitter tx (rnd, { .ephemeral_session_key = key, .hmac_size = kHMACSize });
+	Receiver rx ({ .ephemeral_session_key = key, .hmac_size = kHMACSize });
+	Transport::SequenceNumber sequence_number = 0;
+
+	for (size_t const size: { 0u, 1u, 8u, 15u, 16u, 17u, 64u, 1000u })
+	{
+		Blob plain_text (size, 0);
+
+		for (size_t i = 0; i < size; ++i)
+			plain_text[i] = static_cast<uint8_t> (i * 7 + size);
+
+		auto const decrypted = reference.decrypt_packet (tx.encrypt_packet (plain_text));
+		test_asserts::verify ("reference implementation decrypts Transmitter's packets", decrypted && *decrypted == plain_text);
+
+		auto const encrypted = reference.encrypt_packet (plain_text, ++sequence_number, salt);
+		test_asserts::verify ("Receiver decrypts reference implementation's packets", rx.decrypt_packet (encrypted) == plain_text);
+	}
+});
+
+
+AutoTest t4 ("Xefis Lossy Encryption/Transport: decryption failures", []{
+	Blob const key = to_blob ("abcdefghijklmnop");
+	Blob const plain_text = to_blob ("plain text");
+
+	boost::random::random_device rnd;
+	Transmitter tx (rnd, { .ephemeral_session_key = key });
+	Receiver rx ({ .ephemeral_session_key = key });
+
+	auto const packet_1 = tx.encrypt_packet (plain_text);
+	auto const packet_2 = tx.encrypt_packet (plain_text);
+	auto const packet_3 = tx.encrypt_packet (plain_text);
+	auto tampered_packet = packet_2;
+	tampered_packet[sizeof (Transport::SequenceNumber) + 1] ^= 0x01;
+
+	test_asserts::verify ("short packet is rejected",
+						  decryption_error ([&] { static_cast<void> (rx.decrypt_packet (BlobView (packet_1).substr (0, rx.ciphertext_expansion() - 1))); })
+						  == Transport::HMACTooShort);
+	test_asserts::verify ("tampered packet is rejected",
+						  decryption_error ([&] { static_cast<void> (rx.decrypt_packet (tampered_packet)); }) == Transport::InvalidAuthentication);
+	test_asserts::verify ("packet from far future is rejected",
+						  decryption_error ([&] { static_cast<void> (rx.decrypt_packet (packet_2, 1)); }) == Transport::SeqNumFromFarFuture);
+	test_asserts::verify ("valid packet is accepted",
+						  !decryption_error ([&] { static_cast<void> (rx.decrypt_packet (packet_2)); }));
+	test_asserts::verify ("replayed packet is rejected",
+						  decryption_error ([&] { static_cast<void> (rx.decrypt_packet (packet_1)); }) == Transport::SeqNumFromPast);
+	test_asserts::verify ("next packet is accepted after failures",
+						  rx.decrypt_packet (packet_3) == plain_text);
+});
+
 } // namespace
 } // namespace xf::test
 
@@ -18,15 +18,99 @@
 #include <xefis/config/all.h>
 
 // Neutrino:
-#include <neutrino/crypto/aes.h>
 #include <neutrino/crypto/hkdf.h>
 #include <neutrino/crypto/utility.h>
+#include <neutrino/stdexcept.h>
+
+// Lib:
+#include <boost/endian/conversion.hpp>
+#include <cryptopp/aes.h>
+#include <cryptopp/hmac.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha3.h>
 
 // Standard:
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
 
 
 namespace xf::crypto::xle {
+namespace {
+
+// Size of nonces used for AES-CTR; the rest of the AES block is the block counter, starting from 0.
+constexpr size_t kNonceSize		= 8;
+constexpr size_t kMaxHMACSize	= CryptoPP::SHA3_256::DIGESTSIZE;
+
+using Nonce				= std::array<uint8_t, kNonceSize>;
+using BinarySeqNum		= std::array<uint8_t, sizeof (Transport::SequenceNumber)>;
+using AESCTREncryption	= CryptoPP::CTR_Mode<CryptoPP::AES>::Encryption;
+
+} // namespace
+
+
+/**
+ * AES and HMAC contexts with keys already expanded.
+ * Only Hash::SHA3_256 is implemented, hence the static_asserts.
+ */
+struct Transport::Contexts
+{
+	static_assert (kSignatureHMACHashAlgorithm == Hash::SHA3_256);
+	static_assert (kDataNonceHashAlgorithm == Hash::SHA3_256);
+	static_assert (kSeqNumNonceHashAlgorithm == Hash::SHA3_256);
+
+	CryptoPP::HMAC<CryptoPP::SHA3_256>	hmac;
+	AESCTREncryption					data_cipher;
+	AESCTREncryption					seq_num_cipher;
+	CryptoPP::SHA3_256					nonce_hash;
+
+	// Ctor
+	explicit
+	Contexts (BlobView hmac_key, BlobView data_encryption_key, BlobView seq_num_encryption_key);
+
+	/**
+	 * Return first kNonceSize bytes of the hash of the data.
+	 */
+	Nonce
+	nonce_for (BlobView data);
+
+	/**
+	 * Restart cipher with given nonce, so that the next ProcessData() starts the key stream from the beginning.
+	 * Same as creating a new cipher for each packet, but without expanding the key again.
+	 */
+	static void
+	restart (AESCTREncryption& cipher, Nonce const& nonce);
+};
+
+
+Transport::Contexts::Contexts (BlobView const hmac_key, BlobView const data_encryption_key, BlobView const seq_num_encryption_key):
+	hmac (hmac_key.data(), hmac_key.size())
+{
+	std::array<uint8_t, CryptoPP::AES::BLOCKSIZE> const zero_iv {};
+	data_cipher.SetKeyWithIV (data_encryption_key.data(), data_encryption_key.size(), zero_iv.data(), zero_iv.size());
+	seq_num_cipher.SetKeyWithIV (seq_num_encryption_key.data(), seq_num_encryption_key.size(), zero_iv.data(), zero_iv.size());
+}
+
+
+Nonce
+Transport::Contexts::nonce_for (BlobView const data)
+{
+	Nonce nonce;
+	nonce_hash.Update (data.data(), data.size());
+	nonce_hash.TruncatedFinal (nonce.data(), nonce.size());
+	return nonce;
+}
+
+
+void
+Transport::Contexts::restart (AESCTREncryption& cipher, Nonce const& nonce)
+{
+	std::array<uint8_t, CryptoPP::AES::BLOCKSIZE> iv {};
+	std::copy (nonce.begin(), nonce.end(), iv.begin());
+	cipher.Resynchronize (iv.data(), static_cast<int> (iv.size()));
+}
+
 
 Transport::Transport (Params const& params):
 	_hmac_size (params.hmac_size)
@@ -51,9 +135,17 @@ Transport::Transport (Params const& params):
 		.info = params.hkdf_user_info + to_blob ("seq_num_encryption_key"),
 		.result_length = 32,
 	});
+
+	_contexts = std::make_unique<Contexts> (*_hmac_key, *_data_encryption_key, *_seq_num_encryption_key);
 }
 
 
+Transport::Transport (Transport&&) = default;
+
+
+Transport::~Transport() = default;
+
+
 Transmitter::Transmitter (boost::random::random_device& random_device, Params const& params):
 	Transport (params),
 	_random_device (random_device)
@@ -77,90 +169,124 @@ Transmitter::Transmitter (boost::random::random_device& random_device, Params co
 Blob
 Transmitter::encrypt_packet (BlobView const data)
 {
-	++_sequence_number;
+	Blob encrypted_packet (data.size() + ciphertext_expansion(), 0);
+	encrypt_packet (data, encrypted_packet);
+	return encrypted_packet;
+}
 
-	// It's required that to_blob() gives little-endian encoding:
-	auto const binary_sequence_number = to_blob (_sequence_number);
-	auto const salt = random_blob (kDataSaltSize, _random_device);
-	auto const full_hmac = calculate_hmac<kSignatureHMACHashAlgorithm> ({
-		.data = data + salt + binary_sequence_number,
-		.key = *_hmac_key,
-	});
 
-	if (full_hmac.size() < _hmac_size)
+void
+Transmitter::encrypt_packet (BlobView const data, std::span<uint8_t> const output)
+{
+	if (output.size() != data.size() + ciphertext_expansion())
+		throw InvalidArgument ("Transmitter::encrypt_packet(): wrong output buffer size");
+
+	if (kMaxHMACSize < _hmac_size)
 		throw std::logic_error ("HMAC size doesn't fit requirements");
 
-	auto const hmac = full_hmac.substr (0, _hmac_size);
-	auto const encrypted_data = aes_ctr_xor ({
-		.data = data + salt + hmac,
-		.key = *_data_encryption_key,
-		.nonce = calculate_hash<kDataNonceHashAlgorithm> (binary_sequence_number).substr (0, 8),
-	});
-	auto const encrypted_sequence_number = aes_ctr_xor ({
-		.data = binary_sequence_number,
-		.key = *_seq_num_encryption_key,
-		// Encrypted data must be at least 8 bytes, but longer is better for better entropy to avoid
-		// repeating nonce ever. That's why data salt is added before encryption.
-		.nonce = calculate_hash<kSeqNumNonceHashAlgorithm> (encrypted_data).substr (0, 8),
-	});
-	auto const encrypted_packet = encrypted_sequence_number + encrypted_data;
+	++_sequence_number;
 
-	return encrypted_packet;
+	auto& contexts = *_contexts;
+	BinarySeqNum binary_sequence_number;
+	boost::endian::store_little_u64 (binary_sequence_number.data(), _sequence_number);
+
+	auto const encrypted_sequence_number = output.first (sizeof (SequenceNumber));
+	auto const encrypted_data = output.subspan (sizeof (SequenceNumber));
+	auto const data_part = encrypted_data.first (data.size());
+	auto const salt_part = encrypted_data.subspan (data.size(), kDataSaltSize);
+	auto const hmac_part = encrypted_data.subspan (data.size() + kDataSaltSize);
+
+	// Data may already be in place (or overlap), hence memmove():
+	if (!data.empty())
+		std::memmove (data_part.data(), data.data(), data.size());
+
+	for (size_t i = 0; i < salt_part.size(); i += sizeof (uint32_t))
+	{
+		uint32_t const random = _random_device();
+		std::memcpy (salt_part.data() + i, &random, std::min (sizeof (random), salt_part.size() - i));
+	}
+
+	contexts.hmac.Update (data_part.data(), data_part.size());
+	contexts.hmac.Update (salt_part.data(), salt_part.size());
+	contexts.hmac.Update (binary_sequence_number.data(), binary_sequence_number.size());
+	contexts.hmac.TruncatedFinal (hmac_part.data(), hmac_part.size());
+
+	// Encrypt data + salt + HMAC in place:
+	Contexts::restart (contexts.data_cipher, contexts.nonce_for (BlobView (binary_sequence_number.data(), binary_sequence_number.size())));
+	contexts.data_cipher.ProcessData (encrypted_data.data(), encrypted_data.data(), encrypted_data.size());
+
+	// Encrypted data must be at least 8 bytes, but longer is better for better entropy to avoid
+	// repeating nonce ever. That's why data salt is added before encryption.
+	Contexts::restart (contexts.seq_num_cipher, contexts.nonce_for (BlobView (encrypted_data.data(), encrypted_data.size())));
+	contexts.seq_num_cipher.ProcessData (encrypted_sequence_number.data(), binary_sequence_number.data(), binary_sequence_number.size());
 }
 
 
 Blob
 Receiver::decrypt_packet (BlobView const encrypted_packet, std::optional<SequenceNumber> const maximum_allowed_sequence_number)
 {
-	auto const encrypted_sequence_number = encrypted_packet.substr (0, sizeof (_sequence_number));
-	auto const encrypted_data = encrypted_packet.substr (sizeof (_sequence_number));
-	auto const binary_sequence_number = aes_ctr_xor ({
-		.data = encrypted_sequence_number,
-		.key = *_seq_num_encryption_key,
-		.nonce = calculate_hash<kSeqNumNonceHashAlgorithm> (encrypted_data).substr (0, 8),
-	});
-	auto const data_with_hmac = aes_ctr_xor ({
-		.data = encrypted_data,
-		.key = *_data_encryption_key,
-		.nonce = calculate_hash<kDataNonceHashAlgorithm> (binary_sequence_number).substr (0, 8),
-	});
+	auto const expansion = ciphertext_expansion();
+	Blob data (encrypted_packet.size() >= expansion ? encrypted_packet.size() - expansion : 0, 0);
+	data.resize (decrypt_packet (encrypted_packet, data, maximum_allowed_sequence_number));
+	return data;
+}
 
-	if (data_with_hmac.size() >= kDataSaltSize + _hmac_size)
-	{
-		auto data = BlobView (data_with_hmac);
-		auto salt = data;
-		auto hmac = data;
-		data.remove_suffix (kDataSaltSize + _hmac_size);
-		salt.remove_prefix (data.size());
-		salt.remove_suffix (_hmac_size);
-		hmac.remove_prefix (data.size() + kDataSaltSize);
-
-		auto const calculated_full_hmac = calculate_hmac<kSignatureHMACHashAlgorithm> ({
-			.data = Blob (data) + salt + binary_sequence_number,
-			.key = *_hmac_key,
-		});
-		auto calculated_hmac = BlobView (calculated_full_hmac).substr (0, _hmac_size);
-
-		if (calculated_hmac == hmac)
-		{
-			auto const sequence_number = parse<SequenceNumber> (binary_sequence_number);
-
-			if (sequence_number <= _sequence_number)
-				throw DecryptionFailure (ErrorCode::SeqNumFromPast, "sequence number from past is invalid");
-
-			if (maximum_allowed_sequence_number)
-				if (sequence_number > *maximum_allowed_sequence_number)
-					throw DecryptionFailure (ErrorCode::SeqNumFromFarFuture, "sequence number from far future is invalid");
-
-			_sequence_number = sequence_number;
-
-			return Blob (data);
-		}
-		else
-			throw DecryptionFailure (ErrorCode::InvalidAuthentication, "invalid authentication");
-	}
-	else
+
+size_t
+Receiver::decrypt_packet (BlobView const encrypted_packet,
+						  std::span<uint8_t> const output,
+						  std::optional<SequenceNumber> const maximum_allowed_sequence_number)
+{
+	if (encrypted_packet.size() < ciphertext_expansion())
 		throw DecryptionFailure (ErrorCode::HMACTooShort, "HMAC too short");
+
+	auto const data_size = encrypted_packet.size() - ciphertext_expansion();
+
+	if (output.size() < data_size)
+		throw InvalidArgument ("Receiver::decrypt_packet(): output buffer too small");
+
+	// Calculated HMAC would be shorter than the configured one, so it would never match:
+	if (kMaxHMACSize < _hmac_size)
+		throw DecryptionFailure (ErrorCode::InvalidAuthentication, "invalid authentication");
+
+	auto& contexts = *_contexts;
+	auto const encrypted_sequence_number = encrypted_packet.substr (0, sizeof (SequenceNumber));
+	auto const encrypted_data = encrypted_packet.substr (sizeof (SequenceNumber));
+	BinarySeqNum binary_sequence_number;
+
+	Contexts::restart (contexts.seq_num_cipher, contexts.nonce_for (encrypted_data));
+	contexts.seq_num_cipher.ProcessData (binary_sequence_number.data(), encrypted_sequence_number.data(), encrypted_sequence_number.size());
+
+	// Decrypt data into output and salt + HMAC into a local buffer, continuing the same key stream:
+	std::array<uint8_t, kDataSaltSize + kMaxHMACSize> salt_and_hmac;
+	auto const salt_and_hmac_size = kDataSaltSize + _hmac_size;
+	Contexts::restart (contexts.data_cipher, contexts.nonce_for (BlobView (binary_sequence_number.data(), binary_sequence_number.size())));
+	contexts.data_cipher.ProcessData (output.data(), encrypted_data.data(), data_size);
+	contexts.data_cipher.ProcessData (salt_and_hmac.data(), encrypted_data.data() + data_size, salt_and_hmac_size);
+
+	std::array<uint8_t, kMaxHMACSize> calculated_hmac;
+	contexts.hmac.Update (output.data(), data_size);
+	contexts.hmac.Update (salt_and_hmac.data(), kDataSaltSize);
+	contexts.hmac.Update (binary_sequence_number.data(), binary_sequence_number.size());
+	contexts.hmac.TruncatedFinal (calculated_hmac.data(), _hmac_size);
+
+	auto const hmac = BlobView (salt_and_hmac.data() + kDataSaltSize, _hmac_size);
+
+	if (BlobView (calculated_hmac.data(), _hmac_size) != hmac)
+		throw DecryptionFailure (ErrorCode::InvalidAuthentication, "invalid authentication");
+
+	auto const sequence_number = boost::endian::load_little_u64 (binary_sequence_number.data());
+
+	if (sequence_number <= _sequence_number)
+		throw DecryptionFailure (ErrorCode::SeqNumFromPast, "sequence number from past is invalid");
+
+	if (maximum_allowed_sequence_number)
+		if (sequence_number > *maximum_allowed_sequence_number)
+			throw DecryptionFailure (ErrorCode::SeqNumFromFarFuture, "sequence number from far future is invalid");
+
+	_sequence_number = sequence_number;
+
+	return data_size;
 }
 
 } // namespace xf::crypto::xle
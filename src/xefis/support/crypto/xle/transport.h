@@ -29,12 +29,18 @@
 
 // Standard:
 #include <cstddef>
+#include <memory>
+#include <optional>
+#include <span>
 
 
 namespace xf::crypto::xle {
 
 /**
  * Tool for packets encryption.
+ *
+ * AES and HMAC contexts are expanded from session keys once, in the constructor,
+ * and reused for all packets of the session.
  */
 class Transport
 {
@@ -81,11 +87,21 @@ class Transport
 	static constexpr Hash::Algorithm const kSeqNumEncryptionKeyHKDFHashAlgorithm = Hash::SHA3_256;
 	static constexpr Hash::Algorithm const kSeqNumNonceHashAlgorithm = Hash::SHA3_256;
 
+  protected:
+	// Pre-expanded cipher and HMAC contexts:
+	struct Contexts;
+
   public:
 	// Ctor
 	explicit
 	Transport (Params const&);
 
+	// Move ctor
+	Transport (Transport&&);
+
+	// Dtor
+	~Transport();
+
 	/**
 	 * Return how much larger the resulting packet will be compared to plain text.
 	 */
@@ -115,6 +131,8 @@ class Transport
 	Secure<Blob>	_data_encryption_key;
 	Secure<Blob>	_seq_num_encryption_key;
 	SequenceNumber	_sequence_number	{ 0 };
+	std::unique_ptr<Contexts>
+					_contexts;
 };
 
 
@@ -134,6 +152,17 @@ class Transmitter: public Transport
 	Blob
 	encrypt_packet (BlobView);
 
+	/**
+	 * Encrypt next packet into the output buffer. Doesn't allocate memory.
+	 * The output must be exactly data.size() + ciphertext_expansion() bytes long.
+	 * Data may already be in place, at output.data() + sizeof (SequenceNumber).
+	 *
+	 * \throws std::logic_error if calculated HMAC size < configured hmac_size.
+	 * \throws InvalidArgument if output size is wrong.
+	 */
+	void
+	encrypt_packet (BlobView data, std::span<uint8_t> output);
+
   private:
 	boost::random::random_device& _random_device;
 };
@@ -153,6 +182,19 @@ class Receiver: public Transport
 	[[nodiscard]]
 	Blob
 	decrypt_packet (BlobView data, std::optional<SequenceNumber> maximum_allowed_sequence_number = std::nullopt);
+
+	/**
+	 * Decrypt next packet into the output buffer. Doesn't allocate memory.
+	 * The output must be at least encrypted_packet.size() - ciphertext_expansion() bytes long.
+	 * Contents of the output are unspecified if decryption fails.
+	 *
+	 * \returns	size of the decrypted data.
+	 * \throws	DecryptionFailure on various occasions.
+	 * \throws	InvalidArgument if output is too small.
+	 */
+	[[nodiscard]]
+	size_t
+	decrypt_packet (BlobView encrypted_packet, std::span<uint8_t> output, std::optional<SequenceNumber> maximum_allowed_sequence_number = std::nullopt);
 };
 
 
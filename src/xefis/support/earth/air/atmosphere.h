@@ -21,6 +21,7 @@
 
 // Standard:
 #include <cstddef>
+#include <span>
 
 
 namespace xf {
@@ -38,8 +39,28 @@ class Atmosphere
 	[[nodiscard]]
 	virtual Air<ECEFSpace>
 	air_at (SpaceVector<si::Length, ECEFSpace> const& position) const = 0;
+
+	/**
+	 * Compute air at multiple positions at once.
+	 * Default implementation calls air_at() for each position.
+	 *
+	 * \param	positions
+	 *			Positions in ECEF space.
+	 * \param	results
+	 *			Output air parameters, must have the same size as positions.
+	 */
+	virtual void
+	air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> positions, std::span<Air<ECEFSpace>> results) const;
 };
 
+
+inline void
+Atmosphere::air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> const positions, std::span<Air<ECEFSpace>> const results) const
+{
+	for (std::size_t i = 0; i < positions.size(); ++i)
+		results[i] = air_at (positions[i]);
+}
+
 } // namespace xf
 
 #endif
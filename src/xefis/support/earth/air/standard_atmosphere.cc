@@ -22,6 +22,9 @@
 #include <neutrino/math/field.h>
 
 // Standard:
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
 
 
@@ -112,9 +115,22 @@ air_temperature_to_dynamic_viscosity()
 }
 
 
+using InternationalStandardAtmosphereMap = std::map<si::Length, InternationalStandardAtmosphereParams>;
+
+
+/**
+ * Pair of adjacent entries of the ISA map that enclose given altitude.
+ */
+struct InternationalStandardAtmosphereLayer
+{
+	InternationalStandardAtmosphereMap::const_iterator	lower;
+	InternationalStandardAtmosphereMap::const_iterator	upper;
+};
+
+
 inline si::TemperatureGradient
-standard_temperature_gradient (std::map<si::Length, InternationalStandardAtmosphereParams>::const_iterator const& lower_layer,
-							   std::map<si::Length, InternationalStandardAtmosphereParams>::const_iterator const& upper_layer)
+standard_temperature_gradient (InternationalStandardAtmosphereMap::const_iterator const& lower_layer,
+							   InternationalStandardAtmosphereMap::const_iterator const& upper_layer)
 {
 	if (lower_layer == upper_layer)
 		return 0_K / 0_m;
@@ -125,6 +141,88 @@ standard_temperature_gradient (std::map<si::Length, InternationalStandardAtmosph
 	return delta_temperature / delta_altitude;
 }
 
+
+/**
+ * Clamp altitude to the range of the ISA map.
+ */
+inline si::Length
+clamped_to_isa (si::Length const geometric_altitude_amsl)
+{
+	auto const& atmmap = international_standard_atmosphere_map();
+	return std::clamp (geometric_altitude_amsl, atmmap.begin()->first, atmmap.rbegin()->first);
+}
+
+
+/**
+ * Return layer for given altitude, which must be already clamped to the range of the ISA map.
+ */
+InternationalStandardAtmosphereLayer
+isa_layer_at (si::Length const clamped_geometric_altitude_amsl)
+{
+	auto const& atmmap = international_standard_atmosphere_map();
+	auto upper_layer_it = atmmap.upper_bound (clamped_geometric_altitude_amsl);
+
+	if (upper_layer_it == atmmap.begin())
+		upper_layer_it = std::next (atmmap.begin());
+	else if (upper_layer_it == atmmap.end())
+		--upper_layer_it;
+
+	return { std::prev (upper_layer_it), upper_layer_it };
+}
+
+
+si::Density
+layer_density (InternationalStandardAtmosphereLayer const& layer, si::Length const h)
+{
+	// Using formulas from <https://en.wikipedia.org/wiki/Barometric_formula>
+
+	auto const& lower_layer = layer.lower->second;
+	auto const hb = layer.lower->first;
+	auto const Lb = standard_temperature_gradient (layer.lower, layer.upper);
+	auto const Tb = lower_layer.temperature;
+	auto const rb = lower_layer.density;
+
+	if (abs (Lb) > 0.0_K / 1_m)
+	{
+		auto const p = Tb / (Tb + Lb * (h - hb));
+		auto const e = 1 + (kStdGravitationalAcceleration * kAirMolarMass / (kUniversalGasConstant * Lb));
+
+		return rb * std::pow (p, e);
+	}
+	else
+		return rb * std::exp (-kStdGravitationalAcceleration * kAirMolarMass * (h - hb) / (kUniversalGasConstant * Tb));
+}
+
+
+si::Pressure
+layer_pressure (InternationalStandardAtmosphereLayer const& layer, si::Length const h)
+{
+	// Using formulas from <https://en.wikipedia.org/wiki/Barometric_formula>
+
+	auto const& lower_layer = layer.lower->second;
+	auto const hb = layer.lower->first;
+	auto const Lb = standard_temperature_gradient (layer.lower, layer.upper);
+	auto const Tb = lower_layer.temperature;
+	auto const Pb = lower_layer.pressure;
+
+	if (abs (Lb) > 0.0_K / 1_m)
+	{
+		auto const p = Tb / (Tb + Lb * (h - hb));
+		auto const e = kStdGravitationalAcceleration * kAirMolarMass / (kUniversalGasConstant * Lb);
+
+		return Pb * std::pow (p, e);
+	}
+	else
+		return Pb * std::exp (-kStdGravitationalAcceleration * kAirMolarMass * (h - hb) / (kUniversalGasConstant * Tb));
+}
+
+
+si::Temperature
+layer_temperature (InternationalStandardAtmosphereLayer const& layer, si::Length const h)
+{
+	return layer.lower->second.temperature + standard_temperature_gradient (layer.lower, layer.upper) * (h - layer.lower->first);
+}
+
 } // namespace
 
 
@@ -156,75 +254,182 @@ StandardAtmosphere::air_at_amsl (si::Length const geometric_altitude_amsl) const
 }
 
 
-si::Density
-standard_density (si::Length geometric_altitude_amsl)
+TabulatedStandardAtmosphere::TabulatedStandardAtmosphere()
 {
-	// Using formulas from <https://en.wikipedia.org/wiki/Barometric_formula>
+	compute_altitude_cells();
+	compute_temperature_cells();
+}
 
-	auto const& atmmap = international_standard_atmosphere_map();
 
-	geometric_altitude_amsl = std::clamp (geometric_altitude_amsl, atmmap.begin()->first, atmmap.rbegin()->first);
+Air<ECEFSpace>
+TabulatedStandardAtmosphere::air_at (SpaceVector<si::Length, ECEFSpace> const& position) const
+{
+	return air_at_radius (abs (position));
+}
 
-	auto upper_layer_it = atmmap.upper_bound (geometric_altitude_amsl);
 
-	if (upper_layer_it == atmmap.begin())
-		upper_layer_it = std::next (atmmap.begin());
-	else if (upper_layer_it == atmmap.end())
-		--upper_layer_it;
+void
+TabulatedStandardAtmosphere::air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> const positions,
+									 std::span<Air<ECEFSpace>> const results) const
+{
+	for (std::size_t i = 0; i < positions.size(); ++i)
+		results[i] = air_at_amsl (abs (positions[i]) - kEarthMeanRadius);
+}
 
-	auto const lower_layer_it = std::prev (upper_layer_it);
-	auto const& lower_layer = lower_layer_it->second;
-	auto const h = geometric_altitude_amsl;
-	auto const hb = lower_layer_it->first;
-	auto const Lb = standard_temperature_gradient (lower_layer_it, upper_layer_it);
-	auto const Tb = lower_layer.temperature;
-	auto const rb = lower_layer.density;
 
-	if (abs (Lb) > 0.0_K / 1_m)
-	{
-		auto const p = Tb / (Tb + Lb * (h - hb));
-		auto const e = 1 + (kStdGravitationalAcceleration * kAirMolarMass / (kUniversalGasConstant * Lb));
+Air<ECEFSpace>
+TabulatedStandardAtmosphere::air_at_radius (si::Length const radius) const
+{
+	return air_at_amsl (radius - kEarthMeanRadius);
+}
 
-		return rb * std::pow (p, e);
+
+Air<ECEFSpace>
+TabulatedStandardAtmosphere::air_at_amsl (si::Length const geometric_altitude_amsl) const
+{
+	auto const step = kAltitudeStep.in<si::Meter>();
+	auto const h = std::clamp (geometric_altitude_amsl.in<si::Meter>(), _min_altitude, _max_altitude);
+	auto const line = static_cast<int64_t> (std::floor (h / step));
+	auto const last_index = static_cast<int64_t> (_altitude_cells.size()) - 1;
+	auto const index = std::clamp<int64_t> (line - _first_altitude_line, 0, last_index);
+	auto const& cell = _altitude_cells[static_cast<std::size_t> (index)];
+	auto const dh = h - static_cast<double> (_first_altitude_line + index) * step;
+	auto const temperature = cell.temperature + cell.temperature_gradient * dh;
+
+	Air<ECEFSpace> air;
+	air.density = 1_kgpm3 * (cell.density + cell.density_gradient * dh);
+	air.pressure = 1_Pa * (cell.pressure + cell.pressure_gradient * dh);
+	air.temperature = 1_K * temperature;
+	air.dynamic_viscosity = dynamic_viscosity (temperature);
+	air.speed_of_sound = 1_mps * (cell.speed_of_sound + cell.speed_of_sound_gradient * dh);
+	air.velocity = { 0_mps, 0_mps, 0_mps };
+	return air;
+}
+
+
+void
+TabulatedStandardAtmosphere::compute_altitude_cells()
+{
+	auto const& atmmap = international_standard_atmosphere_map();
+	auto const step = kAltitudeStep.in<si::Meter>();
+
+	_min_altitude = atmmap.begin()->first.in<si::Meter>();
+	_max_altitude = atmmap.rbegin()->first.in<si::Meter>();
+	_first_altitude_line = static_cast<int64_t> (std::floor (_min_altitude / step));
+
+	auto const end_line = static_cast<int64_t> (std::ceil (_max_altitude / step));
+
+	_altitude_cells.clear();
+	_altitude_cells.reserve (static_cast<std::size_t> (end_line - _first_altitude_line));
+
+	for (auto line = _first_altitude_line; line < end_line; ++line)
+	{
+		auto const line_altitude = static_cast<double> (line) * step;
+		// Cells at both ends of the ISA range are cut short:
+		auto const bottom = std::max (_min_altitude, line_altitude);
+		auto const top = std::min (_max_altitude, line_altitude + step);
+		// Density and pressure in the ISA map are discontinuous at layer boundaries,
+		// so evaluate both ends of the cell using the same layer:
+		auto const layer = isa_layer_at (0.5 * (bottom + top) * 1_m);
+
+		auto const sample = [&layer] (double const altitude) -> std::array<double, 4> {
+			auto const h = altitude * 1_m;
+			auto const temperature = layer_temperature (layer, h);
+
+			return {
+				layer_density (layer, h).base_value(),
+				layer_pressure (layer, h).base_value(),
+				temperature.in<si::Kelvin>(),
+				speed_of_sound (temperature).in<si::MeterPerSecond>(),
+			};
+		};
+
+		auto const at_bottom = sample (bottom);
+		auto const at_top = sample (top);
+		std::array<double, 4> gradients;
+
+		for (std::size_t i = 0; i < gradients.size(); ++i)
+			gradients[i] = (at_top[i] - at_bottom[i]) / (top - bottom);
+
+		// Extrapolate values to the grid line, so that lookups don't depend on where the cell starts:
+		auto const offset = line_altitude - bottom;
+
+		_altitude_cells.push_back ({
+			.density = at_bottom[0] + gradients[0] * offset,
+			.pressure = at_bottom[1] + gradients[1] * offset,
+			.temperature = at_bottom[2] + gradients[2] * offset,
+			.speed_of_sound = at_bottom[3] + gradients[3] * offset,
+			.density_gradient = gradients[0],
+			.pressure_gradient = gradients[1],
+			.temperature_gradient = gradients[2],
+			.speed_of_sound_gradient = gradients[3],
+		});
 	}
-	else
-		return rb * std::exp (-kStdGravitationalAcceleration * kAirMolarMass * (h - hb) / (kUniversalGasConstant * Tb));
 }
 
 
-si::Pressure
-standard_pressure (si::Length geometric_altitude_amsl)
+void
+TabulatedStandardAtmosphere::compute_temperature_cells()
 {
-	// Using formulas from <https://en.wikipedia.org/wiki/Barometric_formula>
+	// The viscosity field is piecewise linear with breakpoints at whole degrees Fahrenheit,
+	// so a 1 °F grid reproduces it exactly:
+	_temperature_origin = (0_degF).in<si::Kelvin>();
+	_temperature_step = (1_degF).in<si::Kelvin>() - _temperature_origin;
 
 	auto const& atmmap = international_standard_atmosphere_map();
+	auto const [min_it, max_it] = std::minmax_element (atmmap.begin(), atmmap.end(), [](auto const& a, auto const& b) {
+		return a.second.temperature < b.second.temperature;
+	});
+	auto const min_temperature = min_it->second.temperature.in<si::Kelvin>();
+	auto const max_temperature = max_it->second.temperature.in<si::Kelvin>();
 
-	geometric_altitude_amsl = std::clamp (geometric_altitude_amsl, atmmap.begin()->first, atmmap.rbegin()->first);
+	_first_temperature_line = static_cast<int64_t> (std::floor ((min_temperature - _temperature_origin) / _temperature_step));
 
-	auto upper_layer_it = atmmap.upper_bound (geometric_altitude_amsl);
-
-	if (upper_layer_it == atmmap.begin())
-		upper_layer_it = std::next (atmmap.begin());
-	else if (upper_layer_it == atmmap.end())
-		--upper_layer_it;
+	auto const end_line = static_cast<int64_t> (std::ceil ((max_temperature - _temperature_origin) / _temperature_step));
 
-	auto const lower_layer_it = std::prev (upper_layer_it);
-	auto const& lower_layer = lower_layer_it->second;
-	auto const h = geometric_altitude_amsl;
-	auto const hb = lower_layer_it->first;
-	auto const Lb = standard_temperature_gradient (lower_layer_it, upper_layer_it);
-	auto const Tb = lower_layer.temperature;
-	auto const Pb = lower_layer.pressure;
+	_temperature_cells.clear();
+	_temperature_cells.reserve (static_cast<std::size_t> (end_line - _first_temperature_line));
 
-	if (abs (Lb) > 0.0_K / 1_m)
+	for (auto line = _first_temperature_line; line < end_line; ++line)
 	{
-		auto const p = Tb / (Tb + Lb * (h - hb));
-		auto const e = kStdGravitationalAcceleration * kAirMolarMass / (kUniversalGasConstant * Lb);
-
-		return Pb * std::pow (p, e);
+		auto const bottom = _temperature_origin + static_cast<double> (line) * _temperature_step;
+		auto const at_bottom = dynamic_air_viscosity (bottom * 1_K).base_value();
+		auto const at_top = dynamic_air_viscosity ((bottom + _temperature_step) * 1_K).base_value();
+
+		_temperature_cells.push_back ({
+			.dynamic_viscosity = at_bottom,
+			.dynamic_viscosity_gradient = (at_top - at_bottom) / _temperature_step,
+		});
 	}
-	else
-		return Pb * std::exp (-kStdGravitationalAcceleration * kAirMolarMass * (h - hb) / (kUniversalGasConstant * Tb));
+}
+
+
+si::DynamicViscosity
+TabulatedStandardAtmosphere::dynamic_viscosity (double const temperature_in_kelvins) const
+{
+	auto const line = static_cast<int64_t> (std::floor ((temperature_in_kelvins - _temperature_origin) / _temperature_step));
+	auto const last_index = static_cast<int64_t> (_temperature_cells.size()) - 1;
+	auto const index = std::clamp<int64_t> (line - _first_temperature_line, 0, last_index);
+	auto const& cell = _temperature_cells[static_cast<std::size_t> (index)];
+	auto const dt = temperature_in_kelvins - (_temperature_origin + static_cast<double> (_first_temperature_line + index) * _temperature_step);
+
+	return 1_Pas * (cell.dynamic_viscosity + cell.dynamic_viscosity_gradient * dt);
+}
+
+
+si::Density
+standard_density (si::Length const geometric_altitude_amsl)
+{
+	auto const h = clamped_to_isa (geometric_altitude_amsl);
+	return layer_density (isa_layer_at (h), h);
+}
+
+
+si::Pressure
+standard_pressure (si::Length const geometric_altitude_amsl)
+{
+	auto const h = clamped_to_isa (geometric_altitude_amsl);
+	return layer_pressure (isa_layer_at (h), h);
 }
 
 
@@ -22,6 +22,9 @@
 
 // Standard:
 #include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
 
 
 namespace xf {
@@ -35,6 +38,8 @@ namespace xf {
 class StandardAtmosphere: public Atmosphere
 {
   public:
+	using Atmosphere::air_at;
+
 	[[nodiscard]]
 	Air<ECEFSpace>
 	air_at (SpaceVector<si::Length, ECEFSpace> const& position) const override;
@@ -49,6 +54,98 @@ class StandardAtmosphere: public Atmosphere
 };
 
 
+/**
+ * Standard atmosphere model that precomputes air parameters on a uniform altitude grid
+ * and interpolates linearly within grid cells. Queries don't do any map lookups nor call
+ * std::pow()/std::exp(), and a single query reads just one cache line of the altitude table
+ * (and a few bytes of the small viscosity table).
+ *
+ * ISA layer boundaries lie on the grid, so the only error comes from the curvature
+ * of density and pressure within a cell. Results agree with StandardAtmosphere,
+ * which remains the reference implementation, within kRelativeTolerance.
+ * Altitudes outside of the ISA range are clamped.
+ */
+class TabulatedStandardAtmosphere: public Atmosphere
+{
+  public:
+	// Must divide 1 km, so that ISA layer boundaries fall on the grid:
+	static constexpr si::Length	kAltitudeStep		{ 25_m };
+	// Max relative difference of results from StandardAtmosphere:
+	static constexpr double		kRelativeTolerance	{ 2e-5 };
+
+  private:
+	/**
+	 * Parameters at the bottom grid line of the cell and their gradients,
+	 * in SI base units. Takes exactly one cache line.
+	 */
+	struct alignas (64) AltitudeCell
+	{
+		double	density;
+		double	pressure;
+		double	temperature;
+		double	speed_of_sound;
+		double	density_gradient;
+		double	pressure_gradient;
+		double	temperature_gradient;
+		double	speed_of_sound_gradient;
+	};
+
+	/**
+	 * Dynamic viscosity at the bottom grid line of a temperature cell and its gradient.
+	 */
+	struct TemperatureCell
+	{
+		double	dynamic_viscosity;
+		double	dynamic_viscosity_gradient;
+	};
+
+  public:
+	// Ctor
+	TabulatedStandardAtmosphere();
+
+	using Atmosphere::air_at;
+
+	[[nodiscard]]
+	Air<ECEFSpace>
+	air_at (SpaceVector<si::Length, ECEFSpace> const& position) const override;
+
+	void
+	air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> positions, std::span<Air<ECEFSpace>> results) const override;
+
+	[[nodiscard]]
+	Air<ECEFSpace>
+	air_at_radius (si::Length radius) const;
+
+	[[nodiscard]]
+	Air<ECEFSpace>
+	air_at_amsl (si::Length amsl_height) const;
+
+  private:
+	void
+	compute_altitude_cells();
+
+	void
+	compute_temperature_cells();
+
+	[[nodiscard]]
+	si::DynamicViscosity
+	dynamic_viscosity (double temperature_in_kelvins) const;
+
+  private:
+	std::vector<AltitudeCell>		_altitude_cells;
+	std::vector<TemperatureCell>	_temperature_cells;
+	// Index of the grid line at the bottom of the first cell:
+	int64_t							_first_altitude_line;
+	int64_t							_first_temperature_line;
+	// Temperature grid (in kelvins):
+	double							_temperature_origin;
+	double							_temperature_step;
+	// Altitude range of the ISA (in meters):
+	double							_min_altitude;
+	double							_max_altitude;
+};
+
+
 /*
  * Global functions
  */
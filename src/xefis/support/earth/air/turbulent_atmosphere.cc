@@ -0,0 +1,326 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "turbulent_atmosphere.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/constants.h>
+
+// Standard:
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <random>
+
+
+namespace xf {
+namespace {
+
+/**
+ * Return uniformly distributed number from [0, 1).
+ * Standard distributions aren't guaranteed to give the same results on all standard libraries,
+ * so use the generator output directly to keep the field reproducible.
+ */
+double
+uniform (std::mt19937_64& prng)
+{
+	return static_cast<double> (prng() >> 11) * 0x1.0p-53;
+}
+
+
+/**
+ * Return random unit vector uniformly distributed on a sphere.
+ */
+std::array<double, 3>
+random_direction (std::mt19937_64& prng)
+{
+	auto const z = 2.0 * uniform (prng) - 1.0;
+	auto const phi = 2.0 * std::numbers::pi * uniform (prng);
+	auto const r = std::sqrt (1.0 - z * z);
+	return { r * std::cos (phi), r * std::sin (phi), z };
+}
+
+
+/**
+ * Von Kármán energy spectrum shape for wavenumber k normalized by the turbulence scale (k·L).
+ */
+double
+von_karman_energy (double const kl)
+{
+	auto const kl2 = kl * kl;
+	return kl2 * kl2 / std::pow (1.0 + kl2, 17.0 / 6.0);
+}
+
+} // namespace
+
+
+TurbulentAtmosphere::TurbulentAtmosphere (Atmosphere const& base_atmosphere, TurbulentAtmosphereParameters const& params):
+	_base_atmosphere (base_atmosphere),
+	_params (params)
+{
+	// Wind blows towards the opposite of wind_direction:
+	_wind_north = -_params.wind_speed.in<si::MeterPerSecond>() * cos (_params.wind_direction);
+	_wind_east = -_params.wind_speed.in<si::MeterPerSecond>() * sin (_params.wind_direction);
+
+	compute_wind_profile();
+	compute_turbulence_tile();
+}
+
+
+Air<ECEFSpace>
+TurbulentAtmosphere::air_at (SpaceVector<si::Length, ECEFSpace> const& position) const
+{
+	auto air = _base_atmosphere.air_at (position);
+	air.velocity = wind_at (position);
+	return air;
+}
+
+
+void
+TurbulentAtmosphere::air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> const positions,
+							 std::span<Air<ECEFSpace>> const results) const
+{
+	_base_atmosphere.air_at (positions, results);
+
+	for (std::size_t i = 0; i < positions.size(); ++i)
+		results[i].velocity = wind_at (positions[i]);
+}
+
+
+SpaceVector<si::Velocity, ECEFSpace>
+TurbulentAtmosphere::wind_at (SpaceVector<si::Length, ECEFSpace> const& position) const
+{
+	auto const x = position[0].in<si::Meter>();
+	auto const y = position[1].in<si::Meter>();
+	auto const z = position[2].in<si::Meter>();
+	auto const horizontal = std::sqrt (x * x + y * y);
+	auto const radius = std::sqrt (horizontal * horizontal + z * z);
+	auto const altitude = radius - kEarthMeanRadius.in<si::Meter>();
+
+	// Local east and north unit vectors. Near the poles east is undefined, so pick any horizontal direction:
+	auto const up = std::array { x / radius, y / radius, z / radius };
+	auto const east = horizontal > 1.0
+		? std::array { -y / horizontal, x / horizontal, 0.0 }
+		: std::array { 0.0, 1.0, 0.0 };
+	auto const north = std::array {
+		up[1] * east[2] - up[2] * east[1],
+		up[2] * east[0] - up[0] * east[2],
+		up[0] * east[1] - up[1] * east[0],
+	};
+
+	std::array<double, 3> wind;
+
+	for (std::size_t i = 0; i < 3; ++i)
+		wind[i] = _wind_north * north[i] + _wind_east * east[i];
+
+	auto const profile = wind_profile_factor (altitude);
+	auto const turbulence_intensity = _params.turbulence_intensity.in<si::MeterPerSecond>() * turbulence_factor (altitude);
+
+	if (turbulence_intensity > 0.0)
+	{
+		// Turbulence moves with the mean wind:
+		auto const t = _time.in<si::Second>();
+		auto const turbulence = sample_tile ((x - profile * wind[0] * t) / _tile_cell_size,
+											 (y - profile * wind[1] * t) / _tile_cell_size,
+											 (z - profile * wind[2] * t) / _tile_cell_size);
+
+		for (std::size_t i = 0; i < 3; ++i)
+			wind[i] = profile * wind[i] + turbulence_intensity * turbulence[i];
+	}
+	else
+	{
+		for (auto& w: wind)
+			w *= profile;
+	}
+
+	return { 1_mps * wind[0], 1_mps * wind[1], 1_mps * wind[2] };
+}
+
+
+void
+TurbulentAtmosphere::compute_wind_profile()
+{
+	auto const boundary_layer_height = _params.boundary_layer_height.in<si::Meter>();
+	auto const reference_altitude = _params.reference_altitude.in<si::Meter>();
+
+	_wind_profile.resize (kProfileSamples);
+
+	for (std::size_t i = 0; i < kProfileSamples; ++i)
+	{
+		auto const altitude = boundary_layer_height * static_cast<double> (i) / static_cast<double> (kProfileSamples - 1);
+		_wind_profile[i] = std::pow (altitude / reference_altitude, _params.wind_profile_exponent);
+	}
+}
+
+
+void
+TurbulentAtmosphere::compute_turbulence_tile()
+{
+	constexpr auto n = kTileCells;
+	constexpr auto mask = n - 1;
+
+	static_assert ((n & mask) == 0, "kTileCells must be a power of 2");
+
+	auto const scale = _params.turbulence_scale.in<si::Meter>();
+	auto const tile_length = kTileScales * scale;
+	_tile_cell_size = tile_length / n;
+
+	// Wavevectors are integer multiples of the tile's base wavevector, so that the tile is periodic
+	// and phases can be taken from a table:
+	std::array<double, n> cos_table;
+	std::array<double, n> sin_table;
+
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		auto const angle = 2.0 * std::numbers::pi * static_cast<double> (i) / n;
+		cos_table[i] = std::cos (angle);
+		sin_table[i] = std::sin (angle);
+	}
+
+	std::vector<std::array<double, 3>> field (n * n * n, { 0.0, 0.0, 0.0 });
+	std::mt19937_64 prng (_params.seed);
+	auto const max_wavenumber = 0.5 * n;
+
+	for (std::size_t m = 0; m < kModes; ++m)
+	{
+		// Wavenumbers are sampled log-uniformly between the tile size and the Nyquist limit:
+		std::array<int64_t, 3> wavevector;
+		double wavenumber;
+
+		do {
+			auto const magnitude = std::pow (max_wavenumber, uniform (prng));
+			auto const direction = random_direction (prng);
+
+			for (std::size_t i = 0; i < 3; ++i)
+				wavevector[i] = std::llround (magnitude * direction[i]);
+
+			wavenumber = std::sqrt (static_cast<double> (wavevector[0] * wavevector[0] + wavevector[1] * wavevector[1] + wavevector[2] * wavevector[2]));
+		} while (wavenumber == 0.0);
+
+		// Make the mode divergence-free by removing the component of amplitude parallel to the wavevector:
+		auto amplitude = random_direction (prng);
+		auto const dot = (amplitude[0] * wavevector[0] + amplitude[1] * wavevector[1] + amplitude[2] * wavevector[2]) / (wavenumber * wavenumber);
+
+		for (std::size_t i = 0; i < 3; ++i)
+			amplitude[i] -= dot * wavevector[i];
+
+		// Log-uniform sampling has density ∝ 1/k, so weight energy by k:
+		auto const kl = 2.0 * std::numbers::pi * wavenumber / tile_length * scale;
+		auto const norm = std::sqrt (amplitude[0] * amplitude[0] + amplitude[1] * amplitude[1] + amplitude[2] * amplitude[2]);
+		auto const weight = norm > 0.0 ? std::sqrt (von_karman_energy (kl) * wavenumber) / norm : 0.0;
+		auto const phase = 2.0 * std::numbers::pi * uniform (prng);
+		auto const cos_phase = std::cos (phase);
+		auto const sin_phase = std::sin (phase);
+
+		for (std::size_t zi = 0; zi < n; ++zi)
+		{
+			for (std::size_t yi = 0; yi < n; ++yi)
+			{
+				for (std::size_t xi = 0; xi < n; ++xi)
+				{
+					auto const step = static_cast<std::size_t> (wavevector[0] * static_cast<int64_t> (xi) + wavevector[1] * static_cast<int64_t> (yi) + wavevector[2] * static_cast<int64_t> (zi));
+					auto const k = step & mask;
+					// cos (2π·k/n + phase):
+					auto const c = weight * (cos_table[k] * cos_phase - sin_table[k] * sin_phase);
+					auto& v = field[(zi * n + yi) * n + xi];
+
+					for (std::size_t i = 0; i < 3; ++i)
+						v[i] += c * amplitude[i];
+				}
+			}
+		}
+	}
+
+	// Normalize to unit RMS per component:
+	auto sum_of_squares = 0.0;
+
+	for (auto const& v: field)
+		sum_of_squares += v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+
+	auto const rms = std::sqrt (sum_of_squares / (3.0 * static_cast<double> (field.size())));
+	auto const normalization = rms > 0.0 ? 1.0 / rms : 0.0;
+
+	_tile.resize (field.size());
+
+	for (std::size_t i = 0; i < field.size(); ++i)
+		for (std::size_t j = 0; j < 3; ++j)
+			_tile[i][j] = static_cast<float> (field[i][j] * normalization);
+}
+
+
+double
+TurbulentAtmosphere::wind_profile_factor (double const altitude_in_meters) const
+{
+	auto const boundary_layer_height = _params.boundary_layer_height.in<si::Meter>();
+	auto const position = std::clamp (altitude_in_meters / boundary_layer_height, 0.0, 1.0) * static_cast<double> (kProfileSamples - 1);
+	auto const index = std::min (static_cast<std::size_t> (position), kProfileSamples - 2);
+	auto const fraction = position - static_cast<double> (index);
+
+	return _wind_profile[index] + fraction * (_wind_profile[index + 1] - _wind_profile[index]);
+}
+
+
+double
+TurbulentAtmosphere::turbulence_factor (double const altitude_in_meters) const
+{
+	// Full intensity within the boundary layer, fading out linearly over another boundary layer height:
+	auto const boundary_layer_height = _params.boundary_layer_height.in<si::Meter>();
+	return std::clamp (2.0 - altitude_in_meters / boundary_layer_height, 0.0, 1.0);
+}
+
+
+std::array<double, 3>
+TurbulentAtmosphere::sample_tile (double const x, double const y, double const z) const
+{
+	constexpr auto n = kTileCells;
+	constexpr auto mask = static_cast<int64_t> (n - 1);
+
+	auto const fx = std::floor (x);
+	auto const fy = std::floor (y);
+	auto const fz = std::floor (z);
+	auto const tx = x - fx;
+	auto const ty = y - fy;
+	auto const tz = z - fz;
+	// Bitwise and wraps negative indices correctly too:
+	auto const x0 = static_cast<std::size_t> (static_cast<int64_t> (fx) & mask);
+	auto const y0 = static_cast<std::size_t> (static_cast<int64_t> (fy) & mask);
+	auto const z0 = static_cast<std::size_t> (static_cast<int64_t> (fz) & mask);
+	auto const x1 = (x0 + 1) & (n - 1);
+	auto const y1 = (y0 + 1) & (n - 1);
+	auto const z1 = (z0 + 1) & (n - 1);
+
+	auto const at = [this] (std::size_t const xi, std::size_t const yi, std::size_t const zi) -> std::array<float, 3> const& {
+		return _tile[(zi * n + yi) * n + xi];
+	};
+
+	std::array<double, 3> result;
+
+	for (std::size_t i = 0; i < 3; ++i)
+	{
+		auto const c00 = at (x0, y0, z0)[i] + tx * (at (x1, y0, z0)[i] - at (x0, y0, z0)[i]);
+		auto const c10 = at (x0, y1, z0)[i] + tx * (at (x1, y1, z0)[i] - at (x0, y1, z0)[i]);
+		auto const c01 = at (x0, y0, z1)[i] + tx * (at (x1, y0, z1)[i] - at (x0, y0, z1)[i]);
+		auto const c11 = at (x0, y1, z1)[i] + tx * (at (x1, y1, z1)[i] - at (x0, y1, z1)[i]);
+		auto const c0 = c00 + ty * (c10 - c00);
+		auto const c1 = c01 + ty * (c11 - c01);
+		result[i] = c0 + tz * (c1 - c0);
+	}
+
+	return result;
+}
+
+} // namespace xf
+
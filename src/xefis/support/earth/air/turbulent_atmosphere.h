@@ -0,0 +1,168 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__EARTH__AIR__TURBULENT_ATMOSPHERE_H__INCLUDED
+#define XEFIS__SUPPORT__EARTH__AIR__TURBULENT_ATMOSPHERE_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/earth/air/air.h>
+#include <xefis/support/earth/air/atmosphere.h>
+#include <xefis/support/math/geometry.h>
+
+// Standard:
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+
+namespace xf {
+
+struct TurbulentAtmosphereParameters
+{
+	// Mean wind speed at the reference altitude:
+	si::Velocity	wind_speed				{ 0_mps };
+	// Direction the wind blows from (true):
+	si::Angle		wind_direction			{ 0_deg };
+	si::Length		reference_altitude		{ 10_m };
+	// Above this altitude the mean wind doesn't change anymore and turbulence starts to fade out:
+	si::Length		boundary_layer_height	{ 600_m };
+	// Exponent of the power-law wind profile:
+	double			wind_profile_exponent	{ 1.0 / 7.0 };
+	// RMS of each turbulence velocity component within the boundary layer:
+	si::Velocity	turbulence_intensity	{ 0_mps };
+	// Von Kármán turbulence length scale:
+	si::Length		turbulence_scale		{ 200_m };
+	// Seed for the turbulence field. Same seed gives the same field:
+	uint64_t		seed					{ 0 };
+};
+
+
+/**
+ * Adds wind to another atmosphere model (eg. TabulatedStandardAtmosphere).
+ *
+ * Mean wind follows a power-law profile up to the top of the boundary layer and is constant above.
+ * Turbulence is a divergence-free random field with von Kármán spectrum, synthesized once from the seed
+ * into a periodic tile and sampled with trilinear interpolation, so queries are cheap and don't generate
+ * random numbers. Turbulence is frozen in the air and advected with the mean wind (Taylor's hypothesis),
+ * which makes it coherent both in space and time. Altitude is measured from the mean Earth radius.
+ */
+class TurbulentAtmosphere: public Atmosphere
+{
+  public:
+	// Number of turbulence tile cells along each axis. Must be a power of 2:
+	static constexpr std::size_t	kTileCells		{ 32 };
+	// Tile length relative to the turbulence scale:
+	static constexpr double			kTileScales		{ 8.0 };
+	// Number of Fourier modes used to synthesize the tile:
+	static constexpr std::size_t	kModes			{ 256 };
+	// Number of samples of the mean wind profile within the boundary layer:
+	static constexpr std::size_t	kProfileSamples	{ 128 };
+
+  public:
+	/**
+	 * \param	base_atmosphere
+	 *			Atmosphere that provides all air parameters except for velocity.
+	 *			TurbulentAtmosphere can't outlive it.
+	 */
+	explicit
+	TurbulentAtmosphere (Atmosphere const& base_atmosphere, TurbulentAtmosphereParameters const&);
+
+	using Atmosphere::air_at;
+
+	[[nodiscard]]
+	Air<ECEFSpace>
+	air_at (SpaceVector<si::Length, ECEFSpace> const& position) const override;
+
+	void
+	air_at (std::span<SpaceVector<si::Length, ECEFSpace> const> positions, std::span<Air<ECEFSpace>> results) const override;
+
+	/**
+	 * Return wind velocity (mean wind plus turbulence) at given position.
+	 */
+	[[nodiscard]]
+	SpaceVector<si::Velocity, ECEFSpace>
+	wind_at (SpaceVector<si::Length, ECEFSpace> const& position) const;
+
+	/**
+	 * Return time at which the turbulence field is sampled.
+	 */
+	[[nodiscard]]
+	si::Time
+	time() const noexcept
+		{ return _time; }
+
+	/**
+	 * Set time at which the turbulence field is sampled.
+	 * Must not be called concurrently with air_at().
+	 */
+	void
+	set_time (si::Time const time) noexcept
+		{ _time = time; }
+
+	/**
+	 * Return parameters.
+	 */
+	[[nodiscard]]
+	TurbulentAtmosphereParameters const&
+	parameters() const noexcept
+		{ return _params; }
+
+  private:
+	void
+	compute_wind_profile();
+
+	void
+	compute_turbulence_tile();
+
+	/**
+	 * Return mean wind speed factor relative to the reference altitude.
+	 */
+	[[nodiscard]]
+	double
+	wind_profile_factor (double altitude_in_meters) const;
+
+	/**
+	 * Return turbulence intensity factor relative to the intensity within the boundary layer.
+	 */
+	[[nodiscard]]
+	double
+	turbulence_factor (double altitude_in_meters) const;
+
+	/**
+	 * Sample the tile with trilinear interpolation. Coordinates are in tile cells.
+	 */
+	[[nodiscard]]
+	std::array<double, 3>
+	sample_tile (double x, double y, double z) const;
+
+  private:
+	Atmosphere const&					_base_atmosphere;
+	TurbulentAtmosphereParameters		_params;
+	si::Time							_time				{ 0_s };
+	// Wind profile factor sampled uniformly from 0 m to the boundary layer height:
+	std::vector<double>					_wind_profile;
+	// Turbulence velocities normalized to unit RMS, indexed by [z][y][x]:
+	std::vector<std::array<float, 3>>	_tile;
+	double								_tile_cell_size;
+	// Mean wind at the reference altitude (m/s) towards north and east:
+	double								_wind_north;
+	double								_wind_east;
+};
+
+} // namespace xf
+
+#endif
+
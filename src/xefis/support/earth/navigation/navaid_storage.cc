@@ -28,12 +28,36 @@
 #include <QTextStream>
 
 // Standard:
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <functional>
 #include <memory>
+#include <numbers>
 #include <thread>
 
 
 namespace xf {
+namespace {
+
+[[nodiscard]]
+std::array<double, 3>
+unit_vector (si::LonLat const& position)
+{
+	using std::sin;
+	using std::cos;
+
+	si::Angle::Value const cos_lat = cos (position.lat());
+
+	return {
+		cos_lat * cos (position.lon()),
+		cos_lat * sin (position.lon()),
+		sin (position.lat()),
+	};
+}
+
+} // namespace
+
 
 class GzDataFileIteratorException: public Exception
 {
@@ -142,6 +166,20 @@ NavaidStorage::NavaidStorage (Logger const& logger,
 }
 
 
+NavaidStorage::NavaidStorage (Logger const& logger, Navaids const& navaids):
+	_logger (logger.with_context ("<navaid storage>")),
+	_navaids_tree (access_position)
+{
+	_logger << "Creating NavaidStorage" << std::endl;
+
+	for (auto const& navaid: navaids)
+		_navaids_tree.insert (navaid);
+
+	index_navaids();
+	_loaded = true;
+}
+
+
 NavaidStorage::~NavaidStorage()
 {
 	_destroying = true;
@@ -166,24 +204,43 @@ NavaidStorage::load()
 	if (_loaded)
 		return;
 
-	parse_nav_dat();
-	parse_fix_dat();
-	parse_apt_dat();
+	// A missing file only means there will be no navaids of its kind:
+	for (auto const parse: { &NavaidStorage::parse_nav_dat, &NavaidStorage::parse_fix_dat, &NavaidStorage::parse_apt_dat })
+	{
+		try {
+			(this->*parse)();
+		}
+		catch (GzDataFileIteratorException const& exception)
+		{
+			_logger << "Skipping navaids file: " << exception.what() << std::endl;
+		}
+	}
 
 	if (destroying())
 		return;
 
+	index_navaids();
+}
+
+
+void
+NavaidStorage::index_navaids()
+{
 	_navaids_tree.optimize();
 
 	if (destroying())
 		return;
 
+	// Pointers to navaids must be taken after optimize(), which rebuilds the tree:
 	for (Navaid const& navaid: _navaids_tree)
 	{
 		auto g = _navaids_by_type.insert (std::make_pair (navaid.type(), Group())).first;
 		g->second.by_identifier[navaid.identifier()] = &navaid;
 		g->second.by_frequency.insert (std::make_pair (navaid.frequency(), &navaid));
+		_navaids_index.insert ({ .navaid = &navaid, .unit_vector = unit_vector (navaid.position()) });
 	}
+
+	_navaids_index.optimize();
 }
 
 
@@ -198,28 +255,36 @@ NavaidStorage::async_loader()
 }
 
 
-NavaidStorage::Navaids
-NavaidStorage::get_navs (si::LonLat const& position, si::Length const radius) const
+void
+NavaidStorage::get_navs (si::LonLat const& position, si::Length const radius, NavaidPointers& result) const
 {
+	result.clear();
+
 	if (!_loaded)
-		return {};
+		return;
 
-	Navaids set;
+	// Great-circle distance in radians, converted to distance between unit vectors (chord).
+	// The tree returns everything within a cube around the center, so check exact chord length afterwards:
+	auto const central_angle = std::clamp (radius.in<si::Meter>() / kEarthMeanRadius.in<si::Meter>(), 0.0, std::numbers::pi);
+	auto const chord = 2.0 * std::sin (0.5 * central_angle);
+	auto const chord_squared = chord * chord;
+	auto const center = IndexedNavaid { .navaid = nullptr, .unit_vector = unit_vector (position) };
 
-	auto inserter_and_predicate = [&] (Navaid const& navaid) -> bool
-	{
-		if (xf::haversine_earth (position, navaid.position()) <= radius)
+	auto const visitor = [&] (IndexedNavaid const& indexed_navaid) {
+		auto distance_squared = 0.0;
+
+		for (std::size_t i = 0; i < center.unit_vector.size(); ++i)
 		{
-			set.push_back (navaid);
-			return false;
+			auto const d = indexed_navaid.unit_vector[i] - center.unit_vector[i];
+			distance_squared += d * d;
 		}
-		return true;
-	};
 
-	Navaid navaid_at_position (Navaid::OTHER, position, "", "", 0_nmi);
-	_navaids_tree.find_nearest_if (navaid_at_position, std::numeric_limits<si::Length::Value>::max(), inserter_and_predicate);
+		if (distance_squared <= chord_squared)
+			result.push_back (indexed_navaid.navaid);
+	};
 
-	return set;
+	// KDTree assigns the visitor, so pass a reference_wrapper:
+	_navaids_index.visit_within_range (center, chord, std::cref (visitor));
 }
 
 
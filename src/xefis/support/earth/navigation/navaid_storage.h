@@ -27,11 +27,13 @@
 #include <kdtree++/kdtree.hpp>
 
 // Standard:
+#include <array>
 #include <cstddef>
 #include <future>
 #include <set>
 #include <string_view>
 #include <map>
+#include <vector>
 
 
 namespace xf {
@@ -74,12 +76,34 @@ class NavaidStorage
 
   public:
 	using Navaids = std::vector<Navaid>;
+	using NavaidPointers = std::vector<Navaid const*>;
 
   private:
+	/**
+	 * Navaid with its position as a unit vector in the ECEF frame.
+	 * Unlike latitude/longitude it has no discontinuities at the poles nor at the antimeridian,
+	 * and distance on the sphere is a monotonic function of the distance between unit vectors.
+	 */
+	struct IndexedNavaid
+	{
+		Navaid const*			navaid;
+		std::array<double, 3>	unit_vector;
+	};
+
+	struct AccessUnitVector
+	{
+		using result_type = double;
+
+		double
+		operator() (IndexedNavaid const& indexed_navaid, std::size_t const dimension) const
+			{ return indexed_navaid.unit_vector[dimension]; }
+	};
+
 	static si::Angle::Value
 	access_position (Navaid const& navaid, std::size_t const dimension);
 
 	using NavaidsTree = KDTree::KDTree<2, Navaid, std::function<si::Angle::Value (Navaid const&, std::size_t)>>;
+	using NavaidsIndex = KDTree::KDTree<3, IndexedNavaid, AccessUnitVector>;
 
   public:
 	// Ctor
@@ -89,6 +113,13 @@ class NavaidStorage
 				   std::string_view const& fix_file,
 				   std::string_view const& apt_file);
 
+	/**
+	 * Create storage with given navaids instead of loading them from files.
+	 * The storage is loaded right away.
+	 */
+	explicit
+	NavaidStorage (Logger const&, Navaids const&);
+
 	// Dtor
 	~NavaidStorage();
 
@@ -115,12 +146,13 @@ class NavaidStorage
 		{ _destroying = true; }
 
 	/**
-	 * Return set of navaids withing the given @radius
-	 * from a @position.
+	 * Put into @result pointers to navaids within the given @radius from a @position.
+	 * The @result is cleared first; reuse it between calls to avoid allocations.
+	 * Pointers stay valid for the lifetime of the NavaidStorage.
 	 * \threadsafe
 	 */
-	Navaids
-	get_navs (si::LonLat const& position, si::Length radius) const;
+	void
+	get_navs (si::LonLat const& position, si::Length radius, NavaidPointers& result) const;
 
 	/**
 	 * Find navaid of given type by its @identifier.
@@ -148,6 +180,12 @@ class NavaidStorage
 	void
 	parse_apt_dat();
 
+	/**
+	 * Optimize the navaids tree and build lookups and the range-query index from it.
+	 */
+	void
+	index_navaids();
+
 	bool
 	destroying();
 
@@ -161,6 +199,8 @@ class NavaidStorage
 	std::string			_fix_dat_file;
 	std::string			_apt_dat_file;
 	NavaidsTree			_navaids_tree;
+	// Same navaids indexed for range queries:
+	NavaidsIndex		_navaids_index;
 	NavaidsByType		_navaids_by_type;
 };
 
@@ -0,0 +1,181 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/earth/earth.h>
+#include <xefis/support/earth/navigation/navaid_storage.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+auto g_logger_output	= xf::LoggerOutput (std::clog);
+auto g_logger			= xf::Logger (g_logger_output);
+
+
+struct Location
+{
+	std::string_view	name;
+	si::LonLat			position;
+};
+
+
+/**
+ * Navaids spread over the whole sphere, with extra ones crowded around the poles
+ * and both sides of the antimeridian.
+ */
+NavaidStorage::Navaids
+make_navaids()
+{
+	std::mt19937 prng (1);
+	std::uniform_real_distribution<double> uniform (-1.0, 1.0);
+	std::uniform_real_distribution<double> fraction (0.0, 1.0);
+	NavaidStorage::Navaids navaids;
+
+	auto const add = [&navaids] (si::Angle const lon, si::Angle const lat) {
+		auto const identifier = QString::fromStdString (std::format ("N{:04}", navaids.size()));
+		navaids.emplace_back (Navaid::FIX, si::LonLat (lon, lat), identifier, identifier, 0_nmi);
+	};
+
+	// Uniformly distributed over the sphere:
+	for (std::size_t i = 0; i < 2000; ++i)
+		add (180_deg * uniform (prng), 1_rad * std::asin (uniform (prng)));
+
+	// Within 1° from the poles:
+	for (std::size_t i = 0; i < 200; ++i)
+	{
+		add (180_deg * uniform (prng), 89_deg + 1_deg * fraction (prng));
+		add (180_deg * uniform (prng), -89_deg - 1_deg * fraction (prng));
+	}
+
+	// Within 1° from the antimeridian, on both sides:
+	for (std::size_t i = 0; i < 300; ++i)
+	{
+		add (179_deg + 1_deg * fraction (prng), 60_deg * uniform (prng));
+		add (-179_deg - 1_deg * fraction (prng), 60_deg * uniform (prng));
+	}
+
+	// Exactly on the poles and on the antimeridian (the same points with different longitudes):
+	add (0_deg, 90_deg);
+	add (123_deg, 90_deg);
+	add (0_deg, -90_deg);
+	add (-45_deg, -90_deg);
+	add (180_deg, 10_deg);
+	add (-180_deg, 10_deg);
+
+	return navaids;
+}
+
+
+/**
+ * Return sorted identifiers of navaids within the radius, checking the distance to each one.
+ */
+std::vector<QString>
+haversine_scan (NavaidStorage::Navaids const& navaids, si::LonLat const& position, si::Length const radius)
+{
+	std::vector<QString> result;
+
+	for (auto const& navaid: navaids)
+		if (haversine_earth (position, navaid.position()) <= radius)
+			result.push_back (navaid.identifier());
+
+	std::ranges::sort (result);
+	return result;
+}
+
+
+std::vector<QString>
+sorted_identifiers (NavaidStorage::NavaidPointers const& navaids)
+{
+	std::vector<QString> result;
+
+	for (auto const* navaid: navaids)
+		result.push_back (navaid->identifier());
+
+	std::ranges::sort (result);
+	return result;
+}
+
+
+AutoTest t_1 ("NavaidStorage: get_navs() returns the same navaids as a haversine scan", []{
+	auto const navaids = make_navaids();
+	NavaidStorage const storage (g_logger, navaids);
+
+	std::vector<Location> locations = {
+		{ "North Pole",				{ 0_deg, 90_deg } },
+		{ "South Pole",				{ 77_deg, -90_deg } },
+		{ "near North Pole",		{ -100_deg, 89.9_deg } },
+		{ "near South Pole",		{ 10_deg, -89.7_deg } },
+		{ "antimeridian",			{ 180_deg, 10_deg } },
+		{ "east of antimeridian",	{ -179.95_deg, -20_deg } },
+		{ "west of antimeridian",	{ 179.95_deg, 35_deg } },
+		{ "equator",				{ 0_deg, 0_deg } },
+	};
+
+	std::mt19937 prng (2);
+	std::uniform_real_distribution<double> uniform (-1.0, 1.0);
+
+	for (std::size_t i = 0; i < 20; ++i)
+		locations.push_back ({ "random", { 180_deg * uniform (prng), 1_rad * std::asin (uniform (prng)) } });
+
+	// Up to more than half of the Earth's circumference (≈10'800 nmi):
+	std::vector<si::Length> const radii = { 0_nmi, 7_nmi, 45_nmi, 130_nmi, 370_nmi, 1100_nmi, 3300_nmi, 9900_nmi, 12000_nmi };
+
+	NavaidStorage::NavaidPointers result;
+
+	for (auto const& location: locations)
+	{
+		for (auto const radius: radii)
+		{
+			storage.get_navs (location.position, radius, result);
+			auto const expected = haversine_scan (navaids, location.position, radius);
+			auto const name = std::format ("{} ({:.2f}°, {:.2f}°) within {} nmi",
+										   location.name,
+										   location.position.lon().in<si::Degree>(),
+										   location.position.lat().in<si::Degree>(),
+										   radius.in<si::NauticalMile>());
+
+			test_asserts::verify (name + ": same number of navaids", result.size() == expected.size());
+			test_asserts::verify (name + ": same navaids", sorted_identifiers (result) == expected);
+		}
+	}
+
+	// Make sure the interesting cases actually have something to find:
+	auto const crossing = haversine_scan (navaids, { 179.95_deg, 35_deg }, 130_nmi);
+	test_asserts::verify ("query next to the antimeridian finds navaids on the other side",
+						  std::ranges::any_of (navaids, [&] (Navaid const& navaid) {
+							  return navaid.position().lon() < 0_deg && std::ranges::binary_search (crossing, navaid.identifier());
+						  }));
+	test_asserts::verify ("query at the pole finds navaids at all longitudes", haversine_scan (navaids, { 0_deg, 90_deg }, 45_nmi).size() >= 100);
+
+	storage.get_navs ({ 0_deg, 0_deg }, 12000_nmi, result);
+	test_asserts::verify ("radius larger than half of the circumference returns all navaids", result.size() == navaids.size());
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -0,0 +1,114 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/earth/earth.h>
+#include <xefis/support/earth/navigation/navaid_storage.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <numbers>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+auto g_logger_output	= xf::LoggerOutput (std::clog);
+auto g_logger			= xf::Logger (g_logger_output);
+
+// Run from the top directory, like the machines that use these files:
+constexpr char			kNavFile[]	= "share/nav/nav.dat.gz";
+constexpr char			kFixFile[]	= "share/nav/fix.dat.gz";
+constexpr char			kAptFile[]	= "share/nav/apt.dat.gz";
+constexpr std::size_t	kQueries	= 100;
+
+
+struct Location
+{
+	std::string_view	name;
+	si::LonLat			position;
+};
+
+
+ManualTest t_1 ("NavaidStorage: get_navs() on shipped navigation data", []{
+	NavaidStorage storage (g_logger, kNavFile, kFixFile, kAptFile);
+	// Runs the loader on this thread; the task marks the storage as loaded:
+	storage.async_loader()();
+
+	std::vector<Location> const locations = {
+		{ "Warsaw",				{ 20.97_deg, 52.17_deg } },
+		{ "San Francisco",		{ -122.38_deg, 37.62_deg } },
+		{ "London",				{ -0.46_deg, 51.47_deg } },
+		{ "Antimeridian, Fiji",	{ 179.99_deg, -17.75_deg } },
+		{ "North Pole",			{ 0_deg, 89.99_deg } },
+	};
+
+	// Ranges in nmi as used by the HSI, radius is max (range + 20 nmi, 2·range):
+	std::vector<si::Length> const ranges = { 5_nmi, 10_nmi, 40_nmi, 80_nmi, 160_nmi, 320_nmi };
+
+	// All navaids, for the baseline that checks the distance to each one and copies
+	// matching navaids, which is what get_navs() used to do:
+	NavaidStorage::NavaidPointers all_navaids;
+	storage.get_navs ({ 0_deg, 0_deg }, 2.0 * kEarthMeanRadius * std::numbers::pi, all_navaids);
+	std::cout << std::format ("{} navaids loaded; {} queries per measurement:\n", all_navaids.size(), kQueries);
+
+	NavaidStorage::NavaidPointers result;
+	NavaidStorage::Navaids baseline_result;
+
+	for (auto const& location: locations)
+	{
+		std::cout << std::format ("  {}:\n", location.name);
+
+		for (auto const range: ranges)
+		{
+			auto const radius = std::max (range + 20_nmi, 2.0 * range);
+
+			si::Time const baseline = TimeHelper::measure ([&] {
+				for (std::size_t i = 0; i < kQueries; ++i)
+				{
+					baseline_result.clear();
+
+					for (auto const* navaid: all_navaids)
+						if (haversine_earth (location.position, navaid->position()) <= radius)
+							baseline_result.push_back (*navaid);
+				}
+			});
+
+			si::Time const range_query = TimeHelper::measure ([&] {
+				for (std::size_t i = 0; i < kQueries; ++i)
+					storage.get_navs (location.position, radius, result);
+			});
+
+			std::cout << std::format ("    range {:5.0f} nmi: {:6} navaids{}, full scan {:9.3f} µs/query, range query {:9.3f} µs/query\n",
+									  range.in<si::NauticalMile>(),
+									  result.size(),
+									  result.size() == baseline_result.size() ? "" : " (MISMATCH)",
+									  baseline.in<si::Second>() * 1e6 / kQueries,
+									  range_query.in<si::Second>() * 1e6 / kQueries);
+		}
+	}
+});
+
+} // namespace
+} // namespace xf::test
+
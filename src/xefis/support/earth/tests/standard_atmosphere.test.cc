@@ -13,13 +13,16 @@
 
 // Xefis:
 #include <xefis/support/earth/air/standard_atmosphere.h>
+#include <xefis/support/nature/constants.h>
 
 // Neutrino:
 #include <neutrino/test/auto_test.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
 #include <cmath>
+#include <vector>
 
 
 namespace xf::test {
@@ -63,6 +66,76 @@ AutoTest t_standard_temperature_gradient ("xf::standard_temperature_gradient() d
 });
 
 
+AutoTest t_tabulated_standard_atmosphere ("xf::TabulatedStandardAtmosphere agrees with StandardAtmosphere", []{
+	StandardAtmosphere const reference;
+	TabulatedStandardAtmosphere const tabulated;
+	auto const tolerance = TabulatedStandardAtmosphere::kRelativeTolerance;
+
+	auto const check = [&] (si::Length const altitude) {
+		auto const expected = reference.air_at_amsl (altitude);
+		auto const air = tabulated.air_at_amsl (altitude);
+		auto const at = " at " + to_string (altitude);
+
+		test_asserts::verify_equal_with_epsilon ("density" + at, air.density, expected.density, tolerance * expected.density);
+		test_asserts::verify_equal_with_epsilon ("pressure" + at, air.pressure, expected.pressure, tolerance * expected.pressure);
+		test_asserts::verify_equal_with_epsilon ("temperature" + at, air.temperature, expected.temperature, tolerance * expected.temperature);
+		test_asserts::verify_equal_with_epsilon ("dynamic viscosity" + at, air.dynamic_viscosity, expected.dynamic_viscosity, tolerance * expected.dynamic_viscosity);
+		test_asserts::verify_equal_with_epsilon ("speed of sound" + at, air.speed_of_sound, expected.speed_of_sound, tolerance * expected.speed_of_sound);
+	};
+
+	// Step not aligned with the table grid, so that all positions within cells get tested:
+	for (si::Length altitude = -0.61_km; altitude <= 84.852_km; altitude += 1.37_m)
+		check (altitude);
+
+	// Both sides of ISA layer boundaries and ends of the ISA range:
+	for (auto const boundary: { -0.61_km, 0_km, 11_km, 20_km, 32_km, 47_km, 51_km, 71_km, 84.852_km })
+		for (auto const offset: { -1_mm, 0_m, 1_mm })
+			check (std::clamp (boundary + offset, -0.61_km, 84.852_km));
+});
+
+
+AutoTest t_tabulated_standard_atmosphere_clamping ("xf::TabulatedStandardAtmosphere clamps altitude to the ISA range", []{
+	TabulatedStandardAtmosphere const tabulated;
+
+	auto const below = tabulated.air_at_amsl (-10_km);
+	auto const bottom = tabulated.air_at_amsl (-0.61_km);
+	auto const above = tabulated.air_at_amsl (1000_km);
+	auto const top = tabulated.air_at_amsl (84.852_km);
+
+	test_asserts::verify_equal ("density below ISA range", below.density, bottom.density);
+	test_asserts::verify_equal ("temperature below ISA range", below.temperature, bottom.temperature);
+	test_asserts::verify_equal ("density above ISA range", above.density, top.density);
+	test_asserts::verify_equal ("temperature above ISA range", above.temperature, top.temperature);
+});
+
+
+AutoTest t_atmosphere_batch_air_at ("xf::Atmosphere: batch air_at() gives the same results as single calls", []{
+	StandardAtmosphere const reference;
+	TabulatedStandardAtmosphere const tabulated;
+	std::vector<SpaceVector<si::Length, ECEFSpace>> positions;
+
+	for (si::Length altitude = -1_km; altitude < 100_km; altitude += 3.3_km)
+		positions.push_back ({ 0.6 * (kEarthMeanRadius + altitude), 0.8 * (kEarthMeanRadius + altitude), 0_m });
+
+	for (Atmosphere const* atmosphere: { static_cast<Atmosphere const*> (&reference), static_cast<Atmosphere const*> (&tabulated) })
+	{
+		std::vector<Air<ECEFSpace>> results (positions.size());
+		atmosphere->air_at (positions, results);
+
+		for (std::size_t i = 0; i < positions.size(); ++i)
+		{
+			auto const single = atmosphere->air_at (positions[i]);
+
+			test_asserts::verify_equal ("density", results[i].density, single.density);
+			test_asserts::verify_equal ("pressure", results[i].pressure, single.pressure);
+			test_asserts::verify_equal ("temperature", results[i].temperature, single.temperature);
+			test_asserts::verify_equal ("dynamic viscosity", results[i].dynamic_viscosity, single.dynamic_viscosity);
+			test_asserts::verify_equal ("speed of sound", results[i].speed_of_sound, single.speed_of_sound);
+		}
+	}
+});
+
+
 // TODO Make tests for:
 // TODO   dynamic_air_viscosity (si::Temperature);
 // TODO   speed_of_sound (si::Temperature static_air_temperature)
@@ -0,0 +1,186 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/earth/air/standard_atmosphere.h>
+#include <xefis/support/earth/air/turbulent_atmosphere.h>
+#include <xefis/support/nature/constants.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+TabulatedStandardAtmosphere const kStandardAtmosphere;
+
+
+SpaceVector<si::Length, ECEFSpace>
+position_at_altitude (si::Length const altitude)
+{
+	// On the equator, where east is +Y and north is +Z:
+	return { kEarthMeanRadius + altitude, 0_m, 0_m };
+}
+
+
+AutoTest t_1 ("TurbulentAtmosphere: mean wind without turbulence", []{
+	TurbulentAtmosphere const atmosphere (kStandardAtmosphere, {
+		.wind_speed = 10_mps,
+		.wind_direction = 270_deg,
+		.reference_altitude = 10_m,
+		.boundary_layer_height = 600_m,
+	});
+
+	auto const at_reference = atmosphere.wind_at (position_at_altitude (10_m));
+
+	// Westerly wind blows towards east. The profile is tabulated, so allow for some interpolation error:
+	test_asserts::verify_equal_with_epsilon ("wind blows east", at_reference[1], 10_mps, 0.05_mps);
+	test_asserts::verify_equal_with_epsilon ("no vertical wind", at_reference[0], 0_mps, 1e-9_mps);
+	test_asserts::verify_equal_with_epsilon ("no north wind", at_reference[2], 0_mps, 1e-9_mps);
+
+	auto const at_ground = atmosphere.wind_at (position_at_altitude (0_m));
+	auto const at_100_m = atmosphere.wind_at (position_at_altitude (100_m));
+	auto const at_600_m = atmosphere.wind_at (position_at_altitude (600_m));
+	auto const at_5_km = atmosphere.wind_at (position_at_altitude (5_km));
+
+	test_asserts::verify_equal_with_epsilon ("no wind at the ground", abs (at_ground), 0_mps, 1e-9_mps);
+	test_asserts::verify ("wind increases with altitude", abs (at_100_m) > abs (at_reference) && abs (at_600_m) > abs (at_100_m));
+	test_asserts::verify_equal_with_epsilon ("wind follows the power law", abs (at_600_m), 10_mps * std::pow (60.0, 1.0 / 7.0), 1e-2_mps);
+	test_asserts::verify_equal ("wind is constant above the boundary layer", abs (at_5_km), abs (at_600_m));
+
+	auto const air = atmosphere.air_at (position_at_altitude (100_m));
+	auto const standard_air = kStandardAtmosphere.air_at (position_at_altitude (100_m));
+	test_asserts::verify_equal ("other air parameters come from the base atmosphere", air.density, standard_air.density);
+	test_asserts::verify_equal ("air velocity is wind velocity", abs (air.velocity - at_100_m), 0_mps);
+});
+
+
+AutoTest t_2 ("TurbulentAtmosphere: turbulence is deterministic", []{
+	auto const params_1 = TurbulentAtmosphereParameters { .turbulence_intensity = 2_mps, .seed = 1 };
+	auto const params_2 = TurbulentAtmosphereParameters { .turbulence_intensity = 2_mps, .seed = 2 };
+	TurbulentAtmosphere const atmosphere_1a (kStandardAtmosphere, params_1);
+	TurbulentAtmosphere const atmosphere_1b (kStandardAtmosphere, params_1);
+	TurbulentAtmosphere const atmosphere_2 (kStandardAtmosphere, params_2);
+
+	auto differs = false;
+
+	for (std::size_t i = 0; i < 100; ++i)
+	{
+		auto const position = position_at_altitude (100_m) + SpaceVector<si::Length, ECEFSpace> { 0_m, 37_m * static_cast<double> (i), 11_m * static_cast<double> (i) };
+		auto const wind_1a = atmosphere_1a.wind_at (position);
+
+		test_asserts::verify_equal ("same seed gives the same field", abs (wind_1a - atmosphere_1b.wind_at (position)), 0_mps);
+		differs = differs || abs (wind_1a - atmosphere_2.wind_at (position)) > 0.01_mps;
+	}
+
+	test_asserts::verify ("different seed gives a different field", differs);
+});
+
+
+AutoTest t_3 ("TurbulentAtmosphere: turbulence intensity", []{
+	auto const intensity = 2_mps;
+	TurbulentAtmosphere const atmosphere (kStandardAtmosphere, { .turbulence_intensity = intensity, .turbulence_scale = 10_m });
+
+	// Sample the whole tile at grid points, where there's no interpolation:
+	auto const n = TurbulentAtmosphere::kTileCells;
+	auto const cell = 10_m * TurbulentAtmosphere::kTileScales / static_cast<double> (n);
+	auto const origin_x = cell * std::round ((kEarthMeanRadius + 100_m).in<si::Meter>() / cell.in<si::Meter>());
+	auto sum_of_squares = 0.0;
+	auto mean = SpaceVector<double, ECEFSpace> { 0.0, 0.0, 0.0 };
+
+	for (std::size_t xi = 0; xi < n; ++xi)
+	{
+		for (std::size_t yi = 0; yi < n; ++yi)
+		{
+			for (std::size_t zi = 0; zi < n; ++zi)
+			{
+				auto const position = SpaceVector<si::Length, ECEFSpace> {
+					origin_x + cell * static_cast<double> (xi),
+					cell * static_cast<double> (yi),
+					cell * static_cast<double> (zi),
+				};
+				auto const wind = atmosphere.wind_at (position) / 1_mps;
+				sum_of_squares += square (abs (wind));
+				mean += wind;
+			}
+		}
+	}
+
+	auto const samples = static_cast<double> (n * n * n);
+	auto const rms = 1_mps * std::sqrt (sum_of_squares / (3.0 * samples));
+
+	test_asserts::verify_equal_with_epsilon ("RMS of each component equals intensity", rms, intensity, 1e-3 * intensity);
+	test_asserts::verify ("mean turbulence is zero", abs (mean / samples) < 1e-6);
+
+	auto const fading = TurbulentAtmosphere (kStandardAtmosphere, { .boundary_layer_height = 600_m, .turbulence_intensity = intensity });
+	test_asserts::verify_equal ("no turbulence high above the boundary layer", abs (fading.wind_at (position_at_altitude (1.5_km))), 0_mps);
+});
+
+
+AutoTest t_4 ("TurbulentAtmosphere: turbulence is coherent in space and time", []{
+	auto const params = TurbulentAtmosphereParameters {
+		.wind_speed = 5_mps,
+		.wind_direction = 270_deg,
+		.turbulence_intensity = 2_mps,
+		.turbulence_scale = 200_m,
+	};
+	TurbulentAtmosphere const calm (kStandardAtmosphere, { .wind_speed = params.wind_speed, .wind_direction = params.wind_direction });
+	TurbulentAtmosphere atmosphere (kStandardAtmosphere, params);
+
+	auto const position = position_at_altitude (100_m);
+	auto const nearby = position + SpaceVector<si::Length, ECEFSpace> { 0_m, 10_cm, 10_cm };
+
+	test_asserts::verify ("nearby points have similar wind",
+						  abs (atmosphere.wind_at (position) - atmosphere.wind_at (nearby)) < 0.05 * params.turbulence_intensity);
+
+	// Turbulence is carried by the mean wind:
+	auto const mean_wind = calm.wind_at (position);
+	auto const dt = 10_s;
+	auto const upwind = position - mean_wind * dt;
+	auto const turbulence_upwind_before = atmosphere.wind_at (upwind) - calm.wind_at (upwind);
+	atmosphere.set_time (dt);
+	auto const turbulence_here_after = atmosphere.wind_at (position) - mean_wind;
+
+	test_asserts::verify_equal_with_epsilon ("turbulence is advected with the mean wind",
+											 abs (turbulence_here_after - turbulence_upwind_before), 0_mps, 1e-3_mps);
+});
+
+
+AutoTest t_5 ("TurbulentAtmosphere: batch air_at() gives the same results as single calls", []{
+	TurbulentAtmosphere const atmosphere (kStandardAtmosphere, { .wind_speed = 5_mps, .turbulence_intensity = 2_mps, .seed = 7 });
+	std::vector<SpaceVector<si::Length, ECEFSpace>> positions;
+
+	for (std::size_t i = 0; i < 20; ++i)
+		positions.push_back (position_at_altitude (50_m * static_cast<double> (i)) + SpaceVector<si::Length, ECEFSpace> { 0_m, 1_m * static_cast<double> (i), 0_m });
+
+	std::vector<Air<ECEFSpace>> results (positions.size());
+	atmosphere.air_at (positions, results);
+
+	for (std::size_t i = 0; i < positions.size(); ++i)
+	{
+		auto const single = atmosphere.air_at (positions[i]);
+		test_asserts::verify_equal ("density", results[i].density, single.density);
+		test_asserts::verify_equal ("velocity", abs (results[i].velocity - single.velocity), 0_mps);
+	}
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -0,0 +1,297 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "sparse_ldlt.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Neutrino:
+#include <neutrino/exception.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <set>
+#include <utility>
+
+
+namespace xf {
+namespace {
+
+constexpr auto kNone = std::numeric_limits<SparseLDLT::Index>::max();
+
+
+[[nodiscard]]
+inline bool
+entry_less (SparseLDLT::Entry const& a, SparseLDLT::Entry const& b)
+{
+	return std::pair (a.row, a.column) < std::pair (b.row, b.column);
+}
+
+
+[[nodiscard]]
+inline bool
+entry_equal (SparseLDLT::Entry const& a, SparseLDLT::Entry const& b)
+{
+	return a.row == b.row && a.column == b.column;
+}
+
+} // namespace
+
+
+SparseLDLT::SparseLDLT (Index const n, std::span<Entry const> const off_diagonal):
+	_n (n)
+{
+	// Collect unique (row ≤ column) pairs, one value per symmetric pair:
+	_value_entries.reserve (n + off_diagonal.size());
+
+	for (Index i = 0; i < n; ++i)
+		_value_entries.push_back ({ i, i });
+
+	for (auto const& entry: off_diagonal)
+	{
+		if (entry.row >= n || entry.column >= n)
+			throw InvalidArgument ("SparseLDLT: matrix element outside of the matrix");
+
+		if (entry.row != entry.column)
+			_value_entries.push_back ({ std::min (entry.row, entry.column), std::max (entry.row, entry.column) });
+	}
+
+	std::sort (_value_entries.begin(), _value_entries.end(), entry_less);
+	_value_entries.erase (std::unique (_value_entries.begin(), _value_entries.end(), entry_equal), _value_entries.end());
+	_values.assign (_value_entries.size(), 0.0);
+
+	std::vector<std::vector<Index>> adjacency (n);
+
+	for (auto const& entry: _value_entries)
+	{
+		if (entry.row != entry.column)
+		{
+			adjacency[entry.row].push_back (entry.column);
+			adjacency[entry.column].push_back (entry.row);
+		}
+	}
+
+	compute_ordering (adjacency);
+
+	// Build column-compressed upper triangle of the permuted matrix:
+	std::vector<Index> column_counts (n + 1, 0);
+
+	for (auto const& entry: _value_entries)
+		++column_counts[std::max (_inverse_permutation[entry.row], _inverse_permutation[entry.column]) + 1];
+
+	_column_starts.resize (n + 1);
+	_column_starts[0] = 0;
+
+	for (Index k = 0; k < n; ++k)
+		_column_starts[k + 1] = _column_starts[k] + column_counts[k + 1];
+
+	_row_indices.resize (_value_entries.size());
+	_value_indices.resize (_value_entries.size());
+	std::vector<Index> next (_column_starts.begin(), _column_starts.end() - 1);
+
+	for (Index v = 0; v < _value_entries.size(); ++v)
+	{
+		auto const pr = _inverse_permutation[_value_entries[v].row];
+		auto const pc = _inverse_permutation[_value_entries[v].column];
+		auto const p = next[std::max (pr, pc)]++;
+		_row_indices[p] = std::min (pr, pc);
+		_value_indices[p] = v;
+	}
+
+	compute_symbolic();
+}
+
+
+std::optional<SparseLDLT::Index>
+SparseLDLT::value_index (Index const row, Index const column) const
+{
+	auto const entry = Entry { std::min (row, column), std::max (row, column) };
+	auto const found = std::lower_bound (_value_entries.begin(), _value_entries.end(), entry, entry_less);
+
+	if (found != _value_entries.end() && entry_equal (*found, entry))
+		return static_cast<Index> (found - _value_entries.begin());
+	else
+		return std::nullopt;
+}
+
+
+bool
+SparseLDLT::factorize()
+{
+	// Up-looking LDLᵀ, as in T. Davis, "Algorithm 849: A concise sparse Cholesky factorization package":
+	for (Index k = 0; k < _n; ++k)
+	{
+		_y[k] = 0.0;
+		auto top = _n;
+		_flag[k] = k;
+		_l_counts[k] = 0;
+
+		for (auto p = _column_starts[k]; p < _column_starts[k + 1]; ++p)
+		{
+			auto i = _row_indices[p];
+			_y[i] += _values[_value_indices[p]];
+			Index length = 0;
+
+			for (; _flag[i] != k; i = _parent[i])
+			{
+				_pattern[length++] = i;
+				_flag[i] = k;
+			}
+
+			while (length > 0)
+				_pattern[--top] = _pattern[--length];
+		}
+
+		_d[k] = _y[k];
+		_y[k] = 0.0;
+
+		for (; top < _n; ++top)
+		{
+			auto const i = _pattern[top];
+			auto const yi = _y[i];
+			_y[i] = 0.0;
+			auto const p_end = _l_column_starts[i] + _l_counts[i];
+
+			for (auto p = _l_column_starts[i]; p < p_end; ++p)
+				_y[_l_indices[p]] -= _l_values[p] * yi;
+
+			auto const l_ki = yi / _d[i];
+			_d[k] -= l_ki * yi;
+			_l_indices[p_end] = k;
+			_l_values[p_end] = l_ki;
+			++_l_counts[i];
+		}
+
+		if (_d[k] == 0.0)
+			return false;
+	}
+
+	return true;
+}
+
+
+void
+SparseLDLT::solve (std::span<double> const b) const
+{
+	auto& x = _y;
+
+	for (Index k = 0; k < _n; ++k)
+		x[k] = b[_permutation[k]];
+
+	for (Index j = 0; j < _n; ++j)
+		for (auto p = _l_column_starts[j]; p < _l_column_starts[j + 1]; ++p)
+			x[_l_indices[p]] -= _l_values[p] * x[j];
+
+	for (Index j = 0; j < _n; ++j)
+		x[j] /= _d[j];
+
+	for (Index j = _n; j-- > 0; )
+		for (auto p = _l_column_starts[j]; p < _l_column_starts[j + 1]; ++p)
+			x[j] -= _l_values[p] * x[_l_indices[p]];
+
+	for (Index k = 0; k < _n; ++k)
+	{
+		b[_permutation[k]] = x[k];
+		x[k] = 0.0;
+	}
+}
+
+
+void
+SparseLDLT::compute_ordering (std::vector<std::vector<Index>> const& adjacency)
+{
+	// Greedy minimum degree ordering on the elimination graph:
+	std::vector<std::set<Index>> graph (_n);
+	std::set<std::pair<std::size_t, Index>> by_degree;
+
+	for (Index i = 0; i < _n; ++i)
+	{
+		graph[i].insert (adjacency[i].begin(), adjacency[i].end());
+		by_degree.insert ({ graph[i].size(), i });
+	}
+
+	_permutation.clear();
+	_permutation.reserve (_n);
+
+	while (!by_degree.empty())
+	{
+		auto const v = by_degree.begin()->second;
+		by_degree.erase (by_degree.begin());
+		_permutation.push_back (v);
+
+		// Eliminating v connects all its neighbours with each other:
+		auto const neighbours = std::exchange (graph[v], {});
+
+		for (auto const u: neighbours)
+		{
+			by_degree.erase ({ graph[u].size(), u });
+			graph[u].erase (v);
+
+			for (auto const w: neighbours)
+				if (w != u)
+					graph[u].insert (w);
+
+			by_degree.insert ({ graph[u].size(), u });
+		}
+	}
+
+	_inverse_permutation.resize (_n);
+
+	for (Index k = 0; k < _n; ++k)
+		_inverse_permutation[_permutation[k]] = k;
+}
+
+
+void
+SparseLDLT::compute_symbolic()
+{
+	_parent.assign (_n, kNone);
+	_flag.assign (_n, kNone);
+	_l_counts.assign (_n, 0);
+
+	for (Index k = 0; k < _n; ++k)
+	{
+		_flag[k] = k;
+
+		for (auto p = _column_starts[k]; p < _column_starts[k + 1]; ++p)
+		{
+			for (auto i = _row_indices[p]; _flag[i] != k; i = _parent[i])
+			{
+				if (_parent[i] == kNone)
+					_parent[i] = k;
+
+				++_l_counts[i];
+				_flag[i] = k;
+			}
+		}
+	}
+
+	_l_column_starts.resize (_n + 1);
+	_l_column_starts[0] = 0;
+
+	for (Index k = 0; k < _n; ++k)
+		_l_column_starts[k + 1] = _l_column_starts[k] + _l_counts[k];
+
+	_l_indices.resize (_l_column_starts[_n]);
+	_l_values.resize (_l_column_starts[_n]);
+	_d.resize (_n);
+	_y.assign (_n, 0.0);
+	_pattern.resize (_n);
+}
+
+} // namespace xf
+
@@ -0,0 +1,166 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__MATH__SPARSE_LDLT_H__INCLUDED
+#define XEFIS__SUPPORT__MATH__SPARSE_LDLT_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Standard:
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace xf {
+
+/**
+ * Sparse LDLᵀ factorization of a symmetric matrix, for solving A·x = b many times
+ * with the same sparsity pattern of A.
+ *
+ * Work is split into phases:
+ *  • symbolic analysis (constructor): computes fill-reducing ordering (minimum degree),
+ *    elimination tree and structure of L; done once for a given sparsity pattern,
+ *  • numeric factorization (factorize()): must be redone only when values of A change,
+ *  • solve(): forward and back substitution, for each right-hand side.
+ *
+ * No pivoting is done, so the matrix should be positive-definite (or at least all its
+ * leading minors in the computed ordering must be nonzero).
+ */
+class SparseLDLT
+{
+  public:
+	using Index = std::size_t;
+
+	/**
+	 * Off-diagonal non-zero element position. Symmetric counterpart is implied.
+	 */
+	struct Entry
+	{
+		Index	row;
+		Index	column;
+	};
+
+  public:
+	// Ctor
+	SparseLDLT() = default;
+
+	/**
+	 * Analyze sparsity pattern of an n×n symmetric matrix.
+	 * Diagonal is always included in the pattern. Duplicate entries are allowed.
+	 */
+	explicit
+	SparseLDLT (Index n, std::span<Entry const> off_diagonal);
+
+	/**
+	 * Return matrix size.
+	 */
+	[[nodiscard]]
+	Index
+	size() const noexcept
+		{ return _n; }
+
+	/**
+	 * Return index of given matrix element in values(), or std::nullopt if element
+	 * is not in the pattern. Both (row, column) and (column, row) refer to the same value.
+	 */
+	[[nodiscard]]
+	std::optional<Index>
+	value_index (Index row, Index column) const;
+
+	/**
+	 * Values of matrix elements (one per symmetric pair) referenced by value_index().
+	 * Changing them requires calling factorize() before next solve().
+	 */
+	[[nodiscard]]
+	std::vector<double>&
+	values() noexcept
+		{ return _values; }
+
+	/**
+	 * Values of matrix elements referenced by value_index().
+	 */
+	[[nodiscard]]
+	std::vector<double> const&
+	values() const noexcept
+		{ return _values; }
+
+	/**
+	 * Compute numeric factorization using current values().
+	 *
+	 * \returns	false if a zero pivot was encountered (matrix is singular in the computed ordering).
+	 */
+	[[nodiscard]]
+	bool
+	factorize();
+
+	/**
+	 * Solve A·x = b in-place: b is replaced by x.
+	 * Requires successful factorize().
+	 */
+	void
+	solve (std::span<double> b) const;
+
+	/**
+	 * Return number of non-zero elements in the L factor (excluding unit diagonal).
+	 */
+	[[nodiscard]]
+	std::size_t
+	factor_non_zeros() const noexcept
+		{ return _l_indices.size(); }
+
+  private:
+	/**
+	 * Compute minimum-degree ordering into _permutation and _inverse_permutation.
+	 */
+	void
+	compute_ordering (std::vector<std::vector<Index>> const& adjacency);
+
+	/**
+	 * Compute elimination tree and column pointers of L.
+	 */
+	void
+	compute_symbolic();
+
+  private:
+	Index					_n				{ 0 };
+	// Pattern of the permuted matrix (upper triangle including diagonal, column-compressed).
+	// Each entry refers to an element of _values:
+	std::vector<Index>		_column_starts;
+	std::vector<Index>		_row_indices;
+	std::vector<Index>		_value_indices;
+	std::vector<double>		_values;
+	// Sorted (row, column) pairs with row ≤ column in the original ordering, parallel to _values:
+	std::vector<Entry>		_value_entries;
+	// _permutation[k] is the original index of k-th pivot:
+	std::vector<Index>		_permutation;
+	std::vector<Index>		_inverse_permutation;
+	// Factorization:
+	std::vector<Index>		_parent;
+	std::vector<Index>		_l_column_starts;
+	std::vector<Index>		_l_indices;
+	std::vector<double>		_l_values;
+	std::vector<double>		_d;
+	// Workspace:
+	mutable std::vector<double>	_y;
+	std::vector<Index>		_pattern;
+	std::vector<Index>		_flag;
+	std::vector<Index>		_l_counts;
+};
+
+} // namespace xf
+
+#endif
+
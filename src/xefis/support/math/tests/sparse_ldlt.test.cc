@@ -0,0 +1,170 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/sparse_ldlt.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+/**
+ * Random symmetric, diagonally dominant (thus positive-definite) sparse matrix.
+ */
+struct RandomSystem
+{
+	std::size_t						n;
+	std::vector<SparseLDLT::Entry>	entries;
+	std::vector<double>				dense;
+
+	explicit
+	RandomSystem (std::size_t const n, std::size_t const off_diagonal, std::mt19937& rng):
+		n (n),
+		dense (n * n, 0.0)
+	{
+		std::uniform_int_distribution<std::size_t> index (0, n - 1);
+		std::uniform_real_distribution<double> value (-1.0, 1.0);
+
+		for (std::size_t k = 0; k < off_diagonal; ++k)
+		{
+			auto const i = index (rng);
+			auto const j = index (rng);
+
+			if (i != j)
+			{
+				auto const v = value (rng);
+				entries.push_back ({ i, j });
+				dense[i * n + j] += v;
+				dense[j * n + i] += v;
+				dense[i * n + i] += 2.0 * std::abs (v);
+				dense[j * n + j] += 2.0 * std::abs (v);
+			}
+		}
+
+		for (std::size_t i = 0; i < n; ++i)
+			dense[i * n + i] += 1.0;
+	}
+
+	void
+	load (SparseLDLT& ldlt) const
+	{
+		auto& values = ldlt.values();
+		std::fill (values.begin(), values.end(), 0.0);
+
+		for (std::size_t i = 0; i < n; ++i)
+			for (std::size_t j = i; j < n; ++j)
+				if (dense[i * n + j] != 0.0)
+					values[*ldlt.value_index (i, j)] = dense[i * n + j];
+	}
+
+	[[nodiscard]]
+	double
+	residual (std::vector<double> const& x, std::vector<double> const& b) const
+	{
+		auto max_residual = 0.0;
+
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			auto sum = 0.0;
+
+			for (std::size_t j = 0; j < n; ++j)
+				sum += dense[i * n + j] * x[j];
+
+			max_residual = std::max (max_residual, std::abs (sum - b[i]));
+		}
+
+		return max_residual;
+	}
+};
+
+
+AutoTest t_1 ("SparseLDLT: tridiagonal system", []{
+	constexpr std::size_t n = 100;
+	std::vector<SparseLDLT::Entry> entries;
+
+	for (std::size_t i = 0; i + 1 < n; ++i)
+		entries.push_back ({ i + 1, i });
+
+	SparseLDLT ldlt (n, entries);
+
+	test_asserts::verify ("no fill-in for tridiagonal matrix", ldlt.factor_non_zeros() == n - 1);
+
+	// 1D Laplacian with Dirichlet boundary:
+	for (std::size_t i = 0; i < n; ++i)
+	{
+		ldlt.values()[*ldlt.value_index (i, i)] = 2.0;
+
+		if (i + 1 < n)
+			ldlt.values()[*ldlt.value_index (i, i + 1)] = -1.0;
+	}
+
+	test_asserts::verify ("factorization succeeds", ldlt.factorize());
+
+	// Solution of A·x = e₀ is x[i] = (n - i) / (n + 1):
+	std::vector<double> b (n, 0.0);
+	b[0] = 1.0;
+	ldlt.solve (b);
+
+	for (std::size_t i = 0; i < n; ++i)
+		test_asserts::verify_equal_with_epsilon ("solution is correct", b[i], (n - i) / (n + 1.0), 1e-12);
+});
+
+
+AutoTest t_2 ("SparseLDLT: random systems and refactorization", []{
+	std::mt19937 rng (1);
+
+	for (std::size_t round = 0; round < 20; ++round)
+	{
+		RandomSystem const system (50, 120, rng);
+		SparseLDLT ldlt (system.n, system.entries);
+		std::uniform_real_distribution<double> value (-10.0, 10.0);
+		std::vector<double> b (system.n);
+
+		for (auto& bi: b)
+			bi = value (rng);
+
+		system.load (ldlt);
+		test_asserts::verify ("factorization succeeds", ldlt.factorize());
+
+		auto x = b;
+		ldlt.solve (x);
+		test_asserts::verify ("residual is small", system.residual (x, b) < 1e-10);
+
+		// Same pattern, scaled values:
+		auto scaled = system;
+
+		for (auto& v: scaled.dense)
+			v *= 3.0;
+
+		scaled.load (ldlt);
+		test_asserts::verify ("refactorization succeeds", ldlt.factorize());
+
+		x = b;
+		ldlt.solve (x);
+		test_asserts::verify ("residual after refactorization is small", scaled.residual (x, b) < 1e-10);
+	}
+});
+
+} // namespace
+} // namespace xf::test
+
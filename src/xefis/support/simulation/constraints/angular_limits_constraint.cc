@@ -69,6 +69,28 @@ AngularLimitsConstraint::do_constraint_forces (VelocityMoments<WorldSpace> const
 }
 
 
+void
+AngularLimitsConstraint::clamp_accumulated_forces (ConstraintForces& accumulated) const
+{
+	auto const& hinge_data = _hinge_precalculation.data();
+	// Limits can only rotate body 2 back towards the allowed range, and only when it's outside of it:
+	auto const torque_2 = dot_product (hinge_data.a1, accumulated[1].torque());
+
+	if (_min_angle && hinge_data.angle < *_min_angle)
+	{
+		if (torque_2 < 0_Nm)
+			accumulated = {};
+	}
+	else if (_max_angle && hinge_data.angle > *_max_angle)
+	{
+		if (torque_2 > 0_Nm)
+			accumulated = {};
+	}
+	else
+		accumulated = {};
+}
+
+
 std::optional<ConstraintForces>
 AngularLimitsConstraint::min_angle_corrections (VelocityMoments<WorldSpace> const& vm_1,
 												VelocityMoments<WorldSpace> const& vm_2,
@@ -77,10 +99,10 @@ AngularLimitsConstraint::min_angle_corrections (VelocityMoments<WorldSpace> cons
 {
 	if (_min_angle && hinge_data.angle < *_min_angle)
 	{
-		auto const J = calculate_jacobian (vm_1, _Jv, _min_Jw1, vm_2, _Jv, _min_Jw2);
+		auto const J = calculate_jacobian<NoJacobianRows> (vm_1, _Jv, _min_Jw1, vm_2, _Jv, _min_Jw2);
 		auto const lambda = calculate_lambda (_min_location_constraint_value, J, _min_Z, dt);
 
-		return calculate_constraint_forces (_Jv, _min_Jw1, _Jv, _min_Jw2, lambda);
+		return calculate_constraint_forces<NoJacobianRows> (_Jv, _min_Jw1, _Jv, _min_Jw2, lambda);
 	}
 	else
 		return std::nullopt;
@@ -95,10 +117,10 @@ AngularLimitsConstraint::max_angle_corrections (VelocityMoments<WorldSpace> cons
 {
 	if (_max_angle && hinge_data.angle > *_max_angle)
 	{
-		auto const J = calculate_jacobian (vm_1, _Jv, _min_Jw2, vm_2, _Jv, _min_Jw1);
+		auto const J = calculate_jacobian<NoJacobianRows> (vm_1, _Jv, _min_Jw2, vm_2, _Jv, _min_Jw1);
 		auto const lambda = calculate_lambda (_max_location_constraint_value, J, _max_Z, dt);
 
-		return calculate_constraint_forces (_Jv, _min_Jw2, _Jv, _min_Jw1, lambda);
+		return calculate_constraint_forces<NoJacobianRows> (_Jv, _min_Jw2, _Jv, _min_Jw1, lambda);
 	}
 	else
 		return std::nullopt;
@@ -45,11 +45,27 @@ AngularMotorConstraint::initialize_step (si::Time const dt)
 ConstraintForces
 AngularMotorConstraint::do_constraint_forces (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time dt)
 {
-	auto const J = calculate_jacobian (vm_1, _Jv, _Jw1, vm_2, _Jv, _Jw2);
+	auto const J = calculate_jacobian<NoJacobianRows> (vm_1, _Jv, _Jw1, vm_2, _Jv, _Jw2);
 	auto lambda = calculate_lambda (_location_constraint_value, J, _Z, dt);
 	lambda = std::clamp (lambda.scalar(), -_force, +_force); // TODO scalar?
 
-	return calculate_constraint_forces (_Jv, _Jw1, _Jv, _Jw2, lambda);
+	return calculate_constraint_forces<NoJacobianRows> (_Jv, _Jw1, _Jv, _Jw2, lambda);
+}
+
+
+void
+AngularMotorConstraint::clamp_accumulated_forces (ConstraintForces& accumulated) const
+{
+	// Motor only applies torques about the hinge, opposite on both bodies:
+	auto const axial_torque = abs (dot_product (_hinge_precalculation.data().a1, accumulated[0].torque()));
+
+	if (axial_torque > torque())
+	{
+		auto const factor = torque() / axial_torque;
+
+		for (auto& fm: accumulated)
+			fm = ForceMoments<WorldSpace> (factor * fm.force(), factor * fm.torque());
+	}
 }
 
 } // namespace xf::rigid_body
@@ -56,6 +56,11 @@ class AngularSpringConstraint: public Constraint
 	void
 	initialize_step (si::Time dt) override;
 
+	// Constraint API
+	bool
+	returns_velocity_corrections() const noexcept override
+		{ return false; }
+
   protected:
 	// Constraint API
 	ConstraintForces
@@ -47,6 +47,19 @@ class FixedConstraint: public Constraint
 	ConstraintForces
 	do_constraint_forces (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time dt) override;
 
+	/**
+	 * Calculate constraint forces taking into account only given rows of the Jacobians.
+	 * do_constraint_forces() uses NonZeroVRows, full rows give the same result.
+	 */
+	template<class VRows, class WRows = AllJacobianRows>
+		[[nodiscard]]
+		ConstraintForces
+		constraint_forces_for_rows (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time dt);
+
+  private:
+	// Only the translation rows of Jv1 and Jv2 are non-zero:
+	using NonZeroVRows = JacobianRows<0, 3>;
+
   private:
 	SpaceLength<BodyCOM>	_anchor_1;
 	SpaceLength<BodyCOM>	_anchor_2;
@@ -59,6 +72,17 @@ class FixedConstraint: public Constraint
 	LocationConstraint<6>	_location_constraint_value;
 };
 
+
+template<class VRows, class WRows>
+	inline ConstraintForces
+	FixedConstraint::constraint_forces_for_rows (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time const dt)
+	{
+		auto const J = calculate_jacobian<VRows, WRows> (vm_1, _Jv1, _Jw1, vm_2, _Jv2, _Jw2);
+		auto const lambda = calculate_lambda (_location_constraint_value, J, _Z, dt);
+
+		return calculate_constraint_forces<VRows, WRows> (_Jv1, _Jw1, _Jv2, _Jw2, lambda);
+	}
+
 } // namespace xf::rigid_body
 
 #endif
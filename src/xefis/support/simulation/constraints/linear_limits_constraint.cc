@@ -77,6 +77,28 @@ LinearLimitsConstraint::do_constraint_forces (VelocityMoments<WorldSpace> const&
 }
 
 
+void
+LinearLimitsConstraint::clamp_accumulated_forces (ConstraintForces& accumulated) const
+{
+	auto const& slider_data = _slider_precalculation.data();
+	// Limits can only push body 2 back towards the allowed range, and only when it's outside of it:
+	auto const force_2 = dot_product (slider_data.a, accumulated[1].force());
+
+	if (_min_distance && slider_data.distance < *_min_distance)
+	{
+		if (force_2 < 0_N)
+			accumulated = {};
+	}
+	else if (_max_distance && slider_data.distance > *_max_distance)
+	{
+		if (force_2 > 0_N)
+			accumulated = {};
+	}
+	else
+		accumulated = {};
+}
+
+
 std::optional<ConstraintForces>
 LinearLimitsConstraint::min_distance_corrections (VelocityMoments<WorldSpace> const& vm_1,
 												  VelocityMoments<WorldSpace> const& vm_2,
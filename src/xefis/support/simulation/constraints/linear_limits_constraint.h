@@ -71,6 +71,10 @@ class LinearLimitsConstraint: public Constraint
 	void
 	initialize_step (si::Time dt) override;
 
+	// Constraint API
+	void
+	clamp_accumulated_forces (ConstraintForces& accumulated) const override;
+
   protected:
 	// Constraint API
 	ConstraintForces
@@ -100,10 +100,7 @@ SliderConstraint::initialize_step (si::Time const dt)
 ConstraintForces
 SliderConstraint::do_constraint_forces (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time dt)
 {
-	auto const J = calculate_jacobian (vm_1, _Jv1, _Jw1, vm_2, _Jv2, _Jw2);
-	auto const lambda = calculate_lambda (_location_constraint_value, J, _Z, dt);
-
-	return calculate_constraint_forces (_Jv1, _Jw1, _Jv2, _Jw2, lambda);
+	return constraint_forces_for_rows<NonZeroVRows> (vm_1, vm_2, dt);
 }
 
 } // namespace xf::rigid_body
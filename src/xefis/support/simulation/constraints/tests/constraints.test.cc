@@ -0,0 +1,146 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/mass_moments.h>
+#include <xefis/support/simulation/constraints/fixed_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_precalculation.h>
+#include <xefis/support/simulation/constraints/slider_constraint.h>
+#include <xefis/support/simulation/constraints/slider_precalculation.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cstddef>
+#include <string>
+
+
+namespace xf::test {
+namespace {
+
+constexpr std::size_t	kSteps		= 200;
+constexpr auto			kPrecision	= 1e-9;
+
+
+/**
+ * Constraint that calculates forces with all rows of Jacobians, including the ones known to be zero.
+ */
+template<class SparseConstraint>
+	class DenseConstraint: public SparseConstraint
+	{
+	  public:
+		using SparseConstraint::SparseConstraint;
+
+	  protected:
+		rigid_body::ConstraintForces
+		do_constraint_forces (VelocityMoments<WorldSpace> const& vm_1, VelocityMoments<WorldSpace> const& vm_2, si::Time dt) override
+			{ return this->template constraint_forces_for_rows<rigid_body::Constraint::AllJacobianRows> (vm_1, vm_2, dt); }
+	};
+
+
+struct SimulationResult
+{
+	SpaceLength<WorldSpace>							position_1;
+	SpaceLength<WorldSpace>							position_2;
+	SpaceVector<si::Velocity, WorldSpace>			velocity_2;
+	SpaceVector<si::AngularVelocity, WorldSpace>	angular_velocity_2;
+};
+
+
+/**
+ * Simulate two bodies connected by constraints added by given function.
+ */
+template<class AddConstraint>
+	SimulationResult
+	simulate (AddConstraint&& add_constraint)
+	{
+		rigid_body::System system;
+
+		auto& body_1 = system.add<rigid_body::Body> (MassMoments<BodyCOM> (2_kg, math::unit));
+		body_1.set_placement (Placement<WorldSpace, BodyCOM> ({ 0_m, 0_m, 0_m }, kNoRotation<WorldSpace, BodyCOM>));
+
+		auto& body_2 = system.add<rigid_body::Body> (MassMoments<BodyCOM> (0.5_kg, math::unit));
+		body_2.set_placement (Placement<WorldSpace, BodyCOM> ({ 1_m, 0.2_m, -0.1_m }, kNoRotation<WorldSpace, BodyCOM>));
+		// Spin body 2, so that angular Jacobians matter:
+		body_2.set_velocity_moments (VelocityMoments<WorldSpace> ({ 0.1_mps, 0_mps, 0.2_mps }, { 0.5_radps, -1_radps, 2_radps }));
+
+		add_constraint (system, body_1, body_2);
+
+		rigid_body::ImpulseSolver solver (system);
+
+		for (std::size_t i = 0; i < kSteps; ++i)
+		{
+			body_2.apply_impulse (ForceMoments<WorldSpace> ({ 0.3_N, -4.9_N, 0.1_N }, { 0.02_Nm, 0_Nm, -0.01_Nm }));
+			solver.evolve (1_ms);
+		}
+
+		return {
+			.position_1 = body_1.placement().position(),
+			.position_2 = body_2.placement().position(),
+			.velocity_2 = body_2.velocity_moments<WorldSpace>().velocity(),
+			.angular_velocity_2 = body_2.velocity_moments<WorldSpace>().angular_velocity(),
+		};
+	}
+
+
+void
+verify_same_results (std::string const& name, SimulationResult const& sparse, SimulationResult const& dense)
+{
+	test_asserts::verify_equal_with_epsilon (name + ": position of body 1 is the same", sparse.position_1, dense.position_1, kPrecision * 1_m);
+	test_asserts::verify_equal_with_epsilon (name + ": position of body 2 is the same", sparse.position_2, dense.position_2, kPrecision * 1_m);
+	test_asserts::verify_equal_with_epsilon (name + ": velocity of body 2 is the same", sparse.velocity_2, dense.velocity_2, kPrecision * 1_mps);
+	test_asserts::verify_equal_with_epsilon (name + ": angular velocity of body 2 is the same", sparse.angular_velocity_2, dense.angular_velocity_2, kPrecision * 1_radps);
+}
+
+
+AutoTest t_1 ("rigid_body constraints: sparse Jacobian rows give the same result as full Jacobians", []{
+	auto const fixed = [] <class Constraint> {
+		return simulate ([] (rigid_body::System& system, rigid_body::Body& body_1, rigid_body::Body& body_2) {
+			system.add<Constraint> (body_1, body_2);
+		});
+	};
+
+	auto const hinge = [] <class Constraint> {
+		return simulate ([] (rigid_body::System& system, rigid_body::Body& body_1, rigid_body::Body& body_2) {
+			SpaceLength<BodyCOM> const anchor { 0.5_m, 0.1_m, 0_m };
+			auto& precalculation = system.add<rigid_body::HingePrecalculation> (anchor, anchor + SpaceLength<BodyCOM> { 0_m, 0_m, 1_m }, body_1, body_2);
+			system.add<Constraint> (precalculation);
+		});
+	};
+
+	auto const slider = [] <class Constraint> {
+		return simulate ([] (rigid_body::System& system, rigid_body::Body& body_1, rigid_body::Body& body_2) {
+			auto& precalculation = system.add<rigid_body::SliderPrecalculation> (body_1, body_2, SpaceVector<double, WorldSpace> { 1.0, 0.0, 0.0 });
+			system.add<Constraint> (precalculation);
+		});
+	};
+
+	verify_same_results ("fixed",
+						 fixed.template operator()<rigid_body::FixedConstraint>(),
+						 fixed.template operator()<DenseConstraint<rigid_body::FixedConstraint>>());
+	verify_same_results ("hinge",
+						 hinge.template operator()<rigid_body::HingeConstraint>(),
+						 hinge.template operator()<DenseConstraint<rigid_body::HingeConstraint>>());
+	verify_same_results ("slider",
+						 slider.template operator()<rigid_body::SliderConstraint>(),
+						 slider.template operator()<DenseConstraint<rigid_body::SliderConstraint>>());
+});
+
+} // namespace
+} // namespace xf::test
+
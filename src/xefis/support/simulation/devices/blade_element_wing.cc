@@ -0,0 +1,129 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "blade_element_wing.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/geometry.h>
+#include <xefis/support/nature/wrench.h>
+
+// Neutrino:
+#include <neutrino/exception.h>
+
+// Standard:
+#include <cstddef>
+
+
+namespace xf::sim {
+
+BladeElementWing::BladeElementWing (Airfoil const& airfoil, std::size_t const strips, si::Density const material_density):
+	Wing (airfoil, material_density),
+	_strip_airfoil (airfoil.airfoil_characteristics(), airfoil.chord_length(), airfoil.wing_length() / static_cast<double> (strips))
+{
+	if (strips == 0)
+		throw InvalidArgument ("BladeElementWing needs at least one strip");
+
+	// AirfoilSplineSpace and BodyCOM are the same (see Wing), only the origins differ:
+	auto const strip_length = _strip_airfoil.wing_length();
+
+	for (std::size_t i = 0; i < strips; ++i)
+		_strip_positions.push_back (origin<BodyCOM>() + SpaceLength<BodyCOM> { 0_m, 0_m, strip_length * static_cast<double> (i) });
+
+	_strip_airs.resize (strips);
+	_strip_parameters.resize (strips);
+}
+
+
+void
+BladeElementWing::update_external_forces (Atmosphere const* atmosphere)
+{
+	if (!atmosphere)
+		return;
+
+	auto const world_to_ecef = RotationQuaternion<ECEFSpace, WorldSpace> (math::identity);
+	auto const ecef_to_world = RotationQuaternion<WorldSpace, ECEFSpace> (math::identity);
+	auto const body_to_airfoil_spline = RotationQuaternion<AirfoilSplineSpace, BodyCOM> (math::identity);
+	auto const airfoil_spline_to_body = RotationQuaternion<BodyCOM, AirfoilSplineSpace> (math::identity);
+	auto const world_to_body = placement().base_to_body_rotation();
+
+	auto const ecef_air = atmosphere->air_at (world_to_ecef * placement().position());
+	auto const body_air = (world_to_body * ecef_to_world) * ecef_air;
+	auto const& body_velocity_moments = velocity_moments<BodyCOM>();
+	auto const body_velocity = body_velocity_moments.velocity();
+	auto const omega = body_velocity_moments.angular_velocity();
+
+	// Relative air for each strip. Velocity of strip origins changes linearly along the span.
+	// Use strip centers for the rotation-induced velocity:
+	auto const half_strip = SpaceLength<BodyCOM> { 0_m, 0_m, 0.5 * _strip_airfoil.wing_length() };
+
+	for (std::size_t i = 0; i < _strip_positions.size(); ++i)
+	{
+		auto const strip_velocity = body_velocity + cross_product (omega, _strip_positions[i] + half_strip) / 1_rad;
+		auto strip_air = body_air;
+		strip_air.velocity -= strip_velocity;
+		_strip_airs[i] = body_to_airfoil_spline * strip_air;
+	}
+
+	_strip_airfoil.aerodynamic_forces (_strip_airs, _strip_parameters);
+
+	// Sum up forces of all strips:
+	ForceMoments<BodyCOM> total;
+	SpaceVector<si::Force, BodyCOM> lift_sum { math::zero };
+	SpaceVector<si::Force, BodyCOM> drag_sum { math::zero };
+	SpaceVector<si::Torque, BodyCOM> pitching_moment_sum { math::zero };
+	SpaceVector<decltype (1_m * 1_N), BodyCOM> weighted_center_of_pressure { math::zero };
+	si::Force weight_sum = 0_N;
+
+	for (std::size_t i = 0; i < _strip_parameters.size(); ++i)
+	{
+		auto const forces = airfoil_spline_to_body * _strip_parameters[i].forces;
+		auto const force = forces.lift + forces.drag;
+		auto const center_of_pressure = _strip_positions[i] + forces.center_of_pressure;
+
+		total += resultant_force (Wrench<BodyCOM> (force, forces.pitching_moment, center_of_pressure));
+
+		lift_sum += forces.lift;
+		drag_sum += forces.drag;
+		pitching_moment_sum += forces.pitching_moment;
+		weighted_center_of_pressure += abs (force) * center_of_pressure;
+		weight_sum += abs (force);
+	}
+
+	apply_impulse (total);
+
+	// Aggregated parameters, mostly for visualization. Angle of attack and Reynolds number are taken
+	// from the middle strip:
+	auto const& middle = _strip_parameters[_strip_parameters.size() / 2];
+	auto relative_body_air = body_air;
+	relative_body_air.velocity -= body_velocity;
+
+	set_airfoil_aerodynamic_parameters (AirfoilAerodynamicParameters<BodyCOM> {
+		.air = relative_body_air,
+		.reynolds_number = middle.reynolds_number,
+		.true_air_speed = middle.true_air_speed,
+		.angle_of_attack = middle.angle_of_attack,
+		.forces = {
+			.lift = lift_sum,
+			.drag = drag_sum,
+			.pitching_moment = pitching_moment_sum,
+			.center_of_pressure = weight_sum > 0_N
+				? weighted_center_of_pressure / weight_sum
+				: _strip_positions[_strip_positions.size() / 2] + half_strip,
+		},
+	});
+}
+
+} // namespace xf::sim
+
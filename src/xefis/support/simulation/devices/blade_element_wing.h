@@ -0,0 +1,82 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__DEVICES__BLADE_ELEMENT_WING_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__DEVICES__BLADE_ELEMENT_WING_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/aerodynamics/airfoil.h>
+#include <xefis/support/aerodynamics/airfoil_aerodynamic_parameters.h>
+#include <xefis/support/simulation/devices/wing.h>
+
+// Standard:
+#include <cstddef>
+#include <span>
+#include <vector>
+
+
+namespace xf::sim {
+
+/**
+ * Wing divided into spanwise strips (blade elements) within a single rigid body.
+ *
+ * Each strip gets its own relative air, including velocity induced by the body's rotation, and its own
+ * Airfoil evaluation. Forces of all strips are summed up and applied as a single impulse, so a long wing
+ * or a wing that rotates (eg. rolls) gets realistic force distribution and damping without having to be
+ * split into many Wing bodies tied with constraints.
+ *
+ * Air conditions (density, wind, etc) are taken from the Atmosphere once per frame at the center of mass;
+ * only the velocity differs between strips.
+ */
+class BladeElementWing: public Wing
+{
+  public:
+	// Ctor
+	explicit
+	BladeElementWing (Airfoil const&, std::size_t strips, si::Density material_density);
+
+	/**
+	 * Return number of strips.
+	 */
+	[[nodiscard]]
+	std::size_t
+	strips() const noexcept
+		{ return _strip_positions.size(); }
+
+	/**
+	 * Return aerodynamic parameters of each strip from the last update_external_forces() (in AirfoilSplineSpace
+	 * of each strip, that is relative to the strip's origin).
+	 */
+	[[nodiscard]]
+	std::span<AirfoilAerodynamicParameters<AirfoilSplineSpace> const>
+	strip_aerodynamic_parameters() const noexcept
+		{ return _strip_parameters; }
+
+	// Body API
+	void
+	update_external_forces (Atmosphere const*) override;
+
+  private:
+	Airfoil													_strip_airfoil;
+	// Positions of strip origins (leading edge at the strip's root) in BodyCOM coordinates:
+	std::vector<SpaceLength<BodyCOM>>						_strip_positions;
+	std::vector<Air<AirfoilSplineSpace>>					_strip_airs;
+	std::vector<AirfoilAerodynamicParameters<AirfoilSplineSpace>>
+															_strip_parameters;
+};
+
+} // namespace xf::sim
+
+#endif
+
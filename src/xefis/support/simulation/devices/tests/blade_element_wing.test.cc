@@ -0,0 +1,138 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/aerodynamics/airfoil.h>
+#include <xefis/support/earth/air/atmosphere.h>
+#include <xefis/support/earth/air/standard_atmosphere.h>
+#include <xefis/support/simulation/devices/blade_element_wing.h>
+#include <xefis/support/simulation/devices/wing.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cstddef>
+
+
+namespace xf::test {
+namespace {
+
+/**
+ * Still air with sea-level parameters everywhere.
+ */
+class StillAtmosphere: public Atmosphere
+{
+  public:
+	Air<ECEFSpace>
+	air_at (SpaceVector<si::Length, ECEFSpace> const&) const override
+	{
+		return {
+			.density = standard_density (0_m),
+			.pressure = standard_pressure (0_m),
+			.temperature = standard_temperature (0_m),
+			.dynamic_viscosity = dynamic_air_viscosity (standard_temperature (0_m)),
+			.speed_of_sound = 340_mps,
+			.velocity = { 0_mps, 0_mps, 0_mps },
+		};
+	}
+};
+
+
+AirfoilCharacteristics::LiftField
+make_field (double const at_zero, double const slope_per_degree)
+{
+	return {
+		{
+			1e4,
+			{
+				{ -180_deg, at_zero },
+				{  -20_deg, at_zero - 20.0 * slope_per_degree },
+				{   20_deg, at_zero + 20.0 * slope_per_degree },
+				{  180_deg, at_zero },
+			},
+		},
+		{
+			1e6,
+			{
+				{ -180_deg, at_zero },
+				{  -20_deg, at_zero - 20.0 * slope_per_degree },
+				{   20_deg, at_zero + 20.0 * slope_per_degree },
+				{  180_deg, at_zero },
+			},
+		},
+	};
+}
+
+
+Airfoil const kAirfoil {
+	AirfoilCharacteristics (
+		AirfoilSpline ({ { 1.0, 0.0 }, { 0.5, 0.06 }, { 0.0, 0.0 }, { 0.5, -0.04 } }),
+		make_field (0.2, 0.1),
+		make_field (0.02, 0.0),
+		make_field (-0.05, 0.0),
+		make_field (0.25, 0.0)),
+	20_cm,
+	1_m,
+};
+
+auto const kMaterialDensity = 30_kg / 1_m3;
+
+// Wing moving along -X in AirfoilSplineSpace (air flows from the leading edge) with a few degrees of angle of attack:
+VelocityMoments<WorldSpace> const kFlight ({ -20_mps, -1_mps, 0_mps }, { 0_radps, 0_radps, 0_radps });
+
+
+ForceMoments<BodyCOM>
+external_forces (sim::Wing& wing, VelocityMoments<WorldSpace> const& velocity_moments)
+{
+	StillAtmosphere const atmosphere;
+	wing.set_velocity_moments (velocity_moments);
+	wing.reset_applied_impulses();
+	wing.update_external_forces (&atmosphere);
+	return wing.external_force_moments<BodyCOM>();
+}
+
+
+AutoTest t_1 ("BladeElementWing: without rotation gives the same forces as Wing", []{
+	sim::Wing wing (kAirfoil, kMaterialDensity);
+	auto const expected = external_forces (wing, kFlight);
+
+	for (std::size_t strips: { 1u, 8u })
+	{
+		sim::BladeElementWing blade_element_wing (kAirfoil, strips, kMaterialDensity);
+		auto const forces = external_forces (blade_element_wing, kFlight);
+
+		test_asserts::verify ("lift is generated", abs (expected.force()) > 1_N);
+		test_asserts::verify_equal_with_epsilon ("force is the same", abs (forces.force() - expected.force()), 0_N, 1e-6_N);
+		test_asserts::verify_equal_with_epsilon ("torque is the same", abs (forces.torque() - expected.torque()), 0_Nm, 1e-6_Nm);
+	}
+});
+
+
+AutoTest t_2 ("BladeElementWing: rotation about the chord damps the rotation", []{
+	sim::BladeElementWing wing (kAirfoil, 8, kMaterialDensity);
+	auto const still = external_forces (wing, kFlight);
+
+	// Rotate about the X axis (chord), so that strips at each end of the span get opposite vertical velocities:
+	auto rolling = kFlight;
+	rolling.set_angular_velocity ({ 1_radps, 0_radps, 0_radps });
+	auto const rolling_forces = external_forces (wing, rolling);
+	auto const damping_torque = rolling_forces.torque()[0] - still.torque()[0];
+
+	test_asserts::verify ("torque opposes the rotation", damping_torque < 0_Nm);
+});
+
+} // namespace
+} // namespace xf::test
+
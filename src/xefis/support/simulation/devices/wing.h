@@ -60,6 +60,11 @@ class Wing:
 	create_body_widget()
 		{ return std::make_unique<WingWidget> (*this); }
 
+  protected:
+	void
+	set_airfoil_aerodynamic_parameters (std::optional<AirfoilAerodynamicParameters<BodyCOM>> const& parameters)
+		{ _airfoil_aerodynamic_parameters = parameters; }
+
   private:
 	[[nodiscard]]
 	static MassMomentsAtArm<BodyCOM>
@@ -0,0 +1,501 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "direct_solver.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/electrical/exception.h>
+
+// Neutrino:
+#include <neutrino/exception.h>
+
+// Standard:
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <unordered_map>
+
+
+namespace xf::electrical {
+namespace {
+
+/**
+ * Minimal union-find for merging connected nodes.
+ */
+class DisjointSets
+{
+  public:
+	explicit
+	DisjointSets (std::size_t size):
+		_parents (size)
+	{
+		std::iota (_parents.begin(), _parents.end(), 0);
+	}
+
+	std::size_t
+	find (std::size_t i)
+	{
+		while (_parents[i] != i)
+			i = _parents[i] = _parents[_parents[i]];
+
+		return i;
+	}
+
+	void
+	join (std::size_t a, std::size_t b)
+	{
+		_parents[find (a)] = find (b);
+	}
+
+  private:
+	std::vector<std::size_t> _parents;
+};
+
+
+[[nodiscard]]
+inline bool
+is_linear (Element const& element)
+{
+	return element.has_const_resistance() || element.type() == Element::VoltageSource;
+}
+
+
+[[nodiscard]]
+inline bool
+is_ideal (Element const& element)
+{
+	return is_linear (element) && element.resistance() == 0_Ohm;
+}
+
+} // namespace
+
+
+DirectSolver::DirectSolver (Network const& network, double const accuracy, uint32_t const max_iterations):
+	_accuracy (accuracy),
+	_max_iterations (max_iterations)
+{
+	assemble (network);
+	static_cast<void> (solve());
+}
+
+
+bool
+DirectSolver::solve()
+{
+	_converged = false;
+	auto const any_non_linear = std::any_of (_elements.begin(), _elements.end(), [](auto const& se) { return !se.linear; });
+	auto const iterations = any_non_linear ? std::max<uint32_t> (_max_iterations, 1) : 1;
+
+	update_node_offsets();
+
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		if (linearize() || _factorizations == 0)
+			factorize();
+
+		auto const max_change = substitute();
+
+		if (!any_non_linear || max_change <= _accuracy)
+		{
+			_converged = true;
+			break;
+		}
+	}
+
+	transfer_results();
+	return _converged;
+}
+
+
+void
+DirectSolver::solve_throwing()
+{
+	if (!solve())
+		throw NotConverged ("DirectSolver: solution did not converge in " + std::to_string (_max_iterations) + " iterations");
+}
+
+
+void
+DirectSolver::evolve (si::Time const dt)
+{
+	flow_current (dt);
+	static_cast<void> (solve());
+}
+
+
+void
+DirectSolver::assemble (Network const& network)
+{
+	// Index all nodes: free nodes and element pins:
+	std::vector<Node const*> all_nodes;
+	std::unordered_map<Node const*, std::size_t> node_indices;
+
+	for (auto const& node: network.nodes())
+		all_nodes.push_back (&node);
+
+	for (auto const& element: network.elements())
+	{
+		all_nodes.push_back (&element->anode());
+		all_nodes.push_back (&element->cathode());
+	}
+
+	for (std::size_t i = 0; i < all_nodes.size(); ++i)
+		node_indices[all_nodes[i]] = i;
+
+	// Merge nodes connected directly to each other:
+	DisjointSets sets (all_nodes.size());
+
+	for (std::size_t i = 0; i < all_nodes.size(); ++i)
+		for (auto const* connected_node: all_nodes[i]->connected_nodes())
+			sets.join (i, node_indices.at (connected_node));
+
+	// Number merged nodes:
+	std::vector<std::size_t> merged_indices (all_nodes.size(), kReference);
+	std::size_t merged_nodes = 0;
+
+	for (std::size_t i = 0; i < all_nodes.size(); ++i)
+	{
+		auto& merged = merged_indices[sets.find (i)];
+
+		if (merged == kReference)
+			merged = merged_nodes++;
+	}
+
+	auto const merged_index_of = [&] (Node const& node) {
+		return merged_indices[sets.find (node_indices.at (&node))];
+	};
+
+	_elements.clear();
+	_elements.reserve (network.elements().size());
+
+	for (auto const& element: network.elements())
+	{
+		_elements.push_back (SElement {
+			.element = element.get(),
+			.linear = is_linear (*element),
+			.ideal = is_ideal (*element),
+			.anode_node = merged_index_of (element->anode()),
+			.cathode_node = merged_index_of (element->cathode()),
+		});
+	}
+
+	// Merge nodes connected with ideal elements into supernodes. Remember the ideal elements
+	// of each node, to build spanning trees of the supernodes:
+	DisjointSets supernodes (merged_nodes);
+	std::vector<std::vector<std::size_t>> ideal_elements_of_node (merged_nodes);
+
+	for (std::size_t i = 0; i < _elements.size(); ++i)
+	{
+		auto const& se = _elements[i];
+
+		if (se.ideal)
+		{
+			if (supernodes.find (se.anode_node) == supernodes.find (se.cathode_node))
+				throw InvalidArgument ("DirectSolver: element " + se.element->name() + " has zero resistance and forms a loop with other zero-resistance elements");
+
+			supernodes.join (se.anode_node, se.cathode_node);
+			ideal_elements_of_node[se.anode_node].push_back (i);
+			ideal_elements_of_node[se.cathode_node].push_back (i);
+		}
+	}
+
+	for (auto& se: _elements)
+		se.shorted = supernodes.find (se.anode_node) == supernodes.find (se.cathode_node);
+
+	// Order ideal elements breadth-first from the root of each supernode:
+	_ideal_branches.clear();
+	std::vector<bool> visited (merged_nodes, false);
+
+	for (std::size_t root = 0; root < merged_nodes; ++root)
+	{
+		if (visited[root])
+			continue;
+
+		visited[root] = true;
+		std::vector<std::size_t> queue { root };
+
+		for (std::size_t q = 0; q < queue.size(); ++q)
+		{
+			auto const parent = queue[q];
+
+			for (auto const e: ideal_elements_of_node[parent])
+			{
+				auto const& se = _elements[e];
+				auto const node = se.anode_node == parent ? se.cathode_node : se.anode_node;
+
+				if (!visited[node])
+				{
+					visited[node] = true;
+					queue.push_back (node);
+					_ideal_branches.push_back ({ .element = e, .node = node, .parent = parent, .node_is_anode = node == se.anode_node });
+				}
+			}
+		}
+	}
+
+	// Find connected parts of the network and make the first supernode of each one the reference:
+	DisjointSets parts (merged_nodes);
+
+	for (auto const& se: _elements)
+		parts.join (se.anode_node, se.cathode_node);
+
+	std::vector<std::size_t> supernode_unknowns (merged_nodes, kReference);
+	std::vector<bool> has_reference (merged_nodes, false);
+	std::size_t unknowns = 0;
+
+	for (std::size_t n = 0; n < merged_nodes; ++n)
+	{
+		// Only the root node of each supernode decides:
+		if (supernodes.find (n) != n)
+			continue;
+
+		auto const part = parts.find (n);
+
+		if (has_reference[part])
+			supernode_unknowns[n] = unknowns++;
+		else
+			has_reference[part] = true;
+	}
+
+	_unknowns.resize (merged_nodes);
+
+	for (std::size_t n = 0; n < merged_nodes; ++n)
+		_unknowns[n] = supernode_unknowns[supernodes.find (n)];
+
+	// Analyze the sparsity pattern:
+	std::vector<SparseLDLT::Entry> off_diagonal;
+
+	for (auto const& se: _elements)
+	{
+		auto const a = _unknowns[se.anode_node];
+		auto const k = _unknowns[se.cathode_node];
+
+		if (a != kReference && k != kReference && !se.shorted)
+			off_diagonal.push_back ({ a, k });
+	}
+
+	_matrix = SparseLDLT (unknowns, off_diagonal);
+
+	for (auto& se: _elements)
+	{
+		auto const a = _unknowns[se.anode_node];
+		auto const k = _unknowns[se.cathode_node];
+
+		// Elements shorted by their own pins or by ideal elements don't contribute to the system:
+		if (se.shorted)
+			continue;
+
+		if (a != kReference)
+			se.anode_anode = _matrix.value_index (a, a);
+
+		if (k != kReference)
+			se.cathode_cathode = _matrix.value_index (k, k);
+
+		if (a != kReference && k != kReference)
+			se.anode_cathode = _matrix.value_index (a, k);
+	}
+
+	_diagonal_indices.resize (unknowns);
+
+	for (std::size_t u = 0; u < unknowns; ++u)
+		_diagonal_indices[u] = *_matrix.value_index (u, u);
+
+	_node_offsets.assign (merged_nodes, 0.0);
+	_node_voltages.assign (merged_nodes, 0.0);
+	_node_currents.assign (merged_nodes, 0.0);
+	_factorized_conductances.assign (_elements.size(), std::numeric_limits<double>::quiet_NaN());
+	_rhs.assign (unknowns, 0.0);
+	_factorizations = 0;
+}
+
+
+void
+DirectSolver::update_node_offsets()
+{
+	// Parents come before their children, so each node's offset is computed from an up-to-date one:
+	for (auto const& branch: _ideal_branches)
+	{
+		auto const& element = *_elements[branch.element].element;
+		// Anode-to-cathode voltage at which no current flows:
+		auto const voltage = element.voltage_for_current (0_A).base_value();
+		_node_offsets[branch.node] = _node_offsets[branch.parent] + (branch.node_is_anode ? voltage : -voltage);
+	}
+}
+
+
+bool
+DirectSolver::linearize()
+{
+	auto changed = false;
+
+	for (std::size_t i = 0; i < _elements.size(); ++i)
+	{
+		auto& se = _elements[i];
+		auto const& element = *se.element;
+
+		if (se.ideal)
+		{
+			if (!element.enabled())
+				throw InvalidArgument ("DirectSolver: element " + element.name() + " has zero resistance and can't be disabled");
+
+			if (element.resistance() != 0_Ohm)
+				throw InvalidArgument ("DirectSolver: resistance of element " + element.name() + " is no longer zero, a new solver must be created");
+
+			continue;
+		}
+		else if (!element.enabled())
+		{
+			se.conductance = 0.0;
+			se.current_offset = 0.0;
+		}
+		else if (se.linear)
+		{
+			se.conductance = 1.0 / element.resistance().base_value();
+			se.current_offset = element.current_for_voltage (0_V).base_value();
+		}
+		else
+		{
+			// Use numerical derivative around the current operating point:
+			auto const u = _node_voltages[se.anode_node] - _node_voltages[se.cathode_node];
+			auto const du = std::max (1e-6, 1e-6 * std::abs (u));
+			auto const i_plus = element.current_for_voltage (1_V * (u + du)).base_value();
+			auto const i_minus = element.current_for_voltage (1_V * (u - du)).base_value();
+			se.conductance = (i_plus - i_minus) / (2.0 * du);
+			se.current_offset = element.current_for_voltage (1_V * u).base_value() - se.conductance * u;
+		}
+
+		if (!std::isfinite (se.conductance) || !std::isfinite (se.current_offset))
+			throw InvalidArgument ("DirectSolver: element " + element.name() + " got zero resistance after the solver was created");
+
+		if (se.conductance != _factorized_conductances[i])
+			changed = true;
+	}
+
+	return changed;
+}
+
+
+void
+DirectSolver::factorize()
+{
+	auto& values = _matrix.values();
+	std::fill (values.begin(), values.end(), 0.0);
+
+	for (auto const index: _diagonal_indices)
+		values[index] = kMinConductance.base_value();
+
+	for (std::size_t i = 0; i < _elements.size(); ++i)
+	{
+		auto const& se = _elements[i];
+		auto const g = se.conductance;
+
+		if (se.anode_anode)
+			values[*se.anode_anode] += g;
+
+		if (se.cathode_cathode)
+			values[*se.cathode_cathode] += g;
+
+		if (se.anode_cathode)
+			values[*se.anode_cathode] -= g;
+
+		_factorized_conductances[i] = g;
+	}
+
+	if (!_matrix.factorize())
+		throw InvalidArgument ("DirectSolver: singular network matrix");
+
+	++_factorizations;
+}
+
+
+double
+DirectSolver::substitute()
+{
+	std::fill (_rhs.begin(), _rhs.end(), 0.0);
+
+	// Current offset flows out of the anode node and into the cathode node.
+	// For non-linear elements it also includes the linearization offset:
+	// Voltage offsets of nodes within supernodes add to it a constant current G·(offset_a - offset_k):
+	for (auto const& se: _elements)
+	{
+		if (se.shorted)
+			continue;
+
+		auto const current_offset = se.current_offset + se.conductance * (_node_offsets[se.anode_node] - _node_offsets[se.cathode_node]);
+
+		if (auto const a = _unknowns[se.anode_node]; a != kReference)
+			_rhs[a] -= current_offset;
+
+		if (auto const k = _unknowns[se.cathode_node]; k != kReference)
+			_rhs[k] += current_offset;
+	}
+
+	_matrix.solve (_rhs);
+
+	auto max_change = 0.0;
+
+	for (std::size_t n = 0; n < _node_voltages.size(); ++n)
+	{
+		auto const u = _unknowns[n];
+		auto const voltage = (u != kReference ? _rhs[u] : 0.0) + _node_offsets[n];
+		max_change = std::max (max_change, std::abs (voltage - _node_voltages[n]));
+		_node_voltages[n] = voltage;
+	}
+
+	return max_change;
+}
+
+
+void
+DirectSolver::transfer_results()
+{
+	std::fill (_node_currents.begin(), _node_currents.end(), 0.0);
+
+	for (auto const& se: _elements)
+	{
+		auto const voltage = 1_V * (_node_voltages[se.anode_node] - _node_voltages[se.cathode_node]);
+		se.element->set_voltage (voltage);
+
+		if (!se.ideal)
+		{
+			auto const current = se.element->enabled() ? se.element->current_for_voltage (voltage) : 0_A;
+			se.element->set_current (current);
+			_node_currents[se.anode_node] += current.base_value();
+			_node_currents[se.cathode_node] -= current.base_value();
+		}
+	}
+
+	// Going from leaves of supernode trees towards their roots, current through each ideal element
+	// must balance currents flowing out of the subtree it connects to the parent node:
+	for (auto branch = _ideal_branches.rbegin(); branch != _ideal_branches.rend(); ++branch)
+	{
+		auto const subtree_current = _node_currents[branch->node];
+		branch->current = branch->node_is_anode ? -subtree_current : subtree_current;
+		_node_currents[branch->parent] += subtree_current;
+		_elements[branch->element].element->set_current (1_A * branch->current);
+	}
+}
+
+
+void
+DirectSolver::flow_current (si::Time const dt) const
+{
+	for (auto const& se: _elements)
+		se.element->flow_current (dt);
+}
+
+} // namespace xf::electrical
+
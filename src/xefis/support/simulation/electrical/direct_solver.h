@@ -0,0 +1,248 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__ELECTRICAL__DIRECT_SOLVER_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__ELECTRICAL__DIRECT_SOLVER_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/sparse_ldlt.h>
+#include <xefis/support/simulation/electrical/element.h>
+#include <xefis/support/simulation/electrical/network.h>
+#include <xefis/support/simulation/electrical/node.h>
+
+// Neutrino:
+#include <neutrino/noncopyable.h>
+
+// Standard:
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+
+namespace xf::electrical {
+
+/**
+ * Solves voltages and currents in a Network directly, using nodal analysis and sparse LDLᵀ factorization.
+ *
+ * Each element is replaced by its Norton equivalent: conductance G between its pins and current I₀,
+ * so that current flowing from anode to cathode is I = G·U + I₀, where U is the anode-to-cathode voltage.
+ * For resistors and voltage sources (including capacitors) this is exact, so a network made of them
+ * is solved in a single step. Non-linear elements are handled with Newton iterations.
+ *
+ * The system is assembled once by the constructor: connected nodes are merged, one node of each
+ * connected part of the network becomes the 0 V reference, and the matrix sparsity pattern is analyzed.
+ * After that solve() refactors the matrix only when some element's conductance has changed
+ * (eg. after set_resistance()). Otherwise it reuses the factorization and only substitutes new
+ * source currents (eg. after set_source_voltage() or when capacitors charge).
+ *
+ * Disabled elements (see Element::set_enabled()) are stamped with zero conductance, so toggling switches
+ * or breakers only refactors the matrix numerically; the sparsity pattern is kept.
+ *
+ * A tiny conductance (kMinConductance) is added between each node and the reference,
+ * so that parts of the network isolated by open switches (infinite resistance) have defined voltages.
+ *
+ * Linear elements with zero resistance (ideal voltage sources and shorts) are solved exactly, as in
+ * modified nodal analysis, but without extra unknowns: nodes connected by them are merged into a single
+ * unknown with fixed voltage offsets, and their currents are computed from Kirchhoff's current law.
+ * Such elements must not form loops (eg. two ideal voltage sources in parallel), can't be disabled,
+ * and their resistance must stay zero; InvalidArgument is thrown otherwise.
+ *
+ * Solver must not outlive network or its components. A new Solver must be created after the network
+ * topology changes or after resistance of an element changes from or to zero.
+ */
+class DirectSolver: public Noncopyable
+{
+  public:
+	static constexpr uint32_t			kDefaultMaxIterations	= 100;
+	static constexpr si::Conductance	kMinConductance			= 1e-12 / 1_Ohm;
+
+  private:
+	static constexpr std::size_t		kReference				= std::numeric_limits<std::size_t>::max();
+
+	/**
+	 * Element with its place in the system.
+	 */
+	struct SElement
+	{
+		Element*					element;
+		bool						linear;
+		// Linear element with zero resistance, solved as a fixed voltage between its pins:
+		bool						ideal;
+		// Merged node indices:
+		std::size_t					anode_node;
+		std::size_t					cathode_node;
+		// Indices in SparseLDLT::values() of the element's conductance stamps,
+		// or std::nullopt if the pin is at the reference node:
+		std::optional<std::size_t>	anode_anode;
+		std::optional<std::size_t>	cathode_cathode;
+		std::optional<std::size_t>	anode_cathode;
+		// Both pins are in the same supernode (nodes connected with ideal elements), so the element
+		// doesn't contribute to the system:
+		bool						shorted					{ false };
+		// Norton equivalent in SI units:
+		double						conductance				{ 0.0 };
+		double						current_offset			{ 0.0 };
+	};
+
+	/**
+	 * Ideal element connecting a node to its parent node in the spanning tree of a supernode.
+	 */
+	struct IdealBranch
+	{
+		std::size_t					element;
+		// Merged node indices:
+		std::size_t					node;
+		std::size_t					parent;
+		bool						node_is_anode;
+		// Current flowing from anode to cathode, in SI units:
+		double						current					{ 0.0 };
+	};
+
+  public:
+	/**
+	 * Ctor
+	 *
+	 * \param	Network
+	 *			Electrical network to analyze.
+	 * \param	accuracy
+	 *			Required voltage accuracy for non-linear networks (in volts).
+	 * \param	max_iterations
+	 *			Maximum number of Newton iterations for non-linear networks.
+	 */
+	explicit
+	DirectSolver (Network const&, double accuracy, uint32_t max_iterations = kDefaultMaxIterations);
+
+	/**
+	 * Solve the network voltages. It must be called before evolve() if changes have been
+	 * made to the network elements (changed voltages, resistances, etc).
+	 *
+	 * \returns	true if solution converges before reaching iterations limit; false otherwise.
+	 * \throws	InvalidArgument
+	 *			On network errors.
+	 */
+	[[nodiscard]]
+	bool
+	solve();
+
+	/**
+	 * Version of solve that throws an exception if there's no convergence.
+	 *
+	 * \throws	NotConverged
+	 *			When calculations do not converge.
+	 */
+	void
+	solve_throwing();
+
+	/**
+	 * Evolve the state of the network (flow current and recalculate voltages).
+	 * Ignores convergence errors.
+	 */
+	void
+	evolve (si::Time dt);
+
+	/**
+	 * Return true if last solution converged.
+	 */
+	[[nodiscard]]
+	bool
+	converged() const noexcept
+		{ return _converged; }
+
+	/**
+	 * Return number of numeric factorizations done so far.
+	 */
+	[[nodiscard]]
+	std::size_t
+	factorizations() const noexcept
+		{ return _factorizations; }
+
+  private:
+	/**
+	 * Merge connected nodes, number unknowns and analyze the sparsity pattern.
+	 */
+	void
+	assemble (Network const&);
+
+	/**
+	 * Compute voltage offsets of nodes relative to the roots of their supernodes
+	 * from voltages of ideal elements.
+	 */
+	void
+	update_node_offsets();
+
+	/**
+	 * Compute Norton equivalents of elements for current node voltages.
+	 *
+	 * \returns	true if any conductance has changed since the last factorization.
+	 */
+	[[nodiscard]]
+	bool
+	linearize();
+
+	/**
+	 * Stamp conductances into the matrix and factorize it.
+	 */
+	void
+	factorize();
+
+	/**
+	 * Compute node voltages for current Norton equivalents.
+	 *
+	 * \returns	maximum change of node voltage.
+	 */
+	double
+	substitute();
+
+	/**
+	 * Set calculated voltages and currents on elements. Currents of ideal elements
+	 * are computed from currents of other elements.
+	 */
+	void
+	transfer_results();
+
+	/**
+	 * Flow current through elements.
+	 */
+	void
+	flow_current (si::Time dt) const;
+
+  private:
+	double						_accuracy;
+	uint32_t					_max_iterations;
+	bool						_converged		{ false };
+	std::size_t					_factorizations	{ 0 };
+	std::vector<SElement>		_elements;
+	// Ideal elements in breadth-first order from the roots of supernodes:
+	std::vector<IdealBranch>	_ideal_branches;
+	// For each merged node index of its unknown in the system (shared by the whole supernode), or kReference:
+	std::vector<std::size_t>	_unknowns;
+	// For each merged node its voltage relative to the root of its supernode:
+	std::vector<double>			_node_offsets;
+	std::vector<double>			_node_voltages;
+	// For each merged node sum of currents flowing out of it through non-ideal elements:
+	std::vector<double>			_node_currents;
+	SparseLDLT					_matrix;
+	// For each unknown index of its diagonal element in SparseLDLT::values():
+	std::vector<std::size_t>	_diagonal_indices;
+	// Conductances used by the current factorization:
+	std::vector<double>			_factorized_conductances;
+	std::vector<double>			_rhs;
+};
+
+} // namespace xf::electrical
+
+#endif
+
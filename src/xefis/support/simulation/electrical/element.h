@@ -22,7 +22,9 @@
 #include <neutrino/noncopyable.h>
 
 // Standard:
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -202,6 +204,31 @@ class Element: public Noncopyable
 	set_broken (bool broken) noexcept
 		{ _broken = broken; }
 
+	/**
+	 * True if element is enabled. Disabled element conducts no current, as if it was
+	 * disconnected from the network (eg. an open switch or a tripped breaker).
+	 */
+	[[nodiscard]]
+	bool
+	enabled() const noexcept
+		{ return _enabled; }
+
+	/**
+	 * Enable or disable the element.
+	 * Solvers pick up the change on their next solve (see enabled_serial()).
+	 */
+	void
+	set_enabled (bool enabled) noexcept;
+
+	/**
+	 * Global serial number that changes every time any element gets enabled or disabled.
+	 * Lets solvers know when to look for toggled elements.
+	 */
+	[[nodiscard]]
+	static uint64_t
+	enabled_serial() noexcept
+		{ return _enabled_serial.load (std::memory_order_relaxed); }
+
   protected:
 	/**
 	 * Declare that element has constant resistance by definition.
@@ -221,6 +248,9 @@ class Element: public Noncopyable
 	Node			_anode			{ *this, Node::Anode };
 	Node			_cathode		{ *this, Node::Cathode };
 	bool			_broken			{ false };
+	bool			_enabled		{ true };
+
+	static inline std::atomic<uint64_t>	_enabled_serial	{ 0 };
 };
 
 
@@ -249,6 +279,17 @@ operator<< (Node& node, Element& element)
 }
 
 
+inline void
+Element::set_enabled (bool const enabled) noexcept
+{
+	if (_enabled != enabled)
+	{
+		_enabled = enabled;
+		_enabled_serial.fetch_add (1, std::memory_order_relaxed);
+	}
+}
+
+
 inline Element&
 operator<< (Element& element, Node& node)
 {
@@ -20,9 +20,11 @@
 #include <xefis/support/simulation/electrical/node.h>
 
 // Neutrino:
+#include <neutrino/exception.h>
 #include <neutrino/noncopyable.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
 #include <list>
 #include <string_view>
@@ -61,6 +63,17 @@ class Network: public Noncopyable
 		SpecificElement&
 		add (std::unique_ptr<SpecificElement>&&);
 
+	/**
+	 * Disconnect element from all nodes and remove it from the network.
+	 * Solvers working on the network must be notified before the element is removed,
+	 * see NodeVoltageSolver::remove_element().
+	 *
+	 * \throws	InvalidArgument
+	 *			If element doesn't belong to the network.
+	 */
+	void
+	remove (Element const&);
+
 	/**
 	 * Return list of elements in the network.
 	 */
@@ -98,6 +111,22 @@ Network::make_node (std::string_view const& name)
 }
 
 
+inline void
+Network::remove (Element const& element)
+{
+	auto const found = std::find_if (_elements.begin(), _elements.end(), [&element] (auto const& e) { return e.get() == &element; });
+
+	if (found == _elements.end())
+		throw InvalidArgument ("element " + element.name() + " doesn't belong to the network");
+
+	for (auto* pin: { &(*found)->anode(), &(*found)->cathode() })
+		for (auto* node: std::vector (pin->connected_nodes()))
+			pin->disconnect (*node);
+
+	_elements.erase (found);
+}
+
+
 template<ElementConcept SpecificElement, class ...Args>
 	inline SpecificElement&
 	Network::add (Args&& ...args)
@@ -24,6 +24,7 @@
 #include <cstddef>
 #include <string>
 #include <string_view>
+#include <vector>
 
 
 namespace xf::electrical {
@@ -66,6 +67,13 @@ class Node: public Noncopyable
 	void
 	operator<< (Node&);
 
+	/**
+	 * Disconnect another node from this node.
+	 * Does nothing if nodes were not connected.
+	 */
+	void
+	disconnect (Node&);
+
 	/**
 	 * Return related element, or nullptr if it's not an element-pin-type node.
 	 */
@@ -111,6 +119,14 @@ Node::operator<< (Node& node)
 	node._connected_nodes.push_back (this);
 }
 
+
+inline void
+Node::disconnect (Node& node)
+{
+	std::erase (_connected_nodes, &node);
+	std::erase (node._connected_nodes, this);
+}
+
 } // namespace xf::electrical
 
 #endif
@@ -30,6 +30,7 @@
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 
 namespace xf::electrical {
@@ -75,6 +76,7 @@ template<class Function, class ...Args>
 void
 NodeVoltageSolver::evolve (si::Time const dt)
 {
+	update_enabled_elements();
 	flow_current (dt);
 	static_cast<void> (solve());
 }
@@ -83,6 +85,7 @@ NodeVoltageSolver::evolve (si::Time const dt)
 bool
 NodeVoltageSolver::solve()
 {
+	update_enabled_elements();
 	_converged = false;
 	return _converged = solve (_snetwork, _accuracy / _snetwork.a_k_dir_edges.size(), _max_iterations, false);
 }
@@ -91,6 +94,8 @@ NodeVoltageSolver::solve()
 void
 NodeVoltageSolver::solve_throwing()
 {
+	update_enabled_elements();
+
 	try {
 		static_cast<void> (solve (_snetwork, _accuracy / _snetwork.a_k_dir_edges.size(), _max_iterations, true));
 	}
@@ -147,11 +152,106 @@ NodeVoltageSolver::solve (SNetwork& network, double const accuracy, uint32_t max
 }
 
 
+void
+NodeVoltageSolver::set_enabled (Element& element, bool const enabled)
+{
+	auto& sedge = sedge_for (_snetwork, element);
+	element.set_enabled (enabled);
+	update_enabled (_snetwork, sedge);
+}
+
+
+void
+NodeVoltageSolver::update_enabled_elements()
+{
+	if (auto const serial = Element::enabled_serial(); serial != _enabled_serial)
+	{
+		_enabled_serial = serial;
+
+		for (auto& [element, sedge]: _snetwork.sedges)
+			update_enabled (_snetwork, *sedge);
+	}
+}
+
+
+void
+NodeVoltageSolver::update_enabled (SNetwork& snetwork, SEdge& sedge)
+{
+	auto const enabled = sedge.element->enabled();
+
+	if (sedge.enabled != enabled)
+	{
+		if (enabled)
+			attach (snetwork, sedge);
+		else
+			detach (snetwork, sedge);
+	}
+
+	if (!enabled)
+		sedge.element->set_current (0_A);
+}
+
+
+void
+NodeVoltageSolver::add_element (Element& element)
+{
+	if (_snetwork.sedges.contains (&element))
+		throw InvalidArgument ("element " + element.name() + " is already known to the solver");
+
+	auto& snode_a = snode_for_pin (_snetwork, element.anode());
+	auto& snode_c = snode_for_pin (_snetwork, element.cathode());
+	auto& sedge = make_sedge (_snetwork, element, snode_a, snode_c);
+
+	if (element.enabled())
+		attach (_snetwork, sedge);
+}
+
+
+void
+NodeVoltageSolver::remove_element (Element const& element)
+{
+	auto& sedge = sedge_for (_snetwork, element);
+
+	if (sedge.enabled)
+		detach (_snetwork, sedge);
+
+	for (auto* dir_edge: { sedge.a_k_dir_edge, sedge.a_k_dir_edge->other_dir_edge })
+	{
+		auto& snode = *dir_edge->this_node;
+		std::erase (snode.disabled_dir_edges, dir_edge);
+
+		// Reuse dangling nodes that are left with no connections. Both dir-edges of a self-loop
+		// point to the same node, so make sure it's not listed twice:
+		if (snode.network_nodes.empty() && snode.dir_edges.empty() && snode.disabled_dir_edges.empty() &&
+			std::ranges::find (_snetwork.unused_nodes, &snode) == _snetwork.unused_nodes.end())
+		{
+			_snetwork.unused_nodes.push_back (&snode);
+		}
+	}
+
+	_snetwork.sedges.erase (&element);
+	sedge.element = nullptr;
+	_snetwork.unused_edges.push_back (&sedge);
+}
+
+
+void
+NodeVoltageSolver::merge_nodes (Node const& node_1, Node const& node_2)
+{
+	auto& snode_1 = snode_for (_snetwork, node_1);
+	auto& snode_2 = snode_for (_snetwork, node_2);
+
+	if (&snode_1 != &snode_2)
+		merge_snodes (_snetwork, snode_1, snode_2);
+}
+
+
 void
 NodeVoltageSolver::flow_current (si::Time const dt) const
 {
 	for (auto& edge: _snetwork.edges)
-		edge.element->flow_current (dt);
+		if (edge.element)
+			edge.element->flow_current (dt);
 }
 
 
@@ -161,102 +261,266 @@ NodeVoltageSolver::simplify (Network const& network, SNetwork& snetwork)
 	if (network.nodes().empty())
 		return;
 
-	auto snodes = std::unordered_map<Node const*, SNode*>();
-	auto unvisited_nodes = std::unordered_set<Node const*>();
-	auto unvisited_elements = std::unordered_set<Element*>();
-
+	// For each free node, create a single SNode representing it and all free nodes connected to it:
 	for (auto const& node: network.nodes())
-		unvisited_nodes.insert (&node);
+		static_cast<void> (snode_for (snetwork, node));
+
+	auto unvisited_elements = std::unordered_set<Element*>();
 
 	for (auto const& element: network.elements())
 		unvisited_elements.insert (element.get());
 
-	// Important! Must not allow vectors to realloc (it will break the references),
-	// so preallocate their sizes now.
-	// We could use std::list, but std::vector is more cache-friendly.
-	snetwork.nodes.reserve (network.nodes().size());
-	snetwork.edges.reserve (network.elements().size());
-	snetwork.dir_edges.reserve (2 * network.elements().size());
-	snetwork.a_k_dir_edges.reserve (network.elements().size());
-
-	// Passing nullptr as node creates dangling SNode:
-	auto const add_snode = [&] (Node const* node) -> SNode&
+	// Transfer element edges from Nodes to SNodes.
+	while (!unvisited_elements.empty())
 	{
-		snetwork.nodes.push_back (SNode());
-		SNode& snode = snetwork.nodes.back();
+		Element& element = **unvisited_elements.begin();
 
-		if (node)
-		{
-			snode.name = node->name();
-			snodes[node] = &snode;
-		}
+		unvisited_elements.erase (unvisited_elements.begin());
+
+		auto& snode_a = snode_for_pin (snetwork, element.anode());
+		auto& snode_c = snode_for_pin (snetwork, element.cathode());
+		auto& sedge = make_sedge (snetwork, element, snode_a, snode_c);
+
+		if (element.enabled())
+			attach (snetwork, sedge);
+	}
+}
 
+
+NodeVoltageSolver::SNode&
+NodeVoltageSolver::make_snode (SNetwork& snetwork)
+{
+	if (!snetwork.unused_nodes.empty())
+	{
+		auto& snode = *snetwork.unused_nodes.back();
+		snetwork.unused_nodes.pop_back();
+		snode = SNode();
 		return snode;
-	};
+	}
 
-	// For each node, create a single SNode and iterate all nodes directly connected to the node.
-	// Add a mapping between the s-node and node in "network.nodes".
+	return snetwork.nodes.emplace_back();
+}
+
+
+NodeVoltageSolver::SNode&
+NodeVoltageSolver::snode_for (SNetwork& snetwork, Node const& node)
+{
+	if (auto const* element = node.element())
 	{
-		while (!unvisited_nodes.empty())
-		{
-			Node const& node = **unvisited_nodes.begin();
-			SNode& snode = add_snode (&node);
-			unvisited_nodes.erase (unvisited_nodes.begin());
+		auto const* a_k_dir_edge = sedge_for (snetwork, *element).a_k_dir_edge;
+		return node.direction() == Node::Anode ? *a_k_dir_edge->this_node : *a_k_dir_edge->other_node;
+	}
+
+	if (auto const found = snetwork.snodes.find (&node); found != snetwork.snodes.end())
+		return *found->second;
 
-			for (auto const& connected_node: node.connected_nodes())
+	SNode* snode = &make_snode (snetwork);
+	snode->name = node.name();
+	snode->network_nodes.push_back (&node);
+	snetwork.snodes[&node] = snode;
+
+	for (auto const* connected_node: node.connected_nodes())
+	{
+		if (!connected_node->element())
+		{
+			if (auto const found = snetwork.snodes.find (connected_node); found != snetwork.snodes.end())
 			{
-				if (!connected_node->element())
+				if (found->second != snode)
 				{
-					snodes[connected_node] = &snode;
-					unvisited_nodes.erase (connected_node);
+					auto& target = *found->second;
+					merge_snodes (snetwork, target, *snode);
+					snode = &target;
 				}
 			}
+			else
+			{
+				snode->network_nodes.push_back (connected_node);
+				snetwork.snodes[connected_node] = snode;
+			}
 		}
 	}
 
-	// Transfer element edges from Nodes to SNodes.
+	return *snode;
+}
+
+
+NodeVoltageSolver::SNode&
+NodeVoltageSolver::snode_for_pin (SNetwork& snetwork, Node const& pin)
+{
+	// Make sure that element nodes have only 1 connection, to a normal node:
+	if (pin.connected_nodes().size() > 1)
+		throw InvalidArgument ("Element Node " + pin.name() + " has too many connections, maximum 1 allowed");
+
+	if (pin.connected_nodes().empty())
+		// This creates dangling edge:
+		return make_snode (snetwork);
+
+	auto const& connected_node = *pin.connected_nodes().at (0);
+
+	if (connected_node.element())
+		throw InvalidArgument ("Element Node " + pin.name() + " must be connected to a free node");
+
+	return snode_for (snetwork, connected_node);
+}
+
+
+NodeVoltageSolver::SEdge&
+NodeVoltageSolver::make_sedge (SNetwork& snetwork, Element& element, SNode& snode_a, SNode& snode_c)
+{
+	SEdge* sedge = nullptr;
+	SDirEdge* dir_edge_a = nullptr;
+	SDirEdge* dir_edge_c = nullptr;
+
+	if (!snetwork.unused_edges.empty())
+	{
+		sedge = snetwork.unused_edges.back();
+		snetwork.unused_edges.pop_back();
+		dir_edge_a = sedge->a_k_dir_edge;
+		dir_edge_c = dir_edge_a->other_dir_edge;
+	}
+	else
+	{
+		sedge = &snetwork.edges.emplace_back();
+		dir_edge_a = &snetwork.dir_edges.emplace_back();
+		dir_edge_c = &snetwork.dir_edges.emplace_back();
+	}
+
+	*sedge = SEdge { &element, 0_A, dir_edge_a, false, 0 };
+	*dir_edge_a = SDirEdge { sedge, Node::Anode, &snode_a, &snode_c, dir_edge_c };
+	*dir_edge_c = SDirEdge { sedge, Node::Cathode, &snode_c, &snode_a, dir_edge_a };
+
+	// Start disabled, attach() will enable it. Self-loops are not attached to nodes:
+	if (&snode_a != &snode_c)
+	{
+		snode_a.disabled_dir_edges.push_back (dir_edge_a);
+		snode_c.disabled_dir_edges.push_back (dir_edge_c);
+	}
+
+	snetwork.sedges[&element] = sedge;
+
+	return *sedge;
+}
+
+
+void
+NodeVoltageSolver::attach (SNetwork& snetwork, SEdge& sedge)
+{
+	sedge.enabled = true;
+
+	if (is_self_loop (sedge))
+	{
+		short_out (sedge);
+		return;
+	}
+
+	for (auto* dir_edge: { sedge.a_k_dir_edge, sedge.a_k_dir_edge->other_dir_edge })
+	{
+		std::erase (dir_edge->this_node->disabled_dir_edges, dir_edge);
+		dir_edge->this_node->dir_edges.push_back (dir_edge);
+	}
+
+	sedge.a_k_index = snetwork.a_k_dir_edges.size();
+	snetwork.a_k_dir_edges.push_back (sedge.a_k_dir_edge);
+}
+
+
+void
+NodeVoltageSolver::detach (SNetwork& snetwork, SEdge& sedge)
+{
+	if (!is_self_loop (sedge))
 	{
-		while (!unvisited_elements.empty())
+		for (auto* dir_edge: { sedge.a_k_dir_edge, sedge.a_k_dir_edge->other_dir_edge })
 		{
-			Element& element = **unvisited_elements.begin();
+			std::erase (dir_edge->this_node->dir_edges, dir_edge);
+			dir_edge->this_node->disabled_dir_edges.push_back (dir_edge);
+		}
 
-			unvisited_elements.erase (unvisited_elements.begin());
+		remove_from_a_k_dir_edges (snetwork, sedge);
+	}
 
-			auto const& node_a = element.anode();
-			auto const& node_c = element.cathode();
+	sedge.enabled = false;
+	sedge.a_k_current = 0_A;
+}
 
-			// Make sure that element nodes have only 1 connection, to a normal node:
-			for (auto* node: { &node_a, &node_c })
-				if (node->connected_nodes().size() > 1)
-					throw InvalidArgument ("Element Node " + node->name() + " has too many connections, maximum 1 allowed");
 
-			SNode* snode_a = node_a.connected_nodes().empty()
-				// This creates dangling edge:
-				? &add_snode (nullptr)
-				: snodes.at (node_a.connected_nodes().at (0));
+bool
+NodeVoltageSolver::is_self_loop (SEdge const& sedge)
+{
+	return sedge.a_k_dir_edge->this_node == sedge.a_k_dir_edge->other_node;
+}
+
+
+void
+NodeVoltageSolver::remove_from_a_k_dir_edges (SNetwork& snetwork, SEdge& sedge)
+{
+	// Swap-remove from the list of enabled edges:
+	auto* last = snetwork.a_k_dir_edges.back();
+	snetwork.a_k_dir_edges[sedge.a_k_index] = last;
+	last->edge->a_k_index = sedge.a_k_index;
+	snetwork.a_k_dir_edges.pop_back();
+}
+
 
-			SNode* snode_c = node_c.connected_nodes().empty()
-				// This creates dangling edge:
-				? &add_snode (nullptr)
-				: snodes.at (node_c.connected_nodes().at (0));
+void
+NodeVoltageSolver::short_out (SEdge& sedge)
+{
+	auto& element = *sedge.element;
+	sedge.a_k_current = element.current_for_voltage (0_V);
+	element.set_voltage (0_V);
+	element.set_current (sedge.a_k_current);
+}
 
-			snetwork.edges.push_back (SEdge { &element, 0_A });
-			SEdge& sedge = snetwork.edges.back();
 
-			snetwork.dir_edges.push_back (SDirEdge { &sedge, Node::Anode, snode_a, snode_c, nullptr });
-			auto& dir_edge_a = snetwork.dir_edges.back();
-			snode_a->dir_edges.push_back (&dir_edge_a);
+void
+NodeVoltageSolver::merge_snodes (SNetwork& snetwork, SNode& target, SNode& source)
+{
+	auto const move_dir_edges = [&target] (std::vector<SDirEdge*>& from, std::vector<SDirEdge*>& to) {
+		for (auto* dir_edge: from)
+		{
+			dir_edge->this_node = &target;
+			dir_edge->other_dir_edge->other_node = &target;
+			to.push_back (dir_edge);
+		}
 
-			snetwork.a_k_dir_edges.push_back (&dir_edge_a);
+		from.clear();
+	};
 
-			snetwork.dir_edges.push_back (SDirEdge { &sedge, Node::Cathode, snode_c, snode_a, nullptr });
-			auto& dir_edge_c = snetwork.dir_edges.back();
-			snode_c->dir_edges.push_back (&dir_edge_c);
+	move_dir_edges (source.dir_edges, target.dir_edges);
+	move_dir_edges (source.disabled_dir_edges, target.disabled_dir_edges);
 
-			dir_edge_a.other_dir_edge = &dir_edge_c;
-			dir_edge_c.other_dir_edge = &dir_edge_a;
+	// Edges that connected source with target are now self-loops. They would only disturb balancing
+	// of currents in the target node, so drop them; elements end up with zero voltage on them:
+	for (auto* dir_edge: target.dir_edges)
+	{
+		if (dir_edge == dir_edge->edge->a_k_dir_edge && is_self_loop (*dir_edge->edge))
+		{
+			remove_from_a_k_dir_edges (snetwork, *dir_edge->edge);
+			short_out (*dir_edge->edge);
 		}
 	}
+
+	auto const self_loop = [] (SDirEdge const* dir_edge) { return is_self_loop (*dir_edge->edge); };
+	std::erase_if (target.dir_edges, self_loop);
+	std::erase_if (target.disabled_dir_edges, self_loop);
+
+	for (auto const* node: source.network_nodes)
+	{
+		snetwork.snodes[node] = &target;
+		target.network_nodes.push_back (node);
+	}
+
+	source.network_nodes.clear();
+	snetwork.unused_nodes.push_back (&source);
+}
+
+
+NodeVoltageSolver::SEdge&
+NodeVoltageSolver::sedge_for (SNetwork& snetwork, Element const& element)
+{
+	if (auto const found = snetwork.sedges.find (&element); found != snetwork.sedges.end())
+		return *found->second;
+	else
+		throw InvalidArgument ("element " + element.name() + " is not known to the solver");
 }
 
 
@@ -25,7 +25,9 @@
 
 // Standard:
 #include <cstddef>
+#include <deque>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <variant>
 #include <vector>
@@ -37,8 +39,11 @@ namespace xf::electrical {
  * Solves voltages on electrical loads using loop current method and numerical approach.
  *
  * Solver must not outlive network or its components.
- * Solver will not reflect changes after network is reconfigured. A new Solver must be created
- * after changes are made to the network.
+ * Solver will not reflect changes after network is reconfigured unless notified about them
+ * with add_element(), remove_element() or merge_nodes(). Elements enabled or disabled with
+ * Element::set_enabled() are picked up on the next solve. These update the internal graph
+ * locally and keep the last solution as a starting point, so toggling switches or breakers
+ * doesn't require creating a new Solver.
  */
 class NodeVoltageSolver: public Noncopyable
 {
@@ -47,6 +52,7 @@ class NodeVoltageSolver: public Noncopyable
 
   private:
 	class SNode;
+	class SDirEdge;
 
 	class SEdge
 	{
@@ -54,6 +60,12 @@ class NodeVoltageSolver: public Noncopyable
 		Element*	element;
 		// Current from anode to cathode:
 		si::Current	a_k_current;
+		// Anode→cathode directional edge (its other_dir_edge is the cathode→anode one):
+		SDirEdge*	a_k_dir_edge	{ nullptr };
+		// Disabled edges are not attached to SNodes and not listed in SNetwork::a_k_dir_edges:
+		bool		enabled			{ true };
+		// Position in SNetwork::a_k_dir_edges, if enabled:
+		std::size_t	a_k_index		{ 0 };
 	};
 
 	class SDirEdge
@@ -69,19 +81,31 @@ class NodeVoltageSolver: public Noncopyable
 	class SNode
 	{
 	  public:
-		std::string				name;
-		std::vector<SDirEdge*>	dir_edges;
-		si::Voltage				voltage;
+		std::string					name;
+		std::vector<SDirEdge*>		dir_edges;
+		// Dir-edges of disabled elements, attached to this node when enabled:
+		std::vector<SDirEdge*>		disabled_dir_edges;
+		// Network nodes represented by this SNode:
+		std::vector<Node const*>	network_nodes;
+		si::Voltage					voltage;
 	};
 
 	class SNetwork: public Noncopyable
 	{
 	  public:
-		std::vector<SNode>		nodes;
-		std::vector<SEdge>		edges;
-		std::vector<SDirEdge>	dir_edges;
-		// Contains only anode→cathode directional edges (from anode to cathode):
-		std::vector<SDirEdge*>	a_k_dir_edges;
+		// Deques don't invalidate references when growing, so elements can be added
+		// without rebuilding pointers between nodes and edges:
+		std::deque<SNode>							nodes;
+		std::deque<SEdge>							edges;
+		std::deque<SDirEdge>						dir_edges;
+		// Contains only enabled anode→cathode directional edges (from anode to cathode):
+		std::vector<SDirEdge*>						a_k_dir_edges;
+		// Lookups used by incremental updates:
+		std::unordered_map<Node const*, SNode*>		snodes;
+		std::unordered_map<Element const*, SEdge*>	sedges;
+		// Nodes and edges left after merging nodes or removing elements, to be reused:
+		std::vector<SNode*>							unused_nodes;
+		std::vector<SEdge*>							unused_edges;
 
 	  public:
 		/**
@@ -172,11 +196,64 @@ class NodeVoltageSolver: public Noncopyable
 	converged() const noexcept
 		{ return _converged; }
 
+	/**
+	 * Enable or disable an element (see Element::set_enabled()) and detach it from or reattach it
+	 * to its nodes right away, instead of on the next solve. Current of a disabled element is set to 0 A.
+	 *
+	 * \throws	InvalidArgument
+	 *			If element is not known to the solver.
+	 */
+	void
+	set_enabled (Element&, bool enabled);
+
+	/**
+	 * Add an element that has been added to the network after the solver was created.
+	 * Element pins must already be connected to network nodes.
+	 *
+	 * \throws	InvalidArgument
+	 *			If element is already known to the solver or its pins have too many connections.
+	 */
+	void
+	add_element (Element&);
+
+	/**
+	 * Forget an element. Must be called before the element is removed from the network
+	 * (see Network::remove()).
+	 *
+	 * \throws	InvalidArgument
+	 *			If element is not known to the solver.
+	 */
+	void
+	remove_element (Element const&);
+
+	/**
+	 * Merge two nodes into one, after they have been connected in the network (eg. with node_1 << node_2).
+	 * Nodes can be free nodes or element pins.
+	 *
+	 * \throws	InvalidArgument
+	 *			If a node is an element pin of an element not known to the solver.
+	 */
+	void
+	merge_nodes (Node const&, Node const&);
+
   private:
 	[[nodiscard]]
 	static bool
 	solve (SNetwork& network, double accuracy, uint32_t max_iterations, bool throwing);
 
+	/**
+	 * Attach or detach edges of elements that have been enabled or disabled since last call.
+	 * Does nothing if no element anywhere has been toggled (see Element::enabled_serial()).
+	 */
+	void
+	update_enabled_elements();
+
+	/**
+	 * Attach or detach edge to match the enabled state of its element.
+	 */
+	static void
+	update_enabled (SNetwork&, SEdge&);
+
 	/**
 	 * Flow current through elements.
 	 */
@@ -193,6 +270,76 @@ class NodeVoltageSolver: public Noncopyable
 	static void
 	simplify (Network const& network, SNetwork& result);
 
+	/**
+	 * Return a new or reused SNode.
+	 */
+	static SNode&
+	make_snode (SNetwork&);
+
+	/**
+	 * Return SNode representing given node. For free nodes not yet known, a new SNode is created.
+	 */
+	static SNode&
+	snode_for (SNetwork&, Node const&);
+
+	/**
+	 * Return SNode to which given element pin is connected. For unconnected pins a new, dangling SNode is created.
+	 */
+	static SNode&
+	snode_for_pin (SNetwork&, Node const& pin);
+
+	/**
+	 * Create an SEdge (with both SDirEdges) for given element between given SNodes.
+	 */
+	static SEdge&
+	make_sedge (SNetwork&, Element&, SNode& anode, SNode& cathode);
+
+	/**
+	 * Attach edge to its nodes and to the list of enabled edges.
+	 */
+	static void
+	attach (SNetwork&, SEdge&);
+
+	/**
+	 * Detach edge from its nodes and from the list of enabled edges.
+	 */
+	static void
+	detach (SNetwork&, SEdge&);
+
+	/**
+	 * Return true if both ends of the edge are connected to the same SNode.
+	 */
+	static bool
+	is_self_loop (SEdge const&);
+
+	/**
+	 * Remove edge from the list of enabled edges.
+	 */
+	static void
+	remove_from_a_k_dir_edges (SNetwork&, SEdge&);
+
+	/**
+	 * Set zero voltage and corresponding current on element of a self-loop edge.
+	 */
+	static void
+	short_out (SEdge&);
+
+	/**
+	 * Move all edges and network nodes from the source SNode into the target SNode.
+	 * Edges that become self-loops are dropped from the nodes.
+	 */
+	static void
+	merge_snodes (SNetwork&, SNode& target, SNode& source);
+
+	/**
+	 * Return SEdge for given element.
+	 *
+	 * \throws	InvalidArgument
+	 *			If element is not known to the solver.
+	 */
+	static SEdge&
+	sedge_for (SNetwork&, Element const&);
+
 	/**
 	 * Adjust both v1 and v2 so that v2 - v1 == required_voltage.
 	 *
@@ -295,6 +442,7 @@ class NodeVoltageSolver: public Noncopyable
 	double		_accuracy;
 	uint32_t	_max_iterations;
 	bool		_converged		{ false };
+	uint64_t	_enabled_serial	{ Element::enabled_serial() };
 };
 
 
@@ -0,0 +1,387 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/components/capacitor.h>
+#include <xefis/support/simulation/components/resistor.h>
+#include <xefis/support/simulation/components/voltage_source.h>
+#include <xefis/support/simulation/electrical/direct_solver.h>
+#include <xefis/support/simulation/electrical/network.h>
+#include <xefis/support/simulation/electrical/node_voltage_solver.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+AutoTest t_1 ("Electrical: DirectSolver R.4", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+	auto& n1 = network.make_node ("N1");
+	auto& n2 = network.make_node ("N2");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 1e-9_Ohm);
+	vcc << v1 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 10_Ohm);
+	vcc >> r1 >> n1;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 5_Ohm);
+	vcc >> r2 >> n2;
+
+	auto& r3 = network.add<electrical::Resistor> ("R3", 5_Ohm);
+	n1 << r3 << n2;
+
+	auto& r4 = network.add<electrical::Resistor> ("R4", 5_Ohm);
+	n1 >> r4 >> gnd;
+
+	auto& r5 = network.add<electrical::Resistor> ("R5", 5_Ohm);
+	n2 >> r5 >> gnd;
+
+	auto const precision = 1e-5;
+	electrical::DirectSolver solver (network, precision);
+
+	test_asserts::verify ("solution converged", solver.converged());
+	test_asserts::verify ("linear network is factorized once", solver.factorizations() == 1);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), +3.07692_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R2 voltage is correct", r2.voltage(), +2.69231_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), +0.384615_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R4 voltage is correct", r4.voltage(), +1.92308_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R5 voltage is correct", r5.voltage(), +2.30769_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R1 current is correct", r1.current(), +0.307692_A, precision * 1_A);
+});
+
+
+AutoTest t_2 ("Electrical: DirectSolver V.1 (two voltage sources)", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc1 = network.make_node ("VCC1");
+	auto& vcc2 = network.make_node ("VCC2");
+	auto& n1 = network.make_node ("N1");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 1_mOhm);
+	vcc1 << v1 << gnd;
+
+	auto& v2 = network.add<electrical::VoltageSource> ("V2", 3_V, 1_mOhm);
+	vcc2 << v2 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 100_Ohm);
+	vcc1 >> r1 >> n1;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 500_Ohm);
+	vcc2 >> r2 >> n1;
+
+	auto& r3 = network.add<electrical::Resistor> ("R3", 1_kOhm);
+	n1 >> r3 >> gnd;
+
+	auto const precision = 1e-6;
+	electrical::DirectSolver solver (network, precision);
+
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), +0.692306_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R2 voltage is correct", r2.voltage(), -1.307685_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), +4.307687_V, precision * 1_V);
+
+	// Changing source voltage doesn't require refactorization:
+	v2.set_source_voltage (5_V);
+	solver.solve_throwing();
+
+	test_asserts::verify ("factorization is reused after source voltage change", solver.factorizations() == 1);
+	test_asserts::verify_equal_with_epsilon ("R2 voltage is correct after source voltage change", r2.voltage(), r1.voltage(), 1e-5_V);
+
+	// Changing resistance does:
+	r2.set_resistance (100_Ohm);
+	solver.solve_throwing();
+
+	test_asserts::verify ("matrix is refactorized after resistance change", solver.factorizations() == 2);
+	test_asserts::verify_equal_with_epsilon ("R1 and R2 currents are equal", r1.current(), r2.current(), precision * 1_A);
+});
+
+
+AutoTest t_3 ("Electrical: DirectSolver stiff network", []{
+	// Resistances spanning 12 orders of magnitude, eg. closed and open switches:
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+	auto& n1 = network.make_node ("N1");
+	auto& n2 = network.make_node ("N2");
+	auto& n3 = network.make_node ("N3");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 1_mOhm);
+	vcc << v1 << gnd;
+
+	auto& closed = network.add<electrical::Resistor> ("S1", 1_mOhm);
+	vcc >> closed >> n1;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 100_Ohm);
+	n1 >> r1 >> gnd;
+
+	auto& open = network.add<electrical::Resistor> ("S2", 1_GOhm);
+	n1 >> open >> n2;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 100_Ohm);
+	n2 >> r2 >> n3;
+
+	auto& r3 = network.add<electrical::Resistor> ("R3", 100_Ohm);
+	n3 >> r3 >> gnd;
+
+	electrical::DirectSolver solver (network, 1e-9);
+
+	auto const r1_parallel = 1.0 / (1.0 / 100_Ohm + 1.0 / (1_GOhm + 200_Ohm));
+	auto const n1_voltage = 5_V * r1_parallel / (2_mOhm + r1_parallel);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), n1_voltage, 1e-9_V);
+	// Current through the open switch is tiny, but still must be computed accurately:
+	auto const i2 = n1_voltage / (1_GOhm + 200_Ohm);
+	test_asserts::verify_equal_with_epsilon ("S2 current is correct", open.current(), i2, 1e-6 * i2);
+	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), i2 * 100_Ohm, 1e-6 * i2 * 100_Ohm);
+
+	// Swap the switches:
+	closed.set_resistance (1_GOhm);
+	open.set_resistance (1_mOhm);
+	solver.solve_throwing();
+
+	test_asserts::verify_equal_with_epsilon ("R1 is disconnected", r1.voltage(), 0_V, 1e-6_V);
+	test_asserts::verify_equal_with_epsilon ("R2 voltage is correct after switching", r2.voltage(), r3.voltage(), 1e-9_V);
+});
+
+
+AutoTest t_4 ("Electrical: DirectSolver resistor ladder", []{
+	// Infinite ladder of equal resistors has input resistance R·φ (golden ratio).
+	// A long enough finite ladder converges to it quickly:
+	constexpr std::size_t kRungs = 200;
+	constexpr auto kR = 10_Ohm;
+
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 10_V, 1e-9_Ohm);
+	vcc << v1 << gnd;
+
+	std::vector<electrical::Resistor*> series;
+	auto* previous = &vcc;
+
+	for (std::size_t i = 0; i < kRungs; ++i)
+	{
+		auto& node = network.make_node ("N" + std::to_string (i));
+		auto& rs = network.add<electrical::Resistor> ("RS" + std::to_string (i), kR);
+		*previous >> rs >> node;
+		auto& rp = network.add<electrical::Resistor> ("RP" + std::to_string (i), kR);
+		node >> rp >> gnd;
+		series.push_back (&rs);
+		previous = &node;
+	}
+
+	electrical::DirectSolver solver (network, 1e-9);
+
+	auto const input_resistance = kR * (1.0 + std::sqrt (5.0)) / 2.0;
+	test_asserts::verify_equal_with_epsilon ("input current is correct", series[0]->current(), 10_V / input_resistance, 1e-9_A);
+
+	// Each rung attenuates current by the same factor R / (R + R·φ):
+	auto const ratio = series[1]->current() / series[0]->current();
+	test_asserts::verify_equal_with_epsilon ("attenuation is correct", ratio, (3.0 - std::sqrt (5.0)) / 2.0, 1e-9);
+});
+
+
+AutoTest t_5 ("Electrical: DirectSolver agrees with NodeVoltageSolver for RC network", []{
+	auto const make_network = [] (electrical::Network& network) {
+		auto& gnd = network.make_node ("GND");
+		auto& vcc = network.make_node ("VCC");
+		auto& n1 = network.make_node ("N1");
+
+		auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 1_mOhm);
+		vcc << v1 << gnd;
+
+		auto& r1 = network.add<electrical::Resistor> ("R1", 100_Ohm);
+		vcc >> r1 >> n1;
+
+		auto& c1 = network.add<electrical::Capacitor> ("C1", 1_uF, 10_Ohm);
+		n1 >> c1 >> gnd;
+
+		return &c1;
+	};
+
+	electrical::Network network_1;
+	electrical::Network network_2;
+	auto* c1_1 = make_network (network_1);
+	auto* c1_2 = make_network (network_2);
+	auto const precision = 1e-9;
+	electrical::NodeVoltageSolver iterative_solver (network_1, precision, 1000);
+	electrical::DirectSolver direct_solver (network_2, precision);
+	auto const dt = 500_ns;
+
+	for (auto t = 0_s; t < 1_ms; t += dt)
+	{
+		iterative_solver.evolve (dt);
+		direct_solver.evolve (dt);
+		test_asserts::verify_equal_with_epsilon ("capacitor voltages are equal", c1_1->voltage(), c1_2->voltage(), 1e-5_V);
+	}
+
+	test_asserts::verify ("charging capacitor doesn't need refactorization", direct_solver.factorizations() == 1);
+});
+
+
+AutoTest t_6 ("Electrical: DirectSolver disabled elements", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 5_Ohm);
+	vcc << v1 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 10_Ohm);
+	vcc >> r1 >> gnd;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 10_Ohm);
+	vcc >> r2 >> gnd;
+
+	auto const precision = 1e-9;
+	electrical::DirectSolver solver (network, precision);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), +2.5_V, precision * 1_V);
+
+	r2.set_enabled (false);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 disabled", r1.voltage(), 5_V * 10.0 / 15.0, precision * 1_V);
+	test_asserts::verify_equal ("R2 current is 0 A when disabled", r2.current(), 0_A);
+	test_asserts::verify ("disabling an element refactorizes the matrix", solver.factorizations() == 2);
+
+	r2.set_enabled (true);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R2 current is correct when enabled again", r2.current(), +0.25_A, precision * 1_A);
+});
+
+
+
+AutoTest t_7 ("Electrical: DirectSolver ideal voltage sources", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+	auto& n1 = network.make_node ("N1");
+	auto& n2 = network.make_node ("N2");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 0_Ohm);
+	vcc << v1 << gnd;
+
+	// Second ideal source in series with R1 puts N1 at 2 V:
+	auto& v2 = network.add<electrical::VoltageSource> ("V2", 2_V, 0_Ohm);
+	n1 << v2 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 10_Ohm);
+	vcc >> r1 >> n1;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 10_Ohm);
+	vcc >> r2 >> n2;
+
+	auto& r3 = network.add<electrical::Resistor> ("R3", 30_Ohm);
+	n2 >> r3 >> gnd;
+
+	auto const precision = 1e-9;
+	electrical::DirectSolver solver (network, precision);
+
+	test_asserts::verify ("solution converged", solver.converged());
+	test_asserts::verify_equal_with_epsilon ("V1 voltage is exact", v1.voltage(), -5_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), +3_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), +3.75_V, precision * 1_V);
+	// V1 supplies R1 and R2, V2 sinks the current of R1:
+	test_asserts::verify_equal_with_epsilon ("V1 current is correct", v1.current(), +0.3_A + 0.125_A, precision * 1_A);
+	test_asserts::verify_equal_with_epsilon ("V2 current is correct", v2.current(), -0.3_A, precision * 1_A);
+
+	// Voltages of ideal sources only change the right-hand side:
+	v1.set_source_voltage (10_V);
+	solver.solve_throwing();
+
+	test_asserts::verify ("factorization is reused after source voltage change", solver.factorizations() == 1);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct after source voltage change", r1.voltage(), +8_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("V1 current is correct after source voltage change", v1.current(), +0.8_A + 0.25_A, precision * 1_A);
+
+	auto disabling_rejected = false;
+	v2.set_enabled (false);
+
+	try {
+		solver.solve_throwing();
+	}
+	catch (InvalidArgument const&)
+	{
+		disabling_rejected = true;
+	}
+
+	test_asserts::verify ("disabling ideal voltage source is rejected", disabling_rejected);
+});
+
+
+AutoTest t_8 ("Electrical: DirectSolver charges ideal capacitor", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+	auto& n1 = network.make_node ("N1");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 0_Ohm);
+	vcc << v1 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 100_Ohm);
+	vcc >> r1 >> n1;
+
+	auto& c1 = network.add<electrical::Capacitor> ("C1", 1_uF, 0_Ohm);
+	n1 >> c1 >> gnd;
+
+	electrical::DirectSolver solver (network, 1e-9);
+	// τ = R·C:
+	auto const tau = 100_us;
+	auto const dt = 100_ns;
+	auto t = 0_s;
+
+	for (; t < 2 * tau; t += dt)
+		solver.evolve (dt);
+
+	test_asserts::verify_equal_with_epsilon ("capacitor voltage follows RC charging curve", c1.voltage(), 5_V * (1.0 - std::exp (-t.in<si::Second>() / tau.in<si::Second>())), 5_mV);
+	test_asserts::verify_equal_with_epsilon ("capacitor current equals resistor current", c1.current(), r1.current(), 1e-9_A);
+	test_asserts::verify ("charging ideal capacitor doesn't need refactorization", solver.factorizations() == 1);
+});
+
+
+AutoTest t_9 ("Electrical: DirectSolver rejects loops of ideal voltage sources", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 0_Ohm);
+	vcc << v1 << gnd;
+
+	auto& v2 = network.add<electrical::VoltageSource> ("V2", 3_V, 0_Ohm);
+	vcc << v2 << gnd;
+
+	auto rejected = false;
+
+	try {
+		electrical::DirectSolver solver (network, 1e-9);
+	}
+	catch (InvalidArgument const&)
+	{
+		rejected = true;
+	}
+
+	test_asserts::verify ("parallel ideal voltage sources are rejected", rejected);
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -281,6 +281,69 @@ AutoTest t_v_1 ("Electrical: network V.1 (two voltage sources)", []{
 	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), +4.307687_V, precision * 1_V);
 });
 
+
+AutoTest t_t_1 ("Electrical: network T.1 incremental topology updates", []{
+	electrical::Network network;
+	auto& gnd = network.make_node ("GND");
+	auto& vcc = network.make_node ("VCC");
+	auto& n1 = network.make_node ("N1");
+
+	auto& v1 = network.add<electrical::VoltageSource> ("V1", 5_V, 5_Ohm);
+	vcc << v1 << gnd;
+
+	auto& r1 = network.add<electrical::Resistor> ("R1", 10_Ohm);
+	vcc >> r1 >> gnd;
+
+	auto& r2 = network.add<electrical::Resistor> ("R2", 10_Ohm);
+	vcc >> r2 >> gnd;
+
+	auto const precision = 1e-6;
+	electrical::NodeVoltageSolver solver (network, precision);
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct", r1.voltage(), +2.5_V, precision * 1_V);
+
+	solver.set_enabled (r2, false);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 disabled", r1.voltage(), +3.33333_V, 1e-5_V);
+	test_asserts::verify_equal ("R2 current is 0 A when disabled", r2.current(), 0_A);
+
+	solver.set_enabled (r2, true);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 enabled again", r1.voltage(), +2.5_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R2 current is correct with R2 enabled again", r2.current(), +0.25_A, precision * 1_A);
+
+	// Toggling the element itself is picked up by the solver on next solve:
+	r2.set_enabled (false);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 disabled on the element", r1.voltage(), +3.33333_V, 1e-5_V);
+	test_asserts::verify_equal ("R2 current is 0 A when disabled on the element", r2.current(), 0_A);
+
+	r2.set_enabled (true);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 enabled again on the element", r1.voltage(), +2.5_V, precision * 1_V);
+
+	solver.remove_element (r2);
+	network.remove (r2);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R2 removed", r1.voltage(), +3.33333_V, 1e-5_V);
+
+	auto& r3 = network.add<electrical::Resistor> ("R3", 10_Ohm);
+	vcc >> r3 >> gnd;
+	solver.add_element (r3);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with R3 added", r1.voltage(), +2.5_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R3 voltage is correct", r3.voltage(), +2.5_V, precision * 1_V);
+
+	// R4 hangs on a separate node N1, until N1 is merged with VCC:
+	auto& r4 = network.add<electrical::Resistor> ("R4", 10_Ohm);
+	n1 >> r4 >> gnd;
+	solver.add_element (r4);
+	vcc << n1;
+	solver.merge_nodes (vcc, n1);
+	solver.solve_throwing();
+	test_asserts::verify_equal_with_epsilon ("R1 voltage is correct with N1 merged", r1.voltage(), +2_V, precision * 1_V);
+	test_asserts::verify_equal_with_epsilon ("R4 voltage is correct with N1 merged", r4.voltage(), +2_V, precision * 1_V);
+});
+
 } // namespace
 } // namespace xf::test
 
@@ -0,0 +1,162 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/components/capacitor.h>
+#include <xefis/support/simulation/components/resistor.h>
+#include <xefis/support/simulation/components/voltage_source.h>
+#include <xefis/support/simulation/electrical/direct_solver.h>
+#include <xefis/support/simulation/electrical/network.h>
+#include <xefis/support/simulation/electrical/node_voltage_solver.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+// Each branch has a switch, a feeder resistor, a load and a capacitor; with the source it makes 501 elements:
+constexpr std::size_t	kBranches			= 125;
+constexpr auto			kSimulationTime		= 100_ms;
+constexpr auto			kTimeStep			= 0.1_ms;
+// Switches toggled at 1 kHz:
+constexpr auto			kTogglePeriod		= 1_ms;
+constexpr double		kAccuracy			= 1e-3;
+
+
+/**
+ * Power bus feeding kBranches switched RC loads.
+ */
+struct SwitchedNetwork
+{
+	electrical::Network					network;
+	std::vector<electrical::Resistor*>	switches;
+
+	SwitchedNetwork()
+	{
+		auto& gnd = network.make_node ("GND");
+		auto& vcc = network.make_node ("VCC");
+
+		auto& v1 = network.add<electrical::VoltageSource> ("V1", 28_V, 1_Ohm);
+		vcc << v1 << gnd;
+
+		for (std::size_t i = 0; i < kBranches; ++i)
+		{
+			auto const suffix = std::to_string (i);
+			auto& n1 = network.make_node ("N1." + suffix);
+			auto& n2 = network.make_node ("N2." + suffix);
+
+			auto& sw = network.add<electrical::Resistor> ("S." + suffix, 1_Ohm);
+			vcc >> sw >> n1;
+
+			auto& feeder = network.add<electrical::Resistor> ("RF." + suffix, 10_Ohm);
+			n1 >> feeder >> n2;
+
+			auto& load = network.add<electrical::Resistor> ("RL." + suffix, 1_kOhm * static_cast<double> (1 + i % 10));
+			n2 >> load >> gnd;
+
+			auto& capacitor = network.add<electrical::Capacitor> ("C." + suffix, 100_uF, 10_Ohm);
+			n2 >> capacitor >> gnd;
+
+			switches.push_back (&sw);
+		}
+	}
+};
+
+
+/**
+ * Evolve the network for kSimulationTime, toggling the next switch every kTogglePeriod,
+ * and print average time of a step.
+ *
+ * \param	make_solver
+ *			Returns std::unique_ptr to a new solver for given network.
+ * \param	toggle
+ *			Toggles given switch and updates the solver (or replaces it).
+ */
+template<class MakeSolver, class Toggle>
+	void
+	print_toggle_stats (std::string_view const name, MakeSolver&& make_solver, Toggle&& toggle)
+	{
+		SwitchedNetwork switched;
+		auto solver = make_solver (switched.network);
+		std::size_t toggles = 0;
+		std::size_t steps = 0;
+		auto next_toggle = kTogglePeriod;
+
+		si::Time const total = TimeHelper::measure ([&] {
+			for (auto t = 0_s; t < kSimulationTime; t += kTimeStep)
+			{
+				if (t >= next_toggle)
+				{
+					toggle (solver, switched.network, *switched.switches[toggles % switched.switches.size()]);
+					next_toggle += kTogglePeriod;
+					++toggles;
+				}
+
+				solver->evolve (kTimeStep);
+				++steps;
+			}
+		});
+
+		std::cout << std::format ("  {:40} {:9.3f} ms total, {:8.3f} µs/step\n",
+								  name,
+								  total.in<si::Millisecond>(),
+								  total.in<si::Second>() * 1e6 / static_cast<double> (steps));
+	}
+
+
+ManualTest t_1 ("electrical: toggling switches at 1 kHz on a 500-element network", []{
+	auto const make_node_voltage_solver = [] (electrical::Network const& network) {
+		return std::make_unique<electrical::NodeVoltageSolver> (network, kAccuracy);
+	};
+
+	auto const make_direct_solver = [] (electrical::Network const& network) {
+		return std::make_unique<electrical::DirectSolver> (network, kAccuracy);
+	};
+
+	std::cout << std::format ("{} elements, {} toggles, Δt = {} µs:\n",
+							  1 + 4 * kBranches,
+							  static_cast<std::size_t> (kSimulationTime / kTogglePeriod),
+							  kTimeStep.in<si::Second>() * 1e6);
+
+	// Baseline: create a new NodeVoltageSolver after each change:
+	print_toggle_stats ("NodeVoltageSolver, rebuilt", make_node_voltage_solver, [&] (auto& solver, auto const& network, auto& sw) {
+		sw.set_enabled (!sw.enabled());
+		solver = make_node_voltage_solver (network);
+	});
+
+	print_toggle_stats ("NodeVoltageSolver, incremental", make_node_voltage_solver, [] (auto& solver, auto const&, auto& sw) {
+		solver->set_enabled (sw, !sw.enabled());
+	});
+
+	// DirectSolver notices disabled elements by itself and only refactors numerically:
+	print_toggle_stats ("DirectSolver", make_direct_solver, [] (auto&, auto const&, auto& sw) {
+		sw.set_enabled (!sw.enabled());
+	});
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -18,12 +18,27 @@
 #include <xefis/config/all.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
 
 
 namespace xf {
 
 Evolver::Evolver (si::Time const frame_duration, Logger const& logger, Evolve const evolve):
+	_logger (logger),
+	_frame_duration (frame_duration)
+{
+	if (!evolve)
+		throw InvalidArgument ("'evolve' paramter must not be nullptr");
+
+	_evolve = [evolve] (si::Time const dt, std::optional<std::size_t>) {
+		evolve (dt);
+		return FrameFeedback();
+	};
+}
+
+
+Evolver::Evolver (si::Time const frame_duration, Logger const& logger, AdaptiveEvolve const evolve):
 	_logger (logger),
 	_frame_duration (frame_duration),
 	_evolve (evolve)
@@ -33,21 +48,67 @@ Evolver::Evolver (si::Time const frame_duration, Logger const& logger, Evolve co
 }
 
 
+void
+Evolver::set_adaptive_stepping (std::optional<AdaptiveStepping> const& adaptive_stepping)
+{
+	_adaptive_stepping = adaptive_stepping;
+	_budget_frame_duration = 0_s;
+
+	if (_adaptive_stepping)
+	{
+		_max_iterations = _adaptive_stepping->max_iterations;
+		_frame_duration = std::clamp (_frame_duration, _adaptive_stepping->min_frame_duration, _adaptive_stepping->max_frame_duration);
+	}
+	else
+		_max_iterations.reset();
+}
+
+
 Evolver::EvolutionResult
 Evolver::evolve (si::Time const duration)
 {
 	_target_time += duration;
 	auto frames = 0u;
 	auto const prev_simulation_time = _simulation_time;
-	auto const real_time_taken = TimeHelper::measure ([&] {
-		while (_simulation_time < _target_time)
+	auto const start_time = TimeHelper::now();
+	std::optional<si::Time> budget;
+
+	if (_adaptive_stepping && _adaptive_stepping->real_time_budget)
+		budget = duration * *_adaptive_stepping->real_time_budget;
+
+	while (_simulation_time < _target_time)
+	{
+		auto dt = _frame_duration;
+		auto last_frame = false;
+
+		if (_adaptive_stepping)
 		{
-			_evolve (_frame_duration);
-			_simulation_time += _frame_duration;
-			++frames;
+			auto const remaining = _target_time - _simulation_time;
+
+			// Don't overshoot the target time and don't leave a remainder shorter than the minimum frame duration:
+			if (remaining - dt < _adaptive_stepping->min_frame_duration)
+			{
+				dt = std::max (remaining, _adaptive_stepping->min_frame_duration);
+				last_frame = true;
+			}
 		}
-	});
 
+		auto const feedback = evolve_frame (dt);
+		// Avoid accumulating rounding errors on the last frame:
+		_simulation_time = last_frame ? std::max (_target_time, _simulation_time + dt) : _simulation_time + dt;
+		++frames;
+
+		if (_adaptive_stepping)
+		{
+			// Assume that the rest of the requested time will be simulated at the same speed:
+			auto const elapsed = TimeHelper::now() - start_time;
+			auto const remaining = std::max (0_s, _target_time - _simulation_time);
+			auto const projected_real_time = elapsed + elapsed * (remaining / (_simulation_time - prev_simulation_time));
+			adapt (feedback, projected_real_time, budget);
+		}
+	}
+
+	auto const real_time_taken = TimeHelper::now() - start_time;
 	_performance = (_simulation_time - prev_simulation_time) / real_time_taken;
 
 	return {
@@ -64,9 +125,13 @@ Evolver::evolve (std::size_t const frames)
 	auto const real_time_taken = TimeHelper::measure ([&] {
 		for (std::size_t i = 0; i < frames; ++i)
 		{
-			_evolve (_frame_duration);
-			_target_time += _frame_duration;
-			_simulation_time += _frame_duration;
+			auto const dt = _frame_duration;
+			auto const feedback = evolve_frame (dt);
+			_target_time += dt;
+			_simulation_time += dt;
+
+			if (_adaptive_stepping)
+				adapt (feedback, 0_s, std::nullopt);
 		}
 	});
 
@@ -78,5 +143,62 @@ Evolver::evolve (std::size_t const frames)
 	};
 }
 
+
+Evolver::FrameFeedback
+Evolver::evolve_frame (si::Time const frame_duration)
+{
+	FrameFeedback feedback;
+	auto const frame_time = TimeHelper::measure ([&] {
+		feedback = _evolve (frame_duration, _max_iterations);
+	});
+	_frame_times.push_back (frame_time);
+	return feedback;
+}
+
+
+void
+Evolver::adapt (FrameFeedback const& feedback, si::Time const projected_real_time, std::optional<si::Time> const budget)
+{
+	auto const& params = *_adaptive_stepping;
+	auto const iterations_degraded = _max_iterations && *_max_iterations < params.max_iterations;
+
+	// Shrink Δt if the solver didn't converge, but not if it's because the iterations limit
+	// has been lowered to fit in the budget:
+	auto dt = feedback.converged || iterations_degraded
+		? _frame_duration * kFrameDurationGrowth
+		: _frame_duration * kFrameDurationShrink;
+
+	// Fast bodies need short frames:
+	if (feedback.max_velocity > 0_mps)
+		dt = std::min (dt, params.max_frame_displacement / feedback.max_velocity);
+
+	if (budget && _max_iterations)
+	{
+		if (projected_real_time > *budget)
+		{
+			// Degrade: first lower the iterations limit, then increase Δt:
+			if (*_max_iterations > params.min_iterations)
+				_max_iterations = std::max (params.min_iterations, *_max_iterations / 2);
+			else
+				_budget_frame_duration = std::min (params.max_frame_duration, std::max (_budget_frame_duration, dt) * kFrameDurationGrowth);
+		}
+		else if (projected_real_time < kBudgetRecoveryFactor * *budget)
+		{
+			// Recover in the reverse order:
+			if (_budget_frame_duration > 0_s)
+			{
+				_budget_frame_duration *= kFrameDurationShrink;
+
+				if (_budget_frame_duration < params.min_frame_duration)
+					_budget_frame_duration = 0_s;
+			}
+			else if (*_max_iterations < params.max_iterations)
+				_max_iterations = std::min (params.max_iterations, 2 * *_max_iterations);
+		}
+	}
+
+	_frame_duration = std::clamp (std::max (dt, _budget_frame_duration), params.min_frame_duration, params.max_frame_duration);
+}
+
 } // namespace xf
 
@@ -20,9 +20,13 @@
 // Neutrino:
 #include <neutrino/logger.h>
 
+// Lib:
+#include <boost/circular_buffer.hpp>
+
 // Standard:
 #include <cstddef>
 #include <functional>
+#include <optional>
 
 
 namespace xf {
@@ -31,19 +35,64 @@ namespace xf {
  * Helper for evolving simulations with configured time step.
  * With configured time step 1_ms if we call evolve (1_s),
  * it will cause evolution of 1000 frames.
+ *
+ * Optionally (see set_adaptive_stepping()) the time step can be adapted to the simulation: it gets
+ * smaller when the solver doesn't converge or bodies move fast, and larger otherwise. With a real-time
+ * budget set, the evolver also degrades the simulation quality when it can't keep up: first it limits
+ * the number of solver iterations, then it increases the time step.
  */
 class Evolver
 {
+	static constexpr std::size_t	kMaxFrameTimesBackLog	= 1000;
+	// Factors by which Δt is changed by the adaptive stepping:
+	static constexpr double			kFrameDurationGrowth	= 1.25;
+	static constexpr double			kFrameDurationShrink	= 0.5;
+	// Budget use below which the degradation gets reverted:
+	static constexpr double			kBudgetRecoveryFactor	= 0.75;
+
   public:
+	/**
+	 * Feedback about a single evolved frame, used by adaptive stepping.
+	 */
+	struct FrameFeedback
+	{
+		// Whether the solver converged within the iterations limit:
+		bool			converged		{ true };
+		// The largest velocity of all simulated bodies:
+		si::Velocity	max_velocity	{ 0_mps };
+	};
+
 	// Evolution function called on each simulation frame:
 	using Evolve = std::function<void (si::Time frame_duration)>;
 
+	// Evolution function called on each simulation frame that gives feedback for adaptive stepping.
+	// If max_iterations is nullopt, the solver should use its own configured limit:
+	using AdaptiveEvolve = std::function<FrameFeedback (si::Time frame_duration, std::optional<std::size_t> max_iterations)>;
+
 	struct EvolutionResult
 	{
 		si::Time	real_time_taken;
 		std::size_t	evolved_frames;
 	};
 
+	/**
+	 * Parameters of the adaptive stepping.
+	 */
+	struct AdaptiveStepping
+	{
+		si::Time				min_frame_duration		{ 0.1_ms };
+		si::Time				max_frame_duration		{ 10_ms };
+		// Maximum distance a body should travel in a single frame:
+		si::Length				max_frame_displacement	{ 10_cm };
+		// Solver iterations limit used when within the real-time budget:
+		std::size_t				max_iterations			{ 100 };
+		// Solver iterations limit won't be degraded below this:
+		std::size_t				min_iterations			{ 2 };
+		// Real time that evolve (si::Time) can take per unit of simulation time, eg. 0.5 means that
+		// simulating 10 ms should take no more than 5 ms of real time. Unlimited if nullopt:
+		std::optional<double>	real_time_budget;
+	};
+
   public:
 	/**
 	 * Ctor
@@ -55,6 +104,16 @@ class Evolver
 	explicit
 	Evolver (si::Time frame_duration, Logger const&, Evolve);
 
+	/**
+	 * Ctor
+	 *
+	 * \param	evolve
+	 *			Evolution function called for each simulation frame.
+	 *			Must not be nullptr.
+	 */
+	explicit
+	Evolver (si::Time frame_duration, Logger const&, AdaptiveEvolve);
+
 	/**
 	 * Return current simulation frame Δt.
 	 */
@@ -65,11 +124,35 @@ class Evolver
 
 	/**
 	 * Set new simulation frame Δt.
+	 * With adaptive stepping enabled it's the starting Δt that will get adapted.
 	 */
 	void
 	set_frame_duration (si::Time const dt) noexcept
 		{ _frame_duration = dt; }
 
+	/**
+	 * Return adaptive stepping parameters or nullopt if adaptive stepping is disabled.
+	 */
+	[[nodiscard]]
+	std::optional<AdaptiveStepping> const&
+	adaptive_stepping() const noexcept
+		{ return _adaptive_stepping; }
+
+	/**
+	 * Enable adaptive stepping. Pass nullopt to use fixed frame_duration() (the default).
+	 * Note that the adaptation only affects next frames, already evolved frames are never rolled back.
+	 */
+	void
+	set_adaptive_stepping (std::optional<AdaptiveStepping> const&);
+
+	/**
+	 * Return current solver iterations limit set by the adaptive stepping.
+	 */
+	[[nodiscard]]
+	std::optional<std::size_t>
+	max_iterations() const noexcept
+		{ return _max_iterations; }
+
 	/**
 	 * Return integrated simulation time.
 	 * This is the time how far the simulation has actually advanced and because Δt is not infinitely small, the result
@@ -82,6 +165,8 @@ class Evolver
 
 	/**
 	 * Evolve the rigid body system by given simulation time. Multiple evolve() calls will be made on the System.
+	 * With adaptive stepping the last frame is shortened so that the simulation doesn't go past the requested time
+	 * (unless it would be shorter than the minimum frame duration).
 	 */
 	EvolutionResult
 	evolve (si::Time duration);
@@ -101,13 +186,44 @@ class Evolver
 	performance() const noexcept
 		{ return _performance; }
 
+	/**
+	 * Return real time taken by the most recent frames.
+	 */
+	[[nodiscard]]
+	boost::circular_buffer<si::Time> const&
+	frame_times() const noexcept
+		{ return _frame_times; }
+
+  private:
+	/**
+	 * Evolve a single frame and record its real time.
+	 */
+	FrameFeedback
+	evolve_frame (si::Time frame_duration);
+
+	/**
+	 * Adapt Δt and iterations limit after a frame.
+	 *
+	 * \param	projected_real_time
+	 *			Real time that the whole evolve() call will take if the simulation continues at the current speed.
+	 * \param	budget
+	 *			Real time allowed for the whole evolve() call, if any.
+	 */
+	void
+	adapt (FrameFeedback const&, si::Time projected_real_time, std::optional<si::Time> budget);
+
   private:
-	xf::Logger	_logger;
-	si::Time	_frame_duration;
-	Evolve		_evolve;
-	si::Time	_target_time		{ 0_s };
-	si::Time	_simulation_time	{ 0_s };
-	float		_performance		{ 1.0 };
+	xf::Logger							_logger;
+	si::Time							_frame_duration;
+	AdaptiveEvolve						_evolve;
+	si::Time							_target_time				{ 0_s };
+	si::Time							_simulation_time			{ 0_s };
+	float								_performance				{ 1.0 };
+	boost::circular_buffer<si::Time>	_frame_times				{ kMaxFrameTimesBackLog };
+	std::optional<AdaptiveStepping>		_adaptive_stepping;
+	std::optional<std::size_t>			_max_iterations;
+	// Minimum Δt forced by the real-time budget:
+	si::Time							_budget_frame_duration		{ 0_s };
 };
 
 } // namespace xf
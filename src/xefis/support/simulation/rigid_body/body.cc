@@ -45,6 +45,7 @@ Body::set_mass_moments (MassMomentsAtArm<BodyCOM> const& mass_moments)
 	// We want mass moments to be viewed from the center of mass, so translate if necessary
 	// (this should transform the inertia tensor accordingly):
 	_mass_moments = mass_moments.centered_at_center_of_mass();
+	update_world_space_mass_moments();
 
 	// Move the body so that the placement().position() points to the current center of mass:
 	translate<BodyCOM> (com_position);
@@ -62,7 +63,7 @@ Body::rotate_about_center_of_mass (RotationQuaternion<WorldSpace> const& rotatio
 	_velocity_moments = rotation * _velocity_moments;
 	_acceleration_moments = rotation * _acceleration_moments;
 
-	_world_space_applied_impulses.reset();
+	update_rotated_values();
 }
 
 
@@ -73,7 +74,7 @@ Body::rotate_about_world_origin (RotationQuaternion<WorldSpace> const& rotation)
 	_velocity_moments = rotation * _velocity_moments;
 	_acceleration_moments = rotation * _acceleration_moments;
 
-	_world_space_applied_impulses.reset();
+	update_rotated_values();
 }
 
 
@@ -86,7 +87,7 @@ Body::rotate_about_body_origin (RotationQuaternion<WorldSpace> const& rotation)
 	_velocity_moments = rotation * _velocity_moments;
 	_acceleration_moments = rotation * _acceleration_moments;
 
-	_world_space_applied_impulses.reset();
+	update_rotated_values();
 }
 
 
@@ -101,6 +102,16 @@ Body::move_origin_to (SpaceLength<WorldSpace> const& new_origin_position)
 }
 
 
+void
+Body::update_rotated_values()
+{
+	update_world_space_mass_moments();
+	update_body_space_velocity_moments();
+	update_body_space_acceleration_moments();
+	update_world_space_applied_impulses();
+}
+
+
 si::Energy
 Body::translational_kinetic_energy() const
 {
@@ -38,7 +38,6 @@
 #include <cstddef>
 #include <list>
 #include <memory>
-#include <mutex>
 #include <optional>
 #include <string>
 
@@ -47,6 +46,10 @@ namespace xf::rigid_body {
 
 /**
  * Rigid body.
+ *
+ * Transformed variants of body's state (eg. mass moments in WorldSpace) are recalculated
+ * eagerly whenever the state or placement changes, so that const getters are plain reads
+ * and can be used concurrently without any locking.
  */
 class Body: public Noncopyable
 {
@@ -82,15 +85,14 @@ class Body: public Noncopyable
 	 */
 	template<CoordinateSystemConcept Space>
 		[[nodiscard]]
-		MassMoments<Space>
+		MassMoments<Space> const&
 		mass_moments() const;
 
 	/**
 	 * Set new mass moments at center-of-mass.
 	 */
 	void
-	set_mass_moments (MassMoments<BodyCOM> const& mass_moments)
-		{ _mass_moments = mass_moments; }
+	set_mass_moments (MassMoments<BodyCOM> const&);
 
 	/**
 	 * Set new mass moments at center-of-mass.
@@ -110,8 +112,7 @@ class Body: public Noncopyable
 	 * Set new placement of center-of-mass.
 	 */
 	void
-	set_placement (Placement<WorldSpace, BodyCOM> const& placement) noexcept
-		{ _placement = placement; }
+	set_placement (Placement<WorldSpace, BodyCOM> const&);
 
 	/**
 	 * Return placement of origin point (relative to center-of-mass).
@@ -275,8 +276,7 @@ class Body: public Noncopyable
 	 * Rotate the body about given point.
 	 */
 	void
-	rotate_about (SpaceLength<WorldSpace> const& about_point, RotationQuaternion<WorldSpace> const& rotation)
-		{ _placement.rotate_base_frame_about (about_point, rotation); }
+	rotate_about (SpaceLength<WorldSpace> const& about_point, RotationQuaternion<WorldSpace> const&);
 
 	/**
 	 * Translate the body by given vector.
@@ -361,51 +361,90 @@ class Body: public Noncopyable
 	update_external_forces (Atmosphere const*)
 	{ }
 
+  private:
+	/**
+	 * Recalculate all cached values that depend on body's rotation.
+	 * Must be called after each change of _placement's rotation.
+	 */
+	void
+	update_rotated_values();
+
+	void
+	update_world_space_mass_moments()
+		{ _world_space_mass_moments = _placement.unbound_transform_to_base (_mass_moments); }
+
+	void
+	update_body_space_velocity_moments()
+		{ _body_space_velocity_moments = _placement.unbound_transform_to_body (_velocity_moments); }
+
+	void
+	update_body_space_acceleration_moments()
+		{ _body_space_acceleration_moments = _placement.unbound_transform_to_body (_acceleration_moments); }
+
+	void
+	update_world_space_applied_impulses()
+		{ _world_space_applied_impulses = _placement.unbound_transform_to_base (_applied_impulses); }
+
   private:
 	std::string											_label;
 	MassMoments<BodyCOM>								_mass_moments;
-	mutable std::optional<MassMoments<WorldSpace>>		_world_space_mass_moments;
+	MassMoments<WorldSpace>								_world_space_mass_moments;
 	// Location of center-of-mass:
 	Placement<WorldSpace, BodyCOM>						_placement;
 	// Location of origin:
 	Placement<BodyCOM, BodyOrigin>						_origin_placement;
 	// Velocity of center-of-mass:
 	VelocityMoments<WorldSpace>							_velocity_moments;
-	mutable std::optional<VelocityMoments<BodyCOM>>		_body_space_velocity_moments;
+	VelocityMoments<BodyCOM>							_body_space_velocity_moments;
 	// Acceleration moments of center-of-mass:
 	AccelerationMoments<WorldSpace>						_acceleration_moments;
-	mutable std::optional<AccelerationMoments<BodyCOM>>	_body_space_acceleration_moments;
+	AccelerationMoments<BodyCOM>						_body_space_acceleration_moments;
 	AccelerationMoments<BodyCOM>						_body_space_acceleration_moments_except_gravity;
 	// Impulses applied for the duration of the simulation frame:
-	mutable std::optional<ForceMoments<WorldSpace>>		_world_space_applied_impulses;
+	ForceMoments<WorldSpace>							_world_space_applied_impulses;
 	ForceMoments<BodyCOM>								_applied_impulses;
 	// Stuff calculated when simulation is run:
 	BodyIteration										_iteration;
 	// Body shape:
 	std::optional<Shape>								_shape;
 	ShapeType											_shape_type;
-	// Mutex for all those _world_space_* and _body_space_* optionals:
-	mutable std::mutex									_optionals_mutex;
 	// The body is not valid for computation anymore (eg. has NaNs in physical quantities):
 	bool												_broken { false };
 };
 
 
+inline void
+Body::set_mass_moments (MassMoments<BodyCOM> const& mass_moments)
+{
+	_mass_moments = mass_moments;
+	update_world_space_mass_moments();
+}
+
+
+inline void
+Body::set_placement (Placement<WorldSpace, BodyCOM> const& placement)
+{
+	_placement = placement;
+	update_rotated_values();
+}
+
+
+inline void
+Body::rotate_about (SpaceLength<WorldSpace> const& about_point, RotationQuaternion<WorldSpace> const& rotation)
+{
+	_placement.rotate_base_frame_about (about_point, rotation);
+	update_rotated_values();
+}
+
+
 template<CoordinateSystemConcept Space>
-	inline MassMoments<Space>
+	inline MassMoments<Space> const&
 	Body::mass_moments() const
 	{
 		if constexpr (std::is_same_v<Space, BodyCOM>)
 			return _mass_moments;
 		else if constexpr (std::is_same_v<Space, WorldSpace>)
-		{
-			std::lock_guard lock (_optionals_mutex);
-
-			if (!_world_space_mass_moments)
-				_world_space_mass_moments = _placement.unbound_transform_to_base (_mass_moments);
-
-			return *_world_space_mass_moments;
-		}
+			return _world_space_mass_moments;
 		else
 			static_assert (false, "unsupported coordinate system");
 	}
@@ -418,14 +457,7 @@ template<CoordinateSystemConcept Space>
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 			return _velocity_moments;
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
-		{
-			std::lock_guard lock (_optionals_mutex);
-
-			if (!_body_space_velocity_moments)
-				_body_space_velocity_moments = _placement.unbound_transform_to_body (_velocity_moments);
-
-			return *_body_space_velocity_moments;
-		}
+			return _body_space_velocity_moments;
 		else
 			static_assert (false, "unsupported coordinate system");
 	}
@@ -435,14 +467,14 @@ template<CoordinateSystemConcept Space>
 	inline void
 	Body::set_velocity_moments (VelocityMoments<Space> const& velocity_moments)
 	{
-		_body_space_velocity_moments.reset();
-
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 			_velocity_moments = velocity_moments;
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
 			_velocity_moments = _placement.unbound_transform_to_base (velocity_moments);
 		else
 			static_assert (false, "unsupported coordinate system");
+
+		update_body_space_velocity_moments();
 	}
 
 
@@ -453,14 +485,7 @@ template<CoordinateSystemConcept Space>
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 			return _acceleration_moments;
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
-		{
-			std::lock_guard lock (_optionals_mutex);
-
-			if (!_body_space_acceleration_moments)
-				_body_space_acceleration_moments = _placement.unbound_transform_to_body (_acceleration_moments);
-
-			return *_body_space_acceleration_moments;
-		}
+			return _body_space_acceleration_moments;
 		else
 			static_assert (false, "unsupported coordinate system");
 	}
@@ -470,14 +495,14 @@ template<CoordinateSystemConcept Space>
 	inline void
 	Body::set_acceleration_moments (AccelerationMoments<Space> const& acceleration_moments)
 	{
-		_body_space_acceleration_moments.reset();
-
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 			_acceleration_moments = acceleration_moments;
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
 			_acceleration_moments = _placement.unbound_transform_to_base (acceleration_moments);
 		else
 			static_assert (false, "unsupported coordinate system");
+
+		update_body_space_acceleration_moments();
 	}
 
 
@@ -512,14 +537,7 @@ template<CoordinateSystemConcept Space>
 	Body::external_force_moments() const
 	{
 		if constexpr (std::is_same_v<Space, WorldSpace>)
-		{
-			std::lock_guard lock (_optionals_mutex);
-
-			if (!_world_space_applied_impulses)
-				_world_space_applied_impulses = _placement.unbound_transform_to_base (_applied_impulses);
-
-			return *_world_space_applied_impulses;
-		}
+			return _world_space_applied_impulses;
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
 			return _applied_impulses;
 		else
@@ -531,14 +549,14 @@ template<CoordinateSystemConcept Space>
 	inline void
 	Body::apply_impulse (ForceMoments<Space> const& force_moments)
 	{
-		_world_space_applied_impulses.reset();
-
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 			_applied_impulses += _placement.unbound_transform_to_body (force_moments);
 		else if constexpr (std::is_same_v<Space, BodyCOM>)
 			_applied_impulses += force_moments;
 		else
 			static_assert (false, "unsupported coordinate system");
+
+		update_world_space_applied_impulses();
 	}
 
 
@@ -546,8 +564,6 @@ template<CoordinateSystemConcept ForceSpace, CoordinateSystemConcept PositionSpa
 	inline void
 	Body::apply_impulse (ForceMoments<ForceSpace> const& force_moments, SpaceLength<PositionSpace> const& position)
 	{
-		_world_space_applied_impulses.reset();
-
 		ForceMoments<BodyCOM> body_space_force_moments;
 		SpaceLength<BodyCOM> body_space_position;
 
@@ -573,8 +589,6 @@ template<CoordinateSystemConcept Space>
 	inline void
 	Body::apply_impulse (Wrench<Space> const& wrench)
 	{
-		_world_space_applied_impulses.reset();
-
 		if constexpr (std::is_same_v<Space, WorldSpace>)
 		{
 			// The resultant_force() assumes origin as the center of mass, so for Wrenches in WorldSpace coordinates
@@ -586,6 +600,8 @@ template<CoordinateSystemConcept Space>
 			_applied_impulses += resultant_force (wrench);
 		else
 			static_assert (false, "unsupported coordinate system");
+
+		update_world_space_applied_impulses();
 	}
 
 
@@ -593,7 +609,7 @@ inline void
 Body::reset_applied_impulses() noexcept
 {
 	_applied_impulses = ForceMoments<BodyCOM>();
-	_world_space_applied_impulses.reset();
+	_world_space_applied_impulses = ForceMoments<WorldSpace>();
 }
 
 
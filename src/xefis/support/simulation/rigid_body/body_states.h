@@ -0,0 +1,90 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__RIGID_BODY__BODY_STATES_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__RIGID_BODY__BODY_STATES_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/geometry.h>
+#include <xefis/support/math/placement.h>
+#include <xefis/support/nature/force_moments.h>
+#include <xefis/support/nature/velocity_moments.h>
+#include <xefis/support/simulation/rigid_body/concepts.h>
+
+// Standard:
+#include <cstddef>
+#include <vector>
+
+
+namespace xf::rigid_body {
+
+/**
+ * Per-frame state of all bodies of a System used by the solver, stored as a structure
+ * of arrays. Element i of each array refers to the body System::bodies()[i].
+ *
+ * Filled once at the beginning of each frame, so that loops over all bodies (or pairs
+ * of bodies, as in gravity calculations) read contiguous memory instead of calling Body's
+ * getters through the vector of pointers.
+ */
+class BodyStates
+{
+  public:
+	using InverseMass		= SpaceMatrix<si::Mass, WorldSpace>::InverseMatrix;
+	using InverseInertia	= SpaceMatrix<si::MomentOfInertia, WorldSpace>::InverseMatrix;
+
+  public:
+	// Those stay the same during the whole frame:
+	std::vector<si::Mass>							masses;
+	std::vector<SpaceLength<WorldSpace>>			positions;
+	std::vector<InverseMass>						inv_M;
+	std::vector<InverseInertia>						inv_I;
+	std::vector<ForceMoments<WorldSpace>>			gravitational_force_moments;
+
+	// Those get updated at the end of the frame:
+	std::vector<VelocityMoments<WorldSpace>>		velocity_moments;
+	std::vector<Placement<WorldSpace, BodyCOM>>		placements;
+
+  public:
+	/**
+	 * Return number of bodies.
+	 */
+	[[nodiscard]]
+	std::size_t
+	size() const noexcept
+		{ return masses.size(); }
+
+	/**
+	 * Resize all arrays.
+	 */
+	void
+	resize (std::size_t size);
+};
+
+
+inline void
+BodyStates::resize (std::size_t const size)
+{
+	masses.resize (size);
+	positions.resize (size);
+	inv_M.resize (size);
+	inv_I.resize (size);
+	gravitational_force_moments.resize (size);
+	velocity_moments.resize (size);
+	placements.resize (size);
+}
+
+} // namespace xf::rigid_body
+
+#endif
+
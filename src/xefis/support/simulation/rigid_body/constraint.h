@@ -24,8 +24,11 @@
 #include <neutrino/logger.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
+#include <limits>
 #include <optional>
+#include <utility>
 
 
 namespace xf::rigid_body {
@@ -78,6 +81,23 @@ class Constraint: public ConnectedBodies
 	template<std::size_t N>
 		using ConstraintZMatrix = math::SquareMatrix<decltype (1_kg / 1_s), N, WorldSpace, WorldSpace>;
 
+	/**
+	 * Range [Begin, End) of Jacobian rows that can have non-zero values. Other rows are known
+	 * to be zero and get skipped by calculate_jacobian() and calculate_constraint_forces().
+	 */
+	template<std::size_t pBegin, std::size_t pEnd>
+		struct JacobianRows
+		{
+			static constexpr std::size_t kBegin	= pBegin;
+			static constexpr std::size_t kEnd	= pEnd;
+		};
+
+	// All rows of the Jacobian can be non-zero:
+	using AllJacobianRows = JacobianRows<0, std::numeric_limits<std::size_t>::max()>;
+
+	// The Jacobian is a zero matrix:
+	using NoJacobianRows = JacobianRows<0, 0>;
+
   public:
 	// Ctor
 	using ConnectedBodies::ConnectedBodies;
@@ -222,6 +242,28 @@ class Constraint: public ConnectedBodies
 	initialize_step ([[maybe_unused]] si::Time dt)
 	{ }
 
+	/**
+	 * Return true if constraint_forces() returns a correction for current velocities of the bodies,
+	 * which becomes zero once the constraint is satisfied (as with Jacobian-based constraints).
+	 * Return false if it returns the total force to apply regardless of what has already been applied
+	 * (as with springs). Solvers accumulating impulses over iterations need to know the difference.
+	 * Default implementation returns true.
+	 */
+	[[nodiscard]]
+	virtual bool
+	returns_velocity_corrections() const noexcept
+		{ return true; }
+
+	/**
+	 * Clamp constraint forces accumulated by the solver over iterations (and frames, when warm starting)
+	 * to what the constraint can actually apply, eg. maximum torque of a motor or one direction of a limit.
+	 * Solvers that apply only the returned corrections can't otherwise know the constraint's bounds.
+	 * Called after initialize_step(). Default implementation does nothing.
+	 */
+	virtual void
+	clamp_accumulated_forces ([[maybe_unused]] ConstraintForces& accumulated) const
+	{ }
+
 	/**
 	 * Return constraint forces to apply to the two bodies.
 	 *
@@ -267,10 +309,10 @@ class Constraint: public ConnectedBodies
 	/**
 	 * Helper function that calculates actual corrective forces for given Jacobians and location constraints.
 	 *
-	 * \param	ext_forces_1, ext_forces_2
-	 *			External force-moments acting on bodies 1, 2.
+	 * \tparam	VRows, WRows
+	 *			Rows of linear-velocity and angular-velocity Jacobians that can be non-zero.
 	 */
-	template<std::size_t N>
+	template<class VRows = AllJacobianRows, class WRows = AllJacobianRows, std::size_t N>
 		[[nodiscard]]
 		ConstraintForces
 		calculate_constraint_forces (JacobianV<N> const& Jv1,
@@ -281,8 +323,11 @@ class Constraint: public ConnectedBodies
 
 	/**
 	 * Calculates total jacobian (J[i]) for current simulation frame.
+	 *
+	 * \tparam	VRows, WRows
+	 *			Rows of linear-velocity and angular-velocity Jacobians that can be non-zero.
 	 */
-	template<std::size_t N>
+	template<class VRows = AllJacobianRows, class WRows = AllJacobianRows, std::size_t N>
 		[[nodiscard]]
 		Jacobian<N>
 		calculate_jacobian (VelocityMoments<WorldSpace> const& vm_1,
@@ -294,17 +339,8 @@ class Constraint: public ConnectedBodies
 
 	/**
 	 * Calculate lambda (a vector of si::Force).
-	 */
-	template<std::size_t N>
-		[[nodiscard]]
-		Lambda<N>
-		calculate_lambda (LocationConstraint<N> const& location_constraint,
-						  Jacobian<N> const& J,
-						  ConstraintMassMatrix<N> const& K,
-						  si::Time dt) const;
-
-	/**
-	 * Calculate lambda (a vector of si::Force).
+	 * Z should be calculated with calculate_Z() once per simulation step in initialize_step(),
+	 * since it doesn't change between solver iterations.
 	 */
 	template<std::size_t N>
 		[[nodiscard]]
@@ -377,6 +413,25 @@ class Constraint: public ConnectedBodies
 		ConstraintMassMatrix<N>&
 		apply_constraint_mixing_factor (ConstraintMassMatrix<N>&) const;
 
+  private:
+	/**
+	 * Add Jacobian * vector to the result, computing only given rows.
+	 */
+	template<class Rows, class Scalar, class VectorScalar, std::size_t N>
+		static void
+		add_product (Jacobian<N>& result,
+					 math::Matrix<Scalar, 3, N, WorldSpace, WorldSpace> const& jacobian,
+					 SpaceVector<VectorScalar, WorldSpace> const& vector);
+
+	/**
+	 * Return ~Jacobian * lambda, taking into account only given rows of the Jacobian.
+	 */
+	template<class Rows, class Scalar, std::size_t N>
+		[[nodiscard]]
+		static auto
+		transposed_product (math::Matrix<Scalar, 3, N, WorldSpace, WorldSpace> const& jacobian,
+							Lambda<N> const& lambda);
+
   private:
 	std::string						_label;
 	bool							_enabled						{ true };
@@ -421,7 +476,7 @@ Constraint::constraint_forces (VelocityMoments<WorldSpace> const& vm_1, Velocity
 }
 
 
-template<std::size_t N>
+template<class VRows, class WRows, std::size_t N>
 	inline ConstraintForces
 	Constraint::calculate_constraint_forces (JacobianV<N> const& Jv1,
 											 JacobianW<N> const& Jw1,
@@ -429,19 +484,15 @@ template<std::size_t N>
 											 JacobianW<N> const& Jw2,
 											 Lambda<N> const& lambda) const
 	{
-		auto const Fc1 = ~Jv1 * lambda;
-		auto const Tc1 = ~Jw1 * lambda;
-		auto const Fc2 = ~Jv2 * lambda;
-		auto const Tc2 = ~Jw2 * lambda;
-
+		// Unfolded ~J * lambda, to avoid transposing Jacobians and multiplying zero rows:
 		return {
-			ForceMoments<WorldSpace> (Fc1, Tc1),
-			ForceMoments<WorldSpace> (Fc2, Tc2),
+			ForceMoments<WorldSpace> (transposed_product<VRows> (Jv1, lambda), transposed_product<WRows> (Jw1, lambda)),
+			ForceMoments<WorldSpace> (transposed_product<VRows> (Jv2, lambda), transposed_product<WRows> (Jw2, lambda)),
 		};
 	}
 
 
-template<std::size_t N>
+template<class VRows, class WRows, std::size_t N>
 	inline Constraint::Jacobian<N>
 	Constraint::calculate_jacobian (VelocityMoments<WorldSpace> const& vm_1,
 									JacobianV<N> const& Jv1,
@@ -456,28 +507,16 @@ template<std::size_t N>
 		auto const& b2_iter = body_2().iteration();
 
 		// Total jacobian: J * (v + Δt * a)
-		auto const J = Jv1 * (vm_1.velocity() + b1_iter.external_impulses_over_mass)
-					 + Jw1 * (vm_1.angular_velocity() * inv_radian + b1_iter.external_angular_impulses_over_inertia_tensor)
-					 + Jv2 * (vm_2.velocity() + b2_iter.external_impulses_over_mass)
-					 + Jw2 * (vm_2.angular_velocity() * inv_radian + b2_iter.external_angular_impulses_over_inertia_tensor);
+		Jacobian<N> J { math::zero };
+		add_product<VRows> (J, Jv1, vm_1.velocity() + b1_iter.external_impulses_over_mass);
+		add_product<WRows> (J, Jw1, vm_1.angular_velocity() * inv_radian + b1_iter.external_angular_impulses_over_inertia_tensor);
+		add_product<VRows> (J, Jv2, vm_2.velocity() + b2_iter.external_impulses_over_mass);
+		add_product<WRows> (J, Jw2, vm_2.angular_velocity() * inv_radian + b2_iter.external_angular_impulses_over_inertia_tensor);
 
 		return J;
 	}
 
 
-template<std::size_t N>
-	inline Constraint::Lambda<N>
-	Constraint::calculate_lambda (LocationConstraint<N> const& location_constraint,
-								  Jacobian<N> const& J,
-								  ConstraintMassMatrix<N> const& K,
-								  si::Time const dt) const
-	{
-		auto const inv_dt = 1 / dt;
-		auto const stabilization_bias = baumgarte_factor() * inv_dt * location_constraint;
-		return -inv_dt * inv (K) * (J + stabilization_bias);
-	}
-
-
 template<std::size_t N>
 	inline Constraint::Lambda<N>
 	Constraint::calculate_lambda (LocationConstraint<N> const& location_constraint,
@@ -558,6 +597,35 @@ template<std::size_t N>
 	}
 
 
+template<class Rows, class Scalar, class VectorScalar, std::size_t N>
+	inline void
+	Constraint::add_product (Jacobian<N>& result,
+							 math::Matrix<Scalar, 3, N, WorldSpace, WorldSpace> const& jacobian,
+							 SpaceVector<VectorScalar, WorldSpace> const& vector)
+	{
+		constexpr auto end = std::min (Rows::kEnd, N);
+
+		for (std::size_t r = Rows::kBegin; r < end; ++r)
+			result[r] += jacobian[0, r] * vector[0] + jacobian[1, r] * vector[1] + jacobian[2, r] * vector[2];
+	}
+
+
+template<class Rows, class Scalar, std::size_t N>
+	inline auto
+	Constraint::transposed_product (math::Matrix<Scalar, 3, N, WorldSpace, WorldSpace> const& jacobian,
+									Lambda<N> const& lambda)
+	{
+		constexpr auto end = std::min (Rows::kEnd, N);
+		SpaceVector<decltype (std::declval<Scalar>() * std::declval<si::Force>()), WorldSpace> result { math::zero };
+
+		for (std::size_t r = Rows::kBegin; r < end; ++r)
+			for (std::size_t c = 0; c < 3; ++c)
+				result[c] += jacobian[c, r] * lambda[r];
+
+		return result;
+	}
+
+
 /*
  * Global functions
  */
@@ -0,0 +1,311 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "gravity_models.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/constants.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+
+
+namespace xf::rigid_body {
+namespace {
+
+/**
+ * Return gravitational force acting on body 1 caused by body 2.
+ */
+SpaceVector<si::Force, WorldSpace>
+gravitational_force (si::Mass const m1, SpaceLength<WorldSpace> const& c1, si::Mass const m2, SpaceLength<WorldSpace> const& c2)
+{
+	// For very short distances simulation will be inaccurate due to quantized time, and will result
+	// in one of bodies attaining unrealistically huge velocities.
+	// Calculate minimum allowed distance between bodies to make simulation more realistic.
+	// Those values are quite arbitrarily chosen.
+	constexpr auto zero_distance = 1e-15_m;
+	constexpr auto minimum_distance = 1e-9_m;
+
+	auto const r_unsafe = c2 - c1;
+	auto const r_unsafe_abs = abs (r_unsafe);
+	auto const r =
+		r_unsafe_abs < minimum_distance
+			? r_unsafe_abs < zero_distance
+				? SpaceLength<WorldSpace> { minimum_distance, 0_m, 0_m }
+				: r_unsafe.normalized() * minimum_distance / 1_m
+			: r_unsafe;
+	auto const r_abs = abs (r);
+
+	return kGravitationalConstant * m1 * m2 * r / (r_abs * r_abs * r_abs);
+}
+
+
+void
+add_pairwise_forces_between (std::vector<std::size_t> const& gravitating, BodyStates& states)
+{
+	for (std::size_t g1 = 0; g1 < gravitating.size(); ++g1)
+	{
+		for (std::size_t g2 = g1 + 1; g2 < gravitating.size(); ++g2)
+		{
+			auto const i1 = gravitating[g1];
+			auto const i2 = gravitating[g2];
+			auto const force = gravitational_force (states.masses[i1], states.positions[i1], states.masses[i2], states.positions[i2]);
+
+			states.gravitational_force_moments[i1] += ForceMoments<WorldSpace> { +force, math::zero };
+			states.gravitational_force_moments[i2] += ForceMoments<WorldSpace> { -force, math::zero };
+		}
+	}
+}
+
+} // namespace
+
+
+void
+PairwiseGravity::update_gravitational_forces (System const& system, BodyStates& states)
+{
+	auto const& gravitating = system.gravitating_body_indices();
+
+	// Gravity interactions between gravitating bodies:
+	add_pairwise_forces_between (gravitating, states);
+
+	// Gravity interactions between gravitating bodies and the rest:
+	for (auto const i1: gravitating)
+	{
+		for (auto const i2: system.non_gravitating_body_indices())
+		{
+			auto const force = gravitational_force (states.masses[i1], states.positions[i1], states.masses[i2], states.positions[i2]);
+
+			states.gravitational_force_moments[i1] += ForceMoments<WorldSpace> { +force, math::zero };
+			states.gravitational_force_moments[i2] += ForceMoments<WorldSpace> { -force, math::zero };
+		}
+	}
+}
+
+
+BarnesHutGravity::BarnesHutGravity (double const opening_angle):
+	_opening_angle (opening_angle)
+{ }
+
+
+void
+BarnesHutGravity::update_gravitational_forces (System const& system, BodyStates& states)
+{
+	if (system.gravitating_body_indices().empty())
+		return;
+
+	build_octree (system, states);
+
+	for (std::size_t i = 0; i < states.size(); ++i)
+		states.gravitational_force_moments[i] += ForceMoments<WorldSpace> { force_on (states, i), math::zero };
+}
+
+
+void
+BarnesHutGravity::build_octree (System const& system, BodyStates const& states)
+{
+	auto const& gravitating = system.gravitating_body_indices();
+	auto min = states.positions[gravitating.front()];
+	auto max = min;
+
+	for (auto const i: gravitating)
+	{
+		for (std::size_t k = 0; k < 3; ++k)
+		{
+			min[k] = std::min (min[k], states.positions[i][k]);
+			max[k] = std::max (max[k], states.positions[i][k]);
+		}
+	}
+
+	auto const extents = max - min;
+	auto const size = std::max ({ extents[0], extents[1], extents[2], 1_m });
+
+	_nodes.clear();
+	_nodes.push_back (Node {
+		.center = 0.5 * (min + max),
+		// Make it slightly larger so that no body lies exactly on the boundary:
+		.half_size = 0.5 * 1.001 * size,
+	});
+	_next_body.assign (states.size(), kNone);
+
+	for (auto const i: gravitating)
+		insert (states, i);
+}
+
+
+void
+BarnesHutGravity::insert (BodyStates const& states, std::size_t const body_index)
+{
+	auto const& position = states.positions[body_index];
+	auto const mass = states.masses[body_index];
+
+	auto const octant_of = [&states] (Node const& node, std::size_t const index) {
+		auto const& p = states.positions[index];
+		return (p[0] >= node.center[0] ? 1u : 0u)
+			 | (p[1] >= node.center[1] ? 2u : 0u)
+			 | (p[2] >= node.center[2] ? 4u : 0u);
+	};
+
+	uint32_t node_index = 0;
+
+	for (std::size_t depth = 0; ; ++depth)
+	{
+		{
+			auto& node = _nodes[node_index];
+			node.mass += mass;
+			node.mass_weighted_position += mass * position;
+
+			if (node.leaf)
+			{
+				// Empty leaf or too deep to split further:
+				if (node.first_body == kNone || depth >= kMaxDepth)
+				{
+					_next_body[body_index] = node.first_body;
+					node.first_body = static_cast<uint32_t> (body_index + 1);
+					return;
+				}
+			}
+		}
+
+		if (_nodes[node_index].leaf)
+		{
+			// Split: move the body that's already there into a new child leaf:
+			auto const existing_body = _nodes[node_index].first_body - 1;
+			auto const child_index = make_child (node_index, octant_of (_nodes[node_index], existing_body));
+			auto& child = _nodes[child_index];
+			child.mass = states.masses[existing_body];
+			child.mass_weighted_position = child.mass * states.positions[existing_body];
+			child.first_body = existing_body + 1;
+			_nodes[node_index].first_body = kNone;
+			_nodes[node_index].leaf = false;
+		}
+
+		auto const octant = octant_of (_nodes[node_index], body_index);
+		auto child_index = _nodes[node_index].children[octant];
+
+		if (child_index == kNone)
+			child_index = make_child (node_index, octant);
+
+		node_index = child_index;
+	}
+}
+
+
+uint32_t
+BarnesHutGravity::make_child (uint32_t const parent_index, std::size_t const octant)
+{
+	auto const& parent = _nodes[parent_index];
+	auto const quarter = 0.5 * parent.half_size;
+	auto const offset = SpaceLength<WorldSpace> {
+		(octant & 1u) ? +quarter : -quarter,
+		(octant & 2u) ? +quarter : -quarter,
+		(octant & 4u) ? +quarter : -quarter,
+	};
+	auto const child_index = static_cast<uint32_t> (_nodes.size());
+	auto const child = Node {
+		.center = parent.center + offset,
+		.half_size = quarter,
+	};
+
+	// Might invalidate the parent reference:
+	_nodes.push_back (child);
+	_nodes[parent_index].children[octant] = child_index;
+
+	return child_index;
+}
+
+
+SpaceVector<si::Force, WorldSpace>
+BarnesHutGravity::force_on (BodyStates const& states, std::size_t const body_index)
+{
+	auto const mass = states.masses[body_index];
+	auto const& position = states.positions[body_index];
+	SpaceVector<si::Force, WorldSpace> force { math::zero };
+
+	_stack.clear();
+	_stack.push_back (0);
+
+	while (!_stack.empty())
+	{
+		auto const& node = _nodes[_stack.back()];
+		_stack.pop_back();
+
+		if (node.leaf)
+		{
+			for (auto b = node.first_body; b != kNone; b = _next_body[b - 1])
+				if (b - 1 != body_index)
+					force += gravitational_force (mass, position, states.masses[b - 1], states.positions[b - 1]);
+		}
+		else
+		{
+			auto const contains_body = abs (position[0] - node.center[0]) <= node.half_size
+									&& abs (position[1] - node.center[1]) <= node.half_size
+									&& abs (position[2] - node.center[2]) <= node.half_size;
+			auto const center_of_mass = node.mass_weighted_position / node.mass;
+			auto const distance = abs (center_of_mass - position);
+
+			// Node can't be approximated if the body itself might be inside of it:
+			if (!contains_body && 2.0 * node.half_size < _opening_angle * distance)
+				force += gravitational_force (mass, position, node.mass, center_of_mass);
+			else
+				for (auto const child_index: node.children)
+					if (child_index != kNone)
+						_stack.push_back (child_index);
+		}
+	}
+
+	return force;
+}
+
+
+void
+UniformFieldGravity::update_gravitational_forces (System const& system, BodyStates& states)
+{
+	auto const& gravitating = system.gravitating_body_indices();
+	auto const& non_gravitating = system.non_gravitating_body_indices();
+
+	add_pairwise_forces_between (gravitating, states);
+
+	// Total mass and center of mass of non-gravitating bodies:
+	si::Mass total_mass = 0_kg;
+	SpaceVector<decltype (1_kg * 1_m), WorldSpace> mass_weighted_position { math::zero };
+
+	for (auto const i: non_gravitating)
+	{
+		total_mass += states.masses[i];
+		mass_weighted_position += states.masses[i] * states.positions[i];
+	}
+
+	if (total_mass == 0_kg)
+		return;
+
+	auto const center_of_mass = mass_weighted_position / total_mass;
+	SpaceVector<si::Force, WorldSpace> total_force { math::zero };
+
+	for (auto const i: gravitating)
+	{
+		auto const force = gravitational_force (total_mass, center_of_mass, states.masses[i], states.positions[i]);
+		total_force += force;
+		states.gravitational_force_moments[i] += ForceMoments<WorldSpace> { -force, math::zero };
+	}
+
+	auto const field = total_force / total_mass;
+
+	for (auto const i: non_gravitating)
+		states.gravitational_force_moments[i] += ForceMoments<WorldSpace> { states.masses[i] * field, math::zero };
+}
+
+} // namespace xf::rigid_body
+
@@ -0,0 +1,158 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__RIGID_BODY__GRAVITY_MODELS_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__RIGID_BODY__GRAVITY_MODELS_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/geometry.h>
+#include <xefis/support/simulation/rigid_body/body_states.h>
+#include <xefis/support/simulation/rigid_body/concepts.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Standard:
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace xf::rigid_body {
+
+/**
+ * Method of calculating gravitational forces between bodies of a System.
+ */
+class GravityModel
+{
+  public:
+	// Dtor
+	virtual
+	~GravityModel() = default;
+
+	/**
+	 * Add gravitational forces to BodyStates::gravitational_force_moments.
+	 * Masses and positions in BodyStates are already up to date for the frame.
+	 */
+	virtual void
+	update_gravitational_forces (System const&, BodyStates&) = 0;
+};
+
+
+/**
+ * Exact O(n²) calculation. Each gravitating body attracts all other bodies
+ * and is attracted back by them.
+ */
+class PairwiseGravity: public GravityModel
+{
+  public:
+	// GravityModel API
+	void
+	update_gravitational_forces (System const&, BodyStates&) override;
+};
+
+
+/**
+ * Barnes–Hut approximation, O(n log n).
+ *
+ * Gravitating bodies are put into an octree. Forces acting on each body are calculated
+ * by walking the tree and treating whole octree nodes as point masses, if the node is seen
+ * at a small enough angle: node_size / distance < opening_angle. Opening angle 0 gives
+ * exact results, 0.5 is usually a good compromise.
+ *
+ * Non-gravitating bodies are attracted by gravitating ones, but unlike with PairwiseGravity
+ * they don't attract gravitating bodies back.
+ */
+class BarnesHutGravity: public GravityModel
+{
+	static constexpr uint32_t	kNone		= 0;
+	// Bodies closer to each other than octree size / 2^kMaxDepth end up in the same leaf:
+	static constexpr std::size_t kMaxDepth	= 48;
+
+	class Node
+	{
+	  public:
+		SpaceLength<WorldSpace>								center;
+		si::Length											half_size;
+		si::Mass											mass					{ 0_kg };
+		SpaceVector<decltype (1_kg * 1_m), WorldSpace>		mass_weighted_position	{ math::zero };
+		std::array<uint32_t, 8>								children				{};
+		// First body of the leaf node, as index + 1 (kNone if there are no bodies):
+		uint32_t											first_body				{ kNone };
+		bool												leaf					{ true };
+	};
+
+  public:
+	// Ctor
+	explicit
+	BarnesHutGravity (double opening_angle = 0.5);
+
+	/**
+	 * Return the opening angle.
+	 */
+	[[nodiscard]]
+	double
+	opening_angle() const noexcept
+		{ return _opening_angle; }
+
+	// GravityModel API
+	void
+	update_gravitational_forces (System const&, BodyStates&) override;
+
+  private:
+	void
+	build_octree (System const&, BodyStates const&);
+
+	void
+	insert (BodyStates const&, std::size_t body_index);
+
+	[[nodiscard]]
+	uint32_t
+	make_child (uint32_t parent_index, std::size_t octant);
+
+	/**
+	 * Return gravitational force acting on the body.
+	 */
+	[[nodiscard]]
+	SpaceVector<si::Force, WorldSpace>
+	force_on (BodyStates const&, std::size_t body_index);
+
+  private:
+	double					_opening_angle;
+	// _nodes[0] is the root:
+	std::vector<Node>		_nodes;
+	// Next body in the same leaf, as index + 1, for each body:
+	std::vector<uint32_t>	_next_body;
+	std::vector<uint32_t>	_stack;
+};
+
+
+/**
+ * Approximation for the common case of a planet (or a few of them) and lots of small bodies
+ * close to each other. Gravitating bodies attract each other exactly as in PairwiseGravity,
+ * but for non-gravitating bodies the gravitational acceleration is calculated only once at
+ * their center of mass and applied to all of them. The error grows with the spread of the
+ * bodies relative to the distance from the gravitating bodies.
+ */
+class UniformFieldGravity: public GravityModel
+{
+  public:
+	// GravityModel API
+	void
+	update_gravitational_forces (System const&, BodyStates&) override;
+};
+
+} // namespace xf::rigid_body
+
+#endif
+
@@ -19,11 +19,11 @@
 #include <xefis/support/nature/constants.h>
 #include <xefis/support/nature/mass_moments.h>
 
-// Lib:
-#include <boost/range/adaptors.hpp>
-
 // Standard:
+#include <algorithm>
 #include <cstddef>
+#include <exception>
+#include <future>
 
 
 namespace xf::rigid_body {
@@ -48,13 +48,11 @@ EvolutionDetails
 ImpulseSolver::evolve (si::Time const dt)
 {
 	// Reset required parts of frame cache and initialize starting points:
-	for (auto& body: _system.bodies())
-		body->iteration().reset (body->velocity_moments<WorldSpace>());
+	update_body_states();
 
 	for (auto& frame_precalculation: _system.frame_precalculations())
 		frame_precalculation->reset();
 
-	update_mass_moments();
 	update_forces (dt);
 	auto const details = update_constraint_forces (dt);
 	update_acceleration_moments();
@@ -72,68 +70,38 @@ ImpulseSolver::evolve (si::Time const dt)
 
 
 void
-ImpulseSolver::update_mass_moments()
+ImpulseSolver::update_body_states()
 {
-	for (auto& body: _system.bodies())
-	{
-		auto& iter = body->iteration();
-		auto const mass_moments = body->mass_moments<WorldSpace>();
-		iter.inv_M = SpaceMatrix<decltype (1.0 / 1_kg), WorldSpace>::equal_diagonal (1.0 / mass_moments.mass());
-		iter.inv_I = mass_moments.inverse_inertia_tensor();
-	}
-}
+	auto const& bodies = _system.bodies();
+	auto& states = _system.body_states();
 
+	states.resize (bodies.size());
 
-void
-ImpulseSolver::update_gravitational_forces (Body& b1, Body& b2)
-{
-	auto const m1 = b1.mass_moments<BodyCOM>().mass();
-	auto const m2 = b2.mass_moments<BodyCOM>().mass();
-	auto const c1 = b1.placement().position();
-	auto const c2 = b2.placement().position();
-
-	// For very short distances simulation will be inaccurate due to quantized time, and will result
-	// in one of bodies attaining unrealistically huge velocities.
-	// Calculate minimum allowed distance between bodies to make simulation more realistic.
-	// Those values are quite arbitrarily chosen.
-	constexpr auto zero_distance = 1e-15_m;
-	constexpr auto minimum_distance = 1e-9_m;
-
-	auto const r_unsafe = c2 - c1;
-	auto const r_unsafe_abs = abs (r_unsafe);
-	auto const r =
-		r_unsafe_abs < minimum_distance
-			? r_unsafe_abs < zero_distance
-				? SpaceLength<WorldSpace> { minimum_distance, 0_m, 0_m }
-				: r_unsafe.normalized() * minimum_distance / 1_m
-			: r_unsafe;
-	auto const r_abs = abs (r);
-	auto const gravitational_force = kGravitationalConstant * m1 * m2 * r / (r_abs * r_abs * r_abs);
-
-	b1.iteration().gravitational_force_moments += ForceMoments<WorldSpace> { +gravitational_force, math::zero };
-	b2.iteration().gravitational_force_moments += ForceMoments<WorldSpace> { -gravitational_force, math::zero };
+	for (std::size_t i = 0; i < bodies.size(); ++i)
+	{
+		auto& body = *bodies[i];
+		auto& iter = body.iteration();
+		auto const& mass_moments = body.mass_moments<WorldSpace>();
+
+		states.masses[i] = mass_moments.mass();
+		states.positions[i] = body.placement().position();
+		states.placements[i] = body.placement();
+		states.velocity_moments[i] = body.velocity_moments<WorldSpace>();
+		states.inv_M[i] = SpaceMatrix<decltype (1.0 / 1_kg), WorldSpace>::equal_diagonal (1.0 / mass_moments.mass());
+		states.inv_I[i] = mass_moments.inverse_inertia_tensor();
+		states.gravitational_force_moments[i] = {};
+
+		iter.reset (states.velocity_moments[i]);
+		iter.inv_M = states.inv_M[i];
+		iter.inv_I = states.inv_I[i];
+	}
 }
 
 
 void
 ImpulseSolver::update_gravitational_forces()
 {
-	for (auto& body: _system.bodies())
-		body->iteration().gravitational_force_moments = {};
-
-	auto const& gravitating_bodies = _system.gravitating_bodies();
-	auto const& non_gravitating_bodies = _system.non_gravitating_bodies();
-
-	// Gravity interactions between gravitating bodies:
-	if (gravitating_bodies.size() > 1)
-		for (auto i1: gravitating_bodies | boost::adaptors::indexed())
-			for (auto i2: gravitating_bodies | boost::adaptors::sliced (neutrino::to_unsigned (i1.index()) + 1u, _system.bodies().size()))
-				update_gravitational_forces (*i1.value(), *i2);
-
-	// Gravity interactions between gravitating bodies and the rest:
-	for (auto& b1: gravitating_bodies)
-		for (auto& b2: non_gravitating_bodies)
-			update_gravitational_forces (*b1, *b2);
+	_gravity_model->update_gravitational_forces (_system, _system.body_states());
 }
 
 
@@ -141,18 +109,22 @@ void
 ImpulseSolver::update_external_forces (si::Time const dt)
 {
 	auto const& atmosphere = _system.atmosphere();
+	auto const& bodies = _system.bodies();
+	auto const& states = _system.body_states();
 
-	for (auto& body: _system.bodies())
+	for (auto& body: bodies)
 		body->update_external_forces (atmosphere);
 
-	for (auto& body: _system.bodies())
+	for (std::size_t i = 0; i < bodies.size(); ++i)
 	{
-		auto& iter = body->iteration();
-		iter.external_force_moments_except_gravity = body->external_force_moments<WorldSpace>();
+		auto& body = *bodies[i];
+		auto& iter = body.iteration();
+		iter.gravitational_force_moments = states.gravitational_force_moments[i];
+		iter.external_force_moments_except_gravity = body.external_force_moments<WorldSpace>();
 		iter.external_force_moments = iter.gravitational_force_moments + iter.external_force_moments_except_gravity;
-		iter.external_impulses_over_mass = dt * iter.inv_M * iter.external_force_moments.force();
-		iter.external_angular_impulses_over_inertia_tensor = dt * iter.inv_I * iter.external_force_moments.torque();
-		body->reset_applied_impulses();
+		iter.external_impulses_over_mass = dt * states.inv_M[i] * iter.external_force_moments.force();
+		iter.external_angular_impulses_over_inertia_tensor = dt * states.inv_I[i] * iter.external_force_moments.torque();
+		body.reset_applied_impulses();
 	}
 }
 
@@ -168,9 +140,6 @@ ImpulseSolver::update_forces (si::Time const dt)
 EvolutionDetails
 ImpulseSolver::update_constraint_forces (si::Time const dt)
 {
-	bool precise_enough = false;
-	size_t iteration = 0;
-
 	if (!_warm_starting)
 		for (auto const& constraint: _system.constraints())
 			constraint->previous_calculation_force_moments().reset();
@@ -178,6 +147,32 @@ ImpulseSolver::update_constraint_forces (si::Time const dt)
 	for (auto const& constraint: _system.constraints())
 		constraint->initialize_step (dt);
 
+	auto const details = _work_performer
+		? update_constraint_forces_in_parallel (dt)
+		: update_constraint_forces_serially (dt);
+
+	// Update acceleration moments except gravity (used by eg. acceleration sensors):
+	for (auto& body: _system.bodies())
+		body->set_acceleration_moments_except_gravity (calculate_acceleration_moments (body->iteration(), body->iteration().force_moments_except_gravity()));
+
+	// Tell each constraint that we finally calculated its forces:
+	for (auto& constraint: _system.constraints())
+	{
+		// TODO What, these are summed-up all_constraints_force_moments, not individual ones, should be individual though:
+		constraint->calculated_constraint_forces ({ constraint->body_1().iteration().all_constraints_force_moments,
+													constraint->body_2().iteration().all_constraints_force_moments }, dt);
+	}
+
+	return details;
+}
+
+
+EvolutionDetails
+ImpulseSolver::update_constraint_forces_serially (si::Time const dt)
+{
+	bool precise_enough = false;
+	size_t iteration = 0;
+
 	for (iteration = 0; iteration < _max_iterations && !precise_enough; ++iteration)
 	{
 		// Reset constraint forces:
@@ -191,22 +186,142 @@ ImpulseSolver::update_constraint_forces (si::Time const dt)
 				precise_enough = false;
 	}
 
-	// Update acceleration moments except gravity (used by eg. acceleration sensors):
+	return {
+		.iterations_run = iteration,
+		.converged = precise_enough,
+	};
+}
+
+
+EvolutionDetails
+ImpulseSolver::update_constraint_forces_in_parallel (si::Time const dt)
+{
+	// Bodies that don't belong to any island must also have their constraint forces reset:
 	for (auto& body: _system.bodies())
-		body->set_acceleration_moments_except_gravity (calculate_acceleration_moments (body->mass_moments<WorldSpace>(), body->iteration().force_moments_except_gravity()));
+		body->iteration().all_constraints_force_moments = ForceMoments<WorldSpace>();
 
-	// Tell each constraint that we finally calculated its forces:
-	for (auto& constraint: _system.constraints())
+	auto const islands = _solver_islands.update (_system, kMinConstraintsForColoring);
+	auto result = EvolutionDetails { .iterations_run = 0, .converged = true };
+	std::vector<std::future<EvolutionDetails>> island_results;
+	std::exception_ptr exception;
+
+	auto const merge = [&result] (EvolutionDetails const& details) {
+		result.iterations_run = std::max (result.iterations_run, details.iterations_run);
+		result.converged = result.converged && details.converged;
+	};
+
+	for (auto const& island: islands)
+		if (!island.colored)
+			island_results.push_back (_work_performer->submit ([this, &island, dt] { return solve_island (island, dt); }));
+
+	// Colored islands are solved on this thread, which distributes their constraint groups over
+	// the WorkPerformer. Waiting for the groups here, and not in a worker thread, can't deadlock:
+	try {
+		for (auto const& island: islands)
+			if (island.colored)
+				merge (solve_island (island, dt));
+	}
+	catch (...)
 	{
-		// TODO What, these are summed-up all_constraints_force_moments, not individual ones, should be individual though:
-		constraint->calculated_constraint_forces ({ constraint->body_1().iteration().all_constraints_force_moments,
-													constraint->body_2().iteration().all_constraints_force_moments }, dt);
+		exception = std::current_exception();
 	}
 
-    return {
-        .iterations_run = iteration,
-        .converged = precise_enough,
-    };
+	// Tasks refer to islands, so wait for all of them before anything gets thrown:
+	for (auto& future: island_results)
+		future.wait();
+
+	if (exception)
+		std::rethrow_exception (exception);
+
+	for (auto& future: island_results)
+		merge (future.get());
+
+	return result;
+}
+
+
+EvolutionDetails
+ImpulseSolver::solve_island (SolverIsland const& island, si::Time const dt)
+{
+	bool precise_enough = false;
+	size_t iteration = 0;
+
+	for (iteration = 0; iteration < _max_iterations && !precise_enough; ++iteration)
+	{
+		// Reset constraint forces:
+		for (auto* body: island.bodies)
+			body->iteration().all_constraints_force_moments = ForceMoments<WorldSpace>();
+
+		precise_enough = true;
+
+		for (auto const& group: island.color_groups)
+		{
+			auto const group_precise_enough = island.colored
+				? update_constraint_group_forces_in_parallel (group, dt)
+				: update_constraint_group_forces (group, dt);
+
+			if (!group_precise_enough)
+				precise_enough = false;
+		}
+	}
+
+	return {
+		.iterations_run = iteration,
+		.converged = precise_enough,
+	};
+}
+
+
+bool
+ImpulseSolver::update_constraint_group_forces (std::span<Constraint* const> const constraints, si::Time const dt)
+{
+	bool precise_enough = true;
+
+	for (auto* constraint: constraints)
+		if (!update_single_constraint_forces (constraint, dt))
+			precise_enough = false;
+
+	return precise_enough;
+}
+
+
+bool
+ImpulseSolver::update_constraint_group_forces_in_parallel (std::span<Constraint* const> const constraints, si::Time const dt)
+{
+	if (constraints.size() <= kConstraintsPerTask)
+		return update_constraint_group_forces (constraints, dt);
+
+	std::vector<std::future<bool>> chunk_results;
+	bool precise_enough = true;
+
+	// Submit all chunks except the first one, which is solved on this thread:
+	for (size_t start = kConstraintsPerTask; start < constraints.size(); start += kConstraintsPerTask)
+	{
+		auto const chunk = constraints.subspan (start, std::min (kConstraintsPerTask, constraints.size() - start));
+		chunk_results.push_back (_work_performer->submit ([this, chunk, dt] { return update_constraint_group_forces (chunk, dt); }));
+	}
+
+	std::exception_ptr exception;
+
+	try {
+		precise_enough = update_constraint_group_forces (constraints.first (kConstraintsPerTask), dt);
+	}
+	catch (...)
+	{
+		exception = std::current_exception();
+	}
+
+	for (auto& future: chunk_results)
+		future.wait();
+
+	if (exception)
+		std::rethrow_exception (exception);
+
+	for (auto& future: chunk_results)
+		if (!future.get())
+			precise_enough = false;
+
+	return precise_enough;
 }
 
 
@@ -250,8 +365,8 @@ ImpulseSolver::update_single_constraint_forces (Constraint* constraint, si::Time
 			iter2.all_constraints_force_moments += constraint_forces[1];
 
 			// Recalculate accelerations:
-			iter1.acceleration_moments = calculate_acceleration_moments (b1.mass_moments<WorldSpace>(), iter1.all_force_moments());
-			iter2.acceleration_moments = calculate_acceleration_moments (b2.mass_moments<WorldSpace>(), iter2.all_force_moments());
+			iter1.acceleration_moments = calculate_acceleration_moments (iter1, iter1.all_force_moments());
+			iter2.acceleration_moments = calculate_acceleration_moments (iter2, iter2.all_force_moments());
 
 			// Recalculate velocity moments:
 			iter1.velocity_moments = calculate_velocity_moments (b1.velocity_moments<WorldSpace>(), *iter1.acceleration_moments, dt);
@@ -264,10 +379,10 @@ ImpulseSolver::update_single_constraint_forces (Constraint* constraint, si::Time
 
 
 AccelerationMoments<WorldSpace>
-ImpulseSolver::calculate_acceleration_moments (MassMoments<WorldSpace> const& mass_moments, ForceMoments<WorldSpace> const& force_moments)
+ImpulseSolver::calculate_acceleration_moments (BodyIteration const& iter, ForceMoments<WorldSpace> const& force_moments)
 {
 	// TODO why 1_rad is needed here?
-	return AccelerationMoments<WorldSpace> (force_moments.force() / mass_moments.mass(), 1_rad * mass_moments.inverse_inertia_tensor() * force_moments.torque());
+	return AccelerationMoments<WorldSpace> (iter.inv_M * force_moments.force(), 1_rad * iter.inv_I * force_moments.torque());
 }
 
 
@@ -285,7 +400,7 @@ ImpulseSolver::update_acceleration_moments()
 		{
 			auto fm = iter.all_force_moments();
 			apply_limits (fm); // TODO should also be applied during iterations
-			am = calculate_acceleration_moments (body->mass_moments<WorldSpace>(), fm);
+			am = calculate_acceleration_moments (iter, fm);
 		}
 
 		body->set_acceleration_moments<WorldSpace> (am);
@@ -305,13 +420,21 @@ ImpulseSolver::calculate_velocity_moments (VelocityMoments<WorldSpace> vm, Accel
 void
 ImpulseSolver::update_velocity_moments (si::Time const dt)
 {
-	for (auto& body: _system.bodies())
+	auto const& bodies = _system.bodies();
+	auto& states = _system.body_states();
+
+	for (std::size_t i = 0; i < bodies.size(); ++i)
 	{
-		auto vm = body->iteration().velocity_moments_updated
-			? body->iteration().velocity_moments
-			: calculate_velocity_moments (body->velocity_moments<WorldSpace>(), body->acceleration_moments<WorldSpace>(), dt);
+		auto& body = *bodies[i];
+		auto& vm = states.velocity_moments[i];
+
+		if (body.iteration().velocity_moments_updated)
+			vm = body.iteration().velocity_moments;
+		else
+			vm = calculate_velocity_moments (vm, body.acceleration_moments<WorldSpace>(), dt);
+
 		apply_limits (vm);
-		body->set_velocity_moments<WorldSpace> (vm);
+		body.set_velocity_moments<WorldSpace> (vm);
 	}
 }
 
@@ -333,8 +456,14 @@ ImpulseSolver::calculate_placement (Placement<WorldSpace, BodyCOM> placement, Ve
 void
 ImpulseSolver::update_placements (si::Time dt)
 {
-	for (auto& body: _system.bodies())
-		body->set_placement (calculate_placement (body->placement(), body->velocity_moments<WorldSpace>(), dt));
+	auto const& bodies = _system.bodies();
+	auto& states = _system.body_states();
+
+	for (std::size_t i = 0; i < bodies.size(); ++i)
+	{
+		states.placements[i] = calculate_placement (states.placements[i], states.velocity_moments[i], dt);
+		bodies[i]->set_placement (states.placements[i]);
+	}
 }
 
 
@@ -20,19 +20,24 @@
 #include <xefis/support/nature/force_moments.h>
 #include <xefis/support/nature/velocity_moments.h>
 #include <xefis/support/simulation/rigid_body/body.h>
+#include <xefis/support/simulation/rigid_body/body_states.h>
 #include <xefis/support/simulation/rigid_body/concepts.h>
 #include <xefis/support/simulation/rigid_body/constraint.h>
 #include <xefis/support/simulation/rigid_body/frame_precalculation.h>
+#include <xefis/support/simulation/rigid_body/gravity_models.h>
+#include <xefis/support/simulation/rigid_body/solver_islands.h>
 #include <xefis/support/simulation/rigid_body/system.h>
 
 // Neutrino:
 #include <neutrino/noncopyable.h>
 #include <neutrino/sequence.h>
+#include <neutrino/work_performer.h>
 
 // Standard:
 #include <algorithm>
 #include <cstddef>
 #include <memory>
+#include <span>
 #include <type_traits>
 #include <vector>
 
@@ -52,24 +57,52 @@ class Limits
 };
 
 
+/**
+ * Convergence information about a single solver iteration.
+ */
+class IterationResidual
+{
+  public:
+	// Largest change of a constraint force/torque in the iteration:
+	si::Force	force				{ 0_N };
+	si::Torque	torque				{ 0_Nm };
+	// Number of constraints solved in the iteration:
+	size_t		active_constraints	{ 0 };
+};
+
+
 /**
  * Used by ImpulseSolver to give information about each evolution details.
  */
 class EvolutionDetails
 {
   public:
-	size_t	iterations_run	{ 0 };
-	bool	converged		{ false };
+	size_t							iterations_run	{ 0 };
+	bool							converged		{ false };
+	// One entry per iteration run. Filled only by solvers that track residuals (SequentialImpulseSolver):
+	std::vector<IterationResidual>	residuals;
 };
 
 
 /**
  * Simple impulse solver for rigid_body::System.
+ *
+ * Constraints are solved iteratively, Gauss–Seidel style. If a WorkPerformer is set, on each frame
+ * the system is split into islands of bodies connected with constraints, and islands are solved
+ * in parallel, each one until it converges on its own. Constraints of large islands are additionally
+ * colored, so that constraints of the same color, which don't share any body, are solved concurrently.
+ * This changes the order in which constraints are solved, so results differ from the serial solver,
+ * but only within the precision set with set_required_precision().
  */
 class ImpulseSolver: private Noncopyable
 {
 	static constexpr size_t kDefaultMaxIterations { 1000 };
+	// Islands with at least that many constraints get colored and solved with multiple threads:
+	static constexpr size_t kMinConstraintsForColoring { 128 };
+	// Number of constraints of the same color to solve in a single WorkPerformer task:
+	static constexpr size_t kConstraintsPerTask { 32 };
 
+  protected:
 	struct ForceTorque
 	{
 		si::Force	force;
@@ -82,6 +115,10 @@ class ImpulseSolver: private Noncopyable
 	explicit
 	ImpulseSolver (System&, uint32_t max_iterations = kDefaultMaxIterations);
 
+	// Dtor
+	virtual
+	~ImpulseSolver() = default;
+
 	/**
 	 * Set limits applied during evolution.
 	 */
@@ -111,18 +148,79 @@ class ImpulseSolver: private Noncopyable
 	set_warm_starting (bool enabled)
 		{ _warm_starting = enabled; }
 
+	/**
+	 * Use given WorkPerformer to solve constraints in parallel.
+	 * Pass nullptr to solve everything serially on the calling thread (the default).
+	 * The WorkPerformer must outlive the solver or be reset before it's destroyed.
+	 */
+	void
+	set_work_performer (WorkPerformer* work_performer) noexcept
+		{ _work_performer = work_performer; }
+
+	/**
+	 * Set method of calculating gravitational forces.
+	 * By default it's PairwiseGravity.
+	 */
+	void
+	set_gravity_model (std::unique_ptr<GravityModel> gravity_model)
+		{ _gravity_model = std::move (gravity_model); }
+
 	/**
 	 * Evolve the system physically by given Δt.
 	 */
 	EvolutionDetails
 	evolve (si::Time dt);
 
+  protected:
+	[[nodiscard]]
+	System&
+	system() noexcept
+		{ return _system; }
+
+	[[nodiscard]]
+	size_t
+	max_iterations() const noexcept
+		{ return _max_iterations; }
+
+	[[nodiscard]]
+	std::optional<ForceTorque> const&
+	required_force_torque_precision() const noexcept
+		{ return _required_force_torque_precision; }
+
+	[[nodiscard]]
+	bool
+	warm_starting() const noexcept
+		{ return _warm_starting; }
+
+	/**
+	 * Initialize constraints for the step, solve them and set all_constraints_force_moments
+	 * and acceleration_moments of each body's BodyIteration.
+	 */
+	virtual EvolutionDetails
+	update_constraint_forces (si::Time dt);
+
+	[[nodiscard]]
+	static AccelerationMoments<WorldSpace>
+	calculate_acceleration_moments (BodyIteration const&, ForceMoments<WorldSpace> const&);
+
+	[[nodiscard]]
+	static VelocityMoments<WorldSpace>
+	calculate_velocity_moments (VelocityMoments<WorldSpace>, AccelerationMoments<WorldSpace> const&, si::Time dt);
+
+	template<class Space>
+		void
+		apply_limits (ForceMoments<Space>&) const;
+
+	template<class Space>
+		void
+		apply_limits (VelocityMoments<Space>&) const;
+
   private:
+	/**
+	 * Load state of all bodies into System::body_states() and reset body iterations.
+	 */
 	void
-	update_mass_moments();
-
-	static void
-	update_gravitational_forces (Body&, Body&);
+	update_body_states();
 
 	void
 	update_gravitational_forces();
@@ -137,26 +235,43 @@ class ImpulseSolver: private Noncopyable
 	calculate_constants_for_step (si::Time dt);
 
 	EvolutionDetails
-	update_constraint_forces (si::Time dt);
+	update_constraint_forces_serially (si::Time dt);
+
+	EvolutionDetails
+	update_constraint_forces_in_parallel (si::Time dt);
 
 	/**
-	 * Return true if this constraint is solved withing required precision.
+	 * Iterate constraints of the island until they converge.
+	 * If island is colored, constraint groups are solved on the WorkPerformer.
+	 */
+	EvolutionDetails
+	solve_island (SolverIsland const&, si::Time dt);
+
+	/**
+	 * Return true if all constraints are solved within required precision.
 	 */
 	[[nodiscard]]
 	bool
-	update_single_constraint_forces (Constraint*, si::Time dt);
+	update_constraint_group_forces (std::span<Constraint* const>, si::Time dt);
 
+	/**
+	 * Like update_constraint_group_forces(), but split constraints into WorkPerformer tasks.
+	 * Constraints must not share bodies.
+	 */
 	[[nodiscard]]
-	static AccelerationMoments<WorldSpace>
-	calculate_acceleration_moments (MassMoments<WorldSpace> const&, ForceMoments<WorldSpace> const&);
+	bool
+	update_constraint_group_forces_in_parallel (std::span<Constraint* const>, si::Time dt);
+
+	/**
+	 * Return true if this constraint is solved withing required precision.
+	 */
+	[[nodiscard]]
+	bool
+	update_single_constraint_forces (Constraint*, si::Time dt);
 
 	void
 	update_acceleration_moments();
 
-	[[nodiscard]]
-	static VelocityMoments<WorldSpace>
-	calculate_velocity_moments (VelocityMoments<WorldSpace>, AccelerationMoments<WorldSpace> const&, si::Time dt);
-
 	void
 	update_velocity_moments (si::Time dt);
 
@@ -170,21 +285,16 @@ class ImpulseSolver: private Noncopyable
 	void
 	normalize_rotations();
 
-	template<class Space>
-		void
-		apply_limits (ForceMoments<Space>&) const;
-
-	template<class Space>
-		void
-		apply_limits (VelocityMoments<Space>&) const;
-
   private:
-	System&						_system;
-	std::optional<Limits>		_limits;
-	size_t						_max_iterations		{ kDefaultMaxIterations };
-	uint64_t					_processed_frames	{ 0 };
-	std::optional<ForceTorque>	_required_force_torque_precision;
-	bool						_warm_starting		{ true };
+	System&							_system;
+	std::optional<Limits>			_limits;
+	size_t							_max_iterations		{ kDefaultMaxIterations };
+	uint64_t						_processed_frames	{ 0 };
+	std::optional<ForceTorque>		_required_force_torque_precision;
+	bool							_warm_starting		{ true };
+	WorkPerformer*					_work_performer		{ nullptr };
+	std::unique_ptr<GravityModel>	_gravity_model		{ std::make_unique<PairwiseGravity>() };
+	SolverIslands					_solver_islands;
 };
 
 
@@ -0,0 +1,211 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "sequential_impulse_solver.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+
+
+namespace xf::rigid_body {
+namespace {
+
+[[nodiscard]]
+ForceMoments<WorldSpace>
+scaled (ForceMoments<WorldSpace> const& force_moments, double const factor)
+{
+	return ForceMoments<WorldSpace> (factor * force_moments.force(), factor * force_moments.torque());
+}
+
+} // namespace
+
+
+EvolutionDetails
+SequentialImpulseSolver::update_constraint_forces (si::Time const dt)
+{
+	auto const& constraints = system().constraints();
+
+	prepare_constraint_states();
+
+	for (auto const& constraint: constraints)
+		constraint->initialize_step (dt);
+
+	// Body iterations start with velocities from the beginning of the frame. Apply forces remembered
+	// from the previous frame (or zero forces if warm starting is disabled):
+	_active_constraints.clear();
+
+	for (std::size_t i = 0; i < constraints.size(); ++i)
+	{
+		auto& constraint = *constraints[i];
+
+		if (solvable (constraint))
+		{
+			// Forces remembered from the previous frame might be out of bounds now (eg. for a limit that went slack):
+			constraint.clamp_accumulated_forces (_constraint_states[i].forces);
+			apply_force_change (constraint, _constraint_states[i].forces, dt);
+			_active_constraints.push_back (i);
+		}
+	}
+
+	EvolutionDetails details;
+
+	for (details.iterations_run = 0; details.iterations_run < max_iterations() && !_active_constraints.empty(); ++details.iterations_run)
+	{
+		auto& residual = details.residuals.emplace_back (IterationResidual { .active_constraints = _active_constraints.size() });
+		std::size_t still_active = 0;
+
+		for (auto const i: _active_constraints)
+		{
+			auto& constraint = *constraints[i];
+
+			// Might have become broken in this frame:
+			if (!solvable (constraint))
+				continue;
+
+			auto const change = solve (constraint, _constraint_states[i], dt);
+
+			residual.force = std::max ({ residual.force, abs (change[0].force()), abs (change[1].force()) });
+			residual.torque = std::max ({ residual.torque, abs (change[0].torque()), abs (change[1].torque()) });
+
+			if (!converged (change))
+				_active_constraints[still_active++] = i;
+		}
+
+		_active_constraints.resize (still_active);
+	}
+
+	details.converged = _active_constraints.empty();
+
+	// Sum up constraint forces for each body:
+	for (auto& body: system().bodies())
+		body->iteration().all_constraints_force_moments = ForceMoments<WorldSpace>();
+
+	for (std::size_t i = 0; i < constraints.size(); ++i)
+	{
+		auto& constraint = *constraints[i];
+
+		if (solvable (constraint))
+		{
+			auto const& forces = _constraint_states[i].forces;
+			constraint.body_1().iteration().all_constraints_force_moments += forces[0];
+			constraint.body_2().iteration().all_constraints_force_moments += forces[1];
+		}
+	}
+
+	for (auto& body: system().bodies())
+	{
+		auto& iter = body->iteration();
+		iter.acceleration_moments = calculate_acceleration_moments (iter, iter.all_force_moments());
+		// Update acceleration moments except gravity (used by eg. acceleration sensors):
+		body->set_acceleration_moments_except_gravity (calculate_acceleration_moments (iter, iter.force_moments_except_gravity()));
+	}
+
+	// Unlike ImpulseSolver, each constraint gets its own forces:
+	for (std::size_t i = 0; i < constraints.size(); ++i)
+		if (solvable (*constraints[i]))
+			constraints[i]->calculated_constraint_forces (_constraint_states[i].forces, dt);
+
+	return details;
+}
+
+
+void
+SequentialImpulseSolver::prepare_constraint_states()
+{
+	auto const& constraints = system().constraints();
+
+	_constraint_states.resize (constraints.size());
+
+	for (std::size_t i = 0; i < constraints.size(); ++i)
+	{
+		auto& state = _constraint_states[i];
+
+		if (!warm_starting() || state.constraint != constraints[i].get())
+		{
+			state.constraint = constraints[i].get();
+			state.forces = {};
+		}
+	}
+}
+
+
+bool
+SequentialImpulseSolver::solvable (Constraint const& constraint)
+{
+	return constraint.enabled() && !constraint.broken() && !constraint.body_1().broken() && !constraint.body_2().broken();
+}
+
+
+void
+SequentialImpulseSolver::apply_force_change (Constraint& constraint, ConstraintForces const& change, si::Time const dt)
+{
+	auto& iter_1 = constraint.body_1().iteration();
+	auto& iter_2 = constraint.body_2().iteration();
+
+	iter_1.velocity_moments = calculate_velocity_moments (iter_1.velocity_moments, calculate_acceleration_moments (iter_1, change[0]), dt);
+	iter_2.velocity_moments = calculate_velocity_moments (iter_2.velocity_moments, calculate_acceleration_moments (iter_2, change[1]), dt);
+}
+
+
+ConstraintForces
+SequentialImpulseSolver::solve (Constraint& constraint, ConstraintState& state, si::Time const dt)
+{
+	auto const& iter_1 = constraint.body_1().iteration();
+	auto const& iter_2 = constraint.body_2().iteration();
+	auto const forces = constraint.constraint_forces (iter_1.velocity_moments, iter_2.velocity_moments, dt);
+
+	// Velocity-correcting constraints return the change to apply, others return the total force:
+	auto change = constraint.returns_velocity_corrections()
+		? forces
+		: ConstraintForces { forces[0] - state.forces[0], forces[1] - state.forces[1] };
+
+	ConstraintForces accumulated;
+
+	for (std::size_t b = 0; b < change.size(); ++b)
+		accumulated[b] = state.forces[b] + scaled (change[b], _over_relaxation);
+
+	constraint.clamp_accumulated_forces (accumulated);
+
+	for (std::size_t b = 0; b < change.size(); ++b)
+	{
+		apply_limits (accumulated[b]);
+		change[b] = accumulated[b] - state.forces[b];
+		state.forces[b] = accumulated[b];
+	}
+
+	apply_force_change (constraint, change, dt);
+
+	return change;
+}
+
+
+bool
+SequentialImpulseSolver::converged (ConstraintForces const& change) const
+{
+	auto const& precision = required_force_torque_precision();
+
+	if (!precision)
+		return false;
+
+	return std::ranges::all_of (change, [&precision] (ForceMoments<WorldSpace> const& fm) {
+		return abs (fm.force()) <= precision->force && abs (fm.torque()) <= precision->torque;
+	});
+}
+
+} // namespace xf::rigid_body
+
@@ -0,0 +1,121 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SEQUENTIAL_IMPULSE_SOLVER_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SEQUENTIAL_IMPULSE_SOLVER_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/force_moments.h>
+#include <xefis/support/simulation/rigid_body/constraint.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Standard:
+#include <cstddef>
+#include <vector>
+
+
+namespace xf::rigid_body {
+
+/**
+ * Sequential-impulse variant of ImpulseSolver.
+ *
+ * Instead of resetting all constraint forces on each iteration, each constraint accumulates its own
+ * force over iterations and only the change is applied to the velocities of the bodies. Changes are
+ * scaled by the successive over-relaxation factor, and accumulated forces are clamped to the bounds
+ * of each constraint (see Constraint::clamp_accumulated_forces()) and to Limits (if set). A constraint whose change drops below the required precision is considered converged
+ * and is not solved anymore in the remaining iterations of the frame. Without required precision
+ * set, all constraints are solved in all max_iterations() iterations.
+ *
+ * Constraints are always solved serially; set_work_performer() has no effect on this solver.
+ */
+class SequentialImpulseSolver: public ImpulseSolver
+{
+	static constexpr double kDefaultOverRelaxation { 1.0 };
+
+	class ConstraintState
+	{
+	  public:
+		// Used to detect changes in the list of constraints of the System, which invalidate warm starting:
+		Constraint const*	constraint	{ nullptr };
+		ConstraintForces	forces		{};
+	};
+
+  public:
+	using ImpulseSolver::ImpulseSolver;
+
+	/**
+	 * Return the successive over-relaxation factor.
+	 */
+	[[nodiscard]]
+	double
+	over_relaxation() const noexcept
+		{ return _over_relaxation; }
+
+	/**
+	 * Set the successive over-relaxation factor applied to constraint force changes on each iteration.
+	 * 1.0 gives the plain Gauss–Seidel iteration, values in range (1, 2) usually speed up convergence,
+	 * values below 1 slow it down, but might help with stiff systems.
+	 */
+	void
+	set_over_relaxation (double factor) noexcept
+		{ _over_relaxation = factor; }
+
+  protected:
+	// ImpulseSolver API
+	EvolutionDetails
+	update_constraint_forces (si::Time dt) override;
+
+  private:
+	/**
+	 * Resize _constraint_states to match the System, resetting the states of changed constraints.
+	 */
+	void
+	prepare_constraint_states();
+
+	/**
+	 * Return true if constraint can be solved (is enabled and neither it nor its bodies are broken).
+	 */
+	[[nodiscard]]
+	static bool
+	solvable (Constraint const&);
+
+	/**
+	 * Update velocities of the bodies connected with the constraint by the change of constraint forces.
+	 */
+	static void
+	apply_force_change (Constraint&, ConstraintForces const& change, si::Time dt);
+
+	/**
+	 * Solve constraint once, accumulate forces in the state and return the change of forces.
+	 */
+	[[nodiscard]]
+	ConstraintForces
+	solve (Constraint&, ConstraintState&, si::Time dt);
+
+	[[nodiscard]]
+	bool
+	converged (ConstraintForces const& change) const;
+
+  private:
+	double							_over_relaxation	{ kDefaultOverRelaxation };
+	std::vector<ConstraintState>	_constraint_states;
+	// Indices of constraints that haven't converged yet:
+	std::vector<std::size_t>		_active_constraints;
+};
+
+} // namespace xf::rigid_body
+
+#endif
+
@@ -0,0 +1,191 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "solver_islands.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+
+
+namespace xf::rigid_body {
+
+std::size_t
+SolverIsland::constraints_count() const noexcept
+{
+	std::size_t count = 0;
+
+	for (auto const& group: color_groups)
+		count += group.size();
+
+	return count;
+}
+
+
+bool
+is_active (Constraint const& constraint)
+{
+	return constraint.enabled() && !constraint.broken() && !constraint.body_1().broken() && !constraint.body_2().broken();
+}
+
+
+std::span<SolverIsland const>
+SolverIslands::update (System const& system, std::size_t const min_constraints_for_coloring)
+{
+	auto const& bodies = system.bodies();
+
+	index_bodies (system);
+
+	_parents.resize (bodies.size());
+	std::iota (_parents.begin(), _parents.end(), std::size_t (0));
+
+	for (auto const& constraint: system.constraints())
+		if (is_active (*constraint))
+			unite (_body_indices.at (&constraint->body_1()), _body_indices.at (&constraint->body_2()));
+
+	_island_indices.assign (bodies.size(), std::nullopt);
+	std::size_t islands_count = 0;
+
+	for (auto const& constraint: system.constraints())
+	{
+		if (is_active (*constraint))
+		{
+			auto& island_index = _island_indices[find_root (_body_indices.at (&constraint->body_1()))];
+
+			if (!island_index)
+			{
+				island_index = islands_count++;
+
+				// Reuse vectors from previous frames:
+				if (_island_constraints.size() < islands_count)
+					_island_constraints.emplace_back();
+
+				_island_constraints[*island_index].clear();
+			}
+
+			_island_constraints[*island_index].push_back (constraint.get());
+		}
+	}
+
+	// Never shrink, so that vectors of islands that disappear can be reused later:
+	if (_islands.size() < islands_count)
+		_islands.resize (islands_count);
+
+	for (std::size_t i = 0; i < islands_count; ++i)
+	{
+		_islands[i].bodies.clear();
+
+		for (auto& group: _islands[i].color_groups)
+			group.clear();
+	}
+
+	// Bodies, in System order:
+	for (std::size_t i = 0; i < bodies.size(); ++i)
+		if (auto const island_index = _island_indices[find_root (i)])
+			_islands[*island_index].bodies.push_back (bodies[i].get());
+
+	for (std::size_t i = 0; i < islands_count; ++i)
+	{
+		auto& island = _islands[i];
+		island.colored = _island_constraints[i].size() >= min_constraints_for_coloring;
+
+		if (island.colored)
+		{
+			color_constraints (island, _island_constraints[i]);
+
+			// Drop groups of colors no longer used:
+			while (island.color_groups.back().empty())
+				island.color_groups.pop_back();
+		}
+		else
+		{
+			island.color_groups.resize (1);
+			island.color_groups[0].assign (_island_constraints[i].begin(), _island_constraints[i].end());
+		}
+	}
+
+	return std::span (_islands.data(), islands_count);
+}
+
+
+void
+SolverIslands::index_bodies (System const& system)
+{
+	auto const& bodies = system.bodies();
+	auto const unchanged = std::ranges::equal (bodies, _indexed_bodies, {}, [] (auto const& body) { return body.get(); });
+
+	if (!unchanged)
+	{
+		_indexed_bodies.clear();
+		_body_indices.clear();
+
+		for (std::size_t i = 0; i < bodies.size(); ++i)
+		{
+			_indexed_bodies.push_back (bodies[i].get());
+			_body_indices[bodies[i].get()] = i;
+		}
+
+		_used_colors.resize (bodies.size());
+	}
+}
+
+
+std::size_t
+SolverIslands::find_root (std::size_t index)
+{
+	while (_parents[index] != index)
+	{
+		// Path halving:
+		_parents[index] = _parents[_parents[index]];
+		index = _parents[index];
+	}
+
+	return index;
+}
+
+
+void
+SolverIslands::color_constraints (SolverIsland& island, std::vector<Constraint*> const& constraints)
+{
+	auto const is_used = [] (std::vector<std::size_t> const& colors, std::size_t const color) {
+		return std::find (colors.begin(), colors.end(), color) != colors.end();
+	};
+
+	for (auto* body: island.bodies)
+		_used_colors[_body_indices.at (body)].clear();
+
+	for (auto* constraint: constraints)
+	{
+		auto& used_1 = _used_colors[_body_indices.at (&constraint->body_1())];
+		auto& used_2 = _used_colors[_body_indices.at (&constraint->body_2())];
+		std::size_t color = 0;
+
+		while (is_used (used_1, color) || is_used (used_2, color))
+			++color;
+
+		if (color >= island.color_groups.size())
+			island.color_groups.resize (color + 1);
+
+		island.color_groups[color].push_back (constraint);
+		used_1.push_back (color);
+		used_2.push_back (color);
+	}
+}
+
+} // namespace xf::rigid_body
+
@@ -0,0 +1,126 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SOLVER_ISLANDS_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SOLVER_ISLANDS_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/rigid_body/body.h>
+#include <xefis/support/simulation/rigid_body/constraint.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Standard:
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+
+namespace xf::rigid_body {
+
+/**
+ * A set of bodies connected with active constraints. Constraint forces of an island
+ * don't depend on any other island, so islands can be solved independently.
+ */
+class SolverIsland
+{
+  public:
+	std::vector<Body*>						bodies;
+	// Constraints grouped by colors. Constraints of the same color don't share any body,
+	// so they can be solved concurrently. Uncolored islands have exactly one group with
+	// constraints in the order they were added to the System:
+	std::vector<std::vector<Constraint*>>	color_groups;
+	bool									colored			{ false };
+
+  public:
+	/**
+	 * Return total number of constraints in the island.
+	 */
+	[[nodiscard]]
+	std::size_t
+	constraints_count() const noexcept;
+};
+
+
+/**
+ * Return true if constraint takes part in solving: it's enabled, not broken
+ * and connects bodies that are not broken.
+ */
+[[nodiscard]]
+bool
+is_active (Constraint const&);
+
+
+/**
+ * Splits bodies and active constraints of the system into islands.
+ * Working buffers are kept between calls, so that rebuilding islands on every frame
+ * doesn't allocate once the system stops changing.
+ */
+class SolverIslands
+{
+  public:
+	/**
+	 * Split bodies and active constraints of the system into islands.
+	 * Bodies without active constraints don't belong to any island.
+	 * Returned islands are valid until the next call.
+	 *
+	 * \param	min_constraints_for_coloring
+	 *			Islands that have at least that many constraints get their constraints
+	 *			colored with a greedy graph coloring algorithm. Other islands have all
+	 *			constraints in a single group.
+	 */
+	[[nodiscard]]
+	std::span<SolverIsland const>
+	update (System const&, std::size_t min_constraints_for_coloring);
+
+  private:
+	/**
+	 * Rebuild _body_indices if bodies in the system have changed.
+	 */
+	void
+	index_bodies (System const&);
+
+	/**
+	 * Find root of the disjoint-sets forest over body indices.
+	 */
+	[[nodiscard]]
+	std::size_t
+	find_root (std::size_t body_index);
+
+	void
+	unite (std::size_t body_index_a, std::size_t body_index_b)
+		{ _parents[find_root (body_index_b)] = find_root (body_index_a); }
+
+	void
+	color_constraints (SolverIsland&, std::vector<Constraint*> const&);
+
+  private:
+	std::vector<Body const*>						_indexed_bodies;
+	std::unordered_map<Body const*, std::size_t>	_body_indices;
+	std::vector<std::size_t>						_parents;
+	// Island index for each root of the disjoint-sets forest:
+	std::vector<std::optional<std::size_t>>			_island_indices;
+	// Constraints of each island, in System order:
+	std::vector<std::vector<Constraint*>>			_island_constraints;
+	// Colors already used by constraints attached to each body:
+	std::vector<std::vector<std::size_t>>			_used_colors;
+	// May have more elements than there are islands; they're kept for reuse:
+	std::vector<SolverIsland>						_islands;
+};
+
+} // namespace xf::rigid_body
+
+#endif
+
@@ -17,6 +17,7 @@
 // Xefis:
 #include <xefis/config/all.h>
 #include <xefis/support/simulation/rigid_body/body.h>
+#include <xefis/support/simulation/rigid_body/body_states.h>
 #include <xefis/support/simulation/rigid_body/concepts.h>
 #include <xefis/support/simulation/rigid_body/constraint.h>
 #include <xefis/support/simulation/rigid_body/frame_precalculation.h>
@@ -46,6 +47,7 @@ class System: private Noncopyable
 	using Bodies				= std::vector<std::unique_ptr<Body>>;
 	using Constraints			= std::vector<std::unique_ptr<Constraint>>;
 	using BodyPointers			= std::vector<Body*>;
+	using BodyIndices			= std::vector<std::size_t>;
 
   public:
 	// Ctor
@@ -156,6 +158,40 @@ class System: private Noncopyable
 	non_gravitating_bodies() const noexcept
 		{ return _non_gravitating_bodies; }
 
+	/**
+	 * Return indices (in bodies()) of gravitating bodies.
+	 */
+	[[nodiscard]]
+	BodyIndices const&
+	gravitating_body_indices() const noexcept
+		{ return _gravitating_body_indices; }
+
+	/**
+	 * Return indices (in bodies()) of non-gravitating bodies.
+	 */
+	[[nodiscard]]
+	BodyIndices const&
+	non_gravitating_body_indices() const noexcept
+		{ return _non_gravitating_body_indices; }
+
+	/**
+	 * Return per-frame states of all bodies.
+	 * To be used by the simulator.
+	 */
+	[[nodiscard]]
+	BodyStates&
+	body_states() noexcept
+		{ return _body_states; }
+
+	/**
+	 * Return per-frame states of all bodies.
+	 * To be used by the simulator.
+	 */
+	[[nodiscard]]
+	BodyStates const&
+	body_states() const noexcept
+		{ return _body_states; }
+
 	/**
 	 * Return sequence of body constraints.
 	 */
@@ -223,6 +259,10 @@ class System: private Noncopyable
 	// Bodies acting on all bodies gravitationally (contains pointers to elements in _bodies):
 	BodyPointers			_gravitating_bodies;
 	BodyPointers			_non_gravitating_bodies;
+	BodyIndices				_gravitating_body_indices;
+	BodyIndices				_non_gravitating_body_indices;
+	// Stuff calculated when simulation is run:
+	BodyStates				_body_states;
 	Atmosphere const*		_atmosphere { nullptr };
 };
 
@@ -254,6 +294,7 @@ template<BodyConcept SpecificBody>
 	{
 		_bodies.push_back (std::move (body));
 		_non_gravitating_bodies.push_back (_bodies.back().get());
+		_non_gravitating_body_indices.push_back (_bodies.size() - 1);
 		return static_cast<SpecificBody&> (*_bodies.back());
 	}
 
@@ -272,6 +313,7 @@ template<BodyConcept SpecificBody>
 	{
 		_bodies.push_back (std::move (body));
 		_gravitating_bodies.push_back (_bodies.back().get());
+		_gravitating_body_indices.push_back (_bodies.size() - 1);
 		return static_cast<SpecificBody&> (*_bodies.back());
 	}
 
@@ -0,0 +1,115 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SYSTEM_SNAPSHOT_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__RIGID_BODY__SYSTEM_SNAPSHOT_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/math/placement.h>
+#include <xefis/support/nature/acceleration_moments.h>
+#include <xefis/support/nature/force_moments.h>
+#include <xefis/support/nature/velocity_moments.h>
+#include <xefis/support/simulation/rigid_body/body.h>
+#include <xefis/support/simulation/rigid_body/concepts.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Standard:
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace xf::rigid_body {
+
+/**
+ * Dynamic state of a Body at the end of a simulation frame.
+ */
+class BodySnapshot
+{
+  public:
+	Placement<WorldSpace, BodyCOM>		placement;
+	VelocityMoments<WorldSpace>			velocity_moments;
+	AccelerationMoments<WorldSpace>		acceleration_moments;
+	// What an accelerometer would measure:
+	AccelerationMoments<WorldSpace>		acceleration_moments_except_gravity;
+	ForceMoments<WorldSpace>			gravitational_force_moments;
+	ForceMoments<WorldSpace>			external_force_moments;
+	bool								broken	{ false };
+};
+
+
+/**
+ * Dynamic state of all bodies of a System at the end of a simulation frame.
+ * Can be read from other threads while the System is being evolved.
+ *
+ * Only the dynamic state is captured. Things like the list of bodies, their shapes
+ * or mass moments are expected to not change while the snapshots are being used.
+ */
+class SystemSnapshot
+{
+  public:
+	si::Time					simulation_time	{ 0_s };
+	uint64_t					frame_number	{ 0 };
+	// Element i refers to the body System::bodies()[i]:
+	std::vector<BodySnapshot>	bodies;
+
+  public:
+	/**
+	 * Capture the state of all bodies of the System.
+	 * Reuses already allocated memory if possible.
+	 */
+	void
+	capture (System const&, si::Time simulation_time, uint64_t frame_number);
+
+	/**
+	 * Return snapshot of the body with given index or nullptr if there's no such body
+	 * (eg. no snapshot has been captured yet).
+	 */
+	[[nodiscard]]
+	BodySnapshot const*
+	body (std::size_t index) const noexcept
+		{ return index < bodies.size() ? &bodies[index] : nullptr; }
+};
+
+
+inline void
+SystemSnapshot::capture (System const& system, si::Time const simulation_time, uint64_t const frame_number)
+{
+	auto const& system_bodies = system.bodies();
+
+	this->simulation_time = simulation_time;
+	this->frame_number = frame_number;
+	this->bodies.resize (system_bodies.size());
+
+	for (std::size_t i = 0; i < system_bodies.size(); ++i)
+	{
+		auto const& body = *system_bodies[i];
+		auto const& iter = body.iteration();
+
+		this->bodies[i] = BodySnapshot {
+			.placement = body.placement(),
+			.velocity_moments = body.velocity_moments<WorldSpace>(),
+			.acceleration_moments = body.acceleration_moments<WorldSpace>(),
+			.acceleration_moments_except_gravity = body.acceleration_moments_except_gravity<WorldSpace>(),
+			.gravitational_force_moments = iter.gravitational_force_moments,
+			.external_force_moments = iter.external_force_moments,
+			.broken = body.broken(),
+		};
+	}
+}
+
+} // namespace xf::rigid_body
+
+#endif
+
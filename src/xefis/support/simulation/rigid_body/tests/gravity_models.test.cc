@@ -0,0 +1,175 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/constants.h>
+#include <xefis/support/nature/mass_moments.h>
+#include <xefis/support/simulation/rigid_body/gravity_models.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+#include <xefis/support/simulation/rigid_body/utility.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string_view>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+using MakeGravityModel = std::function<std::unique_ptr<rigid_body::GravityModel>()>;
+
+
+/**
+ * Add a cloud of gravitating bodies within a 100 m cube.
+ */
+void
+add_cloud (rigid_body::System& system, std::size_t const count)
+{
+	std::mt19937 generator (1);
+	std::uniform_real_distribution<double> coordinate (-50.0, +50.0);
+	std::uniform_real_distribution<double> mass (1e8, 1e10);
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto& body = system.add_gravitating<rigid_body::Body> (MassMoments<BodyCOM> (1_kg * mass (generator), math::unit));
+		auto const position = SpaceLength<WorldSpace> { 1_m * coordinate (generator), 1_m * coordinate (generator), 1_m * coordinate (generator) };
+		body.set_placement (Placement<WorldSpace, BodyCOM> (position, kNoRotation<WorldSpace, BodyCOM>));
+	}
+}
+
+
+/**
+ * Add Earth and small bodies within 100 m from each other, 1 km above Earth's surface.
+ */
+void
+add_earth_and_small_bodies (rigid_body::System& system, std::size_t const count)
+{
+	system.add_gravitating (rigid_body::make_earth());
+
+	for (std::size_t i = 0; i < count; ++i)
+	{
+		auto const x = 10_m * static_cast<double> (i % 10);
+		auto const y = 10_m * static_cast<double> (i / 10 % 10);
+		auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (1_kg, math::unit));
+		body.set_placement (Placement<WorldSpace, BodyCOM> ({ x, y, kEarthMeanRadius + 1_km }, kNoRotation<WorldSpace, BodyCOM>));
+	}
+}
+
+
+/**
+ * Evolve the system by one frame from rest and return velocities of all bodies,
+ * which are proportional to gravitational accelerations.
+ */
+std::vector<SpaceVector<si::Velocity, WorldSpace>>
+velocities_after_frame (std::function<void (rigid_body::System&)> const& make_system, MakeGravityModel const& make_gravity_model)
+{
+	rigid_body::System system;
+	make_system (system);
+
+	rigid_body::ImpulseSolver solver (system);
+
+	if (make_gravity_model)
+		solver.set_gravity_model (make_gravity_model());
+
+	solver.evolve (1_s);
+
+	std::vector<SpaceVector<si::Velocity, WorldSpace>> result;
+
+	for (auto const& body: system.bodies())
+		result.push_back (body->velocity_moments<WorldSpace>().velocity());
+
+	return result;
+}
+
+
+/**
+ * Verify that velocities given by the gravity model match exact pairwise calculation
+ * within given fraction of the average velocity.
+ */
+void
+verify_model (std::string_view const name,
+			  std::function<void (rigid_body::System&)> const& make_system,
+			  MakeGravityModel const& make_gravity_model,
+			  double const relative_precision)
+{
+	auto const expected = velocities_after_frame (make_system, nullptr);
+	auto const actual = velocities_after_frame (make_system, make_gravity_model);
+	auto average = 0_mps;
+
+	for (auto const& v: expected)
+		average += abs (v) / static_cast<double> (expected.size());
+
+	for (std::size_t i = 0; i < expected.size(); ++i)
+	{
+		test_asserts::verify_equal_with_epsilon (std::format ("{}: body {} has correct acceleration", name, i),
+												 actual[i], expected[i], relative_precision * average);
+	}
+}
+
+
+AutoTest t_1 ("rigid_body::BarnesHutGravity: opening angle 0 gives exact results", []{
+	verify_model ("Barnes–Hut θ=0",
+				  [] (rigid_body::System& system) { add_cloud (system, 200); },
+				  [] { return std::make_unique<rigid_body::BarnesHutGravity> (0.0); },
+				  1e-9);
+});
+
+
+AutoTest t_2 ("rigid_body::BarnesHutGravity: opening angle 0.5 is accurate", []{
+	verify_model ("Barnes–Hut θ=0.5",
+				  [] (rigid_body::System& system) { add_cloud (system, 500); },
+				  [] { return std::make_unique<rigid_body::BarnesHutGravity> (0.5); },
+				  2e-2);
+});
+
+
+AutoTest t_3 ("rigid_body::BarnesHutGravity: coincident bodies", []{
+	rigid_body::System system;
+
+	for (std::size_t i = 0; i < 3; ++i)
+		system.add_gravitating<rigid_body::Body> (MassMoments<BodyCOM> (1e9_kg, math::unit));
+
+	auto& other = system.add_gravitating<rigid_body::Body> (MassMoments<BodyCOM> (1e9_kg, math::unit));
+	other.set_placement (Placement<WorldSpace, BodyCOM> ({ 10_m, 0_m, 0_m }, kNoRotation<WorldSpace, BodyCOM>));
+
+	rigid_body::ImpulseSolver solver (system);
+	solver.set_gravity_model (std::make_unique<rigid_body::BarnesHutGravity>());
+	solver.evolve (1_ms);
+
+	auto const expected_velocity = kGravitationalConstant * 3e9_kg / (10_m * 10_m) * 1_ms;
+	test_asserts::verify_equal_with_epsilon ("other body is attracted by all coincident bodies",
+											 other.velocity_moments<WorldSpace>().velocity()[0], -expected_velocity, 1e-6 * expected_velocity);
+});
+
+
+AutoTest t_4 ("rigid_body::UniformFieldGravity: matches exact calculation for small bodies near Earth", []{
+	// Bodies are spread over ~100 m, so the field direction differs by ~100 m / 6400 km:
+	verify_model ("uniform field",
+				  [] (rigid_body::System& system) { add_earth_and_small_bodies (system, 100); },
+				  [] { return std::make_unique<rigid_body::UniformFieldGravity>(); },
+				  1e-4);
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -0,0 +1,290 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/constants.h>
+#include <xefis/support/nature/mass_moments.h>
+#include <xefis/support/nature/various_inertia_tensors.h>
+#include <xefis/support/simulation/constraints/angular_limits_constraint.h>
+#include <xefis/support/simulation/constraints/angular_spring_constraint.h>
+#include <xefis/support/simulation/constraints/fixed_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_precalculation.h>
+#include <xefis/support/simulation/rigid_body/gravity_models.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/sequential_impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+#include <xefis/support/simulation/rigid_body/utility.h>
+
+// Neutrino:
+#include <neutrino/test/manual_test.h>
+#include <neutrino/time_helper.h>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string_view>
+
+
+namespace xf::test {
+namespace {
+
+constexpr std::size_t kChainLength	= 10;
+constexpr std::size_t kFrames		= 100;
+
+
+/**
+ * Make a system of bodies orbiting Earth, connected into chains with fixed constraints,
+ * evolve it kFrames times and return average time of a single frame.
+ */
+si::Time
+measure_frame_time (std::size_t const bodies_count)
+{
+	rigid_body::System system;
+	rigid_body::ImpulseSolver solver (system, 10);
+	rigid_body::Body* previous = nullptr;
+
+	system.add_gravitating (rigid_body::make_earth());
+
+	for (std::size_t i = 0; i < bodies_count; ++i)
+	{
+		auto const x = 1_m * static_cast<double> (i % kChainLength);
+		auto const y = 2_m * static_cast<double> (i / kChainLength);
+		auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (1_kg, math::unit));
+		body.set_placement (Placement<WorldSpace, BodyCOM> ({ x, y, kEarthMeanRadius + 1_km }, kNoRotation<WorldSpace, BodyCOM>));
+
+		if (previous && i % kChainLength != 0)
+			system.add<rigid_body::FixedConstraint> (*previous, body);
+
+		previous = &body;
+	}
+
+	auto const total = TimeHelper::measure ([&] {
+		for (std::size_t f = 0; f < kFrames; ++f)
+			solver.evolve (1_ms);
+	});
+
+	return total / static_cast<double> (kFrames);
+}
+
+
+/**
+ * Make a system with given number of gravitating and non-gravitating bodies in a grid and
+ * return average time of a single frame with given gravity model.
+ */
+si::Time
+measure_gravity_frame_time (std::size_t const gravitating_count,
+							std::size_t const non_gravitating_count,
+							std::function<std::unique_ptr<rigid_body::GravityModel>()> const& make_gravity_model)
+{
+	constexpr std::size_t kGravityFrames = 10;
+
+	rigid_body::System system;
+	rigid_body::ImpulseSolver solver (system);
+	solver.set_gravity_model (make_gravity_model());
+
+	auto const grid_position = [] (std::size_t const i, si::Length const z) {
+		return SpaceLength<WorldSpace> { 1_m * static_cast<double> (i % 100), 1_m * static_cast<double> (i / 100), z };
+	};
+
+	for (std::size_t i = 0; i < gravitating_count; ++i)
+	{
+		auto& body = system.add_gravitating<rigid_body::Body> (MassMoments<BodyCOM> (1e6_kg, math::unit));
+		body.set_placement (Placement<WorldSpace, BodyCOM> (grid_position (i, 0_m), kNoRotation<WorldSpace, BodyCOM>));
+	}
+
+	for (std::size_t i = 0; i < non_gravitating_count; ++i)
+	{
+		auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (1_kg, math::unit));
+		body.set_placement (Placement<WorldSpace, BodyCOM> (grid_position (i, 1_km), kNoRotation<WorldSpace, BodyCOM>));
+	}
+
+	auto const total = TimeHelper::measure ([&] {
+		for (std::size_t f = 0; f < kGravityFrames; ++f)
+			solver.evolve (1_ms);
+	});
+
+	return total / static_cast<double> (kGravityFrames);
+}
+
+
+/**
+ * Add a glider-like group of bodies (fuselage, wings on torsion springs, winglets, tail and control
+ * surfaces on hinges with angular limits), connected the same way as the sim-1 aircraft model,
+ * 500 m above Earth's surface. Control surfaces start spinning, so that they hit their limits.
+ */
+void
+add_glider (rigid_body::System& system)
+{
+	SpaceLength<WorldSpace> const origin { 0_m, 0_m, kEarthMeanRadius + 0.5_km };
+
+	auto const add_body = [&] (si::Mass const mass, SpaceLength<> const& dimensions, SpaceLength<WorldSpace> const& position) -> rigid_body::Body& {
+		auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (mass, make_cuboid_inertia_tensor<BodyCOM> (mass, dimensions)));
+		body.set_placement (Placement<WorldSpace, BodyCOM> (origin + position, kNoRotation<WorldSpace, BodyCOM>));
+		return body;
+	};
+
+	auto const add_hinge = [&] (rigid_body::Body& body_1, SpaceLength<WorldSpace> const& anchor_1, SpaceLength<WorldSpace> const& anchor_2, rigid_body::Body& body_2)
+		-> rigid_body::HingePrecalculation&
+	{
+		auto& hinge = system.add<rigid_body::HingePrecalculation> (body_1, origin + anchor_1, origin + anchor_2, body_2);
+		system.add<rigid_body::HingeConstraint> (hinge);
+		return hinge;
+	};
+
+	auto const add_spring = [&] (rigid_body::HingePrecalculation& hinge, rigid_body::TorqueForAngle const torque_for_angle) {
+		system.add<rigid_body::AngularSpringConstraint> (hinge, rigid_body::angular_spring_function (torque_for_angle));
+	};
+
+	auto const add_limits = [&] (rigid_body::HingePrecalculation& hinge) {
+		system.add<rigid_body::AngularLimitsConstraint> (hinge, -60_deg, +60_deg);
+	};
+
+	auto& fuselage = add_body (2_kg, { 1_m, 1_m, 1_m }, { +1_m, 0_m, 0_m });
+	auto& wing_l = add_body (0.4_kg, { 0.5_m, 2_m, 2_cm }, { 0_m, -1.1_m, 0_m });
+	auto& wing_r = add_body (0.4_kg, { 0.5_m, 2_m, 2_cm }, { 0_m, +1.1_m, 0_m });
+	auto& winglet_l = add_body (0.05_kg, { 0.5_m, 0.5_m, 2_cm }, { 0_m, -2.35_m, 0_m });
+	auto& winglet_r = add_body (0.05_kg, { 0.5_m, 0.5_m, 2_cm }, { 0_m, +2.35_m, 0_m });
+	auto& aileron_l = add_body (0.05_kg, { 0.2_m, 1.2_m, 2_cm }, { -0.35_m, -1.4_m, 0_m });
+	auto& aileron_r = add_body (0.05_kg, { 0.2_m, 1.2_m, 2_cm }, { -0.35_m, +1.4_m, 0_m });
+	auto& tail_h = add_body (0.1_kg, { 0.2_m, 1_m, 2_cm }, { -2_m, 0_m, 0_m });
+	auto& tail_v = add_body (0.05_kg, { 0.2_m, 2_cm, 0.5_m }, { -2_m, 0_m, 0.25_m });
+	auto& elevator = add_body (0.05_kg, { 0.2_m, 1_m, 2_cm }, { -2.2_m, 0_m, 0_m });
+	auto& rudder = add_body (0.03_kg, { 0.2_m, 2_cm, 0.5_m }, { -2.2_m, 0_m, 0.25_m });
+
+	add_spring (add_hinge (fuselage, { +0.25_m, -0.1_m, 0_m }, { -0.25_m, -0.1_m, 0_m }, wing_l), 30_Nm / 1_deg);
+	add_spring (add_hinge (fuselage, { +0.25_m, +0.1_m, 0_m }, { -0.25_m, +0.1_m, 0_m }, wing_r), 30_Nm / 1_deg);
+	add_spring (add_hinge (wing_l, { +0.25_m, -2.1_m, 0_m }, { -0.25_m, -2.1_m, 0_m }, winglet_l), 10_Nm / 1_deg);
+	add_spring (add_hinge (wing_r, { +0.25_m, +2.1_m, 0_m }, { -0.25_m, +2.1_m, 0_m }, winglet_r), 10_Nm / 1_deg);
+	add_limits (add_hinge (wing_l, { -0.25_m, -0.8_m, 0_m }, { -0.25_m, -2_m, 0_m }, aileron_l));
+	add_limits (add_hinge (wing_r, { -0.25_m, +0.8_m, 0_m }, { -0.25_m, +2_m, 0_m }, aileron_r));
+	add_limits (add_hinge (tail_h, { -2.1_m, -0.5_m, 0_m }, { -2.1_m, +0.5_m, 0_m }, elevator));
+	add_limits (add_hinge (tail_v, { -2.1_m, 0_m, 0_m }, { -2.1_m, 0_m, 0.5_m }, rudder));
+	system.add<rigid_body::FixedConstraint> (fuselage, tail_h);
+	system.add<rigid_body::FixedConstraint> (tail_h, tail_v);
+
+	for (auto* control_surface: { &aileron_l, &aileron_r, &elevator })
+		control_surface->set_velocity_moments (VelocityMoments<WorldSpace> ({ 0_mps, 0_mps, 0_mps }, { 0_radps, 5_radps, 0_radps }));
+
+	rudder.set_velocity_moments (VelocityMoments<WorldSpace> ({ 0_mps, 0_mps, 0_mps }, { 0_radps, 0_radps, 5_radps }));
+}
+
+
+/**
+ * Evolve the glider falling in Earth's gravity with given solver and print average number
+ * of iterations and time per frame.
+ */
+void
+print_glider_stats (std::string_view const name,
+					std::function<std::unique_ptr<rigid_body::ImpulseSolver> (rigid_body::System&)> const& make_solver)
+{
+	constexpr std::size_t kGliderFrames = 1000;
+
+	rigid_body::System system;
+	add_glider (system);
+	system.add_gravitating (rigid_body::make_earth());
+
+	auto solver = make_solver (system);
+	solver->set_required_precision (1_N, 0.1_Nm);
+	std::size_t total_iterations = 0;
+	std::size_t converged_frames = 0;
+
+	auto const total = TimeHelper::measure ([&] {
+		for (std::size_t f = 0; f < kGliderFrames; ++f)
+		{
+			auto const details = solver->evolve (1_ms);
+			total_iterations += details.iterations_run;
+			converged_frames += details.converged ? 1 : 0;
+		}
+	});
+
+	std::cout << std::format ("  {:32} {:7.2f} iterations/frame, {:9.3f} ms/frame, {:4}/{} frames converged\n",
+							  name,
+							  static_cast<double> (total_iterations) / kGliderFrames,
+							  total.in<si::Millisecond>() / kGliderFrames,
+							  converged_frames,
+							  kGliderFrames);
+}
+
+
+void
+print_gravity_frame_time (std::string_view const name, si::Time const frame_time)
+{
+	std::cout << std::format ("  {:32} {:9.3f} ms/frame\n", name, frame_time.in<si::Millisecond>());
+}
+
+
+ManualTest t_1 ("rigid_body::ImpulseSolver: frame time for 10/100/1000 bodies", []{
+	std::cout << std::format ("ImpulseSolver frames (chains of {} bodies, Earth's gravity, {} frames):\n", kChainLength, kFrames);
+
+	for (std::size_t const bodies_count: { 10u, 100u, 1000u })
+	{
+		auto const frame_time = measure_frame_time (bodies_count);
+
+		std::cout << std::format ("  {:4} bodies: {:9.3f} ms/frame, {:7.3f} µs/body\n",
+								  bodies_count,
+								  frame_time.in<si::Millisecond>(),
+								  frame_time.in<si::Second>() * 1e6 / static_cast<double> (bodies_count));
+	}
+});
+
+ManualTest t_2 ("rigid_body::GravityModel: frame time of various gravity models", []{
+	auto const pairwise = [] { return std::make_unique<rigid_body::PairwiseGravity>(); };
+	auto const barnes_hut = [] { return std::make_unique<rigid_body::BarnesHutGravity> (0.5); };
+	auto const uniform_field = [] { return std::make_unique<rigid_body::UniformFieldGravity>(); };
+
+	std::cout << "Gravitating bodies only:\n";
+
+	for (std::size_t const count: { 100u, 1000u, 5000u })
+	{
+		print_gravity_frame_time (std::format ("{} bodies, pairwise", count), measure_gravity_frame_time (count, 0, pairwise));
+		print_gravity_frame_time (std::format ("{} bodies, Barnes–Hut θ=0.5", count), measure_gravity_frame_time (count, 0, barnes_hut));
+	}
+
+	std::cout << "One planet and small bodies:\n";
+
+	for (std::size_t const count: { 1000u, 10000u })
+	{
+		print_gravity_frame_time (std::format ("{} bodies, pairwise", count), measure_gravity_frame_time (1, count, pairwise));
+		print_gravity_frame_time (std::format ("{} bodies, Barnes–Hut θ=0.5", count), measure_gravity_frame_time (1, count, barnes_hut));
+		print_gravity_frame_time (std::format ("{} bodies, uniform field", count), measure_gravity_frame_time (1, count, uniform_field));
+	}
+});
+
+
+ManualTest t_3 ("rigid_body::SequentialImpulseSolver: iterations and frame time on a glider model", []{
+	constexpr uint32_t kMaxIterations = 100;
+
+	std::cout << std::format ("Glider (max {} iterations):\n", kMaxIterations);
+
+	print_glider_stats ("ImpulseSolver", [] (rigid_body::System& system) {
+		return std::make_unique<rigid_body::ImpulseSolver> (system, kMaxIterations);
+	});
+
+	for (double const sor: { 1.0, 1.3, 1.6 })
+	{
+		print_glider_stats (std::format ("SequentialImpulseSolver SOR={:.1f}", sor), [sor] (rigid_body::System& system) {
+			auto solver = std::make_unique<rigid_body::SequentialImpulseSolver> (system, kMaxIterations);
+			solver->set_over_relaxation (sor);
+			return solver;
+		});
+	}
+});
+
+} // namespace
+} // namespace xf::test
+
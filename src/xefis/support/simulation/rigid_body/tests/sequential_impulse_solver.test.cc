@@ -0,0 +1,234 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/nature/mass_moments.h>
+#include <xefis/support/simulation/constraints/angular_limits_constraint.h>
+#include <xefis/support/simulation/constraints/angular_motor_constraint.h>
+#include <xefis/support/simulation/constraints/fixed_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_constraint.h>
+#include <xefis/support/simulation/constraints/hinge_precalculation.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/sequential_impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <cstddef>
+#include <format>
+#include <optional>
+#include <utility>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+constexpr auto	kForcePrecision		= 1e-6_N;
+constexpr auto	kTorquePrecision	= 1e-6_Nm;
+
+
+rigid_body::Body&
+add_body (rigid_body::System& system, si::Mass const mass, SpaceLength<WorldSpace> const& position)
+{
+	auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (mass, math::unit));
+	body.set_placement (Placement<WorldSpace, BodyCOM> (position, kNoRotation<WorldSpace, BodyCOM>));
+	return body;
+}
+
+
+/**
+ * Make a chain of bodies 1 m apart connected with fixed constraints.
+ */
+std::vector<rigid_body::Body*>
+add_chain (rigid_body::System& system, std::size_t const length)
+{
+	std::vector<rigid_body::Body*> bodies;
+
+	for (std::size_t i = 0; i < length; ++i)
+	{
+		bodies.push_back (&add_body (system, 1_kg, { 1_m * static_cast<double> (i), 0_m, 0_m }));
+
+		if (i > 0)
+			system.add<rigid_body::FixedConstraint> (*bodies[i - 1], *bodies[i]);
+	}
+
+	return bodies;
+}
+
+
+/**
+ * Add a hinge precalculation for bodies 1 m apart with the hinge axis parallel to Z.
+ */
+rigid_body::HingePrecalculation&
+add_hinge (rigid_body::System& system, rigid_body::Body& body_1, rigid_body::Body& body_2)
+{
+	return system.add<rigid_body::HingePrecalculation> (body_1, SpaceLength<WorldSpace> { 0.5_m, 0_m, 0_m }, SpaceLength<WorldSpace> { 0.5_m, 0_m, 1_m }, body_2);
+}
+
+
+/**
+ * Simulate a pendulum made of two bodies connected with a hinge, with given solver type.
+ * Return the final position and velocity of the second body.
+ */
+template<class Solver>
+	std::pair<SpaceLength<WorldSpace>, SpaceVector<si::Velocity, WorldSpace>>
+	simulate_hinge()
+	{
+		rigid_body::System system;
+		auto& body_1 = add_body (system, 2_kg, { 0_m, 0_m, 0_m });
+		auto& body_2 = add_body (system, 0.5_kg, { 1_m, 0.2_m, 0_m });
+		auto& hinge = system.add<rigid_body::HingePrecalculation> (body_1, SpaceLength<WorldSpace> { 0.5_m, 0.1_m, 0_m }, SpaceLength<WorldSpace> { 0.5_m, 0.1_m, 1_m }, body_2);
+		system.add<rigid_body::HingeConstraint> (hinge);
+
+		Solver solver (system);
+		solver.set_required_precision (kForcePrecision, kTorquePrecision);
+
+		for (std::size_t i = 0; i < 200; ++i)
+		{
+			body_2.apply_impulse (ForceMoments<WorldSpace> ({ 0.3_N, -4.9_N, 0.1_N }, { 0.02_Nm, 0_Nm, -0.01_Nm }));
+			solver.evolve (1_ms);
+		}
+
+		return { body_2.placement().position(), body_2.velocity_moments<WorldSpace>().velocity() };
+	}
+
+
+AutoTest t_1 ("rigid_body::SequentialImpulseSolver: converges to required precision", []{
+	rigid_body::System system;
+	auto const chain = add_chain (system, 5);
+	rigid_body::SequentialImpulseSolver solver (system, 1000);
+	solver.set_required_precision (kForcePrecision, kTorquePrecision);
+
+	for (std::size_t step = 0; step < 10; ++step)
+	{
+		chain.front()->apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 10_N, 0_N }, { 0_Nm, 0_Nm, 1_Nm }));
+		auto const details = solver.evolve (1_ms);
+		auto const name = std::format ("frame {}", step);
+
+		test_asserts::verify (name + ": converged", details.converged);
+		test_asserts::verify (name + ": converged before max_iterations", details.iterations_run < 1000);
+		test_asserts::verify (name + ": residuals are tracked for each iteration", details.residuals.size() == details.iterations_run);
+		test_asserts::verify (name + ": last iteration is within required precision",
+							  details.residuals.back().force <= kForcePrecision && details.residuals.back().torque <= kTorquePrecision);
+		test_asserts::verify (name + ": residual decreases", details.residuals.back().force <= details.residuals.front().force);
+	}
+
+	for (std::size_t i = 1; i < chain.size(); ++i)
+	{
+		test_asserts::verify_equal_with_epsilon (std::format ("bodies {} and {} are still 1 m apart", i - 1, i),
+												 abs (chain[i]->placement().position() - chain[i - 1]->placement().position()), 1_m, 1_mm);
+	}
+});
+
+
+AutoTest t_2 ("rigid_body::SequentialImpulseSolver: accumulated constraint forces are clamped to Limits", []{
+	// Acceleration of the body that is moved only by the constraint:
+	auto const constraint_acceleration = [] (std::optional<rigid_body::Limits> const& limits) {
+		rigid_body::System system;
+		auto const chain = add_chain (system, 2);
+		rigid_body::SequentialImpulseSolver solver (system, 100);
+		solver.set_limits (limits);
+		chain.back()->apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 100_N, 0_N }, { 0_Nm, 0_Nm, 10_Nm }));
+		solver.evolve (1_ms);
+		return chain.front()->acceleration_moments_except_gravity<WorldSpace>();
+	};
+
+	auto const unlimited = constraint_acceleration (std::nullopt);
+	auto const limited = constraint_acceleration (rigid_body::Limits { .max_force = 1_N, .max_torque = 1_Nm });
+
+	test_asserts::verify ("without limits constraint force exceeds 1 N", abs (unlimited.acceleration()) > 1_mps2);
+	// Both bodies have mass 1 kg and moments of inertia 1 kg·m²:
+	test_asserts::verify ("force is limited to 1 N", abs (limited.acceleration()) <= 1_mps2 * (1 + 1e-9));
+	test_asserts::verify ("torque is limited to 1 N·m", abs (limited.angular_acceleration()) <= 1_radps2 * (1 + 1e-9));
+});
+
+
+AutoTest t_3 ("rigid_body::SequentialImpulseSolver: gives the same result as ImpulseSolver on a hinge", []{
+	auto const [impulse_position, impulse_velocity] = simulate_hinge<rigid_body::ImpulseSolver>();
+	auto const [sequential_position, sequential_velocity] = simulate_hinge<rigid_body::SequentialImpulseSolver>();
+
+	test_asserts::verify_equal_with_epsilon ("position is the same", sequential_position, impulse_position, 0.1_mm);
+	test_asserts::verify_equal_with_epsilon ("velocity is the same", sequential_velocity, impulse_velocity, 1_mm / 1_s);
+});
+
+
+AutoTest t_4 ("rigid_body::SequentialImpulseSolver: accumulated motor torque doesn't exceed the motor's torque", []{
+	rigid_body::System system;
+	auto& body_1 = add_body (system, 1_kg, { 0_m, 0_m, 0_m });
+	auto& body_2 = add_body (system, 1_kg, { 1_m, 0_m, 0_m });
+	auto& hinge = add_hinge (system, body_1, body_2);
+	// Motor far from its maximum angular velocity, so that it always uses all of its torque:
+	system.add<rigid_body::AngularMotorConstraint> (hinge, 100_radps, 0.5_Nm);
+
+	rigid_body::SequentialImpulseSolver solver (system, 100);
+	solver.set_required_precision (kForcePrecision, kTorquePrecision);
+
+	for (std::size_t step = 0; step < 10; ++step)
+	{
+		solver.evolve (1_ms);
+		// Body 2 has moment of inertia 1 kg·m²:
+		auto const angular_acceleration = abs (body_2.acceleration_moments_except_gravity<WorldSpace>().angular_acceleration());
+		auto const name = std::format ("frame {}", step);
+
+		test_asserts::verify (name + ": motor torque is limited", angular_acceleration <= 0.5_radps2 * (1 + 1e-6));
+		test_asserts::verify (name + ": motor uses its torque", angular_acceleration >= 0.5_radps2 * (1 - 1e-3));
+	}
+});
+
+
+AutoTest t_5 ("rigid_body::SequentialImpulseSolver: warm-started angular limits don't push when slack", []{
+	rigid_body::System system;
+	auto& body_1 = add_body (system, 1_kg, { 0_m, 0_m, 0_m });
+	auto& body_2 = add_body (system, 1_kg, { 1_m, 0_m, 0_m });
+	auto& hinge = add_hinge (system, body_1, body_2);
+	system.add<rigid_body::HingeConstraint> (hinge);
+	system.add<rigid_body::AngularLimitsConstraint> (hinge, -10_deg, +10_deg);
+
+	rigid_body::SequentialImpulseSolver solver (system, 100);
+	solver.set_required_precision (kForcePrecision, kTorquePrecision);
+
+	auto const relative_angular_velocity = [&] {
+		return abs (body_2.velocity_moments<WorldSpace>().angular_velocity() - body_1.velocity_moments<WorldSpace>().angular_velocity());
+	};
+
+	// Rotate body 2 about the hinge against one of the limits:
+	for (std::size_t i = 0; i < 500; ++i)
+	{
+		body_2.apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 0_N, 0_N }, { 0_Nm, 0_Nm, 10_Nm }));
+		solver.evolve (1_ms);
+	}
+
+	auto const angle = abs (hinge.data().angle);
+	test_asserts::verify ("body 2 rests against the limit", angle > 9_deg && angle < 10.5_deg);
+	test_asserts::verify ("body 2 is stopped by the limit", relative_angular_velocity() < 0.1_radps);
+
+	// Now push body 2 slightly away from the limit. The limit goes slack and must not keep pushing
+	// with the torque remembered from previous frames:
+	for (std::size_t i = 0; i < 100; ++i)
+	{
+		body_2.apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 0_N, 0_N }, { 0_Nm, 0_Nm, -0.01_Nm }));
+		solver.evolve (1_ms);
+	}
+
+	// The small torque alone only gives a few mrad/s in that time:
+	test_asserts::verify ("slack limit doesn't push", relative_angular_velocity() < 0.01_radps);
+	test_asserts::verify ("body 2 is within limits", abs (hinge.data().angle) <= 10_deg);
+});
+
+} // namespace
+} // namespace xf::test
+
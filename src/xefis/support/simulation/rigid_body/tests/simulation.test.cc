@@ -16,6 +16,7 @@
 #include <xefis/support/math/transforms.h>
 #include <xefis/support/nature/constants.h>
 #include <xefis/support/nature/mass_moments.h>
+#include <xefis/support/simulation/constraints/fixed_constraint.h>
 #include <xefis/support/simulation/rigid_body/concepts.h>
 #include <xefis/support/simulation/rigid_body/impulse_solver.h>
 #include <xefis/support/simulation/rigid_body/system.h>
@@ -24,11 +25,14 @@
 
 // Neutrino:
 #include <neutrino/test/auto_test.h>
+#include <neutrino/work_performer.h>
 
 // Standard:
 #include <cstddef>
+#include <format>
 #include <memory>
 #include <string>
+#include <vector>
 
 
 namespace xf::test {
@@ -62,6 +66,39 @@ make_iss()
 }
 
 
+/**
+ * Add chains of bodies connected with fixed constraints. Return first bodies of the chains.
+ */
+std::vector<rigid_body::Body*>
+add_chains (rigid_body::System& system, std::vector<std::size_t> const& chain_lengths)
+{
+	std::vector<rigid_body::Body*> first_bodies;
+	auto y = 0_m;
+
+	for (auto const length: chain_lengths)
+	{
+		rigid_body::Body* previous = nullptr;
+
+		for (std::size_t i = 0; i < length; ++i)
+		{
+			auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (1_kg, math::unit));
+			body.set_placement (Placement<WorldSpace, BodyCOM> ({ 1_m * static_cast<double> (i), y, 0_m }, kNoRotation<WorldSpace, BodyCOM>));
+
+			if (previous)
+				system.add<rigid_body::FixedConstraint> (*previous, body);
+			else
+				first_bodies.push_back (&body);
+
+			previous = &body;
+		}
+
+		y += 2_m;
+	}
+
+	return first_bodies;
+}
+
+
 AutoTest t_1 ("rigid_body::System: 90-minute simulation of gravitational forces", []{
 	auto rigid_body_system = rigid_body::System();
 	auto rigid_body_solver = rigid_body::ImpulseSolver (rigid_body_system);
@@ -101,6 +138,48 @@ AutoTest t_1 ("rigid_body::System: 90-minute simulation of gravitational forces"
 	test_asserts::verify_equal_with_epsilon ("Earth didn't travel much", earth.placement().position(), earth_initial_position, 1_cm);
 });
 
+AutoTest t_2 ("rigid_body::ImpulseSolver: parallel solving of islands matches serial solver", []{
+	// Several small islands and one island large enough to get colored:
+	std::vector<std::size_t> const chain_lengths { 2, 3, 5, 8, 130 };
+	auto const force_precision = 1e-2_N;
+	auto const torque_precision = 1e-2_Nm;
+
+	rigid_body::System serial_system;
+	rigid_body::System parallel_system;
+	auto const serial_first_bodies = add_chains (serial_system, chain_lengths);
+	auto const parallel_first_bodies = add_chains (parallel_system, chain_lengths);
+
+	WorkPerformer work_performer (4, g_null_logger);
+	rigid_body::ImpulseSolver serial_solver (serial_system);
+	rigid_body::ImpulseSolver parallel_solver (parallel_system);
+
+	for (auto* solver: { &serial_solver, &parallel_solver })
+		solver->set_required_precision (force_precision, torque_precision);
+
+	parallel_solver.set_work_performer (&work_performer);
+
+	for (std::size_t step = 0; step < 10; ++step)
+	{
+		for (auto* body: serial_first_bodies)
+			body->apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 10_N, 0_N }, { 0_Nm, 0_Nm, 1_Nm }));
+
+		for (auto* body: parallel_first_bodies)
+			body->apply_impulse (ForceMoments<WorldSpace> ({ 0_N, 10_N, 0_N }, { 0_Nm, 0_Nm, 1_Nm }));
+
+		serial_solver.evolve (1_ms);
+		parallel_solver.evolve (1_ms);
+	}
+
+	auto const& serial_bodies = serial_system.bodies();
+	auto const& parallel_bodies = parallel_system.bodies();
+
+	for (std::size_t i = 0; i < serial_bodies.size(); ++i)
+	{
+		test_asserts::verify_equal_with_epsilon (std::format ("body {} is at the same position", i),
+												 parallel_bodies[i]->placement().position(), serial_bodies[i]->placement().position(), 1_mm);
+	}
+});
+
 } // namespace
 } // namespace xf::test
 
@@ -18,6 +18,7 @@
 #include <xefis/config/all.h>
 
 // Standard:
+#include <algorithm>
 #include <cstddef>
 
 
@@ -31,8 +32,25 @@ Simulator::Simulator (rigid_body::System& rigid_body_system,
 	_rigid_body_system (rigid_body_system),
 	_rigid_body_solver (rigid_body_solver)
 {
-	_evolver.emplace (frame_duration, logger.with_context ("Evolver"), [this] (si::Time const dt) {
-		_rigid_body_solver.evolve (dt);
+	// Evolver only gives an iterations limit with adaptive stepping enabled; otherwise restore solver's own setting:
+	auto const solver_max_iterations = _rigid_body_solver.max_iterations();
+
+	_evolver.emplace (frame_duration, logger.with_context ("Evolver"), [this, solver_max_iterations] (si::Time const dt, std::optional<std::size_t> const max_iterations) {
+		_rigid_body_solver.set_max_iterations (max_iterations.value_or (solver_max_iterations));
+
+		if (_frame_callback)
+			_frame_callback (_evolver->simulation_time());
+
+		auto const details = _rigid_body_solver.evolve (dt);
+		auto max_velocity = 0_mps;
+
+		for (auto const& vm: _rigid_body_system.body_states().velocity_moments)
+			max_velocity = std::max (max_velocity, abs (vm.velocity()));
+
+		return Evolver::FrameFeedback {
+			.converged = details.converged,
+			.max_velocity = max_velocity,
+		};
 	});
 }
 
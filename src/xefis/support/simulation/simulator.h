@@ -26,6 +26,7 @@
 
 // Standard:
 #include <cstddef>
+#include <functional>
 #include <optional>
 
 
@@ -36,6 +37,12 @@ namespace xf {
  */
 class Simulator: public Noncopyable
 {
+  public:
+	/**
+	 * Called before each frame with the simulation time at the beginning of the frame.
+	 */
+	using FrameCallback = std::function<void (si::Time simulation_time)>;
+
   public:
 	// Ctor
 	explicit
@@ -97,10 +104,35 @@ class Simulator: public Noncopyable
 	performance() const noexcept
 		{ return _evolver->performance(); }
 
+	/**
+	 * Set Evolver adaptive stepping. In adaptive mode the solver's iterations limit
+	 * is controlled by the Evolver.
+	 */
+	void
+	set_adaptive_stepping (std::optional<Evolver::AdaptiveStepping> const& adaptive_stepping)
+		{ _evolver->set_adaptive_stepping (adaptive_stepping); }
+
+	/**
+	 * Return Evolver::frame_times().
+	 */
+	[[nodiscard]]
+	boost::circular_buffer<si::Time> const&
+	frame_times() const noexcept
+		{ return _evolver->frame_times(); }
+
+	/**
+	 * Set callback called before each frame. Can be used to update time-dependent models,
+	 * like TurbulentAtmosphere. It's called on the thread that evolves the simulation.
+	 */
+	void
+	set_frame_callback (FrameCallback const& callback)
+		{ _frame_callback = callback; }
+
   private:
 	xf::Logger						_logger;
 	rigid_body::System&				_rigid_body_system;
 	rigid_body::ImpulseSolver&		_rigid_body_solver;
+	FrameCallback					_frame_callback;
 	std::optional<xf::Evolver>		_evolver;
 };
 
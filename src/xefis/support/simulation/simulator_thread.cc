@@ -0,0 +1,206 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Local:
+#include "simulator_thread.h"
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Neutrino:
+#include <neutrino/exception.h>
+
+// Standard:
+#include <chrono>
+#include <cstddef>
+
+
+namespace xf {
+namespace {
+
+[[nodiscard]]
+std::chrono::steady_clock::duration
+to_steady_duration (si::Time const time)
+{
+	return std::chrono::duration_cast<std::chrono::steady_clock::duration> (std::chrono::duration<double> (time.in<si::Second>()));
+}
+
+} // namespace
+
+
+SimulatorThread::SimulatorThread (Simulator& simulator, Logger const& logger):
+	_logger (logger.with_context ("SimulatorThread")),
+	_simulator (simulator)
+{ }
+
+
+SimulatorThread::~SimulatorThread()
+{
+	stop();
+}
+
+
+SimulatorThread::SnapshotReader
+SimulatorThread::make_snapshot_reader()
+{
+	if (_thread.joinable())
+		throw InvalidCall ("SimulatorThread::make_snapshot_reader() called after start()");
+
+	auto& buffer = *_snapshot_buffers.emplace_back (std::make_unique<SnapshotBuffer>());
+	// Let readers see the initial state even before the first frame is evolved:
+	buffer.write_buffer().capture (_simulator.rigid_body_system(), _simulator.simulation_time(), _frame_number);
+	buffer.publish();
+
+	return SnapshotReader (buffer);
+}
+
+
+void
+SimulatorThread::start()
+{
+	if (!_thread.joinable())
+	{
+		_thread = std::jthread ([this] (std::stop_token stop_token) {
+			thread_loop (stop_token);
+		});
+	}
+}
+
+
+void
+SimulatorThread::stop()
+{
+	if (_thread.joinable())
+	{
+		_thread.request_stop();
+		// Wake up the thread if it's waiting while paused:
+		_requests.fetch_add (1, std::memory_order_acq_rel);
+		_requests.notify_all();
+		_thread.join();
+	}
+}
+
+
+void
+SimulatorThread::set_paused (bool const paused)
+{
+	_paused.store (paused, std::memory_order_release);
+	auto const request = _requests.fetch_add (1, std::memory_order_acq_rel) + 1;
+	_requests.notify_all();
+	wait_for_thread (request);
+}
+
+
+void
+SimulatorThread::step()
+{
+	if (!paused())
+		return;
+
+	if (_thread.joinable())
+	{
+		_step_requests.fetch_add (1, std::memory_order_acq_rel);
+		auto const request = _requests.fetch_add (1, std::memory_order_acq_rel) + 1;
+		_requests.notify_all();
+		wait_for_thread (request);
+	}
+	else
+		evolve_frame();
+}
+
+
+void
+SimulatorThread::thread_loop (std::stop_token stop_token)
+{
+	auto const acknowledge = [this] (uint64_t const request) {
+		_handled_requests.store (request, std::memory_order_release);
+		_handled_requests.notify_all();
+	};
+
+	auto deadline = std::chrono::steady_clock::now();
+	auto const max_lag = to_steady_duration (kMaxLag);
+
+	while (!stop_token.stop_requested())
+	{
+		// Load the request number before the state, so that a request is never acknowledged
+		// with a state older than the request:
+		auto const request = _requests.load (std::memory_order_acquire);
+
+		if (_paused.load (std::memory_order_acquire))
+		{
+			for (auto steps = _step_requests.exchange (0, std::memory_order_acq_rel); steps > 0; --steps)
+				evolve_frame();
+
+			acknowledge (request);
+			_requests.wait (request, std::memory_order_acquire);
+			deadline = std::chrono::steady_clock::now();
+			continue;
+		}
+
+		acknowledge (request);
+
+		auto const prev_simulation_time = _simulator.simulation_time();
+		evolve_frame();
+		// Frame duration may change from frame to frame in adaptive mode:
+		deadline += to_steady_duration (_simulator.simulation_time() - prev_simulation_time);
+		std::this_thread::sleep_until (deadline);
+
+		// If we're lagging too much, don't try to catch up with a burst of frames:
+		if (auto const now = std::chrono::steady_clock::now(); now - deadline > max_lag)
+		{
+			_logger << std::format ("Simulation lags {:.0f} ms behind real time.\n", std::chrono::duration<double, std::milli> (now - deadline).count());
+			deadline = now;
+		}
+	}
+
+	// Don't leave anyone waiting in set_paused() or step():
+	acknowledge (_requests.load (std::memory_order_acquire));
+}
+
+
+void
+SimulatorThread::evolve_frame()
+{
+	_simulator.evolve (1u);
+	++_frame_number;
+	_performance.store (_simulator.performance(), std::memory_order_relaxed);
+	publish_snapshots();
+}
+
+
+void
+SimulatorThread::publish_snapshots()
+{
+	auto const& system = _simulator.rigid_body_system();
+	auto const simulation_time = _simulator.simulation_time();
+
+	for (auto& buffer: _snapshot_buffers)
+	{
+		buffer->write_buffer().capture (system, simulation_time, _frame_number);
+		buffer->publish();
+	}
+}
+
+
+void
+SimulatorThread::wait_for_thread (uint64_t const request)
+{
+	if (!_thread.joinable())
+		return;
+
+	for (auto handled = _handled_requests.load (std::memory_order_acquire); handled < request; handled = _handled_requests.load (std::memory_order_acquire))
+		_handled_requests.wait (handled, std::memory_order_acquire);
+}
+
+} // namespace xf
+
@@ -0,0 +1,180 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__SUPPORT__SIMULATION__SIMULATOR_THREAD_H__INCLUDED
+#define XEFIS__SUPPORT__SIMULATION__SIMULATOR_THREAD_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/rigid_body/system_snapshot.h>
+#include <xefis/support/simulation/simulator.h>
+#include <xefis/utility/triple_buffer.h>
+
+// Neutrino:
+#include <neutrino/logger.h>
+#include <neutrino/noncopyable.h>
+
+// Standard:
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+
+namespace xf {
+
+/**
+ * Runs Simulator on a dedicated thread, one frame at a time, paced to real time.
+ *
+ * After each frame a rigid_body::SystemSnapshot is published for each SnapshotReader through
+ * a lock-free TripleBuffer, so that readers (virtual sensors, the 3D viewer) on other threads
+ * never block the physics and never see a half-evolved System.
+ *
+ * While the thread is running, the System must not be accessed from other threads, except for
+ * the parts that don't change during simulation (list of bodies, shapes, etc).
+ */
+class SimulatorThread: private Noncopyable
+{
+	// If the simulation falls behind real time more than this, don't try to catch up:
+	static constexpr si::Time kMaxLag { 100_ms };
+
+	using SnapshotBuffer = TripleBuffer<rigid_body::SystemSnapshot>;
+
+  public:
+	/**
+	 * Consumer side of published snapshots.
+	 * Each consumer thread must use its own reader.
+	 */
+	class SnapshotReader
+	{
+	  public:
+		// Ctor
+		explicit
+		SnapshotReader (SnapshotBuffer& buffer):
+			_buffer (&buffer)
+		{ }
+
+		/**
+		 * Return true if a new snapshot has been published since the last read().
+		 */
+		[[nodiscard]]
+		bool
+		has_fresh_snapshot() const noexcept
+			{ return _buffer->has_fresh_value(); }
+
+		/**
+		 * Return the most recent snapshot. The reference is valid until the next call to read().
+		 */
+		[[nodiscard]]
+		rigid_body::SystemSnapshot const&
+		read() noexcept
+			{ return _buffer->read(); }
+
+	  private:
+		SnapshotBuffer* _buffer;
+	};
+
+  public:
+	// Ctor
+	explicit
+	SimulatorThread (Simulator&, Logger const&);
+
+	// Dtor
+	~SimulatorThread();
+
+	/**
+	 * Create a new snapshot reader. Must be called before start().
+	 * Readers must not outlive the SimulatorThread.
+	 */
+	[[nodiscard]]
+	SnapshotReader
+	make_snapshot_reader();
+
+	/**
+	 * Start the simulation thread.
+	 */
+	void
+	start();
+
+	/**
+	 * Stop the simulation thread and wait for it to finish.
+	 */
+	void
+	stop();
+
+	/**
+	 * Return true if simulation is paused.
+	 */
+	[[nodiscard]]
+	bool
+	paused() const noexcept
+		{ return _paused.load (std::memory_order_relaxed); }
+
+	/**
+	 * Pause or resume the simulation. When pausing, wait until the thread finishes the current frame,
+	 * so that after this call the System can be safely accessed.
+	 */
+	void
+	set_paused (bool paused);
+
+	/**
+	 * Evolve a single frame while paused. Waits until the frame is evolved.
+	 */
+	void
+	step();
+
+	/**
+	 * Return Simulator::performance() as of the most recent frame.
+	 */
+	[[nodiscard]]
+	float
+	performance() const noexcept
+		{ return _performance.load (std::memory_order_relaxed); }
+
+  private:
+	void
+	thread_loop (std::stop_token);
+
+	void
+	evolve_frame();
+
+	void
+	publish_snapshots();
+
+	/**
+	 * Wait until the thread acknowledges the current pause state.
+	 */
+	void
+	wait_for_thread (uint64_t request);
+
+  private:
+	Logger										_logger;
+	Simulator&									_simulator;
+	std::vector<std::unique_ptr<SnapshotBuffer>>	_snapshot_buffers;
+	uint64_t									_frame_number		{ 0 };
+	std::atomic<bool>							_paused				{ false };
+	std::atomic<uint64_t>						_step_requests		{ 0 };
+	// Incremented on each request (pause/resume/step) and set by the thread to the request number once it handled it:
+	std::atomic<uint64_t>						_requests			{ 0 };
+	std::atomic<uint64_t>						_handled_requests	{ 0 };
+	std::atomic<float>							_performance		{ 1.0f };
+	std::jthread								_thread;
+};
+
+} // namespace xf
+
+#endif
+
@@ -0,0 +1,109 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/evolver.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+namespace xf::test {
+namespace {
+
+xf::Logger g_null_logger;
+
+
+AutoTest t_1 ("Evolver: fixed frame duration", []{
+	// Use Δt exactly representable in binary, so that rounding errors don't add an extra frame:
+	auto const frame_duration = 1_s / 64;
+	std::size_t frames = 0;
+	auto evolver = Evolver (frame_duration, g_null_logger, [&] (si::Time const dt) {
+		test_asserts::verify ("frame duration is constant", dt == frame_duration);
+		++frames;
+	});
+
+	auto const result = evolver.evolve (1_s);
+
+	test_asserts::verify_equal ("evolved 64 frames", result.evolved_frames, 64u);
+	test_asserts::verify_equal ("evolution function called 64 times", frames, 64u);
+	test_asserts::verify_equal ("frame times recorded", evolver.frame_times().size(), 64u);
+});
+
+
+AutoTest t_2 ("Evolver: adaptive stepping shrinks Δt when solver doesn't converge or bodies are fast", []{
+	bool converged = true;
+	auto max_velocity = 0_mps;
+	auto evolver = Evolver (1_ms, g_null_logger, [&] (si::Time, std::optional<std::size_t>) {
+		return Evolver::FrameFeedback { .converged = converged, .max_velocity = max_velocity };
+	});
+	evolver.set_adaptive_stepping (Evolver::AdaptiveStepping {
+		.min_frame_duration = 0.1_ms,
+		.max_frame_duration = 10_ms,
+		.max_frame_displacement = 1_cm,
+	});
+
+	evolver.evolve (1_s);
+	test_asserts::verify_equal_with_epsilon ("Δt grows to maximum when converging", evolver.frame_duration(), 10_ms, 1e-9_s);
+
+	converged = false;
+	evolver.evolve (1_s);
+	test_asserts::verify_equal_with_epsilon ("Δt shrinks to minimum when not converging", evolver.frame_duration(), 0.1_ms, 1e-9_s);
+
+	converged = true;
+	max_velocity = 5_mps;
+	evolver.evolve (1_s);
+	test_asserts::verify_equal_with_epsilon ("Δt is limited by max displacement", evolver.frame_duration(), 2_ms, 1e-9_s);
+
+	test_asserts::verify ("simulation time doesn't overshoot", abs (evolver.simulation_time() - 3_s) < 1e-9_s);
+});
+
+
+AutoTest t_3 ("Evolver: real-time budget degrades iterations first, then Δt", []{
+	std::vector<std::size_t> iterations;
+	std::vector<si::Time> durations;
+	auto evolver = Evolver (1_ms, g_null_logger, [&] (si::Time const dt, std::optional<std::size_t> const max_iterations) {
+		// Each frame takes much more real time than allowed:
+		std::this_thread::sleep_for (std::chrono::microseconds (200));
+		iterations.push_back (max_iterations.value_or (0));
+		durations.push_back (dt);
+		return Evolver::FrameFeedback { .converged = false };
+	});
+	evolver.set_adaptive_stepping (Evolver::AdaptiveStepping {
+		.min_frame_duration = 1_ms,
+		.max_frame_duration = 10_ms,
+		.max_iterations = 16,
+		.min_iterations = 2,
+		.real_time_budget = 0.01,
+	});
+
+	evolver.evolve (100_ms);
+
+	test_asserts::verify ("starts with max iterations", iterations.front() == 16);
+	test_asserts::verify ("ends with min iterations", iterations.back() == 2);
+	test_asserts::verify ("Δt is not increased before iterations are at minimum",
+						  durations[1] == 1_ms && durations[2] == 1_ms && durations[3] == 1_ms);
+	test_asserts::verify ("Δt is increased after iterations are at minimum", *std::max_element (durations.begin(), durations.end()) > 1_ms);
+});
+
+} // namespace
+} // namespace xf::test
+
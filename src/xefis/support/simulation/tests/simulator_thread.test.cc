@@ -0,0 +1,109 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+// Xefis:
+#include <xefis/config/all.h>
+#include <xefis/support/simulation/rigid_body/impulse_solver.h>
+#include <xefis/support/simulation/rigid_body/system.h>
+#include <xefis/support/simulation/simulator.h>
+#include <xefis/support/simulation/simulator_thread.h>
+#include <xefis/utility/triple_buffer.h>
+
+// Neutrino:
+#include <neutrino/test/auto_test.h>
+
+// Standard:
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+
+namespace xf::test {
+namespace {
+
+xf::Logger g_null_logger;
+
+
+AutoTest t_1 ("TripleBuffer: reader gets the most recently published value", []{
+	TripleBuffer<int> buffer;
+
+	test_asserts::verify ("nothing fresh initially", !buffer.has_fresh_value());
+
+	buffer.write_buffer() = 1;
+	buffer.publish();
+	buffer.write_buffer() = 2;
+	buffer.publish();
+
+	test_asserts::verify ("fresh value available", buffer.has_fresh_value());
+	test_asserts::verify_equal ("older values are skipped", buffer.read(), 2);
+	test_asserts::verify ("value consumed", !buffer.has_fresh_value());
+	test_asserts::verify_equal ("read() without new value returns the same value", buffer.read(), 2);
+
+	auto const& held = buffer.read();
+	buffer.write_buffer() = 3;
+	buffer.publish();
+	buffer.write_buffer() = 4;
+	buffer.publish();
+
+	test_asserts::verify_equal ("value held by reader is not overwritten by the writer", held, 2);
+	test_asserts::verify_equal ("next read() returns the latest value", buffer.read(), 4);
+});
+
+
+AutoTest t_2 ("SimulatorThread: snapshots, pausing and stepping", []{
+	auto const velocity = 1_mps;
+	auto const frame_duration = 1_ms;
+
+	rigid_body::System system;
+	rigid_body::ImpulseSolver solver (system, 1);
+	auto& body = system.add<rigid_body::Body> (MassMoments<BodyCOM> (1_kg, math::unit));
+	body.set_velocity_moments (VelocityMoments<WorldSpace> ({ velocity, 0_mps, 0_mps }, { 0_radps, 0_radps, 0_radps }));
+
+	Simulator simulator (system, solver, frame_duration, g_null_logger);
+	SimulatorThread thread (simulator, g_null_logger);
+	auto reader = thread.make_snapshot_reader();
+
+	test_asserts::verify ("initial snapshot is published", reader.has_fresh_snapshot());
+	test_asserts::verify_equal ("initial snapshot contains all bodies", reader.read().bodies.size(), 1u);
+
+	thread.set_paused (true);
+	thread.start();
+
+	for (int i = 0; i < 3; ++i)
+		thread.step();
+
+	{
+		auto const& snapshot = reader.read();
+		test_asserts::verify_equal ("three frames evolved when stepping", snapshot.frame_number, 3u);
+		test_asserts::verify_equal_with_epsilon ("simulation time matches frames", snapshot.simulation_time, 3 * frame_duration, 1e-9_s);
+		test_asserts::verify_equal_with_epsilon ("body moved", snapshot.bodies[0].placement.position()[0], 3 * frame_duration * velocity, 1e-9_m);
+	}
+
+	thread.set_paused (false);
+	std::this_thread::sleep_for (std::chrono::milliseconds (50));
+	thread.set_paused (true);
+
+	{
+		auto const& snapshot = reader.read();
+		test_asserts::verify ("simulation continued after resuming", snapshot.frame_number > 3u);
+		test_asserts::verify_equal ("paused thread published its last frame", snapshot.simulation_time, simulator.simulation_time());
+		test_asserts::verify_equal_with_epsilon ("snapshot is consistent with the body state",
+												 snapshot.bodies[0].placement.position()[0], body.placement().position()[0], 1e-9_m);
+	}
+
+	thread.stop();
+});
+
+} // namespace
+} // namespace xf::test
+
@@ -77,6 +77,7 @@ RigidBodyPainter::paint (rigid_body::System const& system, QOpenGLPaintDevice& c
 
 	painter.translate (center);
 	painter.beginNativePainting();
+	update_body_indices (system);
 	setup (canvas);
 	paint_world (system);
 	paint_ecef_basis (canvas);
@@ -152,7 +153,7 @@ RigidBodyPainter::apply_camera_rotations()
 	}
 
 	if (_followed_body && _following_orientation)
-		_gl.rotate (_followed_body->placement().body_to_base_rotation());
+		_gl.rotate (placement_of (*_followed_body).body_to_base_rotation());
 }
 
 
@@ -236,7 +237,7 @@ RigidBodyPainter::paint_planet()
 	auto const ground_fog_density = renormalize (normalized_altitude, Range { 0.0f, 1.0f }, Range { 0.001f, 0.0015f });
 
 	// Offset by planet position in the simulation:
-	_gl.translate (_planet_body->placement().position());
+	_gl.translate (placement_of (*_planet_body).position());
 
 	// Draw stuff like we were located at Lon/Lat 0°/0° looking towards south pole.
 	// In other words match ECEF coordinates with standard OpenGL screen coordinates.
@@ -450,8 +451,9 @@ RigidBodyPainter::paint_body (rigid_body::Body const& body, BodyRenderingConfig
 
 	_gl.save_context ([&] {
 		// Transform so that center-of-mass is at the OpenGL space origin:
-		_gl.translate (body.placement().position() - followed_body_position());
-		_gl.rotate (body.placement().base_to_body_rotation());
+		auto const& placement = placement_of (body);
+		_gl.translate (placement.position() - followed_body_position());
+		_gl.rotate (placement.base_to_body_rotation());
 
 		if (focused || rendering.center_of_mass_visible)
 			paint_center_of_mass();
@@ -524,8 +526,9 @@ RigidBodyPainter::paint_constraint (rigid_body::Constraint const& constraint)
 			auto fcorr = followed_body_position();
 			auto const& b1 = constraint.body_1();
 			auto const& b2 = constraint.body_2();
-			auto com1 = b1.placement().position() - fcorr;
-			auto com2 = b2.placement().position() - fcorr;
+			auto const& pl1 = placement_of (b1);
+			auto com1 = pl1.position() - fcorr;
+			auto com2 = placement_of (b2).position() - fcorr;
 
 			auto const rod_from_to = [this] (si::Length const radius, auto const& from, auto const& to, bool front_back_faces, rigid_body::ShapeMaterial const& material)
 			{
@@ -552,8 +555,8 @@ RigidBodyPainter::paint_constraint (rigid_body::Constraint const& constraint)
 
 			if (auto const* hinge = dynamic_cast<rigid_body::HingeConstraint const*> (&constraint))
 			{
-				auto const a1 = b1.placement().unbound_transform_to_base (hinge->hinge_precalculation().body_1_anchor());
-				auto const hinge_1 = b1.placement().unbound_transform_to_base (hinge->hinge_precalculation().body_1_hinge());
+				auto const a1 = pl1.unbound_transform_to_base (hinge->hinge_precalculation().body_1_anchor());
+				auto const hinge_1 = pl1.unbound_transform_to_base (hinge->hinge_precalculation().body_1_hinge());
 				auto const hinge_start_1 = com1 + a1;
 				auto const hinge_end_1 = hinge_start_1 + hinge_1;
 				auto const hinge_center = hinge_start_1 + 0.5 * hinge_1;
@@ -588,16 +591,17 @@ RigidBodyPainter::paint_forces (rigid_body::Body const& body)
 	auto constexpr force_to_length = 0.1_m / 1_N; // TODO unhardcode; make autoscaling depending on aircraft total mass
 	auto constexpr torque_to_length = force_to_length / 1_m; // TODO unhardcode
 
-	auto const& iter = body.iteration();
-	auto const gfm = iter.gravitational_force_moments;
-	auto const efm = iter.external_force_moments;
+	auto const* snapshot = body_snapshot (body);
+	auto const gfm = snapshot ? snapshot->gravitational_force_moments : body.iteration().gravitational_force_moments;
+	auto const efm = snapshot ? snapshot->external_force_moments : body.iteration().external_force_moments;
 	auto const fbp = followed_body_position();
-	auto const com = body.placement().position() - fbp;
+	auto const com = placement_of (body).position() - fbp;
 
 	if (_gravity_visible)
 		draw_arrow (com, gfm.force() * force_to_length, rigid_body::make_material (gravity_color));
 
-	if (_aerodynamic_forces_visible)
+	// Wing parameters are not part of the snapshot and can't be read while the System is evolved elsewhere:
+	if (_aerodynamic_forces_visible && !snapshot)
 	{
 		if (auto const* wing = dynamic_cast<sim::Wing const*> (&body))
 		{
@@ -627,8 +631,8 @@ void
 RigidBodyPainter::paint_angular_velocity (rigid_body::Body const& body)
 {
 	auto constexpr angular_velocity_to_length = 0.1_m / 1_radps; // TODO unhardcode
-	auto const com = body.placement().position() - followed_body_position();
-	auto const omega = body.velocity_moments<WorldSpace>().angular_velocity();
+	auto const com = placement_of (body).position() - followed_body_position();
+	auto const omega = velocity_moments_of (body).angular_velocity();
 
 	draw_arrow (com, omega * angular_velocity_to_length, rigid_body::make_material (Qt::darkMagenta));
 }
@@ -638,10 +642,11 @@ void
 RigidBodyPainter::paint_angular_momentum (rigid_body::Body const& body)
 {
 	auto constexpr angular_momentum_to_length = 0.001_m / (1_kg * 1_m2 / 1_s) / 1_rad; // TODO unhardcode
-	auto const com = body.placement().position() - followed_body_position();
+	auto const& placement = placement_of (body);
+	auto const com = placement.position() - followed_body_position();
 	auto const I = body.mass_moments<BodyCOM>().inertia_tensor();
-	auto const L = I * body.velocity_moments<BodyCOM>().angular_velocity();
-	auto const L_world = body.placement().unbound_transform_to_base (L);
+	auto const L = I * placement.unbound_transform_to_body (velocity_moments_of (body).angular_velocity());
+	auto const L_world = placement.unbound_transform_to_base (L);
 
 	draw_arrow (com, L_world * angular_momentum_to_length, rigid_body::make_material (Qt::darkBlue));
 }
@@ -763,10 +768,58 @@ SpaceLength<WorldSpace>
 RigidBodyPainter::followed_body_position() const
 {
 	if (_followed_body)
-		return _followed_body->placement().position();
+		return placement_of (*_followed_body).position();
 	else
 		return { 0_m, 0_m, 0_m };
 }
 
+
+void
+RigidBodyPainter::update_body_indices (rigid_body::System const& system)
+{
+	auto const& bodies = system.bodies();
+
+	if (_body_indices.size() != bodies.size() || (!bodies.empty() && !_body_indices.contains (bodies.front().get())))
+	{
+		_body_indices.clear();
+
+		for (std::size_t i = 0; i < bodies.size(); ++i)
+			_body_indices[bodies[i].get()] = i;
+	}
+}
+
+
+rigid_body::BodySnapshot const*
+RigidBodyPainter::body_snapshot (rigid_body::Body const& body) const
+{
+	if (!_snapshot)
+		return nullptr;
+
+	if (auto const found = _body_indices.find (&body); found != _body_indices.end())
+		return _snapshot->body (found->second);
+
+	return nullptr;
+}
+
+
+Placement<WorldSpace, BodyCOM> const&
+RigidBodyPainter::placement_of (rigid_body::Body const& body) const
+{
+	if (auto const* snapshot = body_snapshot (body))
+		return snapshot->placement;
+	else
+		return body.placement();
+}
+
+
+VelocityMoments<WorldSpace>
+RigidBodyPainter::velocity_moments_of (rigid_body::Body const& body) const
+{
+	if (auto const* snapshot = body_snapshot (body))
+		return snapshot->velocity_moments;
+	else
+		return body.velocity_moments<WorldSpace>();
+}
+
 } // namespace xf
 
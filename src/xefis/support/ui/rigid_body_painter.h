@@ -18,6 +18,7 @@
 #include <xefis/config/all.h>
 #include <xefis/support/math/rotations.h>
 #include <xefis/support/simulation/rigid_body/system.h>
+#include <xefis/support/simulation/rigid_body/system_snapshot.h>
 #include <xefis/support/ui/gl_space.h>
 
 // Qt:
@@ -30,6 +31,7 @@
 #include <cstddef>
 #include <map>
 #include <random>
+#include <unordered_map>
 
 
 namespace xf {
@@ -129,6 +131,17 @@ class RigidBodyPainter: protected QOpenGLFunctions
 	set_focused (rigid_body::Body const* focused_body) noexcept
 		{ _focused_body = focused_body; }
 
+	/**
+	 * Set snapshot to take dynamic state of bodies from (placements, velocities, forces)
+	 * instead of reading it directly from the bodies. Use it when the System is evolved
+	 * on another thread. Pass nullptr to read state from the bodies.
+	 *
+	 * The snapshot must be captured from the System passed to paint().
+	 */
+	void
+	set_snapshot (rigid_body::SystemSnapshot const* snapshot) noexcept
+		{ _snapshot = snapshot; }
+
 	/**
 	 * Set camera focus point.
 	 */
@@ -312,6 +325,27 @@ class RigidBodyPainter: protected QOpenGLFunctions
 	SpaceLength<WorldSpace>
 	followed_body_position() const;
 
+	/**
+	 * Rebuild the map of body indices used to find bodies in the snapshot.
+	 */
+	void
+	update_body_indices (rigid_body::System const&);
+
+	/**
+	 * Return snapshot of the body or nullptr if there's no snapshot set.
+	 */
+	[[nodiscard]]
+	rigid_body::BodySnapshot const*
+	body_snapshot (rigid_body::Body const&) const;
+
+	[[nodiscard]]
+	Placement<WorldSpace, BodyCOM> const&
+	placement_of (rigid_body::Body const&) const;
+
+	[[nodiscard]]
+	VelocityMoments<WorldSpace>
+	velocity_moments_of (rigid_body::Body const&) const;
+
   private:
 	si::PixelDensity		_pixel_density;
 	// Camera position is relative to the followed body:
@@ -333,6 +367,10 @@ class RigidBodyPainter: protected QOpenGLFunctions
 	std::map<rigid_body::Body const*, BodyRenderingConfig>
 							_body_rendering_config;
 	std::minstd_rand0		_air_particles_prng;
+	rigid_body::SystemSnapshot const*
+							_snapshot					{ nullptr };
+	std::unordered_map<rigid_body::Body const*, std::size_t>
+							_body_indices;
 };
 
 } // namespace xf
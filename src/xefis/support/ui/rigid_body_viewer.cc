@@ -62,6 +62,9 @@ RigidBodyViewer::toggle_pause()
 			_playback = Playback::Paused;
 			break;
 	}
+
+	if (_on_playback_change)
+		_on_playback_change (_playback);
 }
 
 
@@ -70,6 +73,9 @@ RigidBodyViewer::step()
 {
 	_playback = Playback::Stepping;
 	_steps_to_do += 1;
+
+	if (_on_playback_change)
+		_on_playback_change (_playback);
 }
 
 
@@ -59,6 +59,9 @@ class RigidBodyViewer: public GLAnimationWidget
 		Running,
 	};
 
+	// Called after playback mode is changed by the user:
+	using OnPlaybackChange = std::function<void (Playback)>;
+
   public:
 	static constexpr auto		kRotationButton		{ Qt::RightButton };
 	static constexpr auto		kTranslationButton	{ Qt::LeftButton };
@@ -105,6 +108,22 @@ class RigidBodyViewer: public GLAnimationWidget
 	set_redraw_callback (OnRedraw const on_redraw = {})
 		{ _on_redraw = on_redraw; }
 
+	/**
+	 * Set the callback to be called when playback mode is changed with toggle_pause() or step().
+	 * Use it when the rigid body system is evolved elsewhere (eg. by SimulatorThread).
+	 * Pass nullptr to unset.
+	 */
+	void
+	set_playback_change_callback (OnPlaybackChange const on_playback_change = {})
+		{ _on_playback_change = on_playback_change; }
+
+	/**
+	 * Calls set_snapshot() on internal RigidBodyPainter.
+	 */
+	void
+	set_snapshot (rigid_body::SystemSnapshot const* snapshot) noexcept
+		{ _rigid_body_painter.set_snapshot (snapshot); }
+
 	/**
 	 * Set related machine. Used to show configurator widget when pressing Esc.
 	 * Pass nullptr to unset.
@@ -251,6 +270,7 @@ class RigidBodyViewer: public GLAnimationWidget
 	rigid_body::System const*	_rigid_body_system				{ nullptr };
 	RigidBodyPainter			_rigid_body_painter;
 	OnRedraw					_on_redraw;
+	OnPlaybackChange			_on_playback_change;
 	QPoint						_last_pos;
 	bool						_changing_rotation: 1			{ false };
 	bool						_changing_translation: 1		{ false };
@@ -0,0 +1,125 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__UTILITY__SPSC_QUEUE_H__INCLUDED
+#define XEFIS__UTILITY__SPSC_QUEUE_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Standard:
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <type_traits>
+
+
+namespace xf {
+
+/**
+ * Bounded, lock-free, wait-free queue for exactly one producer thread
+ * and exactly one consumer thread.
+ *
+ * One slot is always kept free to tell a full queue from an empty one,
+ * so at most Capacity - 1 elements can be stored at a time.
+ */
+template<class pValue, std::size_t pCapacity>
+	requires (std::is_nothrow_copy_assignable_v<pValue> && std::is_default_constructible_v<pValue>)
+	class SPSCQueue
+	{
+	  public:
+		using Value = pValue;
+
+		static constexpr std::size_t kCapacity = pCapacity;
+
+	  public:
+		/**
+		 * Add element to the queue. Return false if the queue is full
+		 * and the element was dropped.
+		 * Call only from the producer thread.
+		 */
+		bool
+		push (Value const&) noexcept;
+
+		/**
+		 * Take the oldest element from the queue or return std::nullopt if queue is empty.
+		 * Call only from the consumer thread.
+		 */
+		std::optional<Value>
+		pop() noexcept;
+
+		/**
+		 * Number of elements that were dropped by push() because the queue was full.
+		 */
+		[[nodiscard]]
+		std::size_t
+		dropped_count() const noexcept
+			{ return _dropped_count.load (std::memory_order_relaxed); }
+
+	  private:
+		[[nodiscard]]
+		static constexpr std::size_t
+		next (std::size_t index) noexcept
+			{ return (index + 1) % kCapacity; }
+
+	  private:
+		std::array<Value, kCapacity>				_elements;
+		// Written by the consumer:
+		alignas (64) std::atomic<std::size_t>		_head			{ 0 };
+		// Written by the producer:
+		alignas (64) std::atomic<std::size_t>		_tail			{ 0 };
+		std::atomic<std::size_t>					_dropped_count	{ 0 };
+	};
+
+
+template<class V, std::size_t C>
+	requires (std::is_nothrow_copy_assignable_v<V> && std::is_default_constructible_v<V>)
+	inline bool
+	SPSCQueue<V, C>::push (Value const& value) noexcept
+	{
+		auto const tail = _tail.load (std::memory_order_relaxed);
+		auto const new_tail = next (tail);
+
+		if (new_tail == _head.load (std::memory_order_acquire))
+		{
+			_dropped_count.fetch_add (1, std::memory_order_relaxed);
+			return false;
+		}
+
+		_elements[tail] = value;
+		_tail.store (new_tail, std::memory_order_release);
+		return true;
+	}
+
+
+template<class V, std::size_t C>
+	requires (std::is_nothrow_copy_assignable_v<V> && std::is_default_constructible_v<V>)
+	inline std::optional<V>
+	SPSCQueue<V, C>::pop() noexcept
+	{
+		auto const head = _head.load (std::memory_order_relaxed);
+
+		if (head == _tail.load (std::memory_order_acquire))
+			return std::nullopt;
+
+		std::optional<Value> result = _elements[head];
+		_head.store (next (head), std::memory_order_release);
+		return result;
+	}
+
+} // namespace xf
+
+#endif
+
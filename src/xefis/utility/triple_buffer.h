@@ -0,0 +1,125 @@
+/* vim:ts=4
+ *
+ * Copyleft 2024  Michał Gawron
+ * Marduk Unix Labs, http://mulabs.org/
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Visit http://www.gnu.org/licenses/gpl-3.0.html for more information on licensing.
+ */
+
+#ifndef XEFIS__UTILITY__TRIPLE_BUFFER_H__INCLUDED
+#define XEFIS__UTILITY__TRIPLE_BUFFER_H__INCLUDED
+
+// Xefis:
+#include <xefis/config/all.h>
+
+// Standard:
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace xf {
+
+/**
+ * Lock-free, wait-free triple buffer for exactly one producer thread
+ * and exactly one consumer thread.
+ *
+ * The producer fills write_buffer() and calls publish(). The consumer calls read() to get the most
+ * recently published value. Neither side ever waits for the other: the producer always has a buffer
+ * to write to, and the consumer keeps the buffer it got from read() until it calls read() again.
+ * Values published in between are skipped.
+ */
+template<class pValue>
+	requires (std::is_default_constructible_v<pValue>)
+	class TripleBuffer
+	{
+	  public:
+		using Value = pValue;
+
+	  private:
+		static constexpr uint8_t kIndexMask	= 0b011;
+		static constexpr uint8_t kFreshBit	= 0b100;
+
+	  public:
+		/**
+		 * Return the buffer to fill before calling publish().
+		 * Call only from the producer thread.
+		 */
+		[[nodiscard]]
+		Value&
+		write_buffer() noexcept
+			{ return _buffers[_write_index]; }
+
+		/**
+		 * Make write_buffer() available to the consumer and switch to another buffer for writing.
+		 * The new write_buffer() contains some older value, not necessarily the one just published.
+		 * Call only from the producer thread.
+		 */
+		void
+		publish() noexcept;
+
+		/**
+		 * Return true if a value has been published since the last read().
+		 * Call only from the consumer thread.
+		 */
+		[[nodiscard]]
+		bool
+		has_fresh_value() const noexcept
+			{ return _middle.load (std::memory_order_relaxed) & kFreshBit; }
+
+		/**
+		 * Return the most recently published value (or default-constructed Value if nothing has been published yet).
+		 * The reference stays valid until the next call to read().
+		 * Call only from the consumer thread.
+		 */
+		[[nodiscard]]
+		Value const&
+		read() noexcept;
+
+	  private:
+		std::array<Value, 3>				_buffers;
+		// Owned by the producer:
+		alignas (64) uint8_t				_write_index	{ 0 };
+		// Index of the buffer exchanged between producer and consumer, with kFreshBit set if it
+		// contains a value not yet seen by the consumer:
+		alignas (64) std::atomic<uint8_t>	_middle			{ 1 };
+		// Owned by the consumer:
+		alignas (64) uint8_t				_read_index		{ 2 };
+	};
+
+
+template<class V>
+	requires (std::is_default_constructible_v<V>)
+	inline void
+	TripleBuffer<V>::publish() noexcept
+	{
+		auto const previous = _middle.exchange (_write_index | kFreshBit, std::memory_order_acq_rel);
+		_write_index = previous & kIndexMask;
+	}
+
+
+template<class V>
+	requires (std::is_default_constructible_v<V>)
+	inline auto
+	TripleBuffer<V>::read() noexcept -> Value const&
+	{
+		if (has_fresh_value())
+		{
+			auto const previous = _middle.exchange (_read_index, std::memory_order_acq_rel);
+			_read_index = previous & kIndexMask;
+		}
+
+		return _buffers[_read_index];
+	}
+
+} // namespace xf
+
+#endif
+